@@ -14,10 +14,29 @@ struct ListenConfig {
     uint16_t port;
     bool enabled;
     uint32_t backlog;
+    bool compression_enabled;       // 按Accept-Encoding协商gzip/deflate压缩响应
+    int32_t compression_level;      // 压缩级别（1-9，-1为zlib默认）
+    uint32_t compression_min_size;  // 小于该长度的响应体不压缩
+    bool tls_enabled;               // false为明文端口（HTTP/1.1或h2c先验知识）
+    bool early_data;                // 接受TLS 1.3 0-RTT早期数据
+    std::string early_data_methods; // 早期数据中允许处理的可重放方法（逗号分隔）
 
     ListenConfig();
 };
 
+// SNI虚拟主机证书：同一主机名可同时配置RSA、ECDSA与SM2证书，握手时按客户端能力选择
+struct ServerNameConfig {
+    std::string server_name;        // 主机名（不区分大小写），"*.example.com"匹配一级子域名
+    std::string cert_path;          // RSA证书链
+    std::string key_path;
+    std::string ecdsa_cert_path;    // ECDSA证书链（客户端支持ECDSA签名时优先）
+    std::string ecdsa_key_path;
+    std::string sm2_cert_path;      // SM2证书链（客户端提供SM2签名算法时使用）
+    std::string sm2_key_path;
+
+    ServerNameConfig();
+};
+
 // 证书配置
 struct CertificatesConfig {
     std::string cert_path;
@@ -28,6 +47,15 @@ struct CertificatesConfig {
     std::string sm2_sign_cert_path;
     std::string sm2_sign_key_path;
     std::string cipher_suite;
+    bool enable_ktls;          // 启用内核TLS卸载（Linux，不可用时自动回退）
+    uint32_t session_cache_size;    // TLS 1.2服务端会话缓存容量（0关闭）
+    uint32_t session_timeout;       // 会话与会话票据有效期（秒）
+    bool session_tickets;           // 启用无状态会话票据（TLS 1.2/1.3）
+    uint32_t ticket_key_rotation;   // 票据密钥轮换周期（秒）
+    uint32_t record_ramp_bytes;     // 以小记录发送的字节数，之后切换为最大记录（0关闭动态记录长度）
+    uint32_t record_idle_ms;        // 连接空闲超过该时长后重新从小记录开始
+    bool cert_compression;          // TLS 1.3证书压缩（RFC 8879，需OpenSSL 3.2+）
+    std::vector<ServerNameConfig> server_names;  // 按SNI选择的虚拟主机证书（未匹配时使用上面的默认证书）
 
     CertificatesConfig();
 };
@@ -79,6 +107,9 @@ struct LoggingConfig {
 struct Http2Config {
     bool enabled;
     bool allow_h2c;
+    uint32_t initial_window_size;       // 本端流级初始接收窗口（SETTINGS_INITIAL_WINDOW_SIZE）
+    uint32_t max_concurrent_streams;    // 本端允许的最大并发流数
+    uint32_t max_window_size;           // BDP探测放大接收窗口的上限（不大于初始窗口时关闭）
 
     Http2Config();
 };
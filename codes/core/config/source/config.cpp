@@ -24,6 +24,49 @@ void ParseListenConfig(const Json& j, ListenConfig& cfg) {
     if (j.contains("backlog") && j["backlog"].is_number()) {
         cfg.backlog = j["backlog"].get<uint32_t>();
     }
+    if (j.contains("compression_enabled") && j["compression_enabled"].is_boolean()) {
+        cfg.compression_enabled = j["compression_enabled"].get<bool>();
+    }
+    if (j.contains("compression_level") && j["compression_level"].is_number()) {
+        cfg.compression_level = j["compression_level"].get<int32_t>();
+    }
+    if (j.contains("compression_min_size") && j["compression_min_size"].is_number()) {
+        cfg.compression_min_size = j["compression_min_size"].get<uint32_t>();
+    }
+    if (j.contains("tls_enabled") && j["tls_enabled"].is_boolean()) {
+        cfg.tls_enabled = j["tls_enabled"].get<bool>();
+    }
+    if (j.contains("early_data") && j["early_data"].is_boolean()) {
+        cfg.early_data = j["early_data"].get<bool>();
+    }
+    if (j.contains("early_data_methods") && j["early_data_methods"].is_string()) {
+        cfg.early_data_methods = j["early_data_methods"].get<std::string>();
+    }
+}
+
+// 解析ServerNameConfig
+void ParseServerNameConfig(const Json& j, ServerNameConfig& cfg) {
+    if (j.contains("server_name") && j["server_name"].is_string()) {
+        cfg.server_name = j["server_name"].get<std::string>();
+    }
+    if (j.contains("cert_path") && j["cert_path"].is_string()) {
+        cfg.cert_path = j["cert_path"].get<std::string>();
+    }
+    if (j.contains("key_path") && j["key_path"].is_string()) {
+        cfg.key_path = j["key_path"].get<std::string>();
+    }
+    if (j.contains("ecdsa_cert_path") && j["ecdsa_cert_path"].is_string()) {
+        cfg.ecdsa_cert_path = j["ecdsa_cert_path"].get<std::string>();
+    }
+    if (j.contains("ecdsa_key_path") && j["ecdsa_key_path"].is_string()) {
+        cfg.ecdsa_key_path = j["ecdsa_key_path"].get<std::string>();
+    }
+    if (j.contains("sm2_cert_path") && j["sm2_cert_path"].is_string()) {
+        cfg.sm2_cert_path = j["sm2_cert_path"].get<std::string>();
+    }
+    if (j.contains("sm2_key_path") && j["sm2_key_path"].is_string()) {
+        cfg.sm2_key_path = j["sm2_key_path"].get<std::string>();
+    }
 }
 
 // 解析CertificatesConfig
@@ -52,6 +95,38 @@ void ParseCertificatesConfig(const Json& j, CertificatesConfig& cfg) {
     if (j.contains("cipher_suite") && j["cipher_suite"].is_string()) {
         cfg.cipher_suite = j["cipher_suite"].get<std::string>();
     }
+    if (j.contains("enable_ktls") && j["enable_ktls"].is_boolean()) {
+        cfg.enable_ktls = j["enable_ktls"].get<bool>();
+    }
+    if (j.contains("session_cache_size") && j["session_cache_size"].is_number()) {
+        cfg.session_cache_size = j["session_cache_size"].get<uint32_t>();
+    }
+    if (j.contains("session_timeout") && j["session_timeout"].is_number()) {
+        cfg.session_timeout = j["session_timeout"].get<uint32_t>();
+    }
+    if (j.contains("session_tickets") && j["session_tickets"].is_boolean()) {
+        cfg.session_tickets = j["session_tickets"].get<bool>();
+    }
+    if (j.contains("ticket_key_rotation") && j["ticket_key_rotation"].is_number()) {
+        cfg.ticket_key_rotation = j["ticket_key_rotation"].get<uint32_t>();
+    }
+    if (j.contains("record_ramp_bytes") && j["record_ramp_bytes"].is_number()) {
+        cfg.record_ramp_bytes = j["record_ramp_bytes"].get<uint32_t>();
+    }
+    if (j.contains("record_idle_ms") && j["record_idle_ms"].is_number()) {
+        cfg.record_idle_ms = j["record_idle_ms"].get<uint32_t>();
+    }
+    if (j.contains("cert_compression") && j["cert_compression"].is_boolean()) {
+        cfg.cert_compression = j["cert_compression"].get<bool>();
+    }
+    if (j.contains("server_names") && j["server_names"].is_array()) {
+        cfg.server_names.clear();
+        for (const auto& sn : j["server_names"]) {
+            ServerNameConfig server_name;
+            ParseServerNameConfig(sn, server_name);
+            cfg.server_names.push_back(server_name);
+        }
+    }
 }
 
 // 解析DebugPointConfig
@@ -137,6 +212,15 @@ void ParseHttp2Config(const Json& j, Http2Config& cfg) {
     if (j.contains("allow_h2c") && j["allow_h2c"].is_boolean()) {
         cfg.allow_h2c = j["allow_h2c"].get<bool>();
     }
+    if (j.contains("initial_window_size") && j["initial_window_size"].is_number()) {
+        cfg.initial_window_size = j["initial_window_size"].get<uint32_t>();
+    }
+    if (j.contains("max_concurrent_streams") && j["max_concurrent_streams"].is_number()) {
+        cfg.max_concurrent_streams = j["max_concurrent_streams"].get<uint32_t>();
+    }
+    if (j.contains("max_window_size") && j["max_window_size"].is_number()) {
+        cfg.max_window_size = j["max_window_size"].get<uint32_t>();
+    }
 }
 
 } // namespace details
@@ -147,12 +231,31 @@ ListenConfig::ListenConfig()
     , port(8443)
     , enabled(true)
     , backlog(128)
+    , compression_enabled(false)
+    , compression_level(6)
+    , compression_min_size(1024)
+    , tls_enabled(true)
+    , early_data(false)
+    , early_data_methods("GET,HEAD")
+{
+}
+
+// ServerNameConfig
+ServerNameConfig::ServerNameConfig()
 {
 }
 
 // CertificatesConfig
 CertificatesConfig::CertificatesConfig()
     : cipher_suite("TLS_AES_256_GCM_SHA384:TLS_CHACHA20_POLY1305_SHA256:TLS_AES_128_GCM_SHA256")
+    , enable_ktls(false)
+    , session_cache_size(20480)
+    , session_timeout(300)
+    , session_tickets(true)
+    , ticket_key_rotation(3600)
+    , record_ramp_bytes(1024 * 1024)
+    , record_idle_ms(1000)
+    , cert_compression(true)
 {
 }
 
@@ -194,6 +297,9 @@ LoggingConfig::LoggingConfig()
 Http2Config::Http2Config()
     : enabled(true)
     , allow_h2c(false)
+    , initial_window_size(65535)
+    , max_concurrent_streams(100)
+    , max_window_size(16 * 1024 * 1024)
 {
 }
 
@@ -274,6 +380,27 @@ int Config::validate() const {
         if (listen.port == 0) {
             return -1;
         }
+        if (listen.compression_level < -1 || listen.compression_level > 9) {
+            return -1;
+        }
+    }
+    // 会话有效期为0时缓存与票据都立即过期；启用票据时必须能轮换密钥
+    if (certificates_.session_timeout == 0 ||
+        (certificates_.session_tickets && certificates_.ticket_key_rotation == 0)) {
+        return -1;
+    }
+    // 每个SNI主机名至少需要一套完整的证书与私钥
+    for (const auto& sn : certificates_.server_names) {
+        bool has_rsa = !sn.cert_path.empty() && !sn.key_path.empty();
+        bool has_ecdsa = !sn.ecdsa_cert_path.empty() && !sn.ecdsa_key_path.empty();
+        bool has_sm2 = !sn.sm2_cert_path.empty() && !sn.sm2_key_path.empty();
+        if (sn.server_name.empty() || (!has_rsa && !has_ecdsa && !has_sm2)) {
+            return -1;
+        }
+    }
+    // HTTP/2窗口上限为2^31-1（RFC 9113 6.9.2）
+    if (http2_.initial_window_size > 0x7FFFFFFFu || http2_.max_window_size > 0x7FFFFFFFu) {
+        return -1;
     }
     return 0;
 }
@@ -34,7 +34,15 @@ TEST_F(ConfigTest, LoadFromFullJsonString) {
             "sm2_key_path": "certs/sm2/server.key",
             "sm2_sign_cert_path": "certs/sm2/sign.crt",
             "sm2_sign_key_path": "certs/sm2/sign.key",
-            "cipher_suite": "TLS_AES_256_GCM_SHA384:TLS_CHACHA20_POLY1305_SHA256"
+            "cipher_suite": "TLS_AES_256_GCM_SHA384:TLS_CHACHA20_POLY1305_SHA256",
+            "enable_ktls": true,
+            "session_cache_size": 1024,
+            "session_timeout": 600,
+            "session_tickets": false,
+            "ticket_key_rotation": 7200,
+            "record_ramp_bytes": 65536,
+            "record_idle_ms": 500,
+            "cert_compression": false
         },
         "debug": {
             "enabled": false,
@@ -80,6 +88,14 @@ TEST_F(ConfigTest, LoadFromFullJsonString) {
     EXPECT_EQ(certs.sm2_sign_cert_path, "certs/sm2/sign.crt");
     EXPECT_EQ(certs.sm2_sign_key_path, "certs/sm2/sign.key");
     EXPECT_EQ(certs.cipher_suite, "TLS_AES_256_GCM_SHA384:TLS_CHACHA20_POLY1305_SHA256");
+    EXPECT_EQ(certs.enable_ktls, true);
+    EXPECT_EQ(certs.session_cache_size, static_cast<uint32_t>(1024));
+    EXPECT_EQ(certs.session_timeout, static_cast<uint32_t>(600));
+    EXPECT_EQ(certs.session_tickets, false);
+    EXPECT_EQ(certs.ticket_key_rotation, static_cast<uint32_t>(7200));
+    EXPECT_EQ(certs.record_ramp_bytes, static_cast<uint32_t>(65536));
+    EXPECT_EQ(certs.record_idle_ms, static_cast<uint32_t>(500));
+    EXPECT_EQ(certs.cert_compression, false);
 
     // 验证debug
     const auto& debug = config_.get_debug();
@@ -202,6 +218,132 @@ TEST_F(ConfigTest, ValidateValidConfig) {
     EXPECT_EQ(ret, 0);
 }
 
+// 测试用例: 解析监听端口压缩配置
+TEST_F(ConfigTest, LoadListenCompressionConfig) {
+    const std::string json_str = R"({
+        "listens": [
+            {"port": 8443, "compression_enabled": true, "compression_level": 9, "compression_min_size": 256},
+            {"port": 8444, "tls_enabled": false}
+        ]
+    })";
+    ASSERT_EQ(config_.load_from_string(json_str), 0);
+
+    const auto& listens = config_.get_listens();
+    ASSERT_EQ(listens.size(), static_cast<size_t>(2));
+    EXPECT_TRUE(listens[0].compression_enabled);
+    EXPECT_EQ(listens[0].compression_level, 9);
+    EXPECT_EQ(listens[0].compression_min_size, static_cast<uint32_t>(256));
+    EXPECT_FALSE(listens[1].compression_enabled);
+    EXPECT_EQ(listens[1].compression_level, 6);
+    EXPECT_EQ(listens[1].compression_min_size, static_cast<uint32_t>(1024));
+    EXPECT_TRUE(listens[0].tls_enabled);
+    EXPECT_FALSE(listens[1].tls_enabled);
+    EXPECT_EQ(config_.validate(), 0);
+}
+
+// 测试用例: 解析监听端口0-RTT配置
+TEST_F(ConfigTest, LoadListenEarlyDataConfig) {
+    const std::string json_str = R"({
+        "listens": [
+            {"port": 8443, "early_data": true, "early_data_methods": "GET"},
+            {"port": 8444}
+        ]
+    })";
+    ASSERT_EQ(config_.load_from_string(json_str), 0);
+
+    const auto& listens = config_.get_listens();
+    ASSERT_EQ(listens.size(), static_cast<size_t>(2));
+    EXPECT_TRUE(listens[0].early_data);
+    EXPECT_EQ(listens[0].early_data_methods, "GET");
+    EXPECT_FALSE(listens[1].early_data);
+    EXPECT_EQ(listens[1].early_data_methods, "GET,HEAD");
+}
+
+// 测试用例: 配置验证 - 非法压缩级别
+TEST_F(ConfigTest, ValidateInvalidCompressionLevel) {
+    ListenConfig listen;
+    listen.compression_level = 10;
+    config_.set_listens({listen});
+    EXPECT_EQ(config_.validate(), -1);
+}
+
+// 测试用例: 配置验证 - 会话复用参数
+TEST_F(ConfigTest, ValidateSessionResumption) {
+    CertificatesConfig certs;
+    certs.ticket_key_rotation = 0;
+    config_.set_certificates(certs);
+    EXPECT_EQ(config_.validate(), -1);
+
+    // 关闭票据时不要求轮换周期
+    certs.session_tickets = false;
+    config_.set_certificates(certs);
+    EXPECT_EQ(config_.validate(), 0);
+
+    certs.session_timeout = 0;
+    config_.set_certificates(certs);
+    EXPECT_EQ(config_.validate(), -1);
+}
+
+// 测试用例: 解析SNI虚拟主机证书
+TEST_F(ConfigTest, LoadServerNamesConfig) {
+    const std::string json_str = R"({
+        "listens": [{"port": 8443}],
+        "certificates": {
+            "cert_path": "default.crt",
+            "key_path": "default.key",
+            "server_names": [
+                {"server_name": "a.example.com", "cert_path": "a.crt", "key_path": "a.key",
+                 "ecdsa_cert_path": "a-ec.crt", "ecdsa_key_path": "a-ec.key"},
+                {"server_name": "*.example.org", "sm2_cert_path": "o.crt", "sm2_key_path": "o.key"}
+            ]
+        }
+    })";
+    ASSERT_EQ(config_.load_from_string(json_str), 0);
+
+    const auto& server_names = config_.get_certificates().server_names;
+    ASSERT_EQ(server_names.size(), static_cast<size_t>(2));
+    EXPECT_EQ(server_names[0].server_name, "a.example.com");
+    EXPECT_EQ(server_names[0].cert_path, "a.crt");
+    EXPECT_EQ(server_names[0].ecdsa_key_path, "a-ec.key");
+    EXPECT_EQ(server_names[1].server_name, "*.example.org");
+    EXPECT_EQ(server_names[1].sm2_cert_path, "o.crt");
+    EXPECT_TRUE(config_.get_certificates().cert_compression);
+    EXPECT_TRUE(server_names[1].cert_path.empty());
+    EXPECT_EQ(config_.validate(), 0);
+
+    // 没有任何完整证书对的主机名视为配置错误
+    CertificatesConfig certs = config_.get_certificates();
+    certs.server_names[1].sm2_key_path.clear();
+    config_.set_certificates(certs);
+    EXPECT_EQ(config_.validate(), -1);
+}
+
+// 测试用例: 解析HTTP/2流控配置
+TEST_F(ConfigTest, LoadHttp2FlowControlConfig) {
+    const std::string json_str = R"({
+        "listens": [{"port": 8443}],
+        "http2": {"initial_window_size": 1048576, "max_concurrent_streams": 256,
+                  "max_window_size": 8388608}
+    })";
+    ASSERT_EQ(config_.load_from_string(json_str), 0);
+
+    const auto& http2 = config_.get_http2();
+    EXPECT_EQ(http2.initial_window_size, static_cast<uint32_t>(1048576));
+    EXPECT_EQ(http2.max_concurrent_streams, static_cast<uint32_t>(256));
+    EXPECT_EQ(http2.max_window_size, static_cast<uint32_t>(8388608));
+    EXPECT_EQ(config_.validate(), 0);
+
+    Http2Config invalid;
+    invalid.initial_window_size = 0x80000000u;
+    config_.set_http2(invalid);
+    EXPECT_EQ(config_.validate(), -1);
+
+    invalid = Http2Config();
+    invalid.max_window_size = 0x80000000u;
+    config_.set_http2(invalid);
+    EXPECT_EQ(config_.validate(), -1);
+}
+
 // 测试用例: 设置和获取配置
 TEST_F(ConfigTest, SetAndGetConfig) {
     ListenConfig listen;
@@ -20,14 +20,19 @@
 
 namespace https_server_sim {
 
+// 握手线程的nice值：完整握手的签名运算让位于已建立连接的IO与请求处理
+constexpr int kHandshakeThreadNice = 10;
+
 class MsgCenter {
 public:
     /**
      * @brief 构造函数
      * @param io_thread_count IO线程数量，默认2
      * @param worker_thread_count 工作线程数量，默认2
+     * @param handshake_thread_count TLS握手线程数量，默认1（0表示握手任务交给工作线程）
      */
-    explicit MsgCenter(size_t io_thread_count = 2, size_t worker_thread_count = 2);
+    explicit MsgCenter(size_t io_thread_count = 2, size_t worker_thread_count = 2,
+                       size_t handshake_thread_count = 1);
 
     /**
      * @brief 析构函数
@@ -61,6 +66,12 @@ public:
      */
     void post_callback_task(std::function<void()> task);
 
+    /**
+     * @brief 提交TLS握手任务（独立线程池与队列，完成后投递CALLBACK_DONE事件）
+     * @param task 握手任务
+     */
+    void post_handshake_task(std::function<void()> task);
+
     /**
      * @brief 获取EventLoop
      * @return EventLoop指针
@@ -100,6 +111,7 @@ private:
     std::shared_ptr<EventQueue> event_queue_;
     std::shared_ptr<EventLoop> event_loop_;
     std::unique_ptr<WorkerPool> worker_pool_;
+    std::unique_ptr<WorkerPool> handshake_pool_;   // 握手专用，避免与请求处理共用队列
     std::vector<std::unique_ptr<IoThread>> io_threads_;
     std::thread event_loop_thread_;
     std::atomic<bool> running_;
@@ -110,6 +122,7 @@ private:
 
     size_t io_thread_count_;
     size_t worker_thread_count_;
+    size_t handshake_thread_count_;
 };
 
 } // namespace https_server_sim
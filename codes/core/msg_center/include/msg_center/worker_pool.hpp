@@ -63,6 +63,12 @@ public:
      */
     void set_post_callback_done(bool enable);
 
+    /**
+     * @brief 设置工作线程的nice值（需在start前调用，仅Linux生效）
+     * @param nice nice值，正数表示低于默认调度优先级，0表示不调整
+     */
+    void set_thread_nice(int nice);
+
 private:
     /**
      * @brief 工作线程函数
@@ -90,6 +96,9 @@ private:
 
     // 是否投递CALLBACK_DONE事件
     std::atomic<bool> post_callback_done_;
+
+    // 工作线程启动时应用的nice值
+    int thread_nice_;
 };
 
 } // namespace https_server_sim
@@ -28,10 +28,12 @@ const char* msg_center_error_to_string(MsgCenterError error) {
     }
 }
 
-MsgCenter::MsgCenter(size_t io_thread_count, size_t worker_thread_count)
+MsgCenter::MsgCenter(size_t io_thread_count, size_t worker_thread_count,
+                     size_t handshake_thread_count)
     : running_(false)
     , io_thread_count_(io_thread_count)
     , worker_thread_count_(worker_thread_count)
+    , handshake_thread_count_(handshake_thread_count)
 {}
 
 MsgCenter::~MsgCenter() {
@@ -60,6 +62,12 @@ int MsgCenter::start() {
         // WorkerPool构造时post_callback_done_默认为false
         worker_pool_ = std::make_unique<WorkerPool>(worker_thread_count_, event_loop_.get());
 
+        // 创建握手线程池：完成事件为CALLBACK_DONE，优先级低于READ/WRITE
+        if (handshake_thread_count_ > 0) {
+            handshake_pool_ = std::make_unique<WorkerPool>(handshake_thread_count_, event_loop_.get());
+            handshake_pool_->set_thread_nice(kHandshakeThreadNice);
+        }
+
         // 创建io_thread_count_个IoThread（每个传入EventQueue指针）
         io_threads_.reserve(io_thread_count_);
         for (size_t i = 0; i < io_thread_count_; ++i) {
@@ -68,6 +76,9 @@ int MsgCenter::start() {
 
         // 启动WorkerPool
         worker_pool_->start();
+        if (handshake_pool_) {
+            handshake_pool_->start();
+        }
 
         // 启动所有IoThread
         for (auto& io_thread : io_threads_) {
@@ -91,6 +102,9 @@ int MsgCenter::start() {
         // 调用worker_pool_->set_post_callback_done(true)
         // 此时EventLoop已启动，安全启用回调完成事件投递
         worker_pool_->set_post_callback_done(true);
+        if (handshake_pool_) {
+            handshake_pool_->set_post_callback_done(true);
+        }
 
         // 设置running_ = true
         running_.store(true, std::memory_order_release);
@@ -114,6 +128,9 @@ void MsgCenter::stop() {
     running_.store(false, std::memory_order_release);
 
     // 先停止WorkerPool，确保WorkerPool的回调完成事件能被EventLoop处理
+    if (handshake_pool_) {
+        handshake_pool_->stop();
+    }
     if (worker_pool_) {
         worker_pool_->stop();
     }
@@ -137,6 +154,7 @@ void MsgCenter::stop() {
     io_threads_.clear();
 
     // 清理资源
+    handshake_pool_.reset();
     worker_pool_.reset();
     event_loop_.reset();
     event_queue_.reset();
@@ -168,6 +186,15 @@ void MsgCenter::post_callback_task(std::function<void()> task) {
     }
 }
 
+void MsgCenter::post_handshake_task(std::function<void()> task) {
+    if (handshake_pool_) {
+        handshake_pool_->post_task(std::move(task));
+    } else {
+        // 未配置握手线程时与请求处理共用工作线程
+        post_callback_task(std::move(task));
+    }
+}
+
 int MsgCenter::add_listen_fd(int fd) {
     return add_listen_fd(fd, 0);
 }
@@ -8,6 +8,12 @@
 #include "utils/logger.hpp"
 #include <chrono>
 
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 namespace https_server_sim {
 
 WorkerPool::WorkerPool(size_t num_workers, EventLoop* event_loop)
@@ -16,6 +22,7 @@ WorkerPool::WorkerPool(size_t num_workers, EventLoop* event_loop)
     , queue_closed_(false)
     , event_loop_(event_loop)
     , post_callback_done_(false)
+    , thread_nice_(0)
 {}
 
 WorkerPool::~WorkerPool() {
@@ -76,7 +83,19 @@ void WorkerPool::set_post_callback_done(bool enable) {
     post_callback_done_.store(enable, std::memory_order_release);
 }
 
+void WorkerPool::set_thread_nice(int nice) {
+    thread_nice_ = nice;
+}
+
 void WorkerPool::worker_thread() {
+#ifdef __linux__
+    // Linux下nice值按线程生效，调低后与IO线程争用CPU时让出
+    if (thread_nice_ != 0 &&
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), thread_nice_) != 0) {
+        LOG_ERROR("WorkerPool", "setpriority(%d) failed", thread_nice_);
+    }
+#endif
+
     while (true) {
         std::function<void()> task;
         bool has_task = false;
@@ -18,6 +18,11 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <netinet/in.h>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace https_server_sim {
 namespace test {
@@ -438,6 +443,23 @@ TEST_F(WorkerPoolTest, ProcessAllTasksOnStop) {
     EXPECT_EQ(executed_count.load(), task_count);
 }
 
+#ifdef __linux__
+// 补充测试：工作线程按设置的nice值运行
+TEST_F(WorkerPoolTest, AppliesThreadNice) {
+    WorkerPool pool(1, nullptr);
+    pool.set_thread_nice(5);
+    std::atomic<int> nice{0};
+
+    pool.start();
+    pool.post_task([&nice]() {
+        nice = getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+    });
+    pool.stop();
+
+    EXPECT_EQ(nice.load(), 5);
+}
+#endif
+
 // ==================== MsgCenter测试 ====================
 
 class MsgCenterTest : public ::testing::Test {
@@ -509,6 +531,35 @@ TEST_F(MsgCenterTest, ConfigureIoThreadCount) {
     SUCCEED();
 }
 
+// 补充测试：握手任务在独立线程池执行，未配置握手线程时回退到工作线程
+TEST_F(MsgCenterTest, HandshakeTasksUseDedicatedPool) {
+    MsgCenter center(1, 1, 1);
+    ASSERT_EQ(center.start(), static_cast<int>(MsgCenterError::SUCCESS));
+
+    std::atomic<int> done{0};
+    std::thread::id worker_id;
+    std::thread::id handshake_id;
+    center.post_callback_task([&]() { worker_id = std::this_thread::get_id(); done++; });
+    center.post_handshake_task([&]() { handshake_id = std::this_thread::get_id(); done++; });
+    for (int i = 0; i < 100 && done.load() < 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    center.stop();
+
+    ASSERT_EQ(done.load(), 2);
+    EXPECT_NE(worker_id, handshake_id);
+
+    MsgCenter shared(1, 1, 0);
+    ASSERT_EQ(shared.start(), static_cast<int>(MsgCenterError::SUCCESS));
+    std::atomic<bool> ran{false};
+    shared.post_handshake_task([&ran]() { ran = true; });
+    for (int i = 0; i < 100 && !ran.load(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    shared.stop();
+    EXPECT_TRUE(ran.load());
+}
+
 // 补充测试：多次start()返回ALREADY_RUNNING
 TEST_F(MsgCenterTest, StartAlreadyRunning) {
     MsgCenter center(2, 2);
@@ -0,0 +1,172 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: compression.hpp
+//  描述: 响应压缩（gzip/deflate协商、压缩与压缩结果LRU缓存）
+//  版权: Copyright (c) 2026
+// =============================================================================
+#pragma once
+
+#include "protocol/protocol_types.hpp"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace https_server_sim {
+namespace protocol {
+
+// ==================== 内容编码枚举 ====================
+enum class ContentEncoding : uint8_t {
+    IDENTITY = 0,
+    GZIP = 1,
+    DEFLATE = 2
+};
+
+/**
+ * @brief 获取内容编码名称（用于Content-Encoding头部）
+ * @param encoding 内容编码
+ * @return 编码名称，IDENTITY返回"identity"
+ */
+const char* content_encoding_name(ContentEncoding encoding);
+
+/**
+ * @brief 获取预格式化的HTTP/1.1压缩相关头部行
+ * @param encoding 内容编码
+ * @param out_len 输出长度
+ * @return "Content-Encoding: xxx\r\nVary: Accept-Encoding\r\n"，IDENTITY返回空串
+ */
+const char* content_encoding_header_lines(ContentEncoding encoding, size_t* out_len);
+
+/**
+ * @brief 根据Accept-Encoding协商内容编码
+ * @note 支持q值；q相同时优先gzip；不支持压缩库时始终返回IDENTITY
+ * @param accept_encoding Accept-Encoding头部值
+ * @return 协商结果
+ */
+ContentEncoding negotiate_content_encoding(const std::string& accept_encoding);
+
+/**
+ * @brief 压缩数据
+ * @param data 输入数据
+ * @param len 输入长度
+ * @param encoding 内容编码（GZIP或DEFLATE）
+ * @param level 压缩级别（1-9，-1为默认）
+ * @param out 输出压缩结果
+ * @return 0成功，负数失败
+ */
+int compress_body(const uint8_t* data, size_t len, ContentEncoding encoding,
+                  int level, std::vector<uint8_t>* out);
+
+// ==================== 压缩结果缓存 ====================
+// 以(内容哈希, 长度, 编码, 级别)为键的LRU缓存，重复响应体只压缩一次；线程安全。
+class CompressionCache {
+public:
+    static constexpr size_t DEFAULT_CAPACITY_BYTES = 32 * 1024 * 1024;  // 默认容量32MB
+
+    using Body = std::shared_ptr<const std::vector<uint8_t>>;
+
+    /**
+     * @brief 获取缓存单例
+     * @return CompressionCache引用
+     */
+    static CompressionCache& instance();
+
+    /**
+     * @brief 查找压缩结果，未命中时压缩并插入缓存
+     * @param data 原始数据
+     * @param len 原始长度
+     * @param encoding 内容编码
+     * @param level 压缩级别
+     * @return 压缩结果，失败返回空
+     */
+    Body get_or_compress(const uint8_t* data, size_t len,
+                         ContentEncoding encoding, int level);
+
+    /**
+     * @brief 设置缓存容量（字节），超出时按LRU淘汰
+     * @param capacity_bytes 容量，按原始数据与压缩结果之和计算
+     */
+    void set_capacity(size_t capacity_bytes);
+
+    /**
+     * @brief 清空缓存与统计
+     */
+    void clear();
+
+    /**
+     * @brief 获取缓存条目数
+     */
+    size_t entry_count() const;
+
+    /**
+     * @brief 获取缓存占用字节数
+     */
+    size_t size_bytes() const;
+
+    /**
+     * @brief 获取命中次数
+     */
+    uint64_t hits() const;
+
+    /**
+     * @brief 获取未命中次数
+     */
+    uint64_t misses() const;
+
+private:
+    CompressionCache();
+    ~CompressionCache();
+    CompressionCache(const CompressionCache&) = delete;
+    CompressionCache& operator=(const CompressionCache&) = delete;
+
+    struct Key {
+        uint64_t hash;
+        size_t len;
+        ContentEncoding encoding;
+        int level;
+
+        bool operator==(const Key& other) const {
+            return hash == other.hash && len == other.len &&
+                   encoding == other.encoding && level == other.level;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return static_cast<size_t>(key.hash ^ (static_cast<uint64_t>(key.encoding) << 56) ^
+                                       (static_cast<uint64_t>(key.level) << 48));
+        }
+    };
+
+    struct Entry {
+        Key key;
+        Body source;  // 原始数据副本（共享，命中时在锁外逐字节比对以排除哈希碰撞）
+        Body body;
+    };
+
+    /**
+     * @brief 条目占用字节数（原始数据+压缩结果）
+     */
+    static size_t entry_bytes(const Entry& entry);
+
+    /**
+     * @brief 淘汰最久未使用的条目直到不超过容量（需持锁）
+     */
+    void evict_locked();
+
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;  // 头部为最近使用
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+    size_t capacity_bytes_;
+    size_t size_bytes_;
+    uint64_t hits_;
+    uint64_t misses_;
+};
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
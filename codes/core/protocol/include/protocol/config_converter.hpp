@@ -45,6 +45,36 @@ public:
     static void convert_tls_config(
         const config::Config& config,
         TlsConfig& dst);
+
+    /**
+     * @brief 为指定监听端口构造TlsConfig（端口配置tls_enabled=false时为明文模式，0-RTT按端口启用）
+     * @note TlsContextManager已为该端口构建上下文时一并填入TlsConfig::context
+     * @param config Config模块的主配置
+     * @param port 监听端口
+     * @param dst Protocol模块的TLS配置（输出）
+     */
+    static void convert_tls_config(
+        const config::Config& config,
+        uint16_t port,
+        TlsConfig& dst);
+
+    /**
+     * @brief 将ListenConfig中的压缩设置转换为CompressionConfig
+     * @param src Config模块的监听配置
+     * @param dst Protocol模块的压缩配置（输出）
+     */
+    static void convert_compression_config(
+        const config::ListenConfig& src,
+        CompressionConfig& dst);
+
+    /**
+     * @brief 将Http2Config中的流控设置转换为本端Http2Settings
+     * @param src Config模块的HTTP/2配置
+     * @param dst 本端SETTINGS参数（输出，仅覆盖初始窗口与最大并发流）
+     */
+    static void convert_http2_settings(
+        const config::Http2Config& src,
+        Http2Settings& dst);
 };
 
 } // namespace protocol
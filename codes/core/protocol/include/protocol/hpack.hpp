@@ -17,8 +17,8 @@
 //
 //  当前实现支持HPACK基础功能：
 //  - 完整支持静态表索引
-//  - 支持文字头域编码（无Huffman编码）
-//  - 支持基本的动态表大小更新框架
+//  - 支持动态表（环形数组存储，按RFC 7541 §4.4淘汰）及动态表大小更新
+//  - 支持Huffman编码（仅在比原文更短时采用）与解码
 //
 //  若未来需要完整HPACK功能，可按以下步骤重构：
 //  1. 包含nghttp2/nghttp2.h头文件
@@ -29,11 +29,6 @@
 //  6. encode()方法使用nghttp2_hd_deflate_deflate()
 //  7. decode()方法使用nghttp2_hd_inflate_hd()
 //  8. 正确管理动态表大小和状态
-//
-//  当前简化实现的限制：
-//  - 仅支持静态表索引，不支持动态表
-//  - 不支持Huffman编码
-//  - 不支持动态表大小更新的完整语义
 //  ============================================================================
 #pragma once
 
@@ -46,6 +41,105 @@
 namespace https_server_sim {
 namespace protocol {
 
+// ==================== HPACK头部字段 ====================
+struct HpackHeaderField {
+    std::string name;
+    std::string value;
+};
+
+// ==================== HPACK动态表 ====================
+// RFC 7541 §2.3.2：最新插入的条目索引为1；条目大小为name+value+32，
+// 超出最大容量时从最旧的条目开始淘汰。条目存放在容量为2的幂的环形数组中，
+// 插入与淘汰均不移动其他条目；名称及名称/值各有一组哈希链，查找为常数时间且不分配内存。
+class HpackDynamicTable {
+public:
+    static constexpr uint32_t ENTRY_OVERHEAD = 32;
+    static constexpr uint32_t DEFAULT_MAX_SIZE = 4096;
+
+    /**
+     * @brief 构造函数
+     */
+    HpackDynamicTable();
+
+    /**
+     * @brief 插入条目（先淘汰旧条目以腾出空间）
+     * @note 条目本身超过最大容量时清空动态表且不插入
+     * @param name 头部名称
+     * @param value 头部值
+     * @return true已插入，false条目过大
+     */
+    bool add(const std::string& name, const std::string& value);
+
+    /**
+     * @brief 按动态表索引获取条目
+     * @param index 动态表索引（1为最新条目）
+     * @return 条目指针，越界返回nullptr
+     */
+    const HpackHeaderField* get(uint32_t index) const;
+
+    /**
+     * @brief 查找条目
+     * @param name 头部名称
+     * @param value 头部值
+     * @param full_match 输出是否名称和值均匹配
+     * @return 动态表索引（优先完全匹配，其次最新的名称匹配），未找到返回0
+     */
+    uint32_t find(const std::string& name, const std::string& value, bool* full_match) const;
+
+    /**
+     * @brief 设置最大容量，超出部分立即淘汰
+     * @param size 最大容量（字节）
+     */
+    void set_max_size(uint32_t size);
+
+    /**
+     * @brief 获取最大容量
+     */
+    uint32_t get_max_size() const;
+
+    /**
+     * @brief 获取当前占用大小（按RFC 7541计算）
+     */
+    uint32_t get_size() const;
+
+    /**
+     * @brief 获取条目数
+     */
+    size_t get_count() const;
+
+    /**
+     * @brief 清空动态表
+     */
+    void clear();
+
+    /**
+     * @brief 计算条目大小
+     */
+    static uint32_t entry_size(const std::string& name, const std::string& value);
+
+private:
+    // 哈希链节点：链接值为序号+1（0表示链尾），小于等于最旧序号的链接视为已淘汰
+    struct Slot {
+        HpackHeaderField field;
+        uint32_t name_hash = 0;
+        uint32_t pair_hash = 0;
+        uint64_t prev_name = 0;
+        uint64_t prev_pair = 0;
+    };
+
+    void evict_oldest();
+    void grow();
+    void link(Slot* slot, uint64_t seq);
+
+    std::vector<Slot> ring_;              // 容量为2的幂
+    std::vector<uint64_t> name_heads_;    // 名称哈希桶，桶数与ring_容量相同
+    std::vector<uint64_t> pair_heads_;    // 名称/值哈希桶
+    uint64_t inserted_;                   // 累计插入数，最新条目位于ring_[(inserted_-1) & mask]
+    size_t count_;
+    uint32_t size_;
+    uint32_t max_size_;
+};
+
 // ==================== HPACK编码器类 ====================
 class HpackEncoder {
 public:
@@ -73,7 +167,8 @@ public:
                std::vector<uint8_t>* out);
 
     /**
-     * @brief 设置动态表最大大小
+     * @brief 设置动态表最大大小（对端SETTINGS_HEADER_TABLE_SIZE）
+     * @note 下一个头部块开头会发出动态表大小更新
      * @param size 大小
      */
     void set_max_dynamic_table_size(uint32_t size);
@@ -84,8 +179,17 @@ public:
      */
     uint32_t get_max_dynamic_table_size() const;
 
+    /**
+     * @brief 获取动态表
+     * @return 动态表引用
+     */
+    const HpackDynamicTable& get_dynamic_table() const;
+
 private:
     uint32_t max_dynamic_table_size_;
+    HpackDynamicTable dynamic_table_;
+    bool size_update_pending_;
+    uint32_t min_size_update_;  // 两个头部块之间出现过的最小表大小
 };
 
 // ==================== HPACK解码器类 ====================
@@ -116,7 +220,18 @@ public:
                std::map<std::string, std::string>* headers);
 
     /**
-     * @brief 设置动态表最大大小
+     * @brief 解码HPACK数据并追加到已有头部集合（同名字段覆盖，不清空输出）
+     * @param data 输入数据（完整头部块）
+     * @param len 数据长度
+     * @param headers 输出头部集合
+     * @return 0成功，负数失败
+     */
+    int decode_append(const uint8_t* data, size_t len,
+                      std::map<std::string, std::string>* headers);
+
+    /**
+     * @brief 设置动态表最大大小（本端通告的SETTINGS_HEADER_TABLE_SIZE）
+     * @note 对端通过动态表大小更新指令调整的大小不得超过该值
      * @param size 大小
      */
     void set_max_dynamic_table_size(uint32_t size);
@@ -127,8 +242,26 @@ public:
      */
     uint32_t get_max_dynamic_table_size() const;
 
+    /**
+     * @brief 获取动态表
+     * @return 动态表引用
+     */
+    const HpackDynamicTable& get_dynamic_table() const;
+
 private:
+    /**
+     * @brief 按HPACK索引（静态表+动态表）获取头部字段
+     * @param index 索引（从1开始）
+     * @param name 输出名称
+     * @param value 输出值（可为nullptr）
+     * @return 0成功，负数失败
+     */
+    int lookup(uint32_t index, std::string* name, std::string* value) const;
+
     uint32_t max_dynamic_table_size_;
+    HpackDynamicTable dynamic_table_;
+    std::string name_scratch_;     // 解码暂存，跨头部块复用容量
+    std::string value_scratch_;
 };
 
 // ==================== 简化的HPACK编码/解码函数 ====================
@@ -0,0 +1,61 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: hpack_huffman.hpp
+//  描述: HPACK Huffman编解码（RFC 7541 附录B）
+//  版权: Copyright (c) 2026
+// =============================================================================
+#pragma once
+
+#include "protocol/protocol_types.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace https_server_sim {
+namespace protocol {
+
+// ==================== Huffman码表项 ====================
+struct HuffmanCode {
+    uint32_t code;  // 码字（低bits位有效）
+    uint8_t bits;   // 码长
+};
+
+// EOS符号，仅用于填充，出现在编码数据中视为错误
+constexpr uint16_t HUFFMAN_EOS = 256;
+
+/**
+ * @brief 获取符号的Huffman码
+ * @param symbol 符号（0-255为字节，256为EOS）
+ * @return 码表项引用
+ */
+const HuffmanCode& huffman_code(uint16_t symbol);
+
+/**
+ * @brief 计算Huffman编码后的字节数
+ * @param data 输入数据
+ * @param len 输入长度
+ * @return 编码后字节数（含填充）
+ */
+size_t huffman_encoded_length(const uint8_t* data, size_t len);
+
+/**
+ * @brief Huffman编码（按码表逐字节查表）
+ * @param data 输入数据
+ * @param len 输入长度
+ * @param out 输出缓冲区，编码结果追加在末尾
+ */
+void huffman_encode(const uint8_t* data, size_t len, std::vector<uint8_t>* out);
+
+/**
+ * @brief Huffman解码（编译期生成的状态机，每次消费4位）
+ * @param data 输入数据
+ * @param len 输入长度
+ * @param out 输出解码结果
+ * @return 0成功，负数失败（含EOS、填充超过7位或填充不全为1）
+ */
+int huffman_decode(const uint8_t* data, size_t len, std::string* out);
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
@@ -0,0 +1,95 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: http2_bdp_estimator.hpp
+//  描述: Http2BdpEstimator类定义 - 基于PING往返时间的带宽时延积估计
+//  版权: Copyright (c) 2026
+// =============================================================================
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace https_server_sim {
+namespace protocol {
+
+// 服务端BDP探测PING的负载（对端原样回送，用于区分对端自己发起的PING）
+constexpr uint8_t HTTP2_BDP_PING_DATA[8] = {'b', 'd', 'p', '-', 'p', 'i', 'n', 'g'};
+// BDP探测可把接收窗口放大到的默认上限
+constexpr uint32_t HTTP2_DEFAULT_MAX_RECEIVE_WINDOW = 16 * 1024 * 1024;
+
+// ==================== HTTP/2 BDP估计器 ====================
+// 收到DATA时若没有在途探测则发起一次PING，统计PING发出到ACK返回期间收到的字节数
+// 作为一个RTT内的到达量。到达量接近当前窗口（说明窗口成为瓶颈）且带宽不低于历史
+// 最大值时，把窗口放大为到达量的2倍，直到上限。窗口只增不减。
+class Http2BdpEstimator {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief 默认构造函数（未init前不发起探测）
+     */
+    Http2BdpEstimator();
+
+    /**
+     * @brief 设置初始窗口与上限，清空测量状态
+     * @param window 当前接收窗口
+     * @param max_window 窗口上限（不大于window时不发起探测）
+     */
+    void init(uint32_t window, uint32_t max_window);
+
+    /**
+     * @brief 统计收到的DATA负载
+     * @param bytes 负载字节数（含填充）
+     * @return true表示应立即发送一次探测PING（随后调用ping_sent）
+     */
+    bool add_bytes(size_t bytes);
+
+    /**
+     * @brief 记录探测PING已发出
+     * @param now 发出时间
+     */
+    void ping_sent(Clock::time_point now);
+
+    /**
+     * @brief 处理探测PING的ACK，更新RTT与带宽并决定是否放大窗口
+     * @param now ACK到达时间
+     * @return 新窗口大小；不需要调整返回0
+     */
+    uint32_t ping_acked(Clock::time_point now);
+
+    /**
+     * @brief 是否有已发出但未确认的探测PING
+     */
+    bool ping_pending() const { return state_ == State::PENDING; }
+
+    /**
+     * @brief 获取当前窗口估计值
+     */
+    uint32_t window() const { return window_; }
+
+    /**
+     * @brief 获取平滑后的RTT（秒），尚无样本时为0
+     */
+    double rtt() const { return rtt_; }
+
+private:
+    enum class State {
+        IDLE,       // 没有在途探测，下一个DATA触发PING
+        SCHEDULED,  // 已要求发送PING，尚未调用ping_sent
+        PENDING     // PING已发出，等待ACK
+    };
+
+    State state_;
+    uint32_t window_;
+    uint32_t max_window_;
+    uint64_t sample_;              // 本次探测期间收到的字节数
+    Clock::time_point sent_at_;
+    double rtt_;
+    double max_bandwidth_;         // 历史最大带宽（字节/秒）
+};
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
@@ -8,14 +8,30 @@
 
 #include "protocol/protocol_types.hpp"
 #include "protocol/http_message.hpp"
+#include "protocol/compression.hpp"
 #include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace https_server_sim {
 namespace protocol {
 
+/**
+ * @brief 解析RFC 9218 Priority字段（如"u=1, i"）
+ * @note 无法识别的参数与越界的紧急度被忽略，对应输出保持不变
+ * @param value 字段值（priority头部或PRIORITY_UPDATE帧内容）
+ * @param urgency 输入/输出紧急度（0-7）
+ * @param incremental 输入/输出是否增量发送
+ */
+void parse_priority_field(const std::string& value, uint8_t* urgency, bool* incremental);
+
 // ==================== HTTP/2流类 ====================
 class Http2Stream {
 public:
+    static constexpr size_t POOLED_BUFFER_LIMIT = 64 * 1024;  // reset()时保留的缓冲区容量上限
+
     /**
      * @brief 默认构造函数
      */
@@ -33,7 +49,7 @@ public:
     void init(uint32_t stream_id);
 
     /**
-     * @brief 重置流到初始状态
+     * @brief 重置流到初始状态（超过POOLED_BUFFER_LIMIT的缓冲区会被释放）
      */
     void reset();
 
@@ -44,6 +60,55 @@ public:
     HttpResponse response;
     int32_t send_window;
     int32_t recv_window;
+    uint32_t recv_consumed;             // 已消费但尚未通过WINDOW_UPDATE归还的字节数
+    std::vector<uint8_t> pending_data;  // 发送窗口不足时排队的DATA
+    CompressionCache::Body pending_shared;  // 排队的共享响应体（非空时代替pending_data，不复制）
+    size_t pending_offset;              // 排队数据中已发出的字节数
+    bool pending_end_stream;            // END_STREAM尚未发出（排队数据发完后结束流）
+    uint8_t urgency;                    // RFC 9218紧急度，0最高
+    bool incremental;                   // 是否与同紧急度的流交错发送
+    bool awaiting_response;             // 请求已分发，响应尚未生成
+};
+
+// ==================== HTTP/2流响应 ====================
+// 工作线程为单个流生成的响应，回到连接所属IO线程后按stream_id发送
+struct Http2StreamResponse {
+    uint32_t stream_id;
+    uint64_t generation;                        // 分发时连接的代数，连接重置后的旧响应被丢弃
+    std::map<std::string, std::string> headers;
+    std::vector<uint8_t> body;
+    CompressionCache::Body shared_body;         // 压缩缓存共享的响应体（非空时代替body发送）
+
+    Http2StreamResponse()
+        : stream_id(0)
+        , generation(0)
+        , headers()
+        , body()
+        , shared_body()
+    {
+    }
+};
+
+// ==================== HTTP/2响应完成队列 ====================
+// 工作线程写入、IO线程批量取出。连接与在途任务共享所有权，
+// 连接先于任务销毁时结果留在队列中随最后一个引用释放
+class Http2CompletionQueue {
+public:
+    /**
+     * @brief 投递一个已完成的响应（工作线程调用）
+     * @param response 响应
+     */
+    void push(Http2StreamResponse&& response);
+
+    /**
+     * @brief 取出全部已完成的响应（IO线程调用）
+     * @param out 输出数组，调用前应为空，与内部数组交换以复用容量
+     */
+    void drain(std::vector<Http2StreamResponse>* out);
+
+private:
+    std::mutex mutex_;
+    std::vector<Http2StreamResponse> responses_;
 };
 
 } // namespace protocol
@@ -0,0 +1,129 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: http2_stream_table.hpp
+//  描述: Http2StreamTable类定义 - 按最大并发流定长的开放寻址流表（带对象池）
+//  版权: Copyright (c) 2026
+// =============================================================================
+#pragma once
+
+#include "protocol/http2_stream.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace https_server_sim {
+namespace protocol {
+
+// 单连接流表可跟踪的最大流数（SETTINGS_MAX_CONCURRENT_STREAMS配置过大时截断）
+constexpr uint32_t HTTP2_MAX_TRACKED_STREAMS = 4096;
+
+// ==================== HTTP/2流表 ====================
+// 线性探测的开放寻址表，槽位数为容量的2倍以上（2的幂），删除采用后移法不留墓碑。
+// 流对象来自表内对象池，删除时reset()后放回池中复用，连接生命周期内对象数不超过容量。
+class Http2StreamTable {
+public:
+    /**
+     * @brief 默认构造函数（容量为HTTP2_DEFAULT_MAX_CONCURRENT_STREAMS）
+     */
+    Http2StreamTable();
+
+    /**
+     * @brief 析构函数
+     */
+    ~Http2StreamTable();
+
+    // 禁止拷贝
+    Http2StreamTable(const Http2StreamTable&) = delete;
+    Http2StreamTable& operator=(const Http2StreamTable&) = delete;
+
+    /**
+     * @brief 按最大并发流数重建流表，清空所有流
+     * @param max_streams 最大并发流数（超过HTTP2_MAX_TRACKED_STREAMS时截断）
+     */
+    void init(uint32_t max_streams);
+
+    /**
+     * @brief 查找流
+     * @param stream_id 流ID
+     * @return 流指针，不存在返回nullptr
+     */
+    Http2Stream* find(uint32_t stream_id) const;
+
+    /**
+     * @brief 从对象池取出流并插入
+     * @param stream_id 流ID（非0）
+     * @return 已init的流指针；流已存在或表已满返回nullptr
+     */
+    Http2Stream* insert(uint32_t stream_id);
+
+    /**
+     * @brief 删除流，对象reset()后放回对象池
+     * @param stream_id 流ID
+     */
+    void erase(uint32_t stream_id);
+
+    /**
+     * @brief 删除所有流（对象全部放回对象池）
+     */
+    void clear();
+
+    /**
+     * @brief 获取当前流数量
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @brief 获取容量（最大流数量）
+     */
+    size_t capacity() const { return max_streams_; }
+
+    /**
+     * @brief 获取对象池中已分配的流对象总数
+     */
+    size_t allocated() const { return pool_.size(); }
+
+    /**
+     * @brief 遍历所有流（遍历过程中不能增删）
+     * @param fn 回调，参数为Http2Stream*
+     */
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (const Slot& slot : slots_) {
+            if (slot.stream != nullptr) {
+                fn(slot.stream);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        uint32_t stream_id;
+        Http2Stream* stream;   // nullptr表示空槽
+    };
+
+    /**
+     * @brief 计算流ID的起始槽位（客户端流ID为连续奇数，右移一位后天然分散）
+     */
+    size_t home_slot(uint32_t stream_id) const {
+        return static_cast<size_t>(stream_id >> 1) & mask_;
+    }
+
+    /**
+     * @brief 查找流所在槽位
+     * @return 槽位下标，不存在返回slots_.size()
+     */
+    size_t find_slot(uint32_t stream_id) const;
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    size_t size_;
+    uint32_t max_streams_;
+    std::vector<std::unique_ptr<Http2Stream>> pool_;  // 已分配的全部流对象
+    std::vector<Http2Stream*> free_;                  // 空闲流对象
+};
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
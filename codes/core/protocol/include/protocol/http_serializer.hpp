@@ -0,0 +1,76 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: http_serializer.hpp
+//  描述: HttpSerializer类定义 - HTTP/1.1响应直写序列化器
+//  版权: Copyright (c) 2026
+// =============================================================================
+#pragma once
+
+#include "protocol/protocol_types.hpp"
+#include "protocol/http_message.hpp"
+#include "utils/buffer.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace https_server_sim {
+namespace protocol {
+
+// ==================== HTTP/1.1响应序列化器 ====================
+// 先精确计算头部长度，再对目标Buffer做一次reserve/commit直接写入，
+// 序列化过程中不产生任何堆分配（不构造std::string，数字使用std::to_chars）。
+class HttpSerializer {
+public:
+    /**
+     * @brief 计算状态行+头部+空行序列化后的精确长度
+     * @param resp 响应对象
+     * @param body_len 响应体长度（用于自动补充Content-Length）
+     * @return 头部字节数
+     */
+    static size_t header_size(const HttpResponse& resp, size_t body_len);
+
+    /**
+     * @brief 将状态行+头部+空行写入调用方提供的内存
+     * @param resp 响应对象
+     * @param body_len 响应体长度（用于自动补充Content-Length）
+     * @param out 输出地址，调用方保证至少有header_size()字节可写
+     * @return 实际写入字节数
+     */
+    static size_t write_header(const HttpResponse& resp, size_t body_len, uint8_t* out);
+
+    /**
+     * @brief 序列化响应到Buffer（一次reserve/commit）
+     * @param resp 响应对象
+     * @param out 输出缓冲区，数据追加在已有可读数据之后
+     * @param include_body 是否将响应体一并写入（大响应体应走分散写）
+     * @return 0成功，负数失败
+     */
+    static int serialize(const HttpResponse& resp, utils::Buffer* out, bool include_body);
+
+    /**
+     * @brief 序列化响应到Buffer，响应体由调用方提供（如缓存的压缩结果）
+     * @param resp 响应对象（其body字段被忽略）
+     * @param body 响应体指针
+     * @param body_len 响应体长度
+     * @param out 输出缓冲区，数据追加在已有可读数据之后
+     * @param include_body 是否将响应体一并写入
+     * @return 0成功，负数失败
+     */
+    static int serialize(const HttpResponse& resp, const uint8_t* body, size_t body_len,
+                         utils::Buffer* out, bool include_body);
+
+    /**
+     * @brief 获取预生成的状态行
+     * @param status_code 状态码
+     * @param status_text 原因短语，与标准短语不一致时返回nullptr
+     * @param out_len 输出状态行长度（含\r\n）
+     * @return 状态行指针，未命中返回nullptr
+     */
+    static const char* find_status_line(int status_code,
+                                        const std::string& status_text,
+                                        size_t* out_len);
+};
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
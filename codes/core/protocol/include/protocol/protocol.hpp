@@ -10,8 +10,16 @@
 #include "protocol/protocol_utils.hpp"
 #include "protocol/http_message.hpp"
 #include "protocol/http_parser.hpp"
+#include "protocol/http_serializer.hpp"
+#include "protocol/response_template.hpp"
+#include "protocol/compression.hpp"
 #include "protocol/http2_stream.hpp"
+#include "protocol/http2_stream_table.hpp"
+#include "protocol/http2_bdp_estimator.hpp"
 #include "protocol/hpack.hpp"
+#include "protocol/hpack_huffman.hpp"
+#include "protocol/tls_context.hpp"
+#include "protocol/tls_session_cache.hpp"
 #include "protocol/tls_handler.hpp"
 #include "protocol/protocol_handler.hpp"
 #include "protocol/protocol_factory.hpp"
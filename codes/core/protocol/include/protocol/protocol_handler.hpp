@@ -9,7 +9,12 @@
 #include "protocol/protocol_types.hpp"
 #include "protocol/http_message.hpp"
 #include "protocol/http_parser.hpp"
+#include "protocol/http_serializer.hpp"
+#include "protocol/compression.hpp"
+#include "protocol/response_template.hpp"
 #include "protocol/http2_stream.hpp"
+#include "protocol/http2_stream_table.hpp"
+#include "protocol/http2_bdp_estimator.hpp"
 #include "protocol/hpack.hpp"
 #include "protocol/tls_handler.hpp"
 #include "utils/buffer.hpp"
@@ -25,6 +30,10 @@ class Connection;
 
 namespace protocol {
 
+namespace details {
+struct TlsHandshakeJob;
+}
+
 // ==================== 协议处理器接口 ====================
 class ProtocolHandler {
 public:
@@ -85,6 +94,12 @@ public:
      * @brief 重置协议处理器状态
      */
     virtual void reset() = 0;
+
+    /**
+     * @brief 处理回调完成事件（工作线程处理完请求后，在连接所属IO线程调用）
+     * @return 0成功，负数失败
+     */
+    virtual int on_callback_done() { return PROTOCOL_OK; }
 };
 
 // ==================== HTTP/1.1协议处理器 ====================
@@ -146,13 +161,65 @@ public:
      */
     void reset() override;
 
+    /**
+     * @brief 以文件内容作为响应体发送（静态或预生成的响应体）
+     * @note 状态码与头部取自当前响应对象；kTLS启用时响应体经sendfile零拷贝发送。
+     *       返回-EAGAIN时已发送进度保留，由on_write继续发送，期间file_fd须保持打开；
+     *       上一个文件响应未发完时返回-EAGAIN。请求处理流程不会调用此接口，
+     *       由嵌入方在拿到响应文件时直接调用
+     * @param file_fd 文件描述符
+     * @param offset 文件偏移
+     * @param len 响应体长度
+     * @return 0成功，-EAGAIN需要等待可写，负数失败
+     */
+    int send_file_response(int file_fd, int64_t offset, size_t len);
+
+    /**
+     * @brief 设置响应压缩配置（按监听端口）
+     * @param config 压缩配置
+     */
+    void set_compression_config(const CompressionConfig& config);
+
+    /**
+     * @brief 接管已完成握手的TLS处理器并绑定连接（协议协商完成后由NegotiatingHandler调用）
+     * @param conn 连接
+     * @param tls_handler 已初始化的TLS处理器（连接状态保留，不重新握手）
+     * @return 0成功，负数失败
+     */
+    int attach(Connection* conn, std::unique_ptr<TlsHandler> tls_handler);
+
 private:
+    /**
+     * @brief 绑定连接缓冲区并初始化协议状态（init与attach共用）
+     * @param conn 连接
+     * @return 0成功，负数失败
+     */
+    int bind_connection(Connection* conn);
+
     /**
      * @brief 解析请求体
      * @return 0成功，负数失败
      */
     int parse_body();
 
+    /**
+     * @brief 依次处理明文缓冲区中所有完整的请求
+     * @return 0成功（数据不足时也返回0），负数失败
+     */
+    int process_requests();
+
+    /**
+     * @brief 将排队的响应一次性写入TLS层
+     * @return 0成功，负数失败
+     */
+    int flush_responses();
+
+    /**
+     * @brief 继续发送未发完的文件响应体
+     * @return 0已发完（或无待发文件），-EAGAIN需要等待可写，负数失败
+     */
+    int continue_file_response();
+
     /**
      * @brief 处理完整请求
      * @return 0成功，负数失败
@@ -165,6 +232,19 @@ private:
      */
     int generate_response();
 
+    /**
+     * @brief 查找当前端口指定状态码的响应模板（按注册表版本缓存）
+     * @param status_code 状态码
+     * @return 模板指针，未注册返回nullptr
+     */
+    const ResponseTemplate* find_response_template(int status_code);
+
+    /**
+     * @brief 按Accept-Encoding压缩当前响应体（结果来自压缩缓存）
+     * @param accept_encoding 请求的Accept-Encoding头部值
+     */
+    void apply_compression(const std::string& accept_encoding);
+
     Connection* conn_;
     std::unique_ptr<TlsHandler> tls_handler_;
     Http1ParseState state_;
@@ -173,7 +253,19 @@ private:
     utils::Buffer* read_buffer_;
     utils::Buffer* write_buffer_;
     std::unique_ptr<utils::Buffer> plaintext_buffer_;
+    std::unique_ptr<utils::Buffer> response_buffer_;  // 待发送响应队列（跨请求复用）
     HttpParser parser_;
+    bool batching_;                                    // 为true时响应仅排队，由on_read统一写出
+    const ResponseTemplate* response_template_;        // 当前响应使用的模板（nullptr走通用序列化）
+    std::shared_ptr<const ResponseTemplate> cached_template_;
+    int cached_template_status_;
+    uint64_t cached_template_version_;
+    CompressionConfig compression_;
+    CompressionCache::Body compressed_body_;           // 当前响应的压缩体（为空时发送原始响应体）
+    ContentEncoding response_encoding_;
+    int file_fd_;                                      // 待续发的文件响应体（file_remaining_为0时无效）
+    int64_t file_offset_;
+    size_t file_remaining_;
 };
 
 // ==================== HTTP/2协议处理器 ====================
@@ -235,7 +327,60 @@ public:
      */
     void reset() override;
 
+    /**
+     * @brief 设置响应压缩配置（按监听端口）
+     * @param config 压缩配置
+     */
+    void set_compression_config(const CompressionConfig& config);
+
+    /**
+     * @brief 设置本端SETTINGS参数（初始窗口、最大并发流等），需在init前调用
+     * @param settings 本端SETTINGS参数
+     */
+    void set_local_settings(const Http2Settings& settings);
+
+    /**
+     * @brief 设置BDP探测可放大到的接收窗口上限，需在init前调用
+     * @param max_window 窗口上限（不大于初始窗口时关闭BDP探测）
+     */
+    void set_max_receive_window(uint32_t max_window);
+
+    /**
+     * @brief 发送指定流的响应数据（结束该流）
+     * @param stream_id 流ID
+     * @param data 数据
+     * @param len 数据长度
+     * @return 0成功，流不存在返回PROTOCOL_ERROR_INVALID
+     */
+    int send_response(uint32_t stream_id, const uint8_t* data, uint32_t len);
+
+    /**
+     * @brief 按流ID发送工作线程已完成的响应（完成顺序可与请求顺序不同）
+     */
+    int on_callback_done() override;
+
+    /**
+     * @brief 设置请求分发器，每个完整的流作为独立任务分发
+     * @param dispatcher 分发器（如包装WorkerPool::post_task），为空时在IO线程内同步处理
+     */
+    void set_task_dispatcher(TaskDispatcher dispatcher);
+
+    /**
+     * @brief 接管已完成握手的TLS处理器并绑定连接（协议协商完成后由NegotiatingHandler调用）
+     * @param conn 连接
+     * @param tls_handler 已初始化的TLS处理器（连接状态保留，不重新握手）
+     * @return 0成功，负数失败
+     */
+    int attach(Connection* conn, std::unique_ptr<TlsHandler> tls_handler);
+
 private:
+    /**
+     * @brief 绑定连接缓冲区并初始化协议状态（init与attach共用）
+     * @param conn 连接
+     * @return 0成功，负数失败
+     */
+    int bind_connection(Connection* conn);
+
     /**
      * @brief 读取HTTP/2帧
      * @return 0成功，-EAGAIN需要更多数据，负数失败
@@ -254,9 +399,10 @@ private:
      * @brief 处理SETTINGS帧
      * @param payload 帧数据
      * @param len 数据长度
+     * @param flags 帧标志
      * @return 0成功，负数失败
      */
-    int handle_settings_frame(const uint8_t* payload, size_t len);
+    int handle_settings_frame(const uint8_t* payload, size_t len, uint8_t flags);
 
     /**
      * @brief 处理HEADERS帧
@@ -269,6 +415,17 @@ private:
     int handle_headers_frame(uint32_t stream_id, const uint8_t* payload,
                              size_t len, uint8_t flags);
 
+    /**
+     * @brief 解码完整头部块到流的请求头部，必要时创建流或拒绝流
+     * @param stream_id 流ID
+     * @param block 头部块（已去掉填充与优先级字段）
+     * @param len 头部块长度
+     * @param end_stream HEADERS帧是否带END_STREAM
+     * @return 0成功，负数失败
+     */
+    int process_header_block(uint32_t stream_id, const uint8_t* block,
+                             size_t len, bool end_stream);
+
     /**
      * @brief 处理DATA帧
      * @param stream_id 流ID
@@ -308,12 +465,26 @@ private:
     int handle_rst_stream_frame(uint32_t stream_id, uint32_t error_code);
 
     /**
-     * @brief 处理PING帧
+     * @brief 处理PING帧：对端PING回送ACK，BDP探测的ACK用于估计窗口
      * @param payload 帧数据
      * @param len 数据长度
+     * @param flags 帧标志
      * @return 0成功，负数失败
      */
-    int handle_ping_frame(const uint8_t* payload, size_t len);
+    int handle_ping_frame(const uint8_t* payload, size_t len, uint8_t flags);
+
+    /**
+     * @brief 发送BDP探测PING
+     * @return 0成功，负数失败
+     */
+    int send_bdp_ping();
+
+    /**
+     * @brief 放大本端接收窗口：SETTINGS通告新的流初始窗口，WINDOW_UPDATE放大连接窗口
+     * @param window 新窗口大小（大于当前窗口）
+     * @return 0成功，负数失败
+     */
+    int grow_receive_window(uint32_t window);
 
     /**
      * @brief 处理GOAWAY帧
@@ -323,6 +494,14 @@ private:
      */
     int handle_goaway_frame(const uint8_t* payload, size_t len);
 
+    /**
+     * @brief 处理PRIORITY_UPDATE帧（RFC 9218）
+     * @param payload 帧数据
+     * @param len 数据长度
+     * @return 0成功，负数失败
+     */
+    int handle_priority_update_frame(const uint8_t* payload, size_t len);
+
     /**
      * @brief 发送SETTINGS帧
      * @return 0成功，负数失败
@@ -357,6 +536,44 @@ private:
     int send_data_frame(uint32_t stream_id, const uint8_t* data,
                         size_t len, bool end_stream);
 
+    /**
+     * @brief 发送共享响应体（压缩缓存结果），按引用排队，分帧时直接从中拷贝到输出批次
+     * @param stream_id 流ID
+     * @param body 共享响应体
+     * @param end_stream 是否结束流
+     * @return 0成功，负数失败
+     */
+    int send_shared_data_frame(uint32_t stream_id, const CompressionCache::Body& body,
+                               bool end_stream);
+
+    /**
+     * @brief 从流的发送队列取出一个DATA帧追加到帧批次（受窗口与max_frame_size限制）
+     * @param stream 流对象
+     * @param emitted 输出是否产生了帧
+     * @return 0成功，负数失败
+     */
+    int emit_data_frame(Http2Stream* stream, bool* emitted);
+
+    /**
+     * @brief DATA帧调度：按RFC 9218紧急度从高到低发送各流排队数据，
+     *        同紧急度下非增量流按流ID逐个发完，增量流每轮一帧轮转
+     * @return 0成功，负数失败
+     */
+    int flush_pending_data();
+
+    /**
+     * @brief 将连接输出缓冲中的全部帧一次性交给TLS层写出
+     * @note TLS层尚不可写（握手未完成）时帧保留在缓冲中；写失败时未写出的部分同样保留
+     * @return 0成功，负数失败
+     */
+    int flush_frame_batch();
+
+    /**
+     * @brief 连接级已消费字节达到阈值时发送WINDOW_UPDATE归还窗口
+     * @return 0成功，负数失败
+     */
+    int replenish_connection_window();
+
     /**
      * @brief 发送WINDOW_UPDATE帧
      * @param stream_id 流ID
@@ -374,7 +591,7 @@ private:
     int send_rst_stream_frame(uint32_t stream_id, uint32_t error_code);
 
     /**
-     * @brief 写入HTTP/2帧
+     * @brief 写入HTTP/2帧（追加到连接输出缓冲，本轮读/分发结束或超过阈值时写出）
      * @param type 帧类型
      * @param stream_id 流ID
      * @param flags 帧标志
@@ -386,14 +603,30 @@ private:
                     uint8_t flags, const uint8_t* payload, size_t len);
 
     /**
-     * @brief 获取或创建流
+     * @brief 向连接输出缓冲追加9字节帧头
+     * @param type 帧类型
      * @param stream_id 流ID
-     * @return Http2Stream指针
+     * @param flags 帧标志
+     * @param len 载荷长度
      */
-    Http2Stream* get_or_create_stream(uint32_t stream_id);
+    void append_frame_header(Http2FrameType type, uint32_t stream_id,
+                             uint8_t flags, size_t len);
 
     /**
-     * @brief 处理完整请求
+     * @brief 从流表对象池创建流，并按双方SETTINGS设置初始窗口
+     * @param stream_id 流ID
+     * @return Http2Stream指针，流表已满（超出并发限制）返回nullptr
+     */
+    Http2Stream* create_stream(uint32_t stream_id);
+
+    /**
+     * @brief 关闭流：从流表删除，对象reset后回到对象池（排队数据一并丢弃）
+     * @param stream 流对象，调用后不能再访问其内容
+     */
+    void close_stream(Http2Stream* stream);
+
+    /**
+     * @brief 处理完整请求：打包请求交给分发器，响应经完成队列回到on_callback_done
      * @param stream 流对象
      * @return 0成功，负数失败
      */
@@ -401,17 +634,190 @@ private:
 
     Connection* conn_;
     std::unique_ptr<TlsHandler> tls_handler_;
-    std::map<uint32_t, std::unique_ptr<Http2Stream>> streams_;
+    Http2StreamTable streams_;      // 按max_concurrent_streams定长，关闭的流立即回收
     utils::Buffer* read_buffer_;
     utils::Buffer* write_buffer_;
     std::unique_ptr<utils::Buffer> plaintext_buffer_;
     Http2Settings settings_;
     Http2Settings local_settings_;
     uint32_t last_stream_id_;
+    bool preface_received_;         // 已收到并校验客户端连接前言
+    std::vector<uint8_t> header_block_;  // 跨CONTINUATION的头部块片段（同一时刻只有一个）
+    uint32_t continuation_stream_id_;   // 等待CONTINUATION的流，0表示没有未结束的头部块
+    bool header_end_stream_;            // 未结束头部块所属HEADERS帧的END_STREAM
+    HttpHeaders discarded_headers_;     // 被拒绝流的头部解码目标（仅为同步HPACK状态）
     std::unique_ptr<HpackEncoder> hpack_encoder_;
     std::unique_ptr<HpackDecoder> hpack_decoder_;
     bool settings_ack_received_;
     bool settings_ack_sent_;
+    CompressionConfig compression_;
+    int32_t conn_send_window_;      // 连接级发送窗口（只受WINDOW_UPDATE影响）
+    int32_t conn_recv_window_;      // 连接级接收窗口
+    uint32_t conn_recv_consumed_;   // 连接级已消费但尚未归还的字节数
+    Http2BdpEstimator bdp_;         // 按PING往返估计BDP，驱动接收窗口增长
+    uint32_t max_receive_window_;   // BDP探测的窗口上限
+    std::vector<Http2Stream*> ready_[HTTP2_URGENCY_LEVELS];  // 调度时按紧急度分桶的就绪流
+    uint32_t rr_last_stream_id_;    // 增量流轮转的上一个流，下一次调度从其后开始
+    std::vector<uint8_t> frame_batch_;  // 连接输出缓冲：本轮读/分发周期内待合并写出的帧
+    TaskDispatcher dispatcher_;
+    std::shared_ptr<Http2CompletionQueue> completions_;  // 与在途任务共享
+    std::vector<Http2StreamResponse> completed_;         // on_callback_done取出的响应（复用容量）
+    uint64_t dispatch_generation_;  // reset()时递增，用于丢弃重置前分发的请求的响应
+};
+
+// ==================== 协议协商处理器 ====================
+// 连接建立时协议尚未确定：TLS端口在握手完成后按ALPN结果选择HTTP/2或HTTP/1.1，
+// 明文端口在允许h2c时按客户端前言（先验知识）选择。选定后TLS处理器移交给
+// 具体处理器，之后的调用全部转发。
+// 设置握手分发器后，握手在握手线程上推进：TLS处理器连同已收到的密文移入任务，
+// 完成后在on_callback_done中收回，期间IO线程不触碰TLS状态。
+// 接受了0-RTT早期数据且ALPN为HTTP/1.1时不等握手完成即选定处理器，早期数据中的
+// 可重放请求在握手完成前就能得到响应。
+class NegotiatingHandler : public ProtocolHandler {
+public:
+    /**
+     * @brief 默认构造函数
+     */
+    NegotiatingHandler();
+
+    /**
+     * @brief 析构函数
+     */
+    ~NegotiatingHandler() override;
+
+    // 禁止拷贝
+    NegotiatingHandler(const NegotiatingHandler&) = delete;
+    NegotiatingHandler& operator=(const NegotiatingHandler&) = delete;
+
+    /**
+     * @brief 初始化TLS处理器（协议在握手完成后选择）
+     */
+    int init(Connection* conn,
+             const CertConfig& cert_config,
+             const TlsConfig& tls_config) override;
+
+    /**
+     * @brief 处理读事件：推进握手，协议确定后转发给选定的处理器
+     */
+    int on_read() override;
+
+    /**
+     * @brief 处理写事件
+     */
+    int on_write() override;
+
+    /**
+     * @brief 发送响应数据（协议未确定时失败）
+     */
+    int send_response(const uint8_t* data, uint32_t len) override;
+
+    /**
+     * @brief 关闭处理器
+     */
+    void close() override;
+
+    /**
+     * @brief 获取TLS处理器（协议确定后为选定处理器持有的同一对象）
+     */
+    TlsHandler* get_tls_handler() override;
+
+    /**
+     * @brief 获取协议类型
+     * @return 协议确定前为UNKNOWN
+     */
+    ProtocolType get_protocol_type() const override;
+
+    /**
+     * @brief 重置状态
+     */
+    void reset() override;
+
+    /**
+     * @brief 处理回调完成事件：收回已完成的握手任务，协议确定后转发给选定的处理器
+     */
+    int on_callback_done() override;
+
+    /**
+     * @brief 设置响应压缩配置（传给选定的处理器）
+     * @param config 压缩配置
+     */
+    void set_compression_config(const CompressionConfig& config);
+
+    /**
+     * @brief 设置HTTP/2本端SETTINGS参数（选定HTTP/2时使用）
+     * @param settings 本端SETTINGS参数
+     */
+    void set_local_settings(const Http2Settings& settings);
+
+    /**
+     * @brief 设置HTTP/2接收窗口上限（选定HTTP/2时使用）
+     * @param max_window BDP探测可放大到的窗口上限
+     */
+    void set_max_receive_window(uint32_t max_window);
+
+    /**
+     * @brief 设置明文端口是否接受h2c先验知识连接
+     * @param allow true时以客户端前言开头的明文连接使用HTTP/2
+     */
+    void set_allow_h2c(bool allow);
+
+    /**
+     * @brief 设置请求分发器（选定HTTP/2时使用）
+     * @param dispatcher 分发器
+     */
+    void set_task_dispatcher(TaskDispatcher dispatcher);
+
+    /**
+     * @brief 设置握手分发器
+     * @param dispatcher 分发器（如包装MsgCenter::post_handshake_task），为空时在IO线程内同步握手
+     */
+    void set_handshake_dispatcher(TaskDispatcher dispatcher);
+
+    /**
+     * @brief 是否有握手任务在握手线程上执行
+     */
+    bool is_handshake_in_flight() const;
+
+    /**
+     * @brief 获取已选定的协议处理器
+     * @return 协议未确定返回nullptr
+     */
+    ProtocolHandler* get_selected_handler() const;
+
+private:
+    /**
+     * @brief 根据ALPN结果或h2c前言创建具体处理器并移交TLS处理器
+     * @return 0成功，-EAGAIN需要更多数据才能判断，负数失败
+     */
+    int select_protocol();
+
+    /**
+     * @brief 握手未完成时能否按早期数据提前选定协议（仅HTTP/1.1）
+     */
+    bool can_select_early() const;
+
+    /**
+     * @brief 把TLS处理器与连接读缓冲区中的密文移入握手任务并分发
+     * @return 0成功（含暂无数据可处理），负数失败
+     */
+    int start_handshake_job();
+
+    /**
+     * @brief 收回已完成的握手任务：归还TLS处理器，写出握手数据，继续握手或选择协议
+     * @return 0成功，负数失败
+     */
+    int finish_handshake_job();
+
+    Connection* conn_;
+    std::unique_ptr<TlsHandler> tls_handler_;      // 协议确定后移交给selected_
+    std::unique_ptr<ProtocolHandler> selected_;
+    CompressionConfig compression_;
+    Http2Settings http2_settings_;
+    uint32_t max_receive_window_;
+    bool allow_h2c_;
+    TaskDispatcher dispatcher_;
+    TaskDispatcher handshake_dispatcher_;
+    std::shared_ptr<details::TlsHandshakeJob> handshake_job_;  // 在途握手，为空表示TLS处理器在本对象上
 };
 
 } // namespace protocol
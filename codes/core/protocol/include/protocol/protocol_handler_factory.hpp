@@ -6,11 +6,12 @@
 // =============================================================================
 #pragma once
 
+#include <cstdint>
 #include <memory>
 
 namespace https_server_sim {
 namespace config { class Config; }
-namespace protocol { class ProtocolHandler; }
+namespace protocol { class ProtocolHandler; struct CompressionConfig; }
 }
 
 namespace https_server_sim {
@@ -25,10 +26,31 @@ class ProtocolHandlerFactory {
 public:
     /**
      * @brief 创建ProtocolHandler实例
-     * @param config 配置引用，用于决定创建Http1Handler还是Http2Handler
+     * @note HTTP/2启用时返回NegotiatingHandler，握手完成后按ALPN（明文端口按h2c前言）
+     *       选择Http2Handler或Http1Handler；HTTP/2禁用时直接返回Http1Handler
+     * @param config 配置引用
      * @return unique_ptr<ProtocolHandler>，失败返回nullptr
      */
     static std::unique_ptr<ProtocolHandler> create(const config::Config& config);
+
+    /**
+     * @brief 为指定监听端口创建ProtocolHandler实例
+     * @note 应用该端口的响应压缩配置；端口未配置时与create(config)相同
+     * @param config 配置引用
+     * @param port 监听端口
+     * @return unique_ptr<ProtocolHandler>，失败返回nullptr
+     */
+    static std::unique_ptr<ProtocolHandler> create(const config::Config& config, uint16_t port);
+
+private:
+    /**
+     * @brief 按HTTP/2配置创建处理器并应用压缩配置
+     * @param config 配置引用
+     * @param compression 响应压缩配置
+     * @return unique_ptr<ProtocolHandler>
+     */
+    static std::unique_ptr<ProtocolHandler> create_handler(const config::Config& config,
+                                                           const CompressionConfig& compression);
 };
 
 } // namespace protocol
@@ -9,8 +9,10 @@
 #include <cstdint>
 #include <cstddef>
 #include <cerrno>
+#include <functional>
 #include <string>
 #include <map>
+#include <memory>
 #include <vector>
 
 namespace https_server_sim {
@@ -38,9 +40,41 @@ constexpr size_t MAX_BODY_SIZE = 64 * 1024 * 1024;
 constexpr size_t HTTP2_FRAME_HEADER_SIZE = 9;
 constexpr uint32_t HTTP2_DEFAULT_MAX_FRAME_SIZE = 16384;
 constexpr uint32_t HTTP2_DEFAULT_INITIAL_WINDOW_SIZE = 65535;
+constexpr uint32_t HTTP2_MAX_FRAME_SIZE_LIMIT = 16777215;
+constexpr int32_t HTTP2_MAX_WINDOW_SIZE = 0x7FFFFFFF;
+constexpr uint32_t HTTP2_DEFAULT_MAX_CONCURRENT_STREAMS = 100;
+// RFC 9218扩展优先级：紧急度0（最高）到7，默认3
+constexpr uint8_t HTTP2_URGENCY_LEVELS = 8;
+constexpr uint8_t HTTP2_DEFAULT_URGENCY = 3;
+// 客户端连接前言（RFC 9113 3.4），TLS与h2c先验知识连接都以此开头
+constexpr const char* HTTP2_CLIENT_PREFACE = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t HTTP2_CLIENT_PREFACE_LEN = 24;
+// 单个头部块（HEADERS+CONTINUATION）缓存上限
+constexpr size_t HTTP2_MAX_HEADER_BLOCK_SIZE = 256 * 1024;
+
+// ==================== HTTP/2错误码 ====================
+constexpr uint32_t HTTP2_ERROR_PROTOCOL = 0x1;
+constexpr uint32_t HTTP2_ERROR_FLOW_CONTROL = 0x3;
+constexpr uint32_t HTTP2_ERROR_STREAM_CLOSED = 0x5;
+constexpr uint32_t HTTP2_ERROR_REFUSED_STREAM = 0x7;
 
 // ==================== 通用缓冲区常量 ====================
 constexpr size_t TEMP_BUFFER_SIZE = 4096;
+// 响应体超过该阈值时不再拷贝进头部缓冲区，改为分散写（头部+body两段）
+constexpr size_t RESPONSE_SCATTER_THRESHOLD = 16 * 1024;
+// 流水线响应排队超过该长度时提前写出
+constexpr size_t RESPONSE_BATCH_FLUSH_THRESHOLD = 64 * 1024;
+// TLS单条记录最大明文长度
+constexpr size_t TLS_MAX_RECORD_SIZE = 16384;
+// 动态记录长度的小记录明文长度：加上记录头与AEAD开销后仍能装进一个TCP报文段
+constexpr size_t TLS_SMALL_RECORD_SIZE = 1400;
+// 响应压缩默认级别与最小压缩长度
+constexpr int DEFAULT_COMPRESSION_LEVEL = 6;
+constexpr size_t DEFAULT_COMPRESSION_MIN_SIZE = 1024;
+
+// ==================== 请求分发 ====================
+// 把任务交给工作线程执行（如包装WorkerPool::post_task）；处理器未设置时在IO线程内同步执行
+using TaskDispatcher = std::function<void(std::function<void()>)>;
 
 // ==================== ALPN协议常量 ====================
 constexpr const char* ALPN_HTTP11 = "http/1.1";
@@ -50,6 +84,26 @@ constexpr const char* ALPN_HTTP2_HTTP11 = "h2,http/1.1";
 constexpr bool DEFAULT_ENABLE_TLS_1_2 = true;
 constexpr bool DEFAULT_ENABLE_TLS_1_3 = true;
 
+// ==================== TLS会话复用默认值 ====================
+constexpr size_t DEFAULT_TLS_SESSION_CACHE_SIZE = 20480;
+constexpr uint32_t DEFAULT_TLS_SESSION_TIMEOUT = 300;
+constexpr bool DEFAULT_TLS_SESSION_TICKETS = true;
+constexpr uint32_t DEFAULT_TLS_TICKET_KEY_ROTATION = 3600;
+
+// ==================== TLS动态记录长度默认值 ====================
+constexpr size_t DEFAULT_TLS_RECORD_RAMP_BYTES = 1024 * 1024;
+constexpr uint32_t DEFAULT_TLS_RECORD_IDLE_MS = 1000;
+
+// ==================== TLS证书压缩与握手开销 ====================
+constexpr bool DEFAULT_TLS_CERT_COMPRESSION = true;
+// 估算握手往返次数使用的初始拥塞窗口（RFC 6928：10个MSS）
+constexpr size_t TLS_INITIAL_CWND_BYTES = 10 * 1460;
+
+// ==================== TLS 1.3 0-RTT默认值 ====================
+constexpr uint32_t DEFAULT_TLS_MAX_EARLY_DATA = 16384;
+// 早期数据可被重放，只处理幂等且无副作用的方法
+constexpr const char* DEFAULT_EARLY_DATA_METHODS = "GET,HEAD";
+
 // ==================== HTTP/2帧标志 ====================
 constexpr uint8_t HTTP2_FLAG_END_STREAM = 0x01;
 constexpr uint8_t HTTP2_FLAG_END_HEADERS = 0x04;
@@ -93,7 +147,8 @@ enum class Http2FrameType : uint8_t {
     PING = 0x6,
     GOAWAY = 0x7,
     WINDOW_UPDATE = 0x8,
-    CONTINUATION = 0x9
+    CONTINUATION = 0x9,
+    PRIORITY_UPDATE = 0x10   // RFC 9218
 };
 
 // ==================== 证书类型枚举 ====================
@@ -113,6 +168,36 @@ enum class ParseResult {
 // ==================== HTTP头部集合类型 ====================
 using HttpHeaders = std::map<std::string, std::string>;
 
+// ==================== 分散写数据片段 ====================
+// 用于一次写调用提交多段不连续的明文（如：响应头 + 响应体）
+struct IoSlice {
+    const uint8_t* data;
+    size_t len;
+};
+
+// ==================== SNI虚拟主机证书 ====================
+// 同一主机名的RSA/ECDSA/SM2证书，启动时各自预建SSL_CTX，握手时按客户端能力切换
+struct ServerNameCert {
+    std::string server_name;    // 主机名（不区分大小写），"*.example.com"匹配一级子域名
+    std::string cert_path;      // RSA
+    std::string key_path;
+    std::string ecdsa_cert_path;
+    std::string ecdsa_key_path;
+    std::string sm2_cert_path;
+    std::string sm2_key_path;
+
+    ServerNameCert()
+        : server_name()
+        , cert_path()
+        , key_path()
+        , ecdsa_cert_path()
+        , ecdsa_key_path()
+        , sm2_cert_path()
+        , sm2_key_path()
+    {
+    }
+};
+
 // ==================== 证书配置结构体 ====================
 struct CertConfig {
     std::string cert_path;
@@ -123,6 +208,7 @@ struct CertConfig {
     std::string sm2_sign_cert_path;
     std::string sm2_sign_key_path;
     bool use_gmssl;
+    std::vector<ServerNameCert> server_names;  // 按SNI选择的证书（未匹配时使用上面的默认证书）
 
     CertConfig()
         : cert_path()
@@ -133,22 +219,65 @@ struct CertConfig {
         , sm2_sign_cert_path()
         , sm2_sign_key_path()
         , use_gmssl(false)
+        , server_names()
     {
     }
 };
 
 // ==================== TLS配置结构体 ====================
+class TlsContext;
+
 struct TlsConfig {
     std::string cipher_suites;
     std::string alpn_protocols;
     bool enable_tls_1_3;
     bool enable_tls_1_2;
+    bool enable_ktls;       // 内核TLS卸载（仅Linux，内核模块不可用时自动回退）
+    bool plaintext;         // 明文端口：不做TLS，读写直接透传Connection缓冲区
+    std::shared_ptr<TlsContext> context;  // 监听端口共享的SSL上下文，为空时按连接单独构建
+    size_t session_cache_size;      // TLS 1.2服务端会话缓存容量（0关闭）
+    uint32_t session_timeout;       // 会话与会话票据有效期（秒）
+    bool session_tickets;           // 启用无状态会话票据
+    uint32_t ticket_key_rotation;   // 票据密钥轮换周期（秒）
+    size_t record_ramp_bytes;       // 以小记录发送的字节数，之后使用最大记录（0关闭动态记录长度）
+    uint32_t record_idle_ms;        // 空闲超过该时长（毫秒）后回到小记录
+    bool early_data;                // 接受TLS 1.3 0-RTT早期数据（需会话复用）
+    uint32_t max_early_data;        // 单个连接接受的早期数据上限（字节）
+    std::string early_data_methods; // 早期数据中允许处理的方法（逗号分隔）
+    bool cert_compression;          // TLS 1.3证书压缩（RFC 8879，需OpenSSL 3.2+，否则忽略）
 
     TlsConfig()
         : cipher_suites()
         , alpn_protocols(ALPN_HTTP11)
         , enable_tls_1_3(DEFAULT_ENABLE_TLS_1_3)
         , enable_tls_1_2(DEFAULT_ENABLE_TLS_1_2)
+        , enable_ktls(false)
+        , plaintext(false)
+        , context()
+        , session_cache_size(DEFAULT_TLS_SESSION_CACHE_SIZE)
+        , session_timeout(DEFAULT_TLS_SESSION_TIMEOUT)
+        , session_tickets(DEFAULT_TLS_SESSION_TICKETS)
+        , ticket_key_rotation(DEFAULT_TLS_TICKET_KEY_ROTATION)
+        , record_ramp_bytes(DEFAULT_TLS_RECORD_RAMP_BYTES)
+        , record_idle_ms(DEFAULT_TLS_RECORD_IDLE_MS)
+        , early_data(false)
+        , max_early_data(DEFAULT_TLS_MAX_EARLY_DATA)
+        , early_data_methods(DEFAULT_EARLY_DATA_METHODS)
+        , cert_compression(DEFAULT_TLS_CERT_COMPRESSION)
+    {
+    }
+};
+
+// ==================== 响应压缩配置结构体 ====================
+struct CompressionConfig {
+    bool enabled;
+    int level;          // zlib压缩级别（1-9，-1为默认）
+    size_t min_size;    // 小于该长度的响应体不压缩
+
+    CompressionConfig()
+        : enabled(false)
+        , level(DEFAULT_COMPRESSION_LEVEL)
+        , min_size(DEFAULT_COMPRESSION_MIN_SIZE)
     {
     }
 };
@@ -183,9 +312,9 @@ struct Http2Settings {
     void reset() {
         header_table_size = 4096;
         enable_push = 0;
-        max_concurrent_streams = 100;
-        initial_window_size = 65535;
-        max_frame_size = 16384;
+        max_concurrent_streams = HTTP2_DEFAULT_MAX_CONCURRENT_STREAMS;
+        initial_window_size = HTTP2_DEFAULT_INITIAL_WINDOW_SIZE;
+        max_frame_size = HTTP2_DEFAULT_MAX_FRAME_SIZE;
         max_header_list_size = 0xFFFFFFFF;
     }
 
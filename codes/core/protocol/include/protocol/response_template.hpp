@@ -0,0 +1,143 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: response_template.hpp
+//  描述: ResponseTemplate/ResponseTemplateRegistry类定义 - 预生成响应模板
+//  版权: Copyright (c) 2026
+// =============================================================================
+#pragma once
+
+#include "protocol/protocol_types.hpp"
+#include "utils/buffer.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace https_server_sim {
+namespace protocol {
+
+// ==================== 响应模板 ====================
+// 状态行和固定头部在注册时序列化一次，发送时只填入变化的部分：
+// Date（每秒缓存）、Content-Length和响应体。
+class ResponseTemplate {
+public:
+    /**
+     * @brief 构造响应模板
+     * @param status_code 状态码
+     * @param status_text 原因短语
+     * @param headers 固定头部（Date/Content-Length由模板自动生成，传入时忽略）
+     */
+    ResponseTemplate(int status_code,
+                     const std::string& status_text,
+                     const HttpHeaders& headers);
+
+    /**
+     * @brief 获取状态码
+     * @return 状态码
+     */
+    int get_status_code() const;
+
+    /**
+     * @brief 计算渲染后的头部长度
+     * @param body_len 响应体长度
+     * @param extra_len 附加头部长度
+     * @return 头部字节数（不含响应体）
+     */
+    size_t header_size(size_t body_len, size_t extra_len = 0) const;
+
+    /**
+     * @brief 渲染响应到Buffer（一次reserve/commit）
+     * @param body 响应体指针
+     * @param body_len 响应体长度
+     * @param out 输出缓冲区，数据追加在已有可读数据之后
+     * @param include_body 是否将响应体一并写入
+     * @param extra_lines 附加的预格式化头部行（每行以\r\n结尾，如Content-Encoding），可为空
+     * @param extra_len 附加头部长度
+     * @return 0成功，负数失败
+     */
+    int render(const uint8_t* body, size_t body_len,
+               utils::Buffer* out, bool include_body,
+               const char* extra_lines = nullptr, size_t extra_len = 0) const;
+
+private:
+    int status_code_;
+    std::string prefix_;  // 状态行 + 固定头部
+};
+
+// ==================== 响应模板注册表 ====================
+// 按(端口, 状态码)登记模板，供处理器与回调注册；线程安全。
+class ResponseTemplateRegistry {
+public:
+    /**
+     * @brief 获取注册表单例
+     * @return ResponseTemplateRegistry引用
+     */
+    static ResponseTemplateRegistry& instance();
+
+    /**
+     * @brief 注册响应模板
+     * @param port 监听端口
+     * @param status_code 状态码（100-999）
+     * @param status_text 原因短语
+     * @param headers 固定头部
+     * @param replace 已存在时是否替换
+     * @return 0成功，负数失败
+     */
+    int register_template(uint16_t port, int status_code,
+                          const std::string& status_text,
+                          const HttpHeaders& headers,
+                          bool replace = true);
+
+    /**
+     * @brief 登记端口的默认回复模板（200 OK，text/plain），已注册时保留原模板
+     * @note 每个监听端口在启动时调用一次，连接建立时不再注册
+     * @param port 监听端口
+     * @return 0成功，负数失败
+     */
+    int register_defaults(uint16_t port);
+
+    /**
+     * @brief 查找响应模板
+     * @param port 监听端口
+     * @param status_code 状态码
+     * @return 模板指针，未找到返回空
+     */
+    std::shared_ptr<const ResponseTemplate> find(uint16_t port, int status_code) const;
+
+    /**
+     * @brief 注销响应模板
+     * @param port 监听端口
+     * @param status_code 状态码
+     */
+    void deregister_template(uint16_t port, int status_code);
+
+    /**
+     * @brief 清空所有模板
+     */
+    void clear();
+
+    /**
+     * @brief 获取注册表版本号（每次变更递增，供调用方缓存查找结果）
+     * @return 版本号
+     */
+    uint64_t get_version() const;
+
+private:
+    ResponseTemplateRegistry();
+    ~ResponseTemplateRegistry();
+    ResponseTemplateRegistry(const ResponseTemplateRegistry&) = delete;
+    ResponseTemplateRegistry& operator=(const ResponseTemplateRegistry&) = delete;
+
+    static uint32_t make_key(uint16_t port, int status_code);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint32_t, std::shared_ptr<const ResponseTemplate>> templates_;
+    std::atomic<uint64_t> version_;
+};
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
@@ -0,0 +1,294 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: tls_context.hpp
+//  描述: TlsContext类定义 - 按监听端口共享的SSL上下文（证书、套件、ALPN）
+//  版权: Copyright (c) 2026
+// =============================================================================
+#pragma once
+
+#include "protocol/protocol_types.hpp"
+#include "protocol/tls_session_cache.hpp"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace https_server_sim {
+
+namespace config {
+class Config;
+}
+
+namespace protocol {
+
+// ==================== TLS上下文 ====================
+// 封装SSL_CTX：证书链与私钥的加载校验、加密套件、TLS版本与ALPN只在init时做一次，
+// 之后同一监听端口的所有连接共享该上下文，每个连接只创建自己的SSL对象。
+// 通过shared_ptr引用计数管理，最后一个连接释放后SSL_CTX才被销毁。
+// 会话缓存与票据密钥同样挂在上下文上，使同一端口的所有连接都能复用彼此的会话；
+// 0-RTT防重放过滤器也按端口共享，重放到同一端口任一连接的ClientHello都能被识别。
+// 配置了SNI虚拟主机时，每个主机名的RSA/ECDSA/SM2证书在init时各预建一个子上下文，
+// 握手中由servername回调按主机名与客户端签名能力切换过去；会话状态仍归属本上下文。
+class TlsContext {
+public:
+    /**
+     * @brief 默认构造函数
+     */
+    TlsContext();
+
+    /**
+     * @brief 析构函数（释放SSL_CTX）
+     */
+    ~TlsContext();
+
+    // 禁止拷贝
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
+    /**
+     * @brief 创建SSL_CTX并加载证书、配置加密套件与ALPN
+     * @param cert_config 证书配置
+     * @param tls_config TLS配置
+     * @return 0成功，负数失败（错误信息见get_error_msg）
+     */
+    int init(const CertConfig& cert_config, const TlsConfig& tls_config);
+
+    /**
+     * @brief 获取底层SSL_CTX（无OpenSSL时为nullptr）
+     * @return SSL_CTX指针（void*避免条件编译的类型差异）
+     */
+    void* native_handle() const;
+
+    /**
+     * @brief 获取配置的ALPN协议列表（ALPN选择回调使用）
+     * @return ALPN协议字符串（格式: "h2,http/1.1"）
+     */
+    const std::string& get_alpn_protocols() const;
+
+    /**
+     * @brief 获取识别出的证书类型
+     */
+    CertType get_cert_type() const;
+
+    /**
+     * @brief 获取错误码
+     */
+    int get_error_code() const;
+
+    /**
+     * @brief 获取错误信息
+     */
+    const std::string& get_error_msg() const;
+
+    /**
+     * @brief 获取TLS 1.2服务端会话缓存
+     * @return 会话缓存，未启用返回nullptr
+     */
+    TlsSessionCache* get_session_cache() const;
+
+    /**
+     * @brief 获取会话票据密钥环
+     * @return 票据密钥环，未启用返回nullptr
+     */
+    TlsTicketKeys* get_ticket_keys() const;
+
+    /**
+     * @brief 获取0-RTT防重放过滤器
+     * @return 过滤器，未启用早期数据返回nullptr
+     */
+    TlsAntiReplay* get_anti_replay() const;
+
+    /**
+     * @brief 证书链是否已预压缩（TLS 1.3证书压缩，RFC 8879）
+     * @return true已为至少一种算法预压缩，false未启用或OpenSSL不支持
+     */
+    bool is_cert_compressed() const;
+
+    /**
+     * @brief 按SNI主机名与客户端签名能力选择预建的证书上下文
+     * @param server_name 客户端发送的SNI主机名
+     * @param ecdsa 客户端支持ECDSA签名（优先于RSA，签名开销低得多）
+     * @param sm2 客户端支持SM2签名
+     * @return 选中的子上下文，主机名未配置返回nullptr（使用本上下文的默认证书）
+     */
+    TlsContext* select_server_name(const std::string& server_name, bool ecdsa, bool sm2) const;
+
+    /**
+     * @brief 获取已预建证书的SNI主机名数量
+     */
+    size_t get_server_name_count() const;
+
+    /**
+     * @brief 继承旧上下文的会话缓存、票据密钥与0-RTT防重放过滤器（证书热加载时使用）
+     * @param previous 同一端口被替换的旧上下文
+     * @note 只继承两边都启用的部分，新配置关闭的功能保持关闭；继承后容量与轮换周期沿用旧值
+     */
+    void inherit_resumption_state(const TlsContext& previous);
+
+private:
+    // 同一主机名的各类证书子上下文（未配置的为空）
+    struct ServerNameContexts {
+        std::unique_ptr<TlsContext> rsa;
+        std::unique_ptr<TlsContext> ecdsa;
+        std::unique_ptr<TlsContext> sm2;
+    };
+
+    /**
+     * @brief 初始化SSL上下文
+     * @return 0成功，负数失败
+     */
+    int init_ssl_context();
+
+    /**
+     * @brief 识别证书类型
+     * @return 0成功，负数失败
+     */
+    int load_certificates();
+
+    /**
+     * @brief 加载CA证书
+     * @param ca_path CA证书路径
+     * @return 0成功，负数失败
+     */
+    int load_ca_certificate(const std::string& ca_path);
+
+    /**
+     * @brief 配置证书链与私钥
+     * @return 0成功，负数失败
+     */
+    int configure_certificates();
+
+    /**
+     * @brief 配置加密套件与TLS版本
+     * @param config TLS配置
+     * @return 0成功，负数失败
+     */
+    int configure_cipher_suites(const TlsConfig& config);
+
+    /**
+     * @brief 配置ALPN选择回调
+     * @return 0成功，负数失败
+     */
+    int configure_alpn();
+
+    /**
+     * @brief 配置会话复用（服务端会话缓存与无状态票据）
+     * @param config TLS配置
+     * @return 0成功，负数失败
+     */
+    int configure_session_resumption(const TlsConfig& config);
+
+    /**
+     * @brief 配置TLS 1.3早期数据（上限与防重放回调）
+     * @param config TLS配置
+     * @return 0成功，负数失败
+     */
+    int configure_early_data(const TlsConfig& config);
+
+    /**
+     * @brief 配置TLS 1.3证书压缩并预压缩证书链（OpenSSL 3.2+）
+     * @param config TLS配置
+     * @return 0成功，负数失败
+     */
+    int configure_cert_compression(const TlsConfig& config);
+
+    /**
+     * @brief 为所有SNI主机名预建证书子上下文并注册servername回调
+     * @param cert_config 证书配置
+     * @param tls_config TLS配置
+     * @return 0成功，负数失败
+     */
+    int configure_server_names(const CertConfig& cert_config, const TlsConfig& tls_config);
+
+    /**
+     * @brief 构建单个证书子上下文（会话状态挂在本上下文上）
+     * @param cert_config 子上下文的证书配置
+     * @param tls_config TLS配置
+     * @param out 输出子上下文
+     * @return 0成功，负数失败
+     */
+    int build_server_name_context(const CertConfig& cert_config, const TlsConfig& tls_config,
+                                  std::unique_ptr<TlsContext>* out);
+
+    /**
+     * @brief 设置错误信息
+     */
+    void set_error(int code, const std::string& msg);
+
+    void* ssl_ctx_;
+    std::string cert_path_;
+    std::string key_path_;
+    std::string ca_path_;
+    std::string sm2_cert_path_;
+    std::string sm2_key_path_;
+    std::string sm2_sign_cert_path_;
+    std::string sm2_sign_key_path_;
+    CertType cert_type_;
+    bool use_gmssl_;
+    bool cert_compressed_;
+    std::string alpn_protocols_;
+    std::shared_ptr<TlsSessionCache> session_cache_;   // 热加载时新旧上下文共享
+    std::shared_ptr<TlsTicketKeys> ticket_keys_;
+    std::shared_ptr<TlsAntiReplay> anti_replay_;
+    std::unordered_map<std::string, ServerNameContexts> server_names_;  // 规范化主机名 -> 子上下文
+    int error_code_;
+    std::string error_msg_;
+};
+
+// ==================== TLS上下文管理器 ====================
+// 服务启动时为每个TLS监听端口构建一个TlsContext，连接初始化时按端口取出共享。
+// 证书热加载时在调用线程上构建整套新上下文，再以原子指针替换发布：新连接取到新上下文，
+// 已建立的连接继续持有旧上下文直到关闭，取上下文的路径不等待证书加载。
+class TlsContextManager {
+public:
+    /**
+     * @brief 获取单例实例
+     */
+    static TlsContextManager& instance();
+
+    // 禁止拷贝
+    TlsContextManager(const TlsContextManager&) = delete;
+    TlsContextManager& operator=(const TlsContextManager&) = delete;
+
+    /**
+     * @brief 为配置中所有启用TLS的监听端口构建上下文（替换已有上下文，启动与热加载共用）
+     * @param config 全局配置
+     * @return 0成功，负数失败（任一端口失败时不替换已有上下文）
+     * @note 已有端口的会话缓存与票据密钥由新上下文继承，替换后客户端仍可复用会话
+     */
+    int build(const config::Config& config);
+
+    /**
+     * @brief 获取端口对应的共享上下文
+     * @param port 监听端口
+     * @return 上下文，未构建返回nullptr
+     */
+    std::shared_ptr<TlsContext> get(uint16_t port) const;
+
+    /**
+     * @brief 释放所有上下文（已建立的连接仍持有各自引用）
+     */
+    void clear();
+
+    /**
+     * @brief 获取上下文代数（每次成功build加一，用于确认热加载已生效）
+     */
+    uint64_t get_generation() const;
+
+private:
+    using ContextMap = std::map<uint16_t, std::shared_ptr<TlsContext>>;
+
+    TlsContextManager() = default;
+
+    std::mutex build_mutex_;                      // 串行化build/clear，不影响get
+    std::shared_ptr<const ContextMap> contexts_;  // 经std::atomic_load/atomic_store发布
+    std::atomic<uint64_t> generation_{0};
+};
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
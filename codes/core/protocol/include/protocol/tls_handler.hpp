@@ -8,6 +8,7 @@
 
 #include "protocol/protocol_types.hpp"
 #include "utils/buffer.hpp"
+#include <memory>
 #include <string>
 
 // 统一使用void*避免条件编译带来的类型不一致
@@ -18,7 +19,23 @@ class Connection;
 
 namespace protocol {
 
+class TlsContext;
+
+namespace details {
+struct ConnectionBio;
+}
+
 // ==================== TLS处理器类（防腐层）====================
+// 每个连接持有一个SSL对象，SSL_CTX来自共享的TlsContext（TlsConfig::context），
+// 未提供共享上下文时在init中为本连接单独构建。
+// 非kTLS模式下SSL经自定义BIO直接读取Connection读缓冲区中的密文、把密文写入
+// Connection写缓冲区，不再经过中间BIO对搬运。
+// 写入按动态记录长度切分：新连接或空闲后的连接先发TLS_SMALL_RECORD_SIZE的小记录，
+// 使首批数据收到一个报文段即可解密；累计发送record_ramp_bytes后改用最大记录。
+// 共享上下文启用0-RTT时，握手期间先用SSL_read_early_data读出早期数据，协议处理器可在
+// 握手完成前经read_into取得这部分明文，并只处理配置为可重放的方法。
+// 握手期间按“服务端发出一批数据后等待客户端”划分往返，每批超出初始拥塞窗口的部分
+// 额外计一个往返，完成时连同收发字节计入统计，用于观察证书链大小对握手的影响。
 class TlsHandler {
 public:
     /**
@@ -38,7 +55,7 @@ public:
     /**
      * @brief 初始化TLS处理器
      * @param conn Connection对象指针
-     * @param cert_config 证书配置
+     * @param cert_config 证书配置（tls_config.context为空时使用）
      * @param tls_config TLS配置
      * @return 0成功，负数失败
      */
@@ -55,8 +72,19 @@ public:
      */
     int read(uint8_t* data, size_t len, size_t* out_len);
 
+    /**
+     * @brief 读取当前可解密的全部明文，直接追加到目标缓冲区（无中间拷贝）
+     * @note 0-RTT阶段先推进握手并交付已读出的早期数据，握手完成后再读取后续明文
+     * @param dst 目标缓冲区（通常为协议处理器的明文缓冲区）
+     * @param out_len 输出追加的总长度
+     * @return 0成功，-EAGAIN暂无明文，负数失败
+     */
+    int read_into(utils::Buffer* dst, size_t* out_len);
+
     /**
      * @brief 写入明文数据（会加密）
+     * @note 写缓冲区已满时未加密的剩余明文暂存在处理器内，由flush_pending写出，
+     *       暂存部分同样计入out_len
      * @param data 输入数据
      * @param len 数据长度
      * @param out_len 输出实际写入长度
@@ -64,6 +92,86 @@ public:
      */
     int write(const uint8_t* data, size_t len, size_t* out_len);
 
+    /**
+     * @brief 分散写入多段明文数据（会加密），避免调用方先拼接再写入
+     * @param slices 数据片段数组
+     * @param count 片段数量
+     * @param out_len 输出实际写入的总长度
+     * @return 0成功，-EAGAIN需要更多数据，负数失败
+     */
+    int writev(const IoSlice* slices, size_t count, size_t* out_len);
+
+    /**
+     * @brief 发送文件内容（会加密）
+     * @note kTLS发送已启用时走SSL_sendfile，由内核完成加密与拷贝；
+     *       否则回退为分块pread + SSL_write。暂存的明文先于文件内容写出，
+     *       未写完时返回-EAGAIN；返回-EAGAIN时out_len为本次已发送长度，
+     *       调用方在写事件中从offset + out_len继续发送
+     * @param file_fd 文件描述符
+     * @param offset 文件偏移
+     * @param len 发送长度
+     * @param out_len 输出实际发送长度
+     * @return 0成功，-EAGAIN需要等待可写，负数失败
+     */
+    int send_file(int file_fd, int64_t offset, size_t len, size_t* out_len);
+
+    /**
+     * @brief 继续写出因写缓冲区已满而暂存的明文（写事件时调用）
+     * @return 0已全部写出，-EAGAIN仍有剩余，负数失败
+     */
+    int flush_pending();
+
+    /**
+     * @brief 获取暂存待加密的明文长度
+     * @return 字节数
+     */
+    size_t get_pending_bytes() const;
+
+    /**
+     * @brief 获取下一条记录的明文长度（动态记录长度）
+     * @return TLS_SMALL_RECORD_SIZE或TLS_MAX_RECORD_SIZE
+     */
+    size_t get_record_size() const;
+
+    /**
+     * @brief 获取本连接握手的往返次数（按初始拥塞窗口估算）
+     * @return 往返次数，握手未开始为0
+     */
+    uint32_t get_handshake_round_trips() const;
+
+    /**
+     * @brief 检查kTLS发送方向是否已启用
+     * @return true已启用，false未启用
+     */
+    bool is_ktls_tx_enabled() const;
+
+    /**
+     * @brief 检查kTLS接收方向是否已启用
+     * @return true已启用，false未启用
+     */
+    bool is_ktls_rx_enabled() const;
+
+    /**
+     * @brief 检查SSL是否直接绑定socket（kTLS模式，绕过Connection缓冲区）
+     * @note 为true时调用方不应再自行收发该fd的数据，读写事件直接交给ProtocolHandler。
+     *       本仓库尚无套接字收发循环，此接口仅供嵌入方的事件循环查询
+     * @return true直接绑定socket，false经自定义BIO读写Connection缓冲区
+     */
+    bool is_socket_io() const;
+
+    /**
+     * @brief 检查是否为明文模式（TlsConfig::plaintext，h2c等非TLS端口）
+     * @note 明文模式下无握手，read/write直接搬运Connection缓冲区
+     * @return true明文透传，false TLS
+     */
+    bool is_plaintext() const;
+
+    /**
+     * @brief 检测内核是否提供TLS ULP（结果缓存）
+     * @return true可用，false不可用
+     */
+    static bool is_ktls_available();
+
     /**
      * @brief 关闭TLS处理器
      * @return 0成功，负数失败
@@ -76,6 +184,26 @@ public:
      */
     bool is_handshake_done() const;
 
+    /**
+     * @brief 检查是否处于0-RTT阶段（已接受早期数据且握手尚未完成）
+     * @note 此阶段读到的明文可能被重放，只应处理可重放的请求
+     * @return true处于0-RTT阶段，false不是
+     */
+    bool is_early_data() const;
+
+    /**
+     * @brief 检查是否有尚未交付的早期数据明文
+     * @return true有，false没有
+     */
+    bool has_early_data() const;
+
+    /**
+     * @brief 检查方法是否配置为可在早期数据中处理（TlsConfig::early_data_methods）
+     * @param method 请求方法
+     * @return true可重放，false须等握手完成
+     */
+    bool is_early_data_method(const std::string& method) const;
+
     /**
      * @brief 继续TLS握手
      * @return 0握手完成，-EAGAIN需要继续，负数失败
@@ -131,64 +259,65 @@ public:
     void set_write_buffer(utils::Buffer* buffer);
 
 private:
+    friend struct details::ConnectionBio;
+
     /**
-     * @brief 初始化SSL上下文
-     * @param config 证书配置
+     * @brief 设置绑定Connection缓冲区的自定义BIO
      * @return 0成功，负数失败
      */
-    int init_ssl_context(const CertConfig& config);
+    int setup_bio();
 
     /**
-     * @brief 加载证书
-     * @param config 证书配置
-     * @return 0成功，负数失败
+     * @brief 读取0-RTT早期数据到早期数据缓冲区
+     * @return 0早期数据已读完（或被拒绝），-EAGAIN需要更多数据，负数失败
      */
-    int load_certificates(const CertConfig& config);
+    int read_early_data();
 
     /**
-     * @brief 加载CA证书
-     * @param ca_path CA证书路径
-     * @return 0成功，负数失败
+     * @brief 按动态记录长度逐条调用SSL_write
+     * @param data 明文
+     * @param len 明文长度
+     * @param out_len 输出已加密写出的长度
+     * @return 0全部写出，-EAGAIN写缓冲区已满，负数失败
      */
-    int load_ca_certificate(const std::string& ca_path);
+    int write_records(const uint8_t* data, size_t len, size_t* out_len);
 
     /**
-     * @brief 配置证书
-     * @param config 证书配置
-     * @return 0成功，负数失败
+     * @brief 暂存未写出的明文
+     * @return 0成功，PROTOCOL_ERROR_BUFFER超出缓冲区上限
      */
-    int configure_certificates(const CertConfig& config);
+    int stash_pending(const uint8_t* data, size_t len);
 
     /**
-     * @brief 配置加密套件
-     * @param config TLS配置
-     * @return 0成功，负数失败
+     * @brief 指定时刻下一条记录的明文长度
+     * @param now_ms 当前时间（毫秒，单调时钟）
      */
-    int configure_cipher_suites(const TlsConfig& config);
+    size_t record_size_at(uint64_t now_ms) const;
 
     /**
-     * @brief 配置ALPN
-     * @return 0成功，负数失败
+     * @brief 累计已发送的明文，用于小记录到最大记录的切换
+     * @param len 本次写出的明文长度
+     * @param now_ms 当前时间（毫秒，单调时钟）
      */
-    int configure_alpn();
+    void account_record(size_t len, uint64_t now_ms);
 
     /**
-     * @brief 设置内存BIO
-     * @return 0成功，负数失败
+     * @brief 累计握手中发出的字节，一批数据发完并等待对端时折算为往返次数
+     * @param bytes 本次握手推进写出的密文字节
+     * @param flight_done true表示这批数据已发完、需等待对端回应
      */
-    int setup_bio();
+    void account_handshake_flight(size_t bytes, bool flight_done);
 
     /**
-     * @brief 从Connection读缓冲区读取数据写入SSL读BIO
-     * @return 写入字节数，负数失败
+     * @brief 启用kTLS：设置SSL_OP_ENABLE_KTLS并直接绑定连接socket
+     * @return 0成功，负数表示不可用（调用方回退到内存BIO）
      */
-    int pump_read_bio();
+    int setup_ktls();
 
     /**
-     * @brief 从SSL写BIO读取数据写入Connection写缓冲区
-     * @return 读取字节数，负数失败
+     * @brief 握手完成后刷新kTLS收发方向的启用状态
      */
-    int pump_write_bio();
+    void update_ktls_state();
 
     /**
      * @brief 检查是否是SM2证书
@@ -196,34 +325,32 @@ private:
      */
     bool is_sm2_cert() const;
 
-    /**
-     * @brief 获取配置的ALPN协议列表
-     * @return ALPN协议字符串
-     */
-    const std::string& get_alpn_protocols() const;
-
     Connection* conn_;
+    std::shared_ptr<TlsContext> context_;  // 共享的SSL_CTX，连接关闭时释放引用
     // 统一使用void*避免条件编译的类型差异
-    void* ssl_ctx_;
     void* ssl_;
-    void* ssl_read_bio_;
-    void* ssl_write_bio_;
     bool initialized_;
     bool handshake_done_;
+    bool socket_io_;
+    bool plaintext_;
+    bool ktls_tx_;
+    bool ktls_rx_;
     utils::Buffer* read_buffer_;
     utils::Buffer* write_buffer_;
-    std::string cert_path_;
-    std::string key_path_;
-    std::string ca_path_;
-    std::string sm2_cert_path_;
-    std::string sm2_key_path_;
-    std::string sm2_sign_cert_path_;
-    std::string sm2_sign_key_path_;
-    CertType cert_type_;
-    bool use_gmssl_;
+    std::unique_ptr<utils::Buffer> pending_write_;  // 写缓冲区已满时暂存的明文，按需创建
+    size_t retry_len_;              // 上次SSL_write重试的长度，重试时不得小于该值
+    size_t record_ramp_bytes_;
+    uint32_t record_idle_ms_;
+    size_t record_bytes_sent_;      // 本轮（新连接或空闲之后）已发送的明文
+    uint64_t last_write_ms_;
+    size_t handshake_flight_bytes_;     // 当前这批尚未等到对端回应的握手字节
+    uint32_t handshake_round_trips_;
+    bool early_data_reading_;       // 握手中仍在读取早期数据（SSL_read_early_data未返回FINISH）
+    bool early_data_accepted_;      // 客户端发送的早期数据已被接受
+    std::string early_data_methods_;
+    std::unique_ptr<utils::Buffer> early_data_;     // 已解密、尚未交付的早期数据，按需创建
     int error_code_;
     std::string error_msg_;
-    std::string alpn_protocols_;
 };
 
 } // namespace protocol
@@ -0,0 +1,218 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: tls_session_cache.hpp
+//  描述: TlsSessionCache/TlsTicketKeys/TlsAntiReplay类定义 - TLS会话复用（服务端会话缓存、票据密钥与0-RTT防重放）
+//  版权: Copyright (c) 2026
+// =============================================================================
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace https_server_sim {
+namespace protocol {
+
+// 会话缓存分片数（按会话ID散列，每片独立加锁）
+constexpr size_t TLS_SESSION_CACHE_SHARDS = 16;
+// 票据密钥名、AES密钥与HMAC密钥长度（RFC 5077推荐格式）
+constexpr size_t TLS_TICKET_KEY_NAME_SIZE = 16;
+constexpr size_t TLS_TICKET_AES_KEY_SIZE = 32;
+constexpr size_t TLS_TICKET_HMAC_KEY_SIZE = 32;
+// 轮换后仍保留用于解密的旧密钥数
+constexpr size_t TLS_TICKET_RETIRED_KEYS = 2;
+// 0-RTT防重放窗口（秒）：不短于OpenSSL接受早期数据时允许的票据年龄偏差（10秒）
+constexpr uint32_t TLS_EARLY_DATA_REPLAY_WINDOW = 10;
+// 防重放过滤器最多记录的ClientHello数
+constexpr size_t TLS_EARLY_DATA_REPLAY_ENTRIES = 65536;
+
+// ==================== TLS服务端会话缓存 ====================
+// 保存TLS 1.2按会话ID复用所需的序列化会话（DER）。按会话ID散列到固定分片，
+// 每片一把锁、一条LRU链，容量按分片均分，超出时淘汰该片最久未用的会话。
+class TlsSessionCache {
+public:
+    /**
+     * @brief 构造函数
+     * @param capacity 总容量（会话数，0表示不缓存）
+     * @param timeout_sec 会话有效期（秒）
+     */
+    TlsSessionCache(size_t capacity, uint32_t timeout_sec);
+
+    /**
+     * @brief 析构函数
+     */
+    ~TlsSessionCache();
+
+    // 禁止拷贝
+    TlsSessionCache(const TlsSessionCache&) = delete;
+    TlsSessionCache& operator=(const TlsSessionCache&) = delete;
+
+    /**
+     * @brief 保存会话（同ID已存在时覆盖）
+     * @param id 会话ID
+     * @param id_len 会话ID长度
+     * @param session 序列化的会话
+     * @param now 当前时间（秒，单调时钟）
+     */
+    void put(const uint8_t* id, size_t id_len, std::vector<uint8_t> session, uint64_t now);
+
+    /**
+     * @brief 查找会话，过期的会话在查找时删除
+     * @param id 会话ID
+     * @param id_len 会话ID长度
+     * @param now 当前时间（秒，单调时钟）
+     * @param session 输出序列化的会话
+     * @return true命中，false未命中
+     */
+    bool get(const uint8_t* id, size_t id_len, uint64_t now, std::vector<uint8_t>* session);
+
+    /**
+     * @brief 删除会话
+     * @param id 会话ID
+     * @param id_len 会话ID长度
+     */
+    void remove(const uint8_t* id, size_t id_len);
+
+    /**
+     * @brief 获取缓存的会话总数
+     */
+    size_t size() const;
+
+private:
+    struct Entry {
+        std::vector<uint8_t> session;
+        uint64_t expires_at;
+        std::list<std::string>::iterator lru;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+        std::list<std::string> lru;     // 表头为最近使用
+    };
+
+    /**
+     * @brief 会话ID所属分片
+     */
+    Shard& shard_for(const std::string& key);
+
+    Shard shards_[TLS_SESSION_CACHE_SHARDS];
+    size_t shard_capacity_;
+    uint32_t timeout_sec_;
+};
+
+// ==================== TLS会话票据密钥 ====================
+struct TlsTicketKey {
+    uint8_t name[TLS_TICKET_KEY_NAME_SIZE];
+    uint8_t aes_key[TLS_TICKET_AES_KEY_SIZE];
+    uint8_t hmac_key[TLS_TICKET_HMAC_KEY_SIZE];
+    uint64_t created_at;
+};
+
+// 无状态会话票据的密钥环：当前密钥用于签发，到达轮换周期时生成新密钥，
+// 旧密钥再保留TLS_TICKET_RETIRED_KEYS代只用于解密，之后丢弃（对应票据失效）。
+class TlsTicketKeys {
+public:
+    /**
+     * @brief 构造函数
+     * @param rotation_sec 轮换周期（秒）
+     */
+    explicit TlsTicketKeys(uint32_t rotation_sec);
+
+    /**
+     * @brief 析构函数（清零密钥）
+     */
+    ~TlsTicketKeys();
+
+    // 禁止拷贝
+    TlsTicketKeys(const TlsTicketKeys&) = delete;
+    TlsTicketKeys& operator=(const TlsTicketKeys&) = delete;
+
+    /**
+     * @brief 获取签发新票据用的密钥，到期时先轮换
+     * @param now 当前时间（秒，单调时钟）
+     * @param key 输出密钥
+     * @return true成功，false生成密钥失败
+     */
+    bool encrypt_key(uint64_t now, TlsTicketKey* key);
+
+    /**
+     * @brief 按密钥名查找解密用的密钥
+     * @param name 票据中的密钥名（TLS_TICKET_KEY_NAME_SIZE字节）
+     * @param key 输出密钥
+     * @param current 输出是否为当前密钥（false时调用方应重新签发票据）
+     * @return true找到，false密钥未知或已丢弃
+     */
+    bool decrypt_key(const uint8_t* name, TlsTicketKey* key, bool* current) const;
+
+    /**
+     * @brief 获取保留的密钥数（含当前密钥）
+     */
+    size_t size() const;
+
+private:
+    /**
+     * @brief 生成新密钥作为当前密钥，淘汰超出保留代数的旧密钥
+     * @return true成功，false随机数生成失败
+     */
+    bool rotate(uint64_t now);
+
+    mutable std::mutex mutex_;
+    std::vector<TlsTicketKey> keys_;    // keys_[0]为当前密钥
+    uint32_t rotation_sec_;
+};
+
+// ==================== 0-RTT防重放过滤器 ====================
+// 记录窗口内见过的ClientHello随机数：被截获重放的ClientHello随机数不变，第二次出现即拒绝其早期数据。
+// 按时间分为当前桶与上一桶，桶到期整体轮换，每条记录至少保留一个窗口；记录数达到上限时
+// 直接拒绝早期数据（退回完整握手多一个往返，而不是冒重放的风险）。
+class TlsAntiReplay {
+public:
+    /**
+     * @brief 构造函数
+     * @param window_sec 窗口长度（秒）
+     * @param max_entries 最多记录数
+     */
+    TlsAntiReplay(uint32_t window_sec, size_t max_entries);
+
+    /**
+     * @brief 析构函数
+     */
+    ~TlsAntiReplay();
+
+    // 禁止拷贝
+    TlsAntiReplay(const TlsAntiReplay&) = delete;
+    TlsAntiReplay& operator=(const TlsAntiReplay&) = delete;
+
+    /**
+     * @brief 检查并记录ClientHello
+     * @param key ClientHello随机数
+     * @param len 长度
+     * @param now 当前时间（秒，单调时钟）
+     * @return true首次出现（可接受早期数据），false重复或过滤器已满
+     */
+    bool check(const uint8_t* key, size_t len, uint64_t now);
+
+    /**
+     * @brief 获取当前记录数
+     */
+    size_t size() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_set<std::string> current_;
+    std::unordered_set<std::string> previous_;
+    uint64_t bucket_start_;
+    uint32_t window_sec_;
+    size_t max_entries_;
+};
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
@@ -0,0 +1,318 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: compression.cpp
+//  描述: 响应压缩实现
+//  版权: Copyright (c) 2026
+// =============================================================================
+#include "protocol/compression.hpp"
+#include "protocol/protocol_utils.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace https_server_sim {
+namespace protocol {
+
+namespace details {
+
+// FNV-1a 64位哈希
+static uint64_t fnv1a_hash(const uint8_t* data, size_t len) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+#if HAVE_ZLIB
+// 解析q值（"q=0.5"），格式错误按1处理
+static double parse_qvalue(const std::string& params) {
+    size_t pos = params.find("q=");
+    if (pos == std::string::npos) {
+        pos = params.find("Q=");
+    }
+    if (pos == std::string::npos) {
+        return 1.0;
+    }
+    const char* start = params.c_str() + pos + 2;
+    char* end = nullptr;
+    double q = strtod(start, &end);
+    if (end == start) {
+        return 1.0;
+    }
+    return q;
+}
+
+static std::string trim(const std::string& str) {
+    size_t start = str.find_first_not_of(" \t");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = str.find_last_not_of(" \t");
+    return str.substr(start, end - start + 1);
+}
+#endif // HAVE_ZLIB
+
+} // namespace details
+
+// ==================== 编码协商 ====================
+
+const char* content_encoding_name(ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::GZIP:
+            return "gzip";
+        case ContentEncoding::DEFLATE:
+            return "deflate";
+        default:
+            return "identity";
+    }
+}
+
+const char* content_encoding_header_lines(ContentEncoding encoding, size_t* out_len) {
+    static const char GZIP_LINES[] = "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n";
+    static const char DEFLATE_LINES[] = "Content-Encoding: deflate\r\nVary: Accept-Encoding\r\n";
+
+    switch (encoding) {
+        case ContentEncoding::GZIP:
+            *out_len = sizeof(GZIP_LINES) - 1;
+            return GZIP_LINES;
+        case ContentEncoding::DEFLATE:
+            *out_len = sizeof(DEFLATE_LINES) - 1;
+            return DEFLATE_LINES;
+        default:
+            *out_len = 0;
+            return "";
+    }
+}
+
+ContentEncoding negotiate_content_encoding(const std::string& accept_encoding) {
+#if HAVE_ZLIB
+    double gzip_q = 0.0;
+    double deflate_q = 0.0;
+    double wildcard_q = -1.0;
+    bool gzip_listed = false;
+    bool deflate_listed = false;
+
+    size_t pos = 0;
+    while (pos <= accept_encoding.size()) {
+        size_t comma = accept_encoding.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = accept_encoding.size();
+        }
+        std::string item = accept_encoding.substr(pos, comma - pos);
+        pos = comma + 1;
+
+        size_t semicolon = item.find(';');
+        std::string coding = details::trim(item.substr(0, semicolon));
+        double q = (semicolon == std::string::npos) ? 1.0
+                                                    : details::parse_qvalue(item.substr(semicolon + 1));
+        if (coding.empty()) {
+            continue;
+        }
+        if (StrCaseCmp(coding.c_str(), "gzip") == 0 || StrCaseCmp(coding.c_str(), "x-gzip") == 0) {
+            gzip_q = q;
+            gzip_listed = true;
+        } else if (StrCaseCmp(coding.c_str(), "deflate") == 0) {
+            deflate_q = q;
+            deflate_listed = true;
+        } else if (coding == "*") {
+            wildcard_q = q;
+        }
+    }
+
+    // 未显式列出的编码取通配符的q值
+    if (!gzip_listed && wildcard_q >= 0.0) {
+        gzip_q = wildcard_q;
+    }
+    if (!deflate_listed && wildcard_q >= 0.0) {
+        deflate_q = wildcard_q;
+    }
+
+    if (gzip_q > 0.0 && gzip_q >= deflate_q) {
+        return ContentEncoding::GZIP;
+    }
+    if (deflate_q > 0.0) {
+        return ContentEncoding::DEFLATE;
+    }
+#else
+    (void)accept_encoding;
+#endif
+    return ContentEncoding::IDENTITY;
+}
+
+int compress_body(const uint8_t* data, size_t len, ContentEncoding encoding,
+                  int level, std::vector<uint8_t>* out) {
+    if (out == nullptr || (data == nullptr && len > 0) ||
+        encoding == ContentEncoding::IDENTITY) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+#if HAVE_ZLIB
+    // gzip使用gzip封装（windowBits+16），deflate按RFC 9110使用zlib封装
+    int window_bits = (encoding == ContentEncoding::GZIP) ? (MAX_WBITS + 16) : MAX_WBITS;
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    out->resize(deflateBound(&zs, static_cast<uLong>(len)));
+    zs.next_in = const_cast<Bytef*>(data);
+    zs.avail_in = static_cast<uInt>(len);
+    zs.next_out = out->data();
+    zs.avail_out = static_cast<uInt>(out->size());
+
+    int ret = deflate(&zs, Z_FINISH);
+    size_t total_out = zs.total_out;
+    deflateEnd(&zs);
+    if (ret != Z_STREAM_END) {
+        out->clear();
+        return PROTOCOL_ERROR_BUFFER;
+    }
+
+    out->resize(total_out);
+    return PROTOCOL_OK;
+#else
+    (void)level;
+    return PROTOCOL_ERROR_INVALID;
+#endif
+}
+
+// ==================== CompressionCache实现 ====================
+
+CompressionCache& CompressionCache::instance() {
+    static CompressionCache cache;
+    return cache;
+}
+
+CompressionCache::CompressionCache()
+    : mutex_()
+    , lru_()
+    , index_()
+    , capacity_bytes_(DEFAULT_CAPACITY_BYTES)
+    , size_bytes_(0)
+    , hits_(0)
+    , misses_(0)
+{
+}
+
+CompressionCache::~CompressionCache() = default;
+
+CompressionCache::Body CompressionCache::get_or_compress(const uint8_t* data, size_t len,
+                                                         ContentEncoding encoding, int level) {
+    Key key{details::fnv1a_hash(data, len), len, encoding, level};
+
+    // 锁内只取条目的共享指针，逐字节比对在锁外进行，避免大响应体比对阻塞其他线程
+    Body cached_source;
+    Body cached_body;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            cached_source = it->second->source;
+            cached_body = it->second->body;
+        } else {
+            misses_++;
+        }
+    }
+
+    if (cached_body) {
+        // 哈希相同还须原始数据一致，否则碰撞会把他人的响应体返回给当前请求
+        bool same = len == 0 || memcmp(cached_source->data(), data, len) == 0;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (same) {
+            // 命中：条目仍在缓存中（比对期间未被淘汰或替换）时移到LRU头部
+            auto it = index_.find(key);
+            if (it != index_.end() && it->second->body == cached_body) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+            }
+            hits_++;
+            return cached_body;
+        }
+        misses_++;
+    }
+
+    // 压缩在锁外进行；并发未命中同一内容时可能重复压缩，以后插入者为准
+    auto compressed = std::make_shared<std::vector<uint8_t>>();
+    if (compress_body(data, len, encoding, level, compressed.get()) != PROTOCOL_OK) {
+        return nullptr;
+    }
+    Body body = compressed;
+    Entry entry{key, std::make_shared<std::vector<uint8_t>>(data, data + len), body};
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entry_bytes(entry) > capacity_bytes_) {
+        return body;
+    }
+    // 同键旧条目（含碰撞条目）被新条目替换
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        size_bytes_ -= entry_bytes(*it->second);
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+    lru_.push_front(std::move(entry));
+    index_[key] = lru_.begin();
+    size_bytes_ += entry_bytes(lru_.front());
+    evict_locked();
+    return body;
+}
+
+void CompressionCache::set_capacity(size_t capacity_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_bytes_ = capacity_bytes;
+    evict_locked();
+}
+
+void CompressionCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    size_bytes_ = 0;
+    hits_ = 0;
+    misses_ = 0;
+}
+
+size_t CompressionCache::entry_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+}
+
+size_t CompressionCache::size_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_bytes_;
+}
+
+uint64_t CompressionCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+uint64_t CompressionCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+size_t CompressionCache::entry_bytes(const Entry& entry) {
+    return entry.source->size() + entry.body->size();
+}
+
+void CompressionCache::evict_locked() {
+    while (size_bytes_ > capacity_bytes_ && !lru_.empty()) {
+        const Entry& victim = lru_.back();
+        size_bytes_ -= entry_bytes(victim);
+        index_.erase(victim.key);
+        lru_.pop_back();
+    }
+}
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
@@ -6,6 +6,7 @@
 // =============================================================================
 
 #include "protocol/config_converter.hpp"
+#include "protocol/tls_context.hpp"
 
 namespace https_server_sim {
 namespace protocol {
@@ -32,6 +33,20 @@ void ConfigConverter::convert_cert_config(
     // - 【注意】若只配置部分国密路径，后续国密初始化可能失败，这是预期行为
     dst.use_gmssl = !src.sm2_cert_path.empty() || !src.sm2_key_path.empty() ||
                     !src.sm2_sign_cert_path.empty() || !src.sm2_sign_key_path.empty();
+
+    // SNI虚拟主机证书（直接映射）
+    dst.server_names.clear();
+    for (const auto& src_name : src.server_names) {
+        ServerNameCert name;
+        name.server_name = src_name.server_name;
+        name.cert_path = src_name.cert_path;
+        name.key_path = src_name.key_path;
+        name.ecdsa_cert_path = src_name.ecdsa_cert_path;
+        name.ecdsa_key_path = src_name.ecdsa_key_path;
+        name.sm2_cert_path = src_name.sm2_cert_path;
+        name.sm2_key_path = src_name.sm2_key_path;
+        dst.server_names.push_back(std::move(name));
+    }
 }
 
 void ConfigConverter::convert_tls_config(
@@ -54,6 +69,64 @@ void ConfigConverter::convert_tls_config(
     // TLS版本启用标志：使用默认值
     dst.enable_tls_1_3 = DEFAULT_ENABLE_TLS_1_3;
     dst.enable_tls_1_2 = DEFAULT_ENABLE_TLS_1_2;
+
+    // kTLS开关从CertificatesConfig::enable_ktls映射
+    dst.enable_ktls = cert_config.enable_ktls;
+
+    // 会话复用参数从CertificatesConfig映射
+    dst.session_cache_size = cert_config.session_cache_size;
+    dst.session_timeout = cert_config.session_timeout;
+    dst.session_tickets = cert_config.session_tickets;
+    dst.ticket_key_rotation = cert_config.ticket_key_rotation;
+
+    // 动态记录长度参数从CertificatesConfig映射
+    dst.record_ramp_bytes = cert_config.record_ramp_bytes;
+    dst.record_idle_ms = cert_config.record_idle_ms;
+
+    // 证书压缩从CertificatesConfig映射
+    dst.cert_compression = cert_config.cert_compression;
+}
+
+void ConfigConverter::convert_tls_config(
+    const config::Config& config,
+    uint16_t port,
+    TlsConfig& dst)
+{
+    convert_tls_config(config, dst);
+
+    dst.plaintext = false;
+    dst.early_data = false;
+    for (const auto& listen : config.get_listens()) {
+        if (listen.port == port) {
+            dst.plaintext = !listen.tls_enabled;
+            // 0-RTT按监听端口启用
+            dst.early_data = listen.early_data;
+            dst.early_data_methods = listen.early_data_methods;
+            break;
+        }
+    }
+
+    // 监听端口已构建共享上下文时，连接只需创建SSL对象
+    dst.context = dst.plaintext ? nullptr : TlsContextManager::instance().get(port);
+}
+
+void ConfigConverter::convert_compression_config(
+    const config::ListenConfig& src,
+    CompressionConfig& dst)
+{
+    // 压缩设置按监听端口配置
+    dst.enabled = src.compression_enabled;
+    dst.level = src.compression_level;
+    dst.min_size = src.compression_min_size;
+}
+
+void ConfigConverter::convert_http2_settings(
+    const config::Http2Config& src,
+    Http2Settings& dst)
+{
+    // 超出RFC上限的窗口已由Config::validate拒绝，这里只做映射
+    dst.initial_window_size = src.initial_window_size;
+    dst.max_concurrent_streams = src.max_concurrent_streams;
 }
 
 } // namespace protocol
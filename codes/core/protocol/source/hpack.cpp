@@ -17,8 +17,8 @@
 //
 //  当前实现支持HPACK基础功能：
 //  - 完整支持静态表索引
-//  - 支持文字头域编码（无Huffman编码）
-//  - 支持基本的动态表大小更新框架
+//  - 支持动态表（环形数组存储，按RFC 7541 §4.4淘汰）及动态表大小更新
+//  - 支持Huffman编码（仅在比原文更短时采用）与解码
 //
 //  若未来需要完整HPACK功能，可按以下步骤重构：
 //  1. 包含nghttp2/nghttp2.h头文件
@@ -29,13 +29,10 @@
 //  6. encode()方法使用nghttp2_hd_deflate_deflate()
 //  7. decode()方法使用nghttp2_hd_inflate_hd()
 //  8. 正确管理动态表大小和状态
-//
-//  当前简化实现的限制：
-//  - 仅支持静态表索引，不支持动态表
-//  - 不支持Huffman编码
-//  - 不支持动态表大小更新的完整语义
 //  ============================================================================
 #include "protocol/hpack.hpp"
+#include "protocol/hpack_huffman.hpp"
+#include <cstdint>
 #include <cstring>
 #include <algorithm>
 #include <vector>
@@ -51,74 +48,139 @@ namespace details {
 // 静态表（HPACK规范中的静态表）
 struct StaticTableEntry {
     const char* name;
+    size_t name_len;
     const char* value;
+    size_t value_len;
+};
+
+#define HPACK_STATIC_ENTRY(name, value) {name, sizeof(name) - 1, value, sizeof(value) - 1}
+static constexpr StaticTableEntry static_table[] = {
+    HPACK_STATIC_ENTRY(":authority", ""),
+    HPACK_STATIC_ENTRY(":method", "GET"),
+    HPACK_STATIC_ENTRY(":method", "POST"),
+    HPACK_STATIC_ENTRY(":path", "/"),
+    HPACK_STATIC_ENTRY(":path", "/index.html"),
+    HPACK_STATIC_ENTRY(":scheme", "http"),
+    HPACK_STATIC_ENTRY(":scheme", "https"),
+    HPACK_STATIC_ENTRY(":status", "200"),
+    HPACK_STATIC_ENTRY(":status", "204"),
+    HPACK_STATIC_ENTRY(":status", "206"),
+    HPACK_STATIC_ENTRY(":status", "304"),
+    HPACK_STATIC_ENTRY(":status", "400"),
+    HPACK_STATIC_ENTRY(":status", "404"),
+    HPACK_STATIC_ENTRY(":status", "500"),
+    HPACK_STATIC_ENTRY("accept-charset", ""),
+    HPACK_STATIC_ENTRY("accept-encoding", "gzip, deflate"),
+    HPACK_STATIC_ENTRY("accept-language", ""),
+    HPACK_STATIC_ENTRY("accept-ranges", ""),
+    HPACK_STATIC_ENTRY("accept", ""),
+    HPACK_STATIC_ENTRY("access-control-allow-origin", ""),
+    HPACK_STATIC_ENTRY("age", ""),
+    HPACK_STATIC_ENTRY("allow", ""),
+    HPACK_STATIC_ENTRY("authorization", ""),
+    HPACK_STATIC_ENTRY("cache-control", ""),
+    HPACK_STATIC_ENTRY("content-disposition", ""),
+    HPACK_STATIC_ENTRY("content-encoding", ""),
+    HPACK_STATIC_ENTRY("content-language", ""),
+    HPACK_STATIC_ENTRY("content-length", ""),
+    HPACK_STATIC_ENTRY("content-location", ""),
+    HPACK_STATIC_ENTRY("content-range", ""),
+    HPACK_STATIC_ENTRY("content-type", ""),
+    HPACK_STATIC_ENTRY("cookie", ""),
+    HPACK_STATIC_ENTRY("date", ""),
+    HPACK_STATIC_ENTRY("etag", ""),
+    HPACK_STATIC_ENTRY("expect", ""),
+    HPACK_STATIC_ENTRY("expires", ""),
+    HPACK_STATIC_ENTRY("from", ""),
+    HPACK_STATIC_ENTRY("host", ""),
+    HPACK_STATIC_ENTRY("if-match", ""),
+    HPACK_STATIC_ENTRY("if-modified-since", ""),
+    HPACK_STATIC_ENTRY("if-none-match", ""),
+    HPACK_STATIC_ENTRY("if-range", ""),
+    HPACK_STATIC_ENTRY("if-unmodified-since", ""),
+    HPACK_STATIC_ENTRY("last-modified", ""),
+    HPACK_STATIC_ENTRY("link", ""),
+    HPACK_STATIC_ENTRY("location", ""),
+    HPACK_STATIC_ENTRY("max-forwards", ""),
+    HPACK_STATIC_ENTRY("proxy-authenticate", ""),
+    HPACK_STATIC_ENTRY("proxy-authorization", ""),
+    HPACK_STATIC_ENTRY("range", ""),
+    HPACK_STATIC_ENTRY("referer", ""),
+    HPACK_STATIC_ENTRY("refresh", ""),
+    HPACK_STATIC_ENTRY("retry-after", ""),
+    HPACK_STATIC_ENTRY("server", ""),
+    HPACK_STATIC_ENTRY("set-cookie", ""),
+    HPACK_STATIC_ENTRY("strict-transport-security", ""),
+    HPACK_STATIC_ENTRY("transfer-encoding", ""),
+    HPACK_STATIC_ENTRY("user-agent", ""),
+    HPACK_STATIC_ENTRY("vary", ""),
+    HPACK_STATIC_ENTRY("via", ""),
+    HPACK_STATIC_ENTRY("www-authenticate", "")
+};
+#undef HPACK_STATIC_ENTRY
+
+static constexpr size_t static_table_size = sizeof(static_table) / sizeof(static_table[0]);
+
+constexpr bool const_equal(const char* a, size_t a_len, const char* b, size_t b_len) {
+    if (a_len != b_len) {
+        return false;
+    }
+    for (size_t i = 0; i < a_len; ++i) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 静态表名称的编译期完美哈希：选定的FNV-1a初始值使52个不同名称落入128个槽位且无冲突，
+// 槽位记录该名称的首个索引与条目数（同名条目在静态表中连续）
+constexpr uint32_t STATIC_HASH_BASIS = 0x811d6fa8;
+constexpr size_t STATIC_HASH_SLOTS = 128;
+
+constexpr uint32_t static_name_slot(const char* data, size_t len) {
+    uint32_t h = STATIC_HASH_BASIS;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<uint8_t>(data[i]);
+        h *= 16777619u;
+    }
+    return (h ^ (h >> 15)) & static_cast<uint32_t>(STATIC_HASH_SLOTS - 1);
+}
+
+struct StaticNameSlot {
+    uint8_t first;  // 首个条目索引（从1开始），0表示空槽
+    uint8_t count;  // 同名条目数
 };
 
-static const StaticTableEntry static_table[] = {
-    {":authority", ""},
-    {":method", "GET"},
-    {":method", "POST"},
-    {":path", "/"},
-    {":path", "/index.html"},
-    {":scheme", "http"},
-    {":scheme", "https"},
-    {":status", "200"},
-    {":status", "204"},
-    {":status", "206"},
-    {":status", "304"},
-    {":status", "400"},
-    {":status", "404"},
-    {":status", "500"},
-    {"accept-charset", ""},
-    {"accept-encoding", "gzip, deflate"},
-    {"accept-language", ""},
-    {"accept-ranges", ""},
-    {"accept", ""},
-    {"access-control-allow-origin", ""},
-    {"age", ""},
-    {"allow", ""},
-    {"authorization", ""},
-    {"cache-control", ""},
-    {"content-disposition", ""},
-    {"content-encoding", ""},
-    {"content-language", ""},
-    {"content-length", ""},
-    {"content-location", ""},
-    {"content-range", ""},
-    {"content-type", ""},
-    {"cookie", ""},
-    {"date", ""},
-    {"etag", ""},
-    {"expect", ""},
-    {"expires", ""},
-    {"from", ""},
-    {"host", ""},
-    {"if-match", ""},
-    {"if-modified-since", ""},
-    {"if-none-match", ""},
-    {"if-range", ""},
-    {"if-unmodified-since", ""},
-    {"last-modified", ""},
-    {"link", ""},
-    {"location", ""},
-    {"max-forwards", ""},
-    {"proxy-authenticate", ""},
-    {"proxy-authorization", ""},
-    {"range", ""},
-    {"referer", ""},
-    {"refresh", ""},
-    {"retry-after", ""},
-    {"server", ""},
-    {"set-cookie", ""},
-    {"strict-transport-security", ""},
-    {"transfer-encoding", ""},
-    {"user-agent", ""},
-    {"vary", ""},
-    {"via", ""},
-    {"www-authenticate", ""}
+struct StaticNameIndex {
+    StaticNameSlot slots[STATIC_HASH_SLOTS];
+    bool perfect;
 };
 
-static const size_t static_table_size = sizeof(static_table) / sizeof(static_table[0]);
+constexpr StaticNameIndex build_static_name_index() {
+    StaticNameIndex index{};
+    index.perfect = true;
+    for (size_t i = 0; i < static_table_size; ++i) {
+        const StaticTableEntry& entry = static_table[i];
+        StaticNameSlot& slot = index.slots[static_name_slot(entry.name, entry.name_len)];
+        if (slot.first == 0) {
+            slot.first = static_cast<uint8_t>(i + 1);
+            slot.count = 1;
+            continue;
+        }
+        const StaticTableEntry& head = static_table[slot.first - 1];
+        if (const_equal(head.name, head.name_len, entry.name, entry.name_len) &&
+            static_cast<size_t>(slot.first + slot.count) == i + 1) {
+            slot.count++;
+        } else {
+            index.perfect = false;
+        }
+    }
+    return index;
+}
+
+static constexpr StaticNameIndex static_name_index = build_static_name_index();
+static_assert(static_name_index.perfect, "HPACK静态表名称哈希存在冲突，需重新选择STATIC_HASH_BASIS");
 
 // 整数编码（可变长度整数）
 static void encode_int(std::vector<uint8_t>* out, uint32_t value, uint8_t prefix, uint8_t prefix_bits) {
@@ -136,31 +198,68 @@ static void encode_int(std::vector<uint8_t>* out, uint32_t value, uint8_t prefix
     }
 }
 
-// 字符串字面量编码（简化：不使用Huffman编码）
+// 字符串字面量编码：Huffman编码更短时使用Huffman（H=1）
 static void encode_string(std::vector<uint8_t>* out, const std::string& str) {
-    encode_int(out, static_cast<uint32_t>(str.size()), 0, 7);
-    for (char c : str) {
-        out->push_back(static_cast<uint8_t>(c));
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(str.data());
+    size_t huffman_len = huffman_encoded_length(data, str.size());
+    if (huffman_len < str.size()) {
+        encode_int(out, static_cast<uint32_t>(huffman_len), 0x80, 7);
+        huffman_encode(data, str.size(), out);
+    } else {
+        encode_int(out, static_cast<uint32_t>(str.size()), 0, 7);
+        out->insert(out->end(), data, data + str.size());
     }
 }
 
-// 查找静态表
-static int find_static_index(const std::string& name, const std::string& value) {
-    for (size_t i = 0; i < static_table_size; ++i) {
-        if (name == static_table[i].name && value == static_table[i].value) {
-            return static_cast<int>(i + 1); // 索引从1开始
+// 查找静态表：名称哈希定位槽位后只比较同名条目的值
+static uint32_t find_static(const std::string& name, const std::string& value, bool* full_match) {
+    *full_match = false;
+    const StaticNameSlot& slot = static_name_index.slots[static_name_slot(name.data(), name.size())];
+    if (slot.first == 0) {
+        return 0;
+    }
+    const StaticTableEntry& head = static_table[slot.first - 1];
+    if (head.name_len != name.size() || memcmp(head.name, name.data(), name.size()) != 0) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < slot.count; ++i) {
+        const StaticTableEntry& entry = static_table[slot.first - 1 + i];
+        if (entry.value_len == value.size() && memcmp(entry.value, value.data(), value.size()) == 0) {
+            *full_match = true;
+            return slot.first + i;
         }
     }
-    return -1;
+    return slot.first;
 }
 
-static int find_static_name_index(const std::string& name) {
-    for (size_t i = 0; i < static_table_size; ++i) {
-        if (name == static_table[i].name) {
-            return static_cast<int>(i + 1);
-        }
+// 动态表名称哈希与名称/值哈希（FNV-1a，值哈希在名称哈希基础上继续计算）
+static uint32_t dynamic_name_hash(const std::string& name) {
+    uint32_t h = 2166136261u;
+    for (unsigned char c : name) {
+        h ^= c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t dynamic_pair_hash(uint32_t name_hash, const std::string& value) {
+    uint32_t h = (name_hash ^ 0xFFu) * 16777619u;
+    for (unsigned char c : value) {
+        h ^= c;
+        h *= 16777619u;
     }
-    return -1;
+    return h;
+}
+
+// 敏感头部使用Never Indexed表示，禁止中间节点缓存
+static bool is_sensitive_header(const std::string& name) {
+    return name == "authorization" || name == "cookie" ||
+           name == "set-cookie" || name == "proxy-authorization";
+}
+
+// 每个响应都不同的头部不进入动态表，避免挤出可复用的条目
+static bool is_volatile_header(const std::string& name) {
+    return name == "content-length" || name == ":path" || name == "etag" || name == "date";
 }
 
 // 整数解码
@@ -182,7 +281,15 @@ static int decode_int(const uint8_t** data_ptr, const uint8_t* end, uint8_t pref
     uint32_t shift = 0;
     while (data < end) {
         uint8_t b = *data++;
-        value += (b & 0x7F) << shift;
+        // 超过32位的整数视为非法：第5个续字节只剩4位可用，且累加不得回绕
+        if (shift > 28 || (shift == 28 && (b & 0x70) != 0)) {
+            return PROTOCOL_ERROR_INVALID;
+        }
+        uint32_t addend = static_cast<uint32_t>(b & 0x7F) << shift;
+        if (addend > UINT32_MAX - value) {
+            return PROTOCOL_ERROR_INVALID;
+        }
+        value += addend;
         shift += 7;
         if (!(b & 0x80)) {
             *result = value;
@@ -199,26 +306,182 @@ static int decode_string(const uint8_t** data_ptr, const uint8_t* end, std::stri
     const uint8_t* data = *data_ptr;
     uint32_t len = 0;
 
+    if (data >= end) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+    bool huffman = (*data & 0x80) != 0;
+
     int ret = decode_int(&data, end, 7, &len);
     if (ret != PROTOCOL_OK) {
         return ret;
     }
 
-    if (data + len > end) {
+    if (len > static_cast<size_t>(end - data)) {
         return PROTOCOL_ERROR_INVALID;
     }
 
-    result->assign(reinterpret_cast<const char*>(data), len);
+    if (huffman) {
+        ret = huffman_decode(data, len, result);
+        if (ret != PROTOCOL_OK) {
+            return ret;
+        }
+    } else {
+        result->assign(reinterpret_cast<const char*>(data), len);
+    }
     *data_ptr = data + len;
     return PROTOCOL_OK;
 }
 
 } // namespace details
 
+// ==================== HpackDynamicTable实现 ====================
+
+HpackDynamicTable::HpackDynamicTable()
+    : ring_()
+    , name_heads_()
+    , pair_heads_()
+    , inserted_(0)
+    , count_(0)
+    , size_(0)
+    , max_size_(DEFAULT_MAX_SIZE)
+{
+}
+
+uint32_t HpackDynamicTable::entry_size(const std::string& name, const std::string& value) {
+    return static_cast<uint32_t>(name.size() + value.size()) + ENTRY_OVERHEAD;
+}
+
+bool HpackDynamicTable::add(const std::string& name, const std::string& value) {
+    size_t needed = name.size() + value.size() + ENTRY_OVERHEAD;
+    if (needed > max_size_) {
+        // RFC 7541 §4.4：条目大于表容量时清空动态表
+        clear();
+        return false;
+    }
+
+    while (size_ + needed > max_size_) {
+        evict_oldest();
+    }
+    if (count_ == ring_.size()) {
+        grow();
+    }
+
+    // 复用槽位中字符串的已有容量
+    Slot& slot = ring_[inserted_ & (ring_.size() - 1)];
+    slot.field.name = name;
+    slot.field.value = value;
+    slot.name_hash = details::dynamic_name_hash(name);
+    slot.pair_hash = details::dynamic_pair_hash(slot.name_hash, value);
+    link(&slot, inserted_);
+    inserted_++;
+    count_++;
+    size_ += static_cast<uint32_t>(needed);
+    return true;
+}
+
+const HpackHeaderField* HpackDynamicTable::get(uint32_t index) const {
+    if (index == 0 || index > count_) {
+        return nullptr;
+    }
+    return &ring_[(inserted_ - index) & (ring_.size() - 1)].field;
+}
+
+uint32_t HpackDynamicTable::find(const std::string& name, const std::string& value,
+                                 bool* full_match) const {
+    *full_match = false;
+    if (count_ == 0) {
+        return 0;
+    }
+
+    // 链表按插入顺序从新到旧，遇到已淘汰的序号即可停止
+    const uint64_t oldest = inserted_ - count_;
+    const size_t mask = ring_.size() - 1;
+    const uint32_t name_hash = details::dynamic_name_hash(name);
+    const uint32_t pair_hash = details::dynamic_pair_hash(name_hash, value);
+
+    for (uint64_t link = pair_heads_[pair_hash & mask]; link > oldest;) {
+        const Slot& slot = ring_[(link - 1) & mask];
+        if (slot.pair_hash == pair_hash && slot.field.name == name && slot.field.value == value) {
+            *full_match = true;
+            return static_cast<uint32_t>(inserted_ - (link - 1));
+        }
+        link = slot.prev_pair;
+    }
+
+    for (uint64_t link = name_heads_[name_hash & mask]; link > oldest;) {
+        const Slot& slot = ring_[(link - 1) & mask];
+        if (slot.name_hash == name_hash && slot.field.name == name) {
+            return static_cast<uint32_t>(inserted_ - (link - 1));
+        }
+        link = slot.prev_name;
+    }
+    return 0;
+}
+
+void HpackDynamicTable::set_max_size(uint32_t size) {
+    max_size_ = size;
+    while (size_ > max_size_) {
+        evict_oldest();
+    }
+}
+
+uint32_t HpackDynamicTable::get_max_size() const {
+    return max_size_;
+}
+
+uint32_t HpackDynamicTable::get_size() const {
+    return size_;
+}
+
+size_t HpackDynamicTable::get_count() const {
+    return count_;
+}
+
+void HpackDynamicTable::clear() {
+    // 哈希链中的序号均早于inserted_，无需逐个清理
+    count_ = 0;
+    size_ = 0;
+}
+
+void HpackDynamicTable::evict_oldest() {
+    const HpackHeaderField& oldest = ring_[(inserted_ - count_) & (ring_.size() - 1)].field;
+    size_ -= entry_size(oldest.name, oldest.value);
+    count_--;
+}
+
+void HpackDynamicTable::link(Slot* slot, uint64_t seq) {
+    const size_t mask = ring_.size() - 1;
+    slot->prev_name = name_heads_[slot->name_hash & mask];
+    name_heads_[slot->name_hash & mask] = seq + 1;
+    slot->prev_pair = pair_heads_[slot->pair_hash & mask];
+    pair_heads_[slot->pair_hash & mask] = seq + 1;
+}
+
+void HpackDynamicTable::grow() {
+    size_t new_capacity = ring_.empty() ? 16 : ring_.size() * 2;
+    std::vector<Slot> new_ring(new_capacity);
+    for (size_t i = 0; i < count_; ++i) {
+        uint64_t seq = inserted_ - count_ + i;
+        new_ring[seq & (new_capacity - 1)] = std::move(ring_[seq & (ring_.size() - 1)]);
+    }
+    ring_.swap(new_ring);
+
+    // 桶数与环形数组容量相同，扩容后按从旧到新的顺序重建哈希链
+    name_heads_.assign(new_capacity, 0);
+    pair_heads_.assign(new_capacity, 0);
+    for (size_t i = 0; i < count_; ++i) {
+        uint64_t seq = inserted_ - count_ + i;
+        link(&ring_[seq & (new_capacity - 1)], seq);
+    }
+}
+
 // ==================== HpackEncoder实现 ====================
 
 HpackEncoder::HpackEncoder()
-    : max_dynamic_table_size_(4096)
+    : max_dynamic_table_size_(HpackDynamicTable::DEFAULT_MAX_SIZE)
+    , dynamic_table_()
+    , size_update_pending_(false)
+    , min_size_update_(HpackDynamicTable::DEFAULT_MAX_SIZE)
 {
     // 简化实现，不使用nghttp2库
 }
@@ -233,29 +496,63 @@ int HpackEncoder::encode(const std::map<std::string, std::string>& headers,
                          std::vector<uint8_t>* out) {
     out->clear();
 
+    // 表大小变化后，在头部块开头通告（先最小值再最终值，RFC 7541 §4.2）
+    if (size_update_pending_) {
+        if (min_size_update_ < max_dynamic_table_size_) {
+            details::encode_int(out, min_size_update_, 0x20, 5);
+        }
+        details::encode_int(out, max_dynamic_table_size_, 0x20, 5);
+        size_update_pending_ = false;
+    }
+
     for (const auto& pair : headers) {
         const std::string& name = pair.first;
         const std::string& value = pair.second;
 
-        // 尝试查找完整匹配
-        int idx = details::find_static_index(name, value);
-        if (idx > 0) {
+        // 尝试查找完整匹配：静态表（完美哈希）优先，其次动态表（哈希链），均为常数时间
+        bool full_match = false;
+        uint32_t static_idx = details::find_static(name, value, &full_match);
+        if (full_match) {
             // Indexed Header Field Representation - 索引头部字段表示 (0b1xxxxxxx)
-            details::encode_int(out, static_cast<uint32_t>(idx), 0x80, 7);
+            details::encode_int(out, static_idx, 0x80, 7);
+            continue;
+        }
+
+        uint32_t dynamic_idx = dynamic_table_.find(name, value, &full_match);
+        if (full_match) {
+            details::encode_int(out,
+                                static_cast<uint32_t>(details::static_table_size) + dynamic_idx,
+                                0x80, 7);
             continue;
         }
 
         // 尝试查找名称匹配
-        idx = details::find_static_name_index(name);
-        if (idx > 0) {
-            // Literal Header Field with Incremental Indexing - 文字头域增量索引 (0b01xxxxxx)
-            details::encode_int(out, static_cast<uint32_t>(idx), 0x40, 6);
-            details::encode_string(out, value);
+        uint32_t name_idx = static_idx;
+        if (name_idx == 0 && dynamic_idx > 0) {
+            name_idx = static_cast<uint32_t>(details::static_table_size) + dynamic_idx;
+        }
+
+        bool indexing = false;
+        if (details::is_sensitive_header(name)) {
+            // Literal Header Field Never Indexed - 文字头域永不索引 (0b0001xxxx)
+            details::encode_int(out, name_idx, 0x10, 4);
+        } else if (details::is_volatile_header(name) ||
+                   HpackDynamicTable::entry_size(name, value) > dynamic_table_.get_max_size()) {
+            // Literal Header Field without Indexing - 文字头域无索引 (0b0000xxxx)
+            details::encode_int(out, name_idx, 0x00, 4);
         } else {
-            // Literal Header Field with Incremental Indexing - 新名称 (0b01000000)
-            out->push_back(0x40);
+            // Literal Header Field with Incremental Indexing - 文字头域增量索引 (0b01xxxxxx)
+            details::encode_int(out, name_idx, 0x40, 6);
+            indexing = true;
+        }
+
+        if (name_idx == 0) {
             details::encode_string(out, name);
-            details::encode_string(out, value);
+        }
+        details::encode_string(out, value);
+
+        if (indexing) {
+            dynamic_table_.add(name, value);
         }
     }
 
@@ -263,17 +560,31 @@ int HpackEncoder::encode(const std::map<std::string, std::string>& headers,
 }
 
 void HpackEncoder::set_max_dynamic_table_size(uint32_t size) {
+    if (!size_update_pending_) {
+        min_size_update_ = size;
+    } else {
+        min_size_update_ = std::min(min_size_update_, size);
+    }
+    size_update_pending_ = true;
     max_dynamic_table_size_ = size;
+    dynamic_table_.set_max_size(size);
 }
 
 uint32_t HpackEncoder::get_max_dynamic_table_size() const {
     return max_dynamic_table_size_;
 }
 
+const HpackDynamicTable& HpackEncoder::get_dynamic_table() const {
+    return dynamic_table_;
+}
+
 // ==================== HpackDecoder实现 ====================
 
 HpackDecoder::HpackDecoder()
-    : max_dynamic_table_size_(4096)
+    : max_dynamic_table_size_(HpackDynamicTable::DEFAULT_MAX_SIZE)
+    , dynamic_table_()
+    , name_scratch_()
+    , value_scratch_()
 {
     // 简化实现，不使用nghttp2库
 }
@@ -282,14 +593,48 @@ HpackDecoder::~HpackDecoder() {
     // 简化实现，无需清理
 }
 
+int HpackDecoder::lookup(uint32_t index, std::string* name, std::string* value) const {
+    if (index == 0) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    if (index <= details::static_table_size) {
+        const details::StaticTableEntry& entry = details::static_table[index - 1];
+        name->assign(entry.name, entry.name_len);
+        if (value) {
+            value->assign(entry.value, entry.value_len);
+        }
+        return PROTOCOL_OK;
+    }
+
+    const HpackHeaderField* field =
+        dynamic_table_.get(index - static_cast<uint32_t>(details::static_table_size));
+    if (field == nullptr) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+    *name = field->name;
+    if (value) {
+        *value = field->value;
+    }
+    return PROTOCOL_OK;
+}
+
 // 关联用例：HPACK-DECODE-001（功能用例）：解码HPACK数据
 // 关联用例：HPACK-DECODE-002（边界用例）：解码空数据
 int HpackDecoder::decode(const uint8_t* data, size_t len,
                          std::map<std::string, std::string>* headers) {
     headers->clear();
+    return decode_append(data, len, headers);
+}
 
+int HpackDecoder::decode_append(const uint8_t* data, size_t len,
+                                std::map<std::string, std::string>* headers) {
+    // 名称与值先解码到复用的暂存串，只在写入headers时拷贝一次
+    std::string& name = name_scratch_;
+    std::string& value = value_scratch_;
     const uint8_t* ptr = data;
     const uint8_t* end = data + len;
+    bool field_seen = false;  // 本头部块是否已出现字段表示
 
     while (ptr < end) {
         uint8_t first_byte = *ptr;
@@ -301,69 +646,58 @@ int HpackDecoder::decode(const uint8_t* data, size_t len,
             if (ret != PROTOCOL_OK) {
                 return ret;
             }
-            // 查找静态表
-            if (index > 0 && index <= details::static_table_size) {
-                const details::StaticTableEntry& entry = details::static_table[index - 1];
-                (*headers)[entry.name] = entry.value;
-            }
-        } else if ((first_byte & 0xC0) == 0x40) {
-            // Literal with Incremental Indexing - 文字头域增量索引 (0b01xxxxxx)
-            ptr++;
-            uint32_t name_idx = first_byte & 0x3F;
-            std::string name, value;
-
-            if (name_idx == 0) {
-                // 新名称
-                int ret = details::decode_string(&ptr, end, &name);
-                if (ret != PROTOCOL_OK) {
-                    return ret;
-                }
-            } else if (name_idx <= details::static_table_size) {
-                name = details::static_table[name_idx - 1].name;
-            }
-
-            int ret = details::decode_string(&ptr, end, &value);
+            ret = lookup(index, &name, &value);
             if (ret != PROTOCOL_OK) {
                 return ret;
             }
-
-            if (!name.empty()) {
-                (*headers)[name] = value;
-            }
+            (*headers)[name] = value;
+            field_seen = true;
         } else if ((first_byte & 0xE0) == 0x20) {
             // Dynamic Table Size Update - 动态表大小更新 (0b001xxxxx)
+            // RFC 7541 4.2: 只能出现在头部块开头，位于字段表示之后视为COMPRESSION_ERROR
+            if (field_seen) {
+                return PROTOCOL_ERROR_INVALID;
+            }
             uint32_t size = 0;
             int ret = details::decode_int(&ptr, end, 5, &size);
             if (ret != PROTOCOL_OK) {
                 return ret;
             }
-            max_dynamic_table_size_ = size;
+            // 不得超过本端通告的SETTINGS_HEADER_TABLE_SIZE
+            if (size > max_dynamic_table_size_) {
+                return PROTOCOL_ERROR_INVALID;
+            }
+            dynamic_table_.set_max_size(size);
         } else {
-            // Literal without Indexing - 文字头域无索引 (0b0000xxxx or 0b0001xxxx)
-            bool never_index = (first_byte & 0x10) != 0;
-            (void)never_index;
-            uint32_t name_idx = first_byte & 0x0F;
-            ptr++;
-
-            std::string name, value;
+            // Literal with Incremental Indexing - 文字头域增量索引 (0b01xxxxxx)
+            // Literal without Indexing / Never Indexed - 文字头域无索引 (0b0000xxxx / 0b0001xxxx)
+            bool indexing = (first_byte & 0xC0) == 0x40;
+            uint32_t name_idx = 0;
+            int ret = details::decode_int(&ptr, end, indexing ? 6 : 4, &name_idx);
+            if (ret != PROTOCOL_OK) {
+                return ret;
+            }
 
             if (name_idx == 0) {
-                int ret = details::decode_string(&ptr, end, &name);
-                if (ret != PROTOCOL_OK) {
-                    return ret;
-                }
-            } else if (name_idx <= details::static_table_size) {
-                name = details::static_table[name_idx - 1].name;
+                // 新名称
+                ret = details::decode_string(&ptr, end, &name);
+            } else {
+                ret = lookup(name_idx, &name, nullptr);
+            }
+            if (ret != PROTOCOL_OK) {
+                return ret;
             }
 
-            int ret = details::decode_string(&ptr, end, &value);
+            ret = details::decode_string(&ptr, end, &value);
             if (ret != PROTOCOL_OK) {
                 return ret;
             }
 
-            if (!name.empty()) {
-                (*headers)[name] = value;
+            if (indexing) {
+                dynamic_table_.add(name, value);
             }
+            (*headers)[name] = value;
+            field_seen = true;
         }
     }
 
@@ -378,6 +712,10 @@ uint32_t HpackDecoder::get_max_dynamic_table_size() const {
     return max_dynamic_table_size_;
 }
 
+const HpackDynamicTable& HpackDecoder::get_dynamic_table() const {
+    return dynamic_table_;
+}
+
 // ==================== 简化HPACK函数 ====================
 
 int hpack_encode(const std::map<std::string, std::string>& headers,
@@ -0,0 +1,96 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: http2_bdp_estimator.cpp
+//  描述: Http2BdpEstimator类实现
+//  版权: Copyright (c) 2026
+// =============================================================================
+#include "protocol/http2_bdp_estimator.hpp"
+#include <algorithm>
+
+namespace https_server_sim {
+namespace protocol {
+
+namespace details {
+
+// RTT平滑系数：新样本权重
+constexpr double BDP_RTT_ALPHA = 0.9;
+// 到达量不低于窗口的该比例时认为窗口已成为瓶颈
+constexpr double BDP_SATURATION_RATIO = 0.66;
+// 窗口放大倍数（相对本次到达量）
+constexpr uint64_t BDP_GROWTH_FACTOR = 2;
+// RTT样本下限（秒），避免零间隔导致带宽无穷大
+constexpr double BDP_MIN_RTT = 1e-6;
+
+} // namespace details
+
+// ==================== Http2BdpEstimator实现 ====================
+
+Http2BdpEstimator::Http2BdpEstimator()
+    : state_(State::IDLE)
+    , window_(0)
+    , max_window_(0)
+    , sample_(0)
+    , sent_at_()
+    , rtt_(0)
+    , max_bandwidth_(0)
+{
+}
+
+void Http2BdpEstimator::init(uint32_t window, uint32_t max_window) {
+    state_ = State::IDLE;
+    window_ = window;
+    max_window_ = max_window;
+    sample_ = 0;
+    rtt_ = 0;
+    max_bandwidth_ = 0;
+}
+
+bool Http2BdpEstimator::add_bytes(size_t bytes) {
+    // 窗口已到上限时不再探测
+    if (window_ >= max_window_) {
+        return false;
+    }
+    if (state_ == State::IDLE) {
+        state_ = State::SCHEDULED;
+        sample_ = bytes;
+        return true;
+    }
+    sample_ += bytes;
+    return false;
+}
+
+void Http2BdpEstimator::ping_sent(Clock::time_point now) {
+    state_ = State::PENDING;
+    sent_at_ = now;
+}
+
+uint32_t Http2BdpEstimator::ping_acked(Clock::time_point now) {
+    if (state_ != State::PENDING) {
+        return 0;
+    }
+    state_ = State::IDLE;
+
+    std::chrono::duration<double> elapsed = now - sent_at_;
+    double sample_rtt = std::max(elapsed.count(), details::BDP_MIN_RTT);
+    rtt_ = (rtt_ == 0) ? sample_rtt : rtt_ + (sample_rtt - rtt_) * details::BDP_RTT_ALPHA;
+
+    // 到达量远小于窗口说明瓶颈不在流控；带宽下降说明是排队而非窗口不足
+    double bandwidth = static_cast<double>(sample_) / rtt_;
+    if (static_cast<double>(sample_) < details::BDP_SATURATION_RATIO * window_ ||
+        bandwidth < max_bandwidth_) {
+        return 0;
+    }
+    max_bandwidth_ = bandwidth;
+
+    uint64_t target = std::min<uint64_t>(sample_ * details::BDP_GROWTH_FACTOR, max_window_);
+    if (target <= window_) {
+        return 0;
+    }
+    window_ = static_cast<uint32_t>(target);
+    return window_;
+}
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
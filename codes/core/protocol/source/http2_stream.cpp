@@ -9,6 +9,42 @@
 namespace https_server_sim {
 namespace protocol {
 
+// ==================== Priority字段解析 ====================
+
+void parse_priority_field(const std::string& value, uint8_t* urgency, bool* incremental) {
+    // 结构化字段字典：以逗号分隔的key[=value]，此处只关心u与i
+    size_t pos = 0;
+    while (pos < value.size()) {
+        size_t comma = value.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = value.size();
+        }
+        size_t start = value.find_first_not_of(" \t", pos);
+        pos = comma + 1;
+        if (start == std::string::npos || start >= comma) {
+            continue;
+        }
+        size_t end = value.find_last_not_of(" \t", comma - 1);
+        std::string item = value.substr(start, end - start + 1);
+
+        // 去掉参数部分（";"之后）
+        size_t semicolon = item.find(';');
+        if (semicolon != std::string::npos) {
+            item.resize(semicolon);
+        }
+
+        if (item.size() == 3 && item[0] == 'u' && item[1] == '=' &&
+            item[2] >= '0' && item[2] <= '7') {
+            *urgency = static_cast<uint8_t>(item[2] - '0');
+        } else if (item == "i" || item == "i=?1") {
+            *incremental = true;
+        } else if (item == "i=?0") {
+            *incremental = false;
+        }
+    }
+}
+
+
 // ==================== Http2Stream实现 ====================
 
 Http2Stream::Http2Stream()
@@ -18,6 +54,14 @@ Http2Stream::Http2Stream()
     , response()
     , send_window(HTTP2_DEFAULT_INITIAL_WINDOW_SIZE)
     , recv_window(HTTP2_DEFAULT_INITIAL_WINDOW_SIZE)
+    , recv_consumed(0)
+    , pending_data()
+    , pending_shared()
+    , pending_offset(0)
+    , pending_end_stream(false)
+    , urgency(HTTP2_DEFAULT_URGENCY)
+    , incremental(false)
+    , awaiting_response(false)
 {
 }
 
@@ -30,6 +74,14 @@ void Http2Stream::init(uint32_t id) {
     response.reset();
     send_window = HTTP2_DEFAULT_INITIAL_WINDOW_SIZE;
     recv_window = HTTP2_DEFAULT_INITIAL_WINDOW_SIZE;
+    recv_consumed = 0;
+    pending_data.clear();
+    pending_shared.reset();
+    pending_offset = 0;
+    pending_end_stream = false;
+    urgency = HTTP2_DEFAULT_URGENCY;
+    incremental = false;
+    awaiting_response = false;
 }
 
 void Http2Stream::reset() {
@@ -39,6 +91,33 @@ void Http2Stream::reset() {
     response.reset();
     send_window = HTTP2_DEFAULT_INITIAL_WINDOW_SIZE;
     recv_window = HTTP2_DEFAULT_INITIAL_WINDOW_SIZE;
+    recv_consumed = 0;
+    // 流对象会被池化复用，过大的缓冲区直接释放，避免长连接持续占用内存
+    if (request.body.capacity() > POOLED_BUFFER_LIMIT) {
+        std::vector<uint8_t>().swap(request.body);
+    }
+    if (pending_data.capacity() > POOLED_BUFFER_LIMIT) {
+        std::vector<uint8_t>().swap(pending_data);
+    }
+    pending_data.clear();
+    pending_shared.reset();
+    pending_offset = 0;
+    pending_end_stream = false;
+    urgency = HTTP2_DEFAULT_URGENCY;
+    incremental = false;
+    awaiting_response = false;
+}
+
+// ==================== Http2CompletionQueue实现 ====================
+
+void Http2CompletionQueue::push(Http2StreamResponse&& response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    responses_.push_back(std::move(response));
+}
+
+void Http2CompletionQueue::drain(std::vector<Http2StreamResponse>* out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out->swap(responses_);
 }
 
 } // namespace protocol
@@ -0,0 +1,140 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: http2_stream_table.cpp
+//  描述: Http2StreamTable类实现
+//  版权: Copyright (c) 2026
+// =============================================================================
+#include "protocol/http2_stream_table.hpp"
+#include <algorithm>
+
+namespace https_server_sim {
+namespace protocol {
+
+// ==================== Http2StreamTable实现 ====================
+
+Http2StreamTable::Http2StreamTable()
+    : slots_()
+    , mask_(0)
+    , size_(0)
+    , max_streams_(0)
+    , pool_()
+    , free_()
+{
+    init(HTTP2_DEFAULT_MAX_CONCURRENT_STREAMS);
+}
+
+Http2StreamTable::~Http2StreamTable() = default;
+
+void Http2StreamTable::init(uint32_t max_streams) {
+    max_streams = std::max<uint32_t>(1, std::min(max_streams, HTTP2_MAX_TRACKED_STREAMS));
+    if (max_streams == max_streams_) {
+        clear();
+        return;
+    }
+
+    // 槽位数取不小于2倍容量的2的幂，负载因子不超过0.5
+    size_t slot_count = 8;
+    while (slot_count < static_cast<size_t>(max_streams) * 2) {
+        slot_count <<= 1;
+    }
+    slots_.assign(slot_count, Slot{0, nullptr});
+    mask_ = slot_count - 1;
+    size_ = 0;
+    max_streams_ = max_streams;
+
+    // 容量变化时丢弃旧对象池，按需重新分配
+    pool_.clear();
+    free_.clear();
+    free_.reserve(max_streams);
+}
+
+size_t Http2StreamTable::find_slot(uint32_t stream_id) const {
+    size_t index = home_slot(stream_id);
+    while (slots_[index].stream != nullptr) {
+        if (slots_[index].stream_id == stream_id) {
+            return index;
+        }
+        index = (index + 1) & mask_;
+    }
+    return slots_.size();
+}
+
+Http2Stream* Http2StreamTable::find(uint32_t stream_id) const {
+    size_t index = find_slot(stream_id);
+    return index < slots_.size() ? slots_[index].stream : nullptr;
+}
+
+Http2Stream* Http2StreamTable::insert(uint32_t stream_id) {
+    if (stream_id == 0 || size_ >= max_streams_) {
+        return nullptr;
+    }
+
+    size_t index = home_slot(stream_id);
+    while (slots_[index].stream != nullptr) {
+        if (slots_[index].stream_id == stream_id) {
+            return nullptr;
+        }
+        index = (index + 1) & mask_;
+    }
+
+    Http2Stream* stream = nullptr;
+    if (!free_.empty()) {
+        stream = free_.back();
+        free_.pop_back();
+    } else {
+        pool_.push_back(std::make_unique<Http2Stream>());
+        stream = pool_.back().get();
+    }
+    stream->init(stream_id);
+
+    slots_[index].stream_id = stream_id;
+    slots_[index].stream = stream;
+    size_++;
+    return stream;
+}
+
+void Http2StreamTable::erase(uint32_t stream_id) {
+    size_t hole = find_slot(stream_id);
+    if (hole >= slots_.size()) {
+        return;
+    }
+
+    Http2Stream* stream = slots_[hole].stream;
+    stream->reset();
+    free_.push_back(stream);
+    slots_[hole].stream = nullptr;
+    size_--;
+
+    // 后移法删除：把探测链上不在(hole, index]之间起始的元素前移填洞
+    size_t index = hole;
+    while (true) {
+        index = (index + 1) & mask_;
+        if (slots_[index].stream == nullptr) {
+            break;
+        }
+        size_t home = home_slot(slots_[index].stream_id);
+        bool stays = (hole <= index) ? (hole < home && home <= index)
+                                     : (hole < home || home <= index);
+        if (!stays) {
+            slots_[hole] = slots_[index];
+            slots_[index].stream = nullptr;
+            hole = index;
+        }
+    }
+}
+
+void Http2StreamTable::clear() {
+    for (Slot& slot : slots_) {
+        if (slot.stream != nullptr) {
+            slot.stream->reset();
+            free_.push_back(slot.stream);
+            slot.stream = nullptr;
+        }
+    }
+    size_ = 0;
+}
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
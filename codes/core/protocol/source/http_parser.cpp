@@ -5,6 +5,7 @@
 //  版权: Copyright (c) 2026
 // =============================================================================
 #include "protocol/http_parser.hpp"
+#include "protocol/http_serializer.hpp"
 #include "protocol/protocol_utils.hpp"
 #include <cstring>
 #include <algorithm>
@@ -262,62 +263,15 @@ bool HttpParser::find_header(const std::map<std::string, std::string>& headers,
 int HttpParser::build_response(const HttpResponse& resp,
                                 uint8_t* out, size_t max_len,
                                 size_t* out_len) {
-    size_t offset = 0;
-
-    // 1. 写入状态行
-    std::string status_line = "HTTP/1.1 " + std::to_string(resp.status_code) +
-                              " " + resp.status_text + "\r\n";
-
-    if (offset + status_line.size() > max_len) {
-        set_error(PROTOCOL_ERROR_BUFFER, "Buffer too small");
-        return PROTOCOL_ERROR_BUFFER;
-    }
-    memcpy(out + offset, status_line.data(), status_line.size());
-    offset += status_line.size();
-
-    // 2. 写入Headers，同时检查是否有Content-Length
-    bool has_content_length = false;
-    for (const auto& header : resp.headers) {
-        std::string header_line = header.first + ": " + header.second + "\r\n";
-        if (offset + header_line.size() > max_len) {
-            set_error(PROTOCOL_ERROR_BUFFER, "Buffer too small");
-            return PROTOCOL_ERROR_BUFFER;
-        }
-        memcpy(out + offset, header_line.data(), header_line.size());
-        offset += header_line.size();
-
-        // 检查是否是Content-Length头（大小写不敏感）
-        if (!has_content_length &&
-            StrCaseCmp(header.first.c_str(), "Content-Length") == 0) {
-            has_content_length = true;
-        }
-    }
-
-    // 3. 如果没有Content-Length且有body，自动添加
-    if (!has_content_length && !resp.body.empty()) {
-        std::string cl_header = "Content-Length: " + std::to_string(resp.body.size()) + "\r\n";
-        if (offset + cl_header.size() > max_len) {
-            set_error(PROTOCOL_ERROR_BUFFER, "Buffer too small");
-            return PROTOCOL_ERROR_BUFFER;
-        }
-        memcpy(out + offset, cl_header.data(), cl_header.size());
-        offset += cl_header.size();
-    }
-
-    // 4. 写入空行（头部结束）
-    if (offset + 2 > max_len) {
+    // 先计算精确长度，避免逐段构造临时字符串
+    size_t head_len = HttpSerializer::header_size(resp, resp.body.size());
+    if (head_len + resp.body.size() > max_len) {
         set_error(PROTOCOL_ERROR_BUFFER, "Buffer too small");
         return PROTOCOL_ERROR_BUFFER;
     }
-    out[offset++] = '\r';
-    out[offset++] = '\n';
 
-    // 5. 写入Body
+    size_t offset = HttpSerializer::write_header(resp, resp.body.size(), out);
     if (!resp.body.empty()) {
-        if (offset + resp.body.size() > max_len) {
-            set_error(PROTOCOL_ERROR_BUFFER, "Buffer too small");
-            return PROTOCOL_ERROR_BUFFER;
-        }
         memcpy(out + offset, resp.body.data(), resp.body.size());
         offset += resp.body.size();
     }
@@ -0,0 +1,244 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: http_serializer.cpp
+//  描述: HttpSerializer类实现
+//  版权: Copyright (c) 2026
+// =============================================================================
+#include "protocol/http_serializer.hpp"
+#include "protocol/protocol_utils.hpp"
+#include <charconv>
+#include <cstring>
+
+namespace https_server_sim {
+namespace protocol {
+
+// ==================== 序列化辅助函数 ====================
+
+namespace details {
+
+// 常用状态码及标准原因短语（RFC 9110）
+#define HTTP_STATUS_LINES(X)                      \
+    X(100, "Continue")                            \
+    X(101, "Switching Protocols")                 \
+    X(200, "OK")                                  \
+    X(201, "Created")                             \
+    X(202, "Accepted")                            \
+    X(204, "No Content")                          \
+    X(206, "Partial Content")                     \
+    X(301, "Moved Permanently")                   \
+    X(302, "Found")                               \
+    X(304, "Not Modified")                        \
+    X(400, "Bad Request")                         \
+    X(401, "Unauthorized")                        \
+    X(403, "Forbidden")                           \
+    X(404, "Not Found")                           \
+    X(405, "Method Not Allowed")                  \
+    X(408, "Request Timeout")                     \
+    X(413, "Content Too Large")                   \
+    X(414, "URI Too Long")                        \
+    X(431, "Request Header Fields Too Large")     \
+    X(500, "Internal Server Error")               \
+    X(501, "Not Implemented")                     \
+    X(502, "Bad Gateway")                         \
+    X(503, "Service Unavailable")                 \
+    X(504, "Gateway Timeout")
+
+// 预生成的状态行表项
+struct StatusLineEntry {
+    const char* reason;
+    size_t reason_len;
+    const char* line;
+    size_t line_len;
+};
+
+#define STATUS_LINE_INDEX(code, reason) STATUS_LINE_IDX_##code,
+enum StatusLineIndex {
+    HTTP_STATUS_LINES(STATUS_LINE_INDEX)
+    STATUS_LINE_COUNT
+};
+#undef STATUS_LINE_INDEX
+
+#define STATUS_LINE_ENTRY(code, reason) \
+    {reason, sizeof(reason) - 1, "HTTP/1.1 " #code " " reason "\r\n", sizeof("HTTP/1.1 " #code " " reason "\r\n") - 1},
+static const StatusLineEntry status_lines[STATUS_LINE_COUNT] = {
+    HTTP_STATUS_LINES(STATUS_LINE_ENTRY)
+};
+#undef STATUS_LINE_ENTRY
+
+// 状态码到表项的映射（switch由编译器生成跳转表）
+static const StatusLineEntry* lookup_status_line(int status_code) {
+#define STATUS_LINE_CASE(code, reason) \
+    case code: return &status_lines[STATUS_LINE_IDX_##code];
+    switch (status_code) {
+        HTTP_STATUS_LINES(STATUS_LINE_CASE)
+        default: return nullptr;
+    }
+#undef STATUS_LINE_CASE
+}
+
+#undef HTTP_STATUS_LINES
+
+constexpr char HTTP_VERSION_PREFIX[] = "HTTP/1.1 ";
+constexpr size_t HTTP_VERSION_PREFIX_LEN = sizeof(HTTP_VERSION_PREFIX) - 1;
+constexpr char CONTENT_LENGTH_PREFIX[] = "Content-Length: ";
+constexpr size_t CONTENT_LENGTH_PREFIX_LEN = sizeof(CONTENT_LENGTH_PREFIX) - 1;
+
+// 十进制数字位数（含负号），足以容纳64位整数
+constexpr size_t MAX_DECIMAL_LEN = 24;
+
+template <typename T>
+static size_t decimal_len(T value) {
+    char tmp[MAX_DECIMAL_LEN];
+    auto result = std::to_chars(tmp, tmp + sizeof(tmp), value);
+    return static_cast<size_t>(result.ptr - tmp);
+}
+
+template <typename T>
+static uint8_t* put_decimal(uint8_t* p, T value) {
+    char* begin = reinterpret_cast<char*>(p);
+    auto result = std::to_chars(begin, begin + MAX_DECIMAL_LEN, value);
+    return reinterpret_cast<uint8_t*>(result.ptr);
+}
+
+static uint8_t* put(uint8_t* p, const char* data, size_t len) {
+    if (len > 0) {
+        memcpy(p, data, len);
+    }
+    return p + len;
+}
+
+// 是否需要自动补充Content-Length头部
+static bool need_content_length(const HttpResponse& resp, size_t body_len) {
+    if (body_len == 0) {
+        return false;
+    }
+    for (const auto& header : resp.headers) {
+        if (StrCaseCmp(header.first.c_str(), "Content-Length") == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace details
+
+// ==================== HttpSerializer实现 ====================
+
+const char* HttpSerializer::find_status_line(int status_code,
+                                             const std::string& status_text,
+                                             size_t* out_len) {
+    const details::StatusLineEntry* entry = details::lookup_status_line(status_code);
+    if (entry == nullptr ||
+        entry->reason_len != status_text.size() ||
+        memcmp(entry->reason, status_text.data(), entry->reason_len) != 0) {
+        return nullptr;
+    }
+    if (out_len) {
+        *out_len = entry->line_len;
+    }
+    return entry->line;
+}
+
+size_t HttpSerializer::header_size(const HttpResponse& resp, size_t body_len) {
+    size_t size = 0;
+
+    // 1. 状态行
+    size_t line_len = 0;
+    if (find_status_line(resp.status_code, resp.status_text, &line_len) != nullptr) {
+        size += line_len;
+    } else {
+        size += details::HTTP_VERSION_PREFIX_LEN +
+                details::decimal_len(resp.status_code) + 1 +
+                resp.status_text.size() + 2;
+    }
+
+    // 2. 头部："name: value\r\n"
+    for (const auto& header : resp.headers) {
+        size += header.first.size() + 2 + header.second.size() + 2;
+    }
+
+    // 3. 自动补充的Content-Length
+    if (details::need_content_length(resp, body_len)) {
+        size += details::CONTENT_LENGTH_PREFIX_LEN + details::decimal_len(body_len) + 2;
+    }
+
+    // 4. 空行
+    return size + 2;
+}
+
+size_t HttpSerializer::write_header(const HttpResponse& resp, size_t body_len, uint8_t* out) {
+    uint8_t* p = out;
+
+    // 1. 状态行：优先使用预生成表
+    size_t line_len = 0;
+    const char* line = find_status_line(resp.status_code, resp.status_text, &line_len);
+    if (line != nullptr) {
+        p = details::put(p, line, line_len);
+    } else {
+        p = details::put(p, details::HTTP_VERSION_PREFIX, details::HTTP_VERSION_PREFIX_LEN);
+        p = details::put_decimal(p, resp.status_code);
+        *p++ = ' ';
+        p = details::put(p, resp.status_text.data(), resp.status_text.size());
+        *p++ = '\r';
+        *p++ = '\n';
+    }
+
+    // 2. 头部
+    for (const auto& header : resp.headers) {
+        p = details::put(p, header.first.data(), header.first.size());
+        *p++ = ':';
+        *p++ = ' ';
+        p = details::put(p, header.second.data(), header.second.size());
+        *p++ = '\r';
+        *p++ = '\n';
+    }
+
+    // 3. 自动补充Content-Length
+    if (details::need_content_length(resp, body_len)) {
+        p = details::put(p, details::CONTENT_LENGTH_PREFIX, details::CONTENT_LENGTH_PREFIX_LEN);
+        p = details::put_decimal(p, body_len);
+        *p++ = '\r';
+        *p++ = '\n';
+    }
+
+    // 4. 空行
+    *p++ = '\r';
+    *p++ = '\n';
+
+    return static_cast<size_t>(p - out);
+}
+
+int HttpSerializer::serialize(const HttpResponse& resp, utils::Buffer* out, bool include_body) {
+    return serialize(resp, reinterpret_cast<const uint8_t*>(resp.body.data()),
+                     resp.body.size(), out, include_body);
+}
+
+int HttpSerializer::serialize(const HttpResponse& resp, const uint8_t* body, size_t body_len,
+                              utils::Buffer* out, bool include_body) {
+    if (out == nullptr || (body == nullptr && body_len > 0)) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    size_t head_len = header_size(resp, body_len);
+    size_t total = head_len + (include_body ? body_len : 0);
+
+    // 一次reserve，缓冲区容量足够时不触发任何分配
+    uint8_t* p = out->reserve(total);
+    if (p == nullptr) {
+        return PROTOCOL_ERROR_BUFFER;
+    }
+
+    size_t written = write_header(resp, body_len, p);
+    if (include_body && body_len > 0) {
+        memcpy(p + written, body, body_len);
+        written += body_len;
+    }
+
+    out->commit(written);
+    return PROTOCOL_OK;
+}
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
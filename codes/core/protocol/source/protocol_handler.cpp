@@ -1,7 +1,7 @@
 // =============================================================================
 //  HTTPS Server Simulator - Protocol Module
 //  文件: protocol_handler.cpp
-//  描述: ProtocolHandler接口实现类（Http1Handler/Http2Handler/ProtocolFactory）
+//  描述: ProtocolHandler接口实现类（Http1Handler/Http2Handler/NegotiatingHandler/ProtocolFactory）
 //  版权: Copyright (c) 2026
 // =============================================================================
 #include "protocol/protocol_handler.hpp"
@@ -11,6 +11,8 @@
 #include "connection/connection.hpp"
 #include "callback/client_context.h"
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstring>
 #include <cstdlib>
 #include <cerrno>
@@ -18,6 +20,81 @@
 namespace https_server_sim {
 namespace protocol {
 
+namespace details {
+
+// 连接级接收窗口大小：初始固定为65535，本端配置更大的流窗口时同步放大
+static int32_t connection_recv_window_size(const Http2Settings& local_settings) {
+    uint32_t size = std::max(local_settings.initial_window_size, HTTP2_DEFAULT_INITIAL_WINDOW_SIZE);
+    return static_cast<int32_t>(std::min(size, static_cast<uint32_t>(HTTP2_MAX_WINDOW_SIZE)));
+}
+
+// 分发给握手线程的TLS握手：在途期间独占TLS处理器，密文读写只经过任务自己的缓冲区
+struct TlsHandshakeJob {
+    std::unique_ptr<TlsHandler> tls_handler;
+    utils::Buffer input;                // 分发时从连接读缓冲区移入的密文
+    utils::Buffer output;               // 握手产生的待发送数据
+    int result = PROTOCOL_OK;
+    std::atomic<bool> done{false};
+};
+
+// 分发给工作线程的HTTP/2请求，持有生成响应所需的全部数据，不引用连接与流
+struct Http2RequestJob {
+    uint32_t stream_id = 0;
+    uint64_t generation = 0;
+    ClientInfo client_info;
+    CompressionConfig compression;
+    HttpRequest request;
+};
+
+// 流排队DATA的数据源：共享响应体优先，否则为流自有缓冲
+static const std::vector<uint8_t>& pending_bytes(const Http2Stream* stream) {
+    return stream->pending_shared ? *stream->pending_shared : stream->pending_data;
+}
+
+// 为单个流生成响应（工作线程执行，只访问job与线程安全的压缩缓存）
+static void build_stream_response(Http2RequestJob* job, Http2StreamResponse* response) {
+    response->stream_id = job->stream_id;
+    response->generation = job->generation;
+
+    // 模拟Callback模块调用
+    response->headers[":status"] = "200";
+    response->headers["content-type"] = "text/plain";
+
+    // 如果有请求体，回显请求体，否则返回"OK"
+    if (job->request.body.empty()) {
+        static const uint8_t kDefaultBody[] = {'O', 'K'};
+        response->body.assign(kDefaultBody, kDefaultBody + sizeof(kDefaultBody));
+    } else {
+        response->body = std::move(job->request.body);
+    }
+
+    // 按accept-encoding压缩，结果由全局缓存共享
+    const CompressionConfig& compression = job->compression;
+    if (!compression.enabled || response->body.size() < compression.min_size) {
+        return;
+    }
+    for (const auto& header : job->request.headers) {
+        if (StrCaseCmp(header.first.c_str(), "accept-encoding") != 0) {
+            continue;
+        }
+        ContentEncoding encoding = negotiate_content_encoding(header.second);
+        if (encoding != ContentEncoding::IDENTITY) {
+            CompressionCache::Body compressed = CompressionCache::instance().get_or_compress(
+                response->body.data(), response->body.size(), encoding, compression.level);
+            if (compressed && compressed->size() < response->body.size()) {
+                response->headers["content-encoding"] = content_encoding_name(encoding);
+                response->headers["vary"] = "accept-encoding";
+                // 直接引用缓存中的压缩体，分帧时才拷贝到输出批次
+                response->shared_body = std::move(compressed);
+                response->body.clear();
+            }
+        }
+        break;
+    }
+}
+
+} // namespace details
+
 // ==================== Http1Handler实现 ====================
 
 Http1Handler::Http1Handler()
@@ -29,7 +106,19 @@ Http1Handler::Http1Handler()
     , read_buffer_(nullptr)
     , write_buffer_(nullptr)
     , plaintext_buffer_(std::make_unique<utils::Buffer>())
+    , response_buffer_(std::make_unique<utils::Buffer>())
     , parser_()
+    , batching_(false)
+    , response_template_(nullptr)
+    , cached_template_()
+    , cached_template_status_(0)
+    , cached_template_version_(0)
+    , compression_()
+    , compressed_body_()
+    , response_encoding_(ContentEncoding::IDENTITY)
+    , file_fd_(-1)
+    , file_offset_(0)
+    , file_remaining_(0)
 {
 }
 
@@ -38,12 +127,23 @@ Http1Handler::~Http1Handler() = default;
 int Http1Handler::init(Connection* conn,
                        const CertConfig& cert_config,
                        const TlsConfig& tls_config) {
-    conn_ = conn;
-
     int ret = tls_handler_->init(conn, cert_config, tls_config);
     if (ret != PROTOCOL_OK) {
         return ret;
     }
+    return bind_connection(conn);
+}
+
+int Http1Handler::attach(Connection* conn, std::unique_ptr<TlsHandler> tls_handler) {
+    if (!tls_handler) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+    tls_handler_ = std::move(tls_handler);
+    return bind_connection(conn);
+}
+
+int Http1Handler::bind_connection(Connection* conn) {
+    conn_ = conn;
 
     // 从Connection获取Buffer指针
     if (conn_) {
@@ -63,13 +163,10 @@ int Http1Handler::on_read() {
         return PROTOCOL_ERROR_INVALID;
     }
 
-    uint8_t temp_buf[TEMP_BUFFER_SIZE];
+    // 一次读事件内取完TLS层已解密的全部数据，直接解密到明文缓冲区
     size_t read_len = 0;
-    int ret = tls_handler_->read(temp_buf, sizeof(temp_buf), &read_len);
-    if (ret == PROTOCOL_ERROR_EAGAIN) {
-        return PROTOCOL_OK;
-    }
-    if (ret < 0) {
+    int ret = tls_handler_->read_into(plaintext_buffer_.get(), &read_len);
+    if (ret < 0 && ret != PROTOCOL_ERROR_EAGAIN) {
         state_ = Http1ParseState::ERROR;
         response_.status_code = 400;
         response_.status_text = "Bad Request";
@@ -77,9 +174,17 @@ int Http1Handler::on_read() {
         return PROTOCOL_ERROR_INVALID;
     }
 
-    if (read_len > 0) {
-        plaintext_buffer_->write(temp_buf, read_len);
-    }
+    // 处理缓冲区内所有完整请求（流水线），响应按序排队，最后一次性写出
+    batching_ = true;
+    ret = process_requests();
+    batching_ = false;
+
+    int flush_ret = flush_responses();
+    return (ret != PROTOCOL_OK) ? ret : flush_ret;
+}
+
+int Http1Handler::process_requests() {
+    int ret = PROTOCOL_OK;
 
     // 确保parser_已正确初始化
     parser_.init(plaintext_buffer_.get());
@@ -186,11 +291,17 @@ int Http1Handler::on_read() {
             }
 
             case Http1ParseState::EXPECT_COMPLETE: {
+                // 0-RTT早期数据可能被重放：不可重放的方法（及其后的流水线请求）等握手完成再处理
+                if (tls_handler_->is_early_data() && !tls_handler_->is_early_data_method(request_.method)) {
+                    return PROTOCOL_OK;
+                }
                 ret = handle_complete_request();
-                if (ret == PROTOCOL_OK) {
-                    reset();
+                if (ret != PROTOCOL_OK) {
+                    return ret;
                 }
-                return ret;
+                // 继续处理缓冲区中后续的流水线请求
+                reset();
+                break;
             }
 
             case Http1ParseState::ERROR: {
@@ -207,11 +318,16 @@ int Http1Handler::on_read() {
 }
 
 int Http1Handler::on_write() {
-    // 处理写事件：尝试将TLS层待发送的数据 flush 到Connection写缓冲区
+    // 处理写事件：续写TLS层暂存的明文，再续发文件响应体与其后排队的响应
     if (tls_handler_) {
-        // TLSHandler的write()方法内部已包含pump_write_bio()逻辑
-        // 这里我们无需额外操作，因为generate_response()已通过tls_handler_->write()发送数据
-        // 如果有部分写入的场景，这里可以补充处理
+        int ret = tls_handler_->flush_pending();
+        if (ret == PROTOCOL_OK) {
+            ret = continue_file_response();
+        }
+        if (ret == PROTOCOL_OK) {
+            ret = flush_responses();
+        }
+        return ret == PROTOCOL_ERROR_EAGAIN ? PROTOCOL_OK : ret;
     }
     return PROTOCOL_OK;
 }
@@ -225,6 +341,8 @@ void Http1Handler::close() {
     if (tls_handler_) {
         tls_handler_->close();
     }
+    response_buffer_->clear();
+    file_remaining_ = 0;
     reset();
 }
 
@@ -240,6 +358,9 @@ void Http1Handler::reset() {
     state_ = Http1ParseState::EXPECT_REQUEST_LINE;
     request_.reset();
     response_.reset();
+    response_template_ = nullptr;
+    compressed_body_.reset();
+    response_encoding_ = ContentEncoding::IDENTITY;
     parser_.reset();
     parser_.init(plaintext_buffer_.get());
 }
@@ -274,68 +395,189 @@ int Http1Handler::handle_complete_request() {
 
     // 模拟AsyncParseContentFunc调用（桩代码）
     // 实际项目中: strategy->parse(&ctx, body_data, body_len);
+    (void)body_data;
 
     // 模拟AsyncReplyContentFunc调用（桩代码）
     // uint8_t reply_buf[4096];
     // uint32_t reply_len = 0;
     // 实际项目中: strategy->reply(&ctx, reply_buf, &reply_len);
 
-    // 默认回复
+    // 默认回复：端口注册了模板时跳过头部序列化
     response_.status_code = 200;
     response_.status_text = "OK";
-    response_.add_header("Content-Type", "text/plain");
+    response_template_ = find_response_template(200);
+    if (response_template_ == nullptr) {
+        response_.add_header("Content-Type", "text/plain");
+    }
 
-    // 如果有请求体，回显请求体，否则返回"OK"
+    // 如果有请求体，回显请求体（交换所有权，不拷贝），否则返回"OK"
     if (body_len > 0) {
-        response_.set_body(body_data, body_len);
+        response_.body.swap(request_.body);
     } else {
         const char* reply = "OK";
         response_.set_body(reinterpret_cast<const uint8_t*>(reply), 2);
     }
 
+    std::string accept_encoding;
+    if (compression_.enabled &&
+        parser_.find_header(request_.headers, "Accept-Encoding", &accept_encoding)) {
+        apply_compression(accept_encoding);
+    }
+
     return generate_response();
 }
 
 int Http1Handler::generate_response() {
-    // 使用动态分配的缓冲区避免栈溢出
-    // 先估算需要的大小：状态行 + 头部 + 空行 + 体
-    size_t estimated_size = 1024; // 状态行和基本头部
-    for (const auto& header : response_.headers) {
-        estimated_size += header.first.size() + header.second.size() + 32;
+    // 头部按精确长度一次性序列化，追加到待发送响应之后（保持流水线顺序）；
+    // 小响应体随头部一起拷贝，大响应体不经过中间缓冲区，作为独立片段分散写入TLS层
+    const uint8_t* body = response_.body.data();
+    size_t body_len = response_.body.size();
+    if (compressed_body_) {
+        body = compressed_body_->data();
+        body_len = compressed_body_->size();
+    }
+    // 文件响应体未发完时后续响应只能排队，不走分散写
+    bool scatter = body_len >= RESPONSE_SCATTER_THRESHOLD && file_remaining_ == 0;
+
+    int ret = PROTOCOL_OK;
+    if (response_template_ != nullptr && response_.headers.empty()) {
+        size_t extra_len = 0;
+        const char* extra = content_encoding_header_lines(response_encoding_, &extra_len);
+        ret = response_template_->render(body, body_len, response_buffer_.get(), !scatter,
+                                         extra, extra_len);
+    } else {
+        ret = HttpSerializer::serialize(response_, body, body_len, response_buffer_.get(), !scatter);
+    }
+    if (ret != PROTOCOL_OK) {
+        return ret;
     }
-    estimated_size += response_.body.size() + 64; // 额外余量
 
-    std::vector<uint8_t> buf(estimated_size);
-    size_t out_len = 0;
-    int ret = parser_.build_response(response_, buf.data(), buf.size(), &out_len);
+    if (scatter) {
+        // 已排队的响应与本响应头部、响应体一起写出
+        if (!tls_handler_) {
+            response_buffer_->clear();
+            return PROTOCOL_ERROR_INVALID;
+        }
+        IoSlice slices[2] = {
+            {response_buffer_->read_ptr(), response_buffer_->readable_bytes()},
+            {body, body_len}
+        };
+        size_t written = 0;
+        ret = tls_handler_->writev(slices, 2, &written);
+        response_buffer_->clear();
+        return ret;
+    }
 
-    // 如果缓冲区不够，扩容后重试
-    if (ret == PROTOCOL_ERROR_BUFFER) {
-        // 计算实际需要的大小
-        estimated_size = 4096 + response_.body.size();
-        buf.resize(estimated_size);
-        ret = parser_.build_response(response_, buf.data(), buf.size(), &out_len);
+    // 非批处理或排队数据过多时立即写出
+    if (!batching_ || response_buffer_->readable_bytes() >= RESPONSE_BATCH_FLUSH_THRESHOLD) {
+        return flush_responses();
     }
+    return PROTOCOL_OK;
+}
 
-    if (ret != PROTOCOL_OK) {
-        return ret;
+int Http1Handler::flush_responses() {
+    // 文件响应体未发完时保留排队的响应，由on_write在文件发完后写出
+    if (response_buffer_->readable_bytes() == 0 || file_remaining_ > 0) {
+        return PROTOCOL_OK;
     }
 
-    // 只通过TlsHandler进行数据加密发送，避免双重写入
+    int ret = PROTOCOL_ERROR_INVALID;
     if (tls_handler_) {
         size_t written = 0;
-        ret = tls_handler_->write(buf.data(), out_len, &written);
-        if (ret != PROTOCOL_OK) {
-            return ret;
-        }
-        // 检查是否所有数据都写入了
-        if (written != out_len) {
-            // 部分写入的情况，这里简化处理
-            // 实际项目中应该处理这种情况
-        }
+        ret = tls_handler_->write(response_buffer_->read_ptr(),
+                                  response_buffer_->readable_bytes(), &written);
     }
+    response_buffer_->clear();
+    return ret;
+}
 
-    return PROTOCOL_OK;
+int Http1Handler::send_file_response(int file_fd, int64_t offset, size_t len) {
+    if (!tls_handler_) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+    if (file_remaining_ > 0) {
+        return PROTOCOL_ERROR_EAGAIN;
+    }
+
+    // 头部按文件长度生成Content-Length，排在已排队的流水线响应之后一起写出；
+    // 响应体不经过用户态缓冲区
+    uint8_t* p = response_buffer_->reserve(HttpSerializer::header_size(response_, len));
+    if (p == nullptr) {
+        return PROTOCOL_ERROR_BUFFER;
+    }
+    response_buffer_->commit(HttpSerializer::write_header(response_, len, p));
+
+    int ret = flush_responses();
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+
+    // 头部未写完的部分暂存在TLS层，send_file会先写出它再发送文件内容
+    file_fd_ = file_fd;
+    file_offset_ = offset;
+    file_remaining_ = len;
+    return continue_file_response();
+}
+
+int Http1Handler::continue_file_response() {
+    if (file_remaining_ == 0) {
+        return PROTOCOL_OK;
+    }
+
+    size_t sent = 0;
+    int ret = tls_handler_->send_file(file_fd_, file_offset_, file_remaining_, &sent);
+    file_offset_ += static_cast<int64_t>(sent);
+    file_remaining_ -= sent;
+    if (ret != PROTOCOL_OK && ret != PROTOCOL_ERROR_EAGAIN) {
+        file_remaining_ = 0;
+    }
+    return ret;
+}
+
+void Http1Handler::set_compression_config(const CompressionConfig& config) {
+    compression_ = config;
+}
+
+void Http1Handler::apply_compression(const std::string& accept_encoding) {
+    size_t body_len = response_.body.size();
+    if (body_len < compression_.min_size) {
+        return;
+    }
+
+    ContentEncoding encoding = negotiate_content_encoding(accept_encoding);
+    if (encoding == ContentEncoding::IDENTITY) {
+        return;
+    }
+
+    // 相同内容的压缩结果由全局缓存共享；压缩后不更小时发送原始响应体
+    CompressionCache::Body compressed = CompressionCache::instance().get_or_compress(
+        response_.body.data(), body_len, encoding, compression_.level);
+    if (!compressed || compressed->size() >= body_len) {
+        return;
+    }
+
+    compressed_body_ = std::move(compressed);
+    response_encoding_ = encoding;
+    if (response_template_ == nullptr) {
+        response_.add_header("Content-Encoding", content_encoding_name(encoding));
+        response_.add_header("Vary", "Accept-Encoding");
+    }
+}
+
+const ResponseTemplate* Http1Handler::find_response_template(int status_code) {
+    if (conn_ == nullptr) {
+        return nullptr;
+    }
+
+    // 注册表未变化且状态码相同时直接复用上次查找结果，避免每次加锁
+    ResponseTemplateRegistry& registry = ResponseTemplateRegistry::instance();
+    uint64_t version = registry.get_version();
+    if (version != cached_template_version_ || status_code != cached_template_status_) {
+        cached_template_ = registry.find(conn_->get_client_info().server_port, status_code);
+        cached_template_version_ = version;
+        cached_template_status_ = status_code;
+    }
+    return cached_template_.get();
 }
 
 // ==================== Http2Handler实现 ====================
@@ -350,10 +592,28 @@ Http2Handler::Http2Handler()
     , settings_()
     , local_settings_()
     , last_stream_id_(0)
+    , preface_received_(false)
+    , header_block_()
+    , continuation_stream_id_(0)
+    , header_end_stream_(false)
+    , discarded_headers_()
     , hpack_encoder_(std::make_unique<HpackEncoder>())
     , hpack_decoder_(std::make_unique<HpackDecoder>())
     , settings_ack_received_(false)
     , settings_ack_sent_(false)
+    , compression_()
+    , conn_send_window_(HTTP2_DEFAULT_INITIAL_WINDOW_SIZE)
+    , conn_recv_window_(HTTP2_DEFAULT_INITIAL_WINDOW_SIZE)
+    , conn_recv_consumed_(0)
+    , bdp_()
+    , max_receive_window_(HTTP2_DEFAULT_MAX_RECEIVE_WINDOW)
+    , ready_()
+    , rr_last_stream_id_(0)
+    , frame_batch_()
+    , dispatcher_()
+    , completions_(std::make_shared<Http2CompletionQueue>())
+    , completed_()
+    , dispatch_generation_(0)
 {
 }
 
@@ -362,12 +622,23 @@ Http2Handler::~Http2Handler() = default;
 int Http2Handler::init(Connection* conn,
                        const CertConfig& cert_config,
                        const TlsConfig& tls_config) {
-    conn_ = conn;
-
     int ret = tls_handler_->init(conn, cert_config, tls_config);
     if (ret != PROTOCOL_OK) {
         return ret;
     }
+    return bind_connection(conn);
+}
+
+int Http2Handler::attach(Connection* conn, std::unique_ptr<TlsHandler> tls_handler) {
+    if (!tls_handler) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+    tls_handler_ = std::move(tls_handler);
+    return bind_connection(conn);
+}
+
+int Http2Handler::bind_connection(Connection* conn) {
+    conn_ = conn;
 
     // 从Connection获取Buffer指针
     if (conn_) {
@@ -378,57 +649,104 @@ int Http2Handler::init(Connection* conn,
         tls_handler_->set_write_buffer(write_buffer_);
     }
 
+    // local_settings_由set_local_settings配置，这里只重置对端参数
     settings_.reset();
-    local_settings_.reset();
-    streams_.clear();
-    last_stream_id_ = 0;
-    settings_ack_received_ = false;
-    settings_ack_sent_ = false;
+    streams_.init(local_settings_.max_concurrent_streams);
+    reset();
 
     send_settings_frame();
+    // 连接级窗口不受SETTINGS影响，需通过WINDOW_UPDATE放大到本端配置的窗口
+    int32_t conn_window = details::connection_recv_window_size(local_settings_);
+    if (conn_window > static_cast<int32_t>(HTTP2_DEFAULT_INITIAL_WINDOW_SIZE)) {
+        send_window_update_frame(0, static_cast<uint32_t>(conn_window) - HTTP2_DEFAULT_INITIAL_WINDOW_SIZE);
+    }
+    // 此时TLS层可能尚不可写（握手未完成），SETTINGS等留在输出缓冲中，由首次读/写事件写出
     return PROTOCOL_OK;
 }
 
 int Http2Handler::on_read() {
-    uint8_t temp_buf[TEMP_BUFFER_SIZE];
+    // 一次读事件内取完TLS层已解密的全部数据（直接解密到明文缓冲区），再统一解析帧
     size_t read_len = 0;
-    int ret = tls_handler_->read(temp_buf, sizeof(temp_buf), &read_len);
-    if (ret == PROTOCOL_ERROR_EAGAIN) {
-        return PROTOCOL_OK;
-    }
-    if (ret < 0) {
+    int ret = tls_handler_->read_into(plaintext_buffer_.get(), &read_len);
+    if (ret < 0 && ret != PROTOCOL_ERROR_EAGAIN) {
         return ret;
     }
 
-    if (read_len > 0) {
-        plaintext_buffer_->write(temp_buf, read_len);
-    }
-
     while (true) {
         ret = read_frame();
         if (ret == PROTOCOL_ERROR_EAGAIN) {
             break;
         }
         if (ret < 0) {
+            // 出错前已排队的帧（如RST_STREAM）仍需写出
+            flush_frame_batch();
             return ret;
         }
     }
 
-    return PROTOCOL_OK;
+    // 本批帧处理完成后发送已完成的响应并统一调度DATA，使同一批完成的响应能按优先级交错
+    return on_callback_done();
 }
 
 int Http2Handler::on_write() {
-    // 处理写事件：尝试将TLS层待发送的数据 flush 到Connection写缓冲区
+    // 处理写事件：写缓冲区已满时TLS层暂存的明文在此继续加密写出，之后写出仍在排队的帧
     if (tls_handler_) {
-        // TLSHandler的write()方法内部已包含pump_write_bio()逻辑
-        // 这里我们无需额外操作
-        // 如果有部分写入的场景，这里可以补充处理
+        int ret = tls_handler_->flush_pending();
+        if (ret != PROTOCOL_OK) {
+            return ret == PROTOCOL_ERROR_EAGAIN ? PROTOCOL_OK : ret;
+        }
     }
-    return PROTOCOL_OK;
+    return flush_frame_batch();
 }
 
 int Http2Handler::send_response(const uint8_t* data, uint32_t len) {
-    return send_data_frame(1, data, len, true);
+    // 通用接口不带流ID，发往最近打开的请求流
+    return send_response(last_stream_id_, data, len);
+}
+
+int Http2Handler::send_response(uint32_t stream_id, const uint8_t* data, uint32_t len) {
+    Http2Stream* stream = streams_.find(stream_id);
+    if (stream == nullptr) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+    stream->awaiting_response = false;
+    int ret = send_data_frame(stream_id, data, len, true);
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+    return flush_pending_data();
+}
+
+int Http2Handler::on_callback_done() {
+    completions_->drain(&completed_);
+    int ret = PROTOCOL_OK;
+    for (Http2StreamResponse& response : completed_) {
+        if (ret != PROTOCOL_OK || response.generation != dispatch_generation_) {
+            continue;
+        }
+        // 等待期间被RST_STREAM关闭的流不再响应
+        Http2Stream* stream = streams_.find(response.stream_id);
+        if (stream == nullptr || !stream->awaiting_response) {
+            continue;
+        }
+        stream->awaiting_response = false;
+        ret = send_headers_frame(response.stream_id, response.headers, false);
+        if (ret == PROTOCOL_OK) {
+            ret = response.shared_body
+                ? send_shared_data_frame(response.stream_id, response.shared_body, true)
+                : send_data_frame(response.stream_id, response.body.data(),
+                                  response.body.size(), true);
+        }
+    }
+    completed_.clear();
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+    return flush_pending_data();
+}
+
+void Http2Handler::set_task_dispatcher(TaskDispatcher dispatcher) {
+    dispatcher_ = std::move(dispatcher);
 }
 
 void Http2Handler::close() {
@@ -449,11 +767,57 @@ ProtocolType Http2Handler::get_protocol_type() const {
 void Http2Handler::reset() {
     streams_.clear();
     last_stream_id_ = 0;
+    preface_received_ = false;
+    header_block_.clear();
+    continuation_stream_id_ = 0;
+    header_end_stream_ = false;
     settings_ack_received_ = false;
     settings_ack_sent_ = false;
+    conn_send_window_ = HTTP2_DEFAULT_INITIAL_WINDOW_SIZE;
+    conn_recv_window_ = details::connection_recv_window_size(local_settings_);
+    conn_recv_consumed_ = 0;
+    bdp_.init(static_cast<uint32_t>(conn_recv_window_), max_receive_window_);
+    rr_last_stream_id_ = 0;
+    frame_batch_.clear();
+    // 重置前分发的请求仍可能在工作线程中完成，其响应按代数丢弃
+    dispatch_generation_++;
+}
+
+void Http2Handler::set_compression_config(const CompressionConfig& config) {
+    compression_ = config;
+}
+
+void Http2Handler::set_local_settings(const Http2Settings& settings) {
+    local_settings_ = settings;
+    if (local_settings_.initial_window_size > static_cast<uint32_t>(HTTP2_MAX_WINDOW_SIZE)) {
+        local_settings_.initial_window_size = HTTP2_MAX_WINDOW_SIZE;
+    }
+    conn_recv_window_ = details::connection_recv_window_size(local_settings_);
+    bdp_.init(static_cast<uint32_t>(conn_recv_window_), max_receive_window_);
+    // 对端的表大小更新不得超过本端通告的SETTINGS_HEADER_TABLE_SIZE
+    hpack_decoder_->set_max_dynamic_table_size(local_settings_.header_table_size);
+}
+
+void Http2Handler::set_max_receive_window(uint32_t max_window) {
+    max_receive_window_ = std::min(max_window, static_cast<uint32_t>(HTTP2_MAX_WINDOW_SIZE));
+    bdp_.init(static_cast<uint32_t>(details::connection_recv_window_size(local_settings_)),
+              max_receive_window_);
 }
 
 int Http2Handler::read_frame() {
+    // 连接的第一批数据必须是客户端前言，之后才是帧
+    if (!preface_received_) {
+        if (plaintext_buffer_->readable_bytes() < HTTP2_CLIENT_PREFACE_LEN) {
+            return PROTOCOL_ERROR_EAGAIN;
+        }
+        if (std::memcmp(plaintext_buffer_->read_ptr(), HTTP2_CLIENT_PREFACE,
+                        HTTP2_CLIENT_PREFACE_LEN) != 0) {
+            return PROTOCOL_ERROR_INVALID;
+        }
+        plaintext_buffer_->skip(HTTP2_CLIENT_PREFACE_LEN);
+        preface_received_ = true;
+    }
+
     if (plaintext_buffer_->readable_bytes() < HTTP2_FRAME_HEADER_SIZE) {
         return PROTOCOL_ERROR_EAGAIN;
     }
@@ -487,9 +851,14 @@ int Http2Handler::read_frame() {
 }
 
 int Http2Handler::handle_frame(const Http2FrameHeader* header, const uint8_t* payload) {
+    // 头部块未结束时只允许同一流的CONTINUATION
+    if (continuation_stream_id_ != 0 && header->type != Http2FrameType::CONTINUATION) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+
     switch (header->type) {
         case Http2FrameType::SETTINGS:
-            return handle_settings_frame(payload, header->length);
+            return handle_settings_frame(payload, header->length, header->flags);
         case Http2FrameType::HEADERS:
             return handle_headers_frame(header->stream_id, payload, header->length, header->flags);
         case Http2FrameType::DATA:
@@ -516,17 +885,26 @@ int Http2Handler::handle_frame(const Http2FrameHeader* header, const uint8_t* pa
             }
             break;
         case Http2FrameType::PING:
-            return handle_ping_frame(payload, header->length);
+            return handle_ping_frame(payload, header->length, header->flags);
         case Http2FrameType::GOAWAY:
             return handle_goaway_frame(payload, header->length);
+        case Http2FrameType::PRIORITY_UPDATE:
+            if (header->stream_id != 0) {
+                return PROTOCOL_ERROR_INVALID;
+            }
+            return handle_priority_update_frame(payload, header->length);
         default:
             break;
     }
     return PROTOCOL_OK;
 }
 
-int Http2Handler::handle_settings_frame(const uint8_t* payload, size_t len) {
-    if (len == 0) {
+int Http2Handler::handle_settings_frame(const uint8_t* payload, size_t len, uint8_t flags) {
+    // ACK只确认本端SETTINGS，不带参数；不带ACK的空SETTINGS同样需要回复ACK
+    if (flags & HTTP2_FLAG_ACK) {
+        if (len != 0) {
+            return PROTOCOL_ERROR_INVALID;  // FRAME_SIZE_ERROR
+        }
         settings_ack_received_ = true;
         return PROTOCOL_OK;
     }
@@ -542,11 +920,43 @@ int Http2Handler::handle_settings_frame(const uint8_t* payload, size_t len) {
         pos += 6;
 
         switch (id) {
-            case 1: settings_.header_table_size = value; break;
+            case 1:
+                // 对端解码器的动态表容量，编码器在下一个头部块通告表大小更新；
+                // RFC 7541 4.2允许编码器只用其中一部分，本端不超过默认4096字节
+                settings_.header_table_size = value;
+                hpack_encoder_->set_max_dynamic_table_size(
+                    std::min(value, HpackDynamicTable::DEFAULT_MAX_SIZE));
+                break;
             case 2: settings_.enable_push = value; break;
             case 3: settings_.max_concurrent_streams = value; break;
-            case 4: settings_.initial_window_size = value; break;
-            case 5: settings_.max_frame_size = value; break;
+            case 4: {
+                if (value > static_cast<uint32_t>(HTTP2_MAX_WINDOW_SIZE)) {
+                    return PROTOCOL_ERROR_INVALID;  // FLOW_CONTROL_ERROR
+                }
+                // 初始窗口变化按差值作用于所有已打开流的发送窗口（可变为负数）
+                int64_t delta = static_cast<int64_t>(value) -
+                                static_cast<int64_t>(settings_.initial_window_size);
+                bool overflow = false;
+                streams_.for_each([delta, &overflow](Http2Stream* stream) {
+                    int64_t window = stream->send_window + delta;
+                    if (window > HTTP2_MAX_WINDOW_SIZE) {
+                        overflow = true;
+                        return;
+                    }
+                    stream->send_window = static_cast<int32_t>(window);
+                });
+                if (overflow) {
+                    return PROTOCOL_ERROR_INVALID;  // FLOW_CONTROL_ERROR
+                }
+                settings_.initial_window_size = value;
+                break;
+            }
+            case 5:
+                if (value < HTTP2_DEFAULT_MAX_FRAME_SIZE || value > HTTP2_MAX_FRAME_SIZE_LIMIT) {
+                    return PROTOCOL_ERROR_INVALID;  // PROTOCOL_ERROR
+                }
+                settings_.max_frame_size = value;
+                break;
             case 6: settings_.max_header_list_size = value; break;
             default: break;
         }
@@ -557,131 +967,295 @@ int Http2Handler::handle_settings_frame(const uint8_t* payload, size_t len) {
 
 int Http2Handler::handle_headers_frame(uint32_t stream_id, const uint8_t* payload,
                                         size_t len, uint8_t flags) {
-    Http2Stream* stream = get_or_create_stream(stream_id);
-    if (!stream) {
+    if (stream_id == 0) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    // 去掉填充长度、优先级字段与尾部填充，剩下的是头部块片段
+    size_t offset = 0;
+    size_t padding = 0;
+    if (flags & HTTP2_FLAG_PADDED) {
+        if (len < 1) {
+            return PROTOCOL_ERROR_INVALID;
+        }
+        padding = payload[0];
+        offset = 1;
+    }
+    if (flags & HTTP2_FLAG_PRIORITY) {
+        offset += 5;  // 流依赖(4) + 权重(1)，RFC 9113已弃用，忽略
+    }
+    if (offset + padding > len) {
         return PROTOCOL_ERROR_INVALID;
     }
+    const uint8_t* fragment = payload + offset;
+    size_t fragment_len = len - offset - padding;
+    bool end_stream = (flags & HTTP2_FLAG_END_STREAM) != 0;
 
-    if (stream->state == Http2StreamState::IDLE) {
+    // 完整头部块直接在帧负载上解码，跨CONTINUATION的才需要缓存
+    if (flags & HTTP2_FLAG_END_HEADERS) {
+        return process_header_block(stream_id, fragment, fragment_len, end_stream);
+    }
+    if (fragment_len > HTTP2_MAX_HEADER_BLOCK_SIZE) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+    header_block_.assign(fragment, fragment + fragment_len);
+    continuation_stream_id_ = stream_id;
+    header_end_stream_ = end_stream;
+    return PROTOCOL_OK;
+}
+
+int Http2Handler::process_header_block(uint32_t stream_id, const uint8_t* block,
+                                        size_t len, bool end_stream) {
+    Http2Stream* stream = streams_.find(stream_id);
+    if (stream == nullptr) {
+        // 客户端发起的新流ID必须为奇数且单调递增；已关闭的流不在表中
+        if ((stream_id & 1) == 0 || stream_id <= last_stream_id_) {
+            return PROTOCOL_ERROR_INVALID;
+        }
+        last_stream_id_ = stream_id;
+        // 流表按max_concurrent_streams定长，表满即超出并发限制
+        stream = create_stream(stream_id);
+        if (stream == nullptr) {
+            // 被拒绝的流也必须解码，保持HPACK动态表与对端同步
+            int ret = hpack_decoder_->decode(block, len, &discarded_headers_);
+            if (ret != PROTOCOL_OK) {
+                return ret;
+            }
+            return send_rst_stream_frame(stream_id, HTTP2_ERROR_REFUSED_STREAM);
+        }
         stream->state = Http2StreamState::OPEN;
+    } else {
+        // 已有流上只接受对端仍可发送时带END_STREAM的尾部头部块；
+        // 请求已交给工作线程的流再收到头部块会重复分发，按流错误复位
+        uint32_t error_code = 0;
+        if (stream->state != Http2StreamState::OPEN &&
+            stream->state != Http2StreamState::HALF_CLOSED_LOCAL) {
+            error_code = HTTP2_ERROR_STREAM_CLOSED;
+        } else if (!end_stream) {
+            error_code = HTTP2_ERROR_PROTOCOL;
+        }
+        if (error_code != 0) {
+            // 被复位流的头部块也必须解码，保持HPACK动态表与对端同步
+            int ret = hpack_decoder_->decode(block, len, &discarded_headers_);
+            if (ret != PROTOCOL_OK) {
+                return ret;
+            }
+            close_stream(stream);
+            return send_rst_stream_frame(stream_id, error_code);
+        }
     }
 
-    std::map<std::string, std::string> headers;
-    int ret = hpack_decoder_->decode(payload, len, &headers);
+    // 直接解码进流的请求头部（尾部头部块追加到同一集合）
+    int ret = hpack_decoder_->decode_append(block, len, &stream->request.headers);
     if (ret != PROTOCOL_OK) {
         return ret;
     }
 
-    for (const auto& pair : headers) {
-        stream->request.headers[pair.first] = pair.second;
-    }
-
-    if (!(flags & HTTP2_FLAG_END_HEADERS)) {
-        return PROTOCOL_OK;
+    // RFC 9218: 请求头部中的priority字段决定响应的调度优先级
+    auto priority = stream->request.headers.find("priority");
+    if (priority != stream->request.headers.end()) {
+        parse_priority_field(priority->second, &stream->urgency, &stream->incremental);
     }
 
-    if (flags & HTTP2_FLAG_END_STREAM) {
+    if (end_stream) {
+        if (stream->state == Http2StreamState::HALF_CLOSED_LOCAL) {
+            close_stream(stream);
+            return PROTOCOL_OK;
+        }
         stream->state = Http2StreamState::HALF_CLOSED_REMOTE;
         return handle_complete_request(stream);
     }
-
     return PROTOCOL_OK;
 }
 
 int Http2Handler::handle_data_frame(uint32_t stream_id, const uint8_t* payload,
                                      size_t len, uint8_t flags) {
-    auto it = streams_.find(stream_id);
-    if (it == streams_.end()) {
-        return PROTOCOL_ERROR_INVALID;
+    // 整个帧负载（含填充）计入连接级流控，即使所属流已关闭
+    if (static_cast<int64_t>(len) > conn_recv_window_) {
+        return PROTOCOL_ERROR_INVALID;  // FLOW_CONTROL_ERROR
+    }
+    conn_recv_window_ -= static_cast<int32_t>(len);
+    conn_recv_consumed_ += static_cast<uint32_t>(len);
+    int ret = replenish_connection_window();
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+    if (bdp_.add_bytes(len)) {
+        ret = send_bdp_ping();
+        if (ret != PROTOCOL_OK) {
+            return ret;
+        }
     }
 
-    Http2Stream* stream = it->second.get();
+    Http2Stream* stream = streams_.find(stream_id);
+    if (stream == nullptr) {
+        if (stream_id == 0 || stream_id > last_stream_id_) {
+            return PROTOCOL_ERROR_INVALID;
+        }
+        // 已关闭或被拒绝的流上仍在途的数据，丢弃
+        return PROTOCOL_OK;
+    }
+    if (stream->state != Http2StreamState::OPEN &&
+        stream->state != Http2StreamState::HALF_CLOSED_LOCAL) {
+        send_rst_stream_frame(stream_id, HTTP2_ERROR_STREAM_CLOSED);
+        close_stream(stream);
+        return PROTOCOL_OK;
+    }
+    if (static_cast<int64_t>(len) > stream->recv_window) {
+        send_rst_stream_frame(stream_id, HTTP2_ERROR_FLOW_CONTROL);
+        close_stream(stream);
+        return PROTOCOL_OK;
+    }
+    stream->recv_window -= static_cast<int32_t>(len);
+
     if (len > 0 && payload != nullptr) {
         stream->request.body.insert(stream->request.body.end(), payload, payload + len);
     }
 
     if (flags & HTTP2_FLAG_END_STREAM) {
+        // 对端不再发送数据，无需归还流级窗口
+        if (stream->state == Http2StreamState::HALF_CLOSED_LOCAL) {
+            close_stream(stream);
+            return PROTOCOL_OK;
+        }
         stream->state = Http2StreamState::HALF_CLOSED_REMOTE;
         return handle_complete_request(stream);
     }
 
-    return PROTOCOL_OK;
+    // 数据已被消费（写入请求体），累计到半个窗口时一次性归还
+    stream->recv_consumed += static_cast<uint32_t>(len);
+    if (stream->recv_consumed >= local_settings_.initial_window_size / 2 &&
+        stream->recv_consumed > 0) {
+        ret = send_window_update_frame(stream_id, stream->recv_consumed);
+        stream->recv_window += static_cast<int32_t>(stream->recv_consumed);
+        stream->recv_consumed = 0;
+    }
+    return ret;
 }
 
 int Http2Handler::handle_continuation_frame(uint32_t stream_id, const uint8_t* payload,
                                              size_t len, uint8_t flags) {
-    auto it = streams_.find(stream_id);
-    if (it == streams_.end()) {
+    // CONTINUATION只能紧跟在同一流未结束的HEADERS/CONTINUATION之后
+    if (continuation_stream_id_ == 0 || stream_id != continuation_stream_id_) {
         return PROTOCOL_ERROR_INVALID;
     }
-
-    Http2Stream* stream = it->second.get();
-
-    std::map<std::string, std::string> headers;
-    int ret = hpack_decoder_->decode(payload, len, &headers);
-    if (ret != PROTOCOL_OK) {
-        return ret;
-    }
-
-    for (const auto& pair : headers) {
-        stream->request.headers[pair.first] = pair.second;
+    if (header_block_.size() + len > HTTP2_MAX_HEADER_BLOCK_SIZE) {
+        return PROTOCOL_ERROR_INVALID;
     }
-
-    if (flags & HTTP2_FLAG_END_HEADERS) {
-        if (stream->state == Http2StreamState::HALF_CLOSED_REMOTE) {
-            return handle_complete_request(stream);
-        }
+    header_block_.insert(header_block_.end(), payload, payload + len);
+    if (!(flags & HTTP2_FLAG_END_HEADERS)) {
+        return PROTOCOL_OK;
     }
 
-    return PROTOCOL_OK;
+    continuation_stream_id_ = 0;
+    int ret = process_header_block(stream_id, header_block_.data(), header_block_.size(),
+                                   header_end_stream_);
+    header_block_.clear();
+    return ret;
 }
 
 int Http2Handler::handle_window_update_frame(uint32_t stream_id, uint32_t increment) {
-    // 检查整数溢出
-    constexpr uint32_t MAX_WINDOW = 0x7FFFFFFF;
-    if (increment == 0 || increment > MAX_WINDOW) {
+    if (increment == 0 || increment > static_cast<uint32_t>(HTTP2_MAX_WINDOW_SIZE)) {
         return PROTOCOL_ERROR_INVALID;
     }
 
     int32_t incr = static_cast<int32_t>(increment);
-    int32_t max_win = static_cast<int32_t>(MAX_WINDOW);
 
     if (stream_id == 0) {
-        for (auto& pair : streams_) {
-            if (pair.second->send_window > max_win - incr) {
-                pair.second->send_window = max_win;
-            } else {
-                pair.second->send_window += incr;
-            }
-        }
-    } else {
-        auto it = streams_.find(stream_id);
-        if (it != streams_.end()) {
-            if (it->second->send_window > max_win - incr) {
-                it->second->send_window = max_win;
-            } else {
-                it->second->send_window += incr;
-            }
+        // 连接级窗口溢出为连接错误（FLOW_CONTROL_ERROR）
+        if (conn_send_window_ > HTTP2_MAX_WINDOW_SIZE - incr) {
+            return PROTOCOL_ERROR_INVALID;
         }
+        // 排队数据由本批帧处理完成后的调度统一发出
+        conn_send_window_ += incr;
+        return PROTOCOL_OK;
     }
+
+    Http2Stream* stream = streams_.find(stream_id);
+    if (stream == nullptr) {
+        return PROTOCOL_OK;
+    }
+
+    if (stream->send_window > HTTP2_MAX_WINDOW_SIZE - incr) {
+        // 流级窗口溢出只重置该流
+        send_rst_stream_frame(stream_id, HTTP2_ERROR_FLOW_CONTROL);
+        close_stream(stream);
+        return PROTOCOL_OK;
+    }
+    stream->send_window += incr;
     return PROTOCOL_OK;
 }
 
 int Http2Handler::handle_rst_stream_frame(uint32_t stream_id, uint32_t error_code) {
     (void)error_code;
-    auto it = streams_.find(stream_id);
-    if (it != streams_.end()) {
-        it->second->state = Http2StreamState::CLOSED;
+    Http2Stream* stream = streams_.find(stream_id);
+    if (stream != nullptr) {
+        close_stream(stream);
     }
     return PROTOCOL_OK;
 }
 
-int Http2Handler::handle_ping_frame(const uint8_t* payload, size_t len) {
-    // 发送PING ACK响应
-    if (len >= 8) {
-        write_frame(Http2FrameType::PING, 0, HTTP2_FLAG_ACK, payload, 8);
+int Http2Handler::handle_ping_frame(const uint8_t* payload, size_t len, uint8_t flags) {
+    if (len != 8) {
+        return PROTOCOL_ERROR_INVALID;  // FRAME_SIZE_ERROR
     }
-    return PROTOCOL_OK;
+    if (!(flags & HTTP2_FLAG_ACK)) {
+        // 发送PING ACK响应
+        return write_frame(Http2FrameType::PING, 0, HTTP2_FLAG_ACK, payload, len);
+    }
+
+    // ACK不再回复；只有本端BDP探测的ACK参与窗口估计
+    if (!bdp_.ping_pending() ||
+        std::memcmp(payload, HTTP2_BDP_PING_DATA, sizeof(HTTP2_BDP_PING_DATA)) != 0) {
+        return PROTOCOL_OK;
+    }
+    uint32_t window = bdp_.ping_acked(Http2BdpEstimator::Clock::now());
+    if (window == 0) {
+        return PROTOCOL_OK;
+    }
+    return grow_receive_window(window);
+}
+
+int Http2Handler::send_bdp_ping() {
+    bdp_.ping_sent(Http2BdpEstimator::Clock::now());
+    return write_frame(Http2FrameType::PING, 0, 0, HTTP2_BDP_PING_DATA, sizeof(HTTP2_BDP_PING_DATA));
+}
+
+int Http2Handler::grow_receive_window(uint32_t window) {
+    int32_t old_conn_window = details::connection_recv_window_size(local_settings_);
+    uint32_t old_initial = local_settings_.initial_window_size;
+    if (window <= old_initial) {
+        return PROTOCOL_OK;
+    }
+    local_settings_.initial_window_size = window;
+
+    // 对端收到SETTINGS后按差值放大已打开流的发送窗口，本端接收窗口同步放大
+    int32_t delta = static_cast<int32_t>(window - old_initial);
+    streams_.for_each([delta](Http2Stream* stream) {
+        stream->recv_window += delta;
+    });
+
+    // 只通告SETTINGS_INITIAL_WINDOW_SIZE
+    uint8_t payload[6] = {
+        0, 4,
+        static_cast<uint8_t>((window >> 24) & 0xFF),
+        static_cast<uint8_t>((window >> 16) & 0xFF),
+        static_cast<uint8_t>((window >> 8) & 0xFF),
+        static_cast<uint8_t>(window & 0xFF)
+    };
+    int ret = write_frame(Http2FrameType::SETTINGS, 0, 0, payload, sizeof(payload));
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+
+    // 连接级窗口不受SETTINGS影响，通过WINDOW_UPDATE放大
+    int32_t conn_window = details::connection_recv_window_size(local_settings_);
+    if (conn_window > old_conn_window) {
+        uint32_t increment = static_cast<uint32_t>(conn_window - old_conn_window);
+        conn_recv_window_ += static_cast<int32_t>(increment);
+        ret = send_window_update_frame(0, increment);
+    }
+    return ret;
 }
 
 int Http2Handler::handle_goaway_frame(const uint8_t* payload, size_t len) {
@@ -692,6 +1266,27 @@ int Http2Handler::handle_goaway_frame(const uint8_t* payload, size_t len) {
     return PROTOCOL_OK;
 }
 
+int Http2Handler::handle_priority_update_frame(const uint8_t* payload, size_t len) {
+    if (len < 4) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+    uint32_t stream_id = ((static_cast<uint32_t>(payload[0]) << 24) |
+                          (static_cast<uint32_t>(payload[1]) << 16) |
+                          (static_cast<uint32_t>(payload[2]) << 8) |
+                          static_cast<uint32_t>(payload[3])) & 0x7FFFFFFF;
+    if (stream_id == 0) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    // 尚未打开或已关闭的流上的优先级更新直接忽略
+    Http2Stream* stream = streams_.find(stream_id);
+    if (stream != nullptr) {
+        std::string field(reinterpret_cast<const char*>(payload) + 4, len - 4);
+        parse_priority_field(field, &stream->urgency, &stream->incremental);
+    }
+    return PROTOCOL_OK;
+}
+
 int Http2Handler::send_settings_frame() {
     // 使用辅助函数写入 SETTINGS 参数
     struct SettingParam {
@@ -726,11 +1321,9 @@ int Http2Handler::send_settings_frame() {
 }
 
 int Http2Handler::send_settings_ack() {
-    if (!settings_ack_sent_) {
-        settings_ack_sent_ = true;
-        return write_frame(Http2FrameType::SETTINGS, 0, HTTP2_FLAG_ACK, nullptr, 0);
-    }
-    return PROTOCOL_OK;
+    // 对端每个SETTINGS帧都需要单独确认
+    settings_ack_sent_ = true;
+    return write_frame(Http2FrameType::SETTINGS, 0, HTTP2_FLAG_ACK, nullptr, 0);
 }
 
 int Http2Handler::send_headers_frame(uint32_t stream_id,
@@ -783,26 +1376,193 @@ int Http2Handler::send_headers_frame(uint32_t stream_id,
 
 int Http2Handler::send_data_frame(uint32_t stream_id, const uint8_t* data,
                                    size_t len, bool end_stream) {
-    size_t max_size = local_settings_.max_frame_size;
-    size_t offset = 0;
+    Http2Stream* stream = streams_.find(stream_id);
+    if (stream == nullptr) {
+        return PROTOCOL_ERROR_INVALID;
+    }
 
-    while (offset < len) {
-        size_t chunk_size = std::min(len - offset, max_size);
-        bool last_chunk = (offset + chunk_size == len);
-        uint8_t flags = (last_chunk && end_stream) ? HTTP2_FLAG_END_STREAM : 0;
+    // 只入队，由flush_pending_data按优先级与窗口统一调度
+    if (stream->pending_offset >= details::pending_bytes(stream).size()) {
+        stream->pending_data.clear();
+        stream->pending_shared.reset();
+        stream->pending_offset = 0;
+    } else if (stream->pending_shared) {
+        // 共享响应体尚未发完时，剩余部分转入流自有缓冲再追加
+        stream->pending_data.assign(stream->pending_shared->begin() + stream->pending_offset,
+                                    stream->pending_shared->end());
+        stream->pending_shared.reset();
+        stream->pending_offset = 0;
+    }
+    stream->pending_data.insert(stream->pending_data.end(), data, data + len);
+    stream->pending_end_stream = end_stream;
+    return PROTOCOL_OK;
+}
 
-        int ret = write_frame(Http2FrameType::DATA, stream_id, flags,
-                              data + offset, chunk_size);
-        if (ret != PROTOCOL_OK) {
-            return ret;
-        }
+int Http2Handler::send_shared_data_frame(uint32_t stream_id, const CompressionCache::Body& body,
+                                         bool end_stream) {
+    Http2Stream* stream = streams_.find(stream_id);
+    if (stream == nullptr || !body) {
+        return PROTOCOL_ERROR_INVALID;
+    }
 
-        offset += chunk_size;
+    // 已有未发完的数据时按普通数据追加，保持发送顺序
+    if (stream->pending_offset < details::pending_bytes(stream).size()) {
+        return send_data_frame(stream_id, body->data(), body->size(), end_stream);
+    }
+    stream->pending_data.clear();
+    stream->pending_shared = body;
+    stream->pending_offset = 0;
+    stream->pending_end_stream = end_stream;
+    return PROTOCOL_OK;
+}
+
+int Http2Handler::emit_data_frame(Http2Stream* stream, bool* emitted) {
+    *emitted = false;
+    const std::vector<uint8_t>& pending = details::pending_bytes(stream);
+    size_t remaining = pending.size() - stream->pending_offset;
+    if (remaining == 0 && !stream->pending_end_stream) {
+        return PROTOCOL_OK;
     }
 
+    // 帧大小受对端SETTINGS_MAX_FRAME_SIZE限制；空DATA帧不占用窗口
+    size_t chunk_size = std::min(remaining, static_cast<size_t>(settings_.max_frame_size));
+    if (chunk_size > 0) {
+        int32_t window = std::min(stream->send_window, conn_send_window_);
+        if (window <= 0) {
+            return PROTOCOL_OK;
+        }
+        chunk_size = std::min(chunk_size, static_cast<size_t>(window));
+    }
+    bool last_chunk = (chunk_size == remaining);
+    uint8_t flags = (last_chunk && stream->pending_end_stream) ? HTTP2_FLAG_END_STREAM : 0;
+
+    append_frame_header(Http2FrameType::DATA, stream->stream_id, flags, chunk_size);
+    const uint8_t* data = pending.data() + stream->pending_offset;
+    frame_batch_.insert(frame_batch_.end(), data, data + chunk_size);
+
+    stream->send_window -= static_cast<int32_t>(chunk_size);
+    conn_send_window_ -= static_cast<int32_t>(chunk_size);
+    stream->pending_offset += chunk_size;
+    *emitted = true;
+
+    if (last_chunk) {
+        bool end_stream = stream->pending_end_stream;
+        stream->pending_data.clear();
+        stream->pending_shared.reset();
+        stream->pending_offset = 0;
+        stream->pending_end_stream = false;
+        if (end_stream) {
+            if (stream->state == Http2StreamState::HALF_CLOSED_REMOTE) {
+                close_stream(stream);
+            } else if (stream->state == Http2StreamState::OPEN) {
+                stream->state = Http2StreamState::HALF_CLOSED_LOCAL;
+            }
+        }
+    }
+
+    // 批次足够大时提前写出，避免占用过多内存
+    if (frame_batch_.size() >= RESPONSE_BATCH_FLUSH_THRESHOLD) {
+        return flush_frame_batch();
+    }
     return PROTOCOL_OK;
 }
 
+int Http2Handler::flush_pending_data() {
+    for (auto& bucket : ready_) {
+        bucket.clear();
+    }
+    streams_.for_each([this](Http2Stream* stream) {
+        if (stream->pending_offset < details::pending_bytes(stream).size() ||
+            stream->pending_end_stream) {
+            ready_[stream->urgency].push_back(stream);
+        }
+    });
+
+    int ret = PROTOCOL_OK;
+    for (auto& bucket : ready_) {
+        if (bucket.empty()) {
+            continue;
+        }
+        std::sort(bucket.begin(), bucket.end(), [](const Http2Stream* a, const Http2Stream* b) {
+            return a->stream_id < b->stream_id;
+        });
+
+        // 非增量流：按流ID顺序逐个发完（或直到窗口耗尽）
+        bool emitted = false;
+        for (Http2Stream* stream : bucket) {
+            if (stream->incremental) {
+                continue;
+            }
+            do {
+                ret = emit_data_frame(stream, &emitted);
+                if (ret != PROTOCOL_OK) {
+                    return ret;
+                }
+            } while (emitted);
+        }
+
+        // 增量流：每轮每流一帧，从上次轮转位置之后开始，保证跨调度公平
+        auto first = std::upper_bound(bucket.begin(), bucket.end(), rr_last_stream_id_,
+                                      [](uint32_t id, const Http2Stream* stream) {
+                                          return id < stream->stream_id;
+                                      });
+        std::rotate(bucket.begin(), first, bucket.end());
+        bool progressed = true;
+        while (progressed) {
+            progressed = false;
+            for (Http2Stream* stream : bucket) {
+                if (!stream->incremental) {
+                    continue;
+                }
+                // 发完的流会被回收并reset，需先记下流ID
+                uint32_t stream_id = stream->stream_id;
+                ret = emit_data_frame(stream, &emitted);
+                if (ret != PROTOCOL_OK) {
+                    return ret;
+                }
+                if (emitted) {
+                    rr_last_stream_id_ = stream_id;
+                    progressed = true;
+                }
+            }
+        }
+    }
+
+    return flush_frame_batch();
+}
+
+int Http2Handler::flush_frame_batch() {
+    if (frame_batch_.empty()) {
+        return PROTOCOL_OK;
+    }
+
+    // 握手完成（或已接受0-RTT）前TLS层不可写，帧继续排队等待后续读/写事件
+    if (!tls_handler_ || (!tls_handler_->is_handshake_done() && !tls_handler_->is_early_data())) {
+        return PROTOCOL_OK;
+    }
+
+    // 控制帧、HEADERS与DATA合并为一次TLS写，由TLS层按动态记录长度切分，减少小记录与系统调用
+    size_t written = 0;
+    int ret = tls_handler_->write(frame_batch_.data(), frame_batch_.size(), &written);
+    // 只移除已交给TLS层的部分，写失败时剩余帧保留，由下一次写事件重试
+    frame_batch_.erase(frame_batch_.begin(), frame_batch_.begin() + static_cast<std::ptrdiff_t>(written));
+    if (ret == PROTOCOL_OK && !frame_batch_.empty()) {
+        ret = PROTOCOL_ERROR_BUFFER;
+    }
+    return ret;
+}
+
+int Http2Handler::replenish_connection_window() {
+    uint32_t threshold = static_cast<uint32_t>(details::connection_recv_window_size(local_settings_)) / 2;
+    if (conn_recv_consumed_ == 0 || conn_recv_consumed_ < threshold) {
+        return PROTOCOL_OK;
+    }
+    int ret = send_window_update_frame(0, conn_recv_consumed_);
+    conn_recv_window_ += static_cast<int32_t>(conn_recv_consumed_);
+    conn_recv_consumed_ = 0;
+    return ret;
+}
+
 int Http2Handler::send_window_update_frame(uint32_t stream_id, uint32_t increment) {
     uint8_t payload[4];
     payload[0] = (increment >> 24) & 0x7F;
@@ -823,6 +1583,21 @@ int Http2Handler::send_rst_stream_frame(uint32_t stream_id, uint32_t error_code)
 
 int Http2Handler::write_frame(Http2FrameType type, uint32_t stream_id,
                                uint8_t flags, const uint8_t* payload, size_t len) {
+    // 所有帧先进入连接输出缓冲，本轮读/分发结束时一次写给TLS层
+    append_frame_header(type, stream_id, flags, len);
+    if (len > 0 && payload != nullptr) {
+        frame_batch_.insert(frame_batch_.end(), payload, payload + len);
+    }
+
+    // 缓冲足够大时提前写出，避免占用过多内存
+    if (frame_batch_.size() >= RESPONSE_BATCH_FLUSH_THRESHOLD) {
+        return flush_frame_batch();
+    }
+    return PROTOCOL_OK;
+}
+
+void Http2Handler::append_frame_header(Http2FrameType type, uint32_t stream_id,
+                                       uint8_t flags, size_t len) {
     uint8_t header[HTTP2_FRAME_HEADER_SIZE];
 
     header[0] = (len >> 16) & 0xFF;
@@ -834,97 +1609,316 @@ int Http2Handler::write_frame(Http2FrameType type, uint32_t stream_id,
     header[6] = (stream_id >> 16) & 0xFF;
     header[7] = (stream_id >> 8) & 0xFF;
     header[8] = stream_id & 0xFF;
+    frame_batch_.insert(frame_batch_.end(), header, header + HTTP2_FRAME_HEADER_SIZE);
+}
 
-    // 只通过TlsHandler进行数据加密发送，避免双重写入
-    if (tls_handler_) {
-        size_t written = 0;
-        int ret = tls_handler_->write(header, HTTP2_FRAME_HEADER_SIZE, &written);
-        if (ret != PROTOCOL_OK) {
-            return ret;
+Http2Stream* Http2Handler::create_stream(uint32_t stream_id) {
+    Http2Stream* stream = streams_.insert(stream_id);
+    if (stream == nullptr) {
+        return nullptr;
+    }
+    // 发送窗口取对端通告值，接收窗口取本端通告值
+    stream->send_window = static_cast<int32_t>(settings_.initial_window_size);
+    stream->recv_window = static_cast<int32_t>(local_settings_.initial_window_size);
+    return stream;
+}
+
+void Http2Handler::close_stream(Http2Stream* stream) {
+    // 关闭即回收：对象reset后回到流表的对象池，流ID不再可查
+    streams_.erase(stream->stream_id);
+}
+
+int Http2Handler::handle_complete_request(Http2Stream* stream) {
+    // 空指针检查
+    if (conn_ == nullptr || stream == nullptr) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    // 请求移入任务后交给工作线程，流留在流表中（仍占用并发额度）等待响应
+    auto job = std::make_shared<details::Http2RequestJob>();
+    job->stream_id = stream->stream_id;
+    job->generation = dispatch_generation_;
+    job->client_info = conn_->get_client_info();
+    job->compression = compression_;
+    job->request = std::move(stream->request);
+    stream->awaiting_response = true;
+
+    std::shared_ptr<Http2CompletionQueue> completions = completions_;
+    auto task = [job, completions]() {
+        Http2StreamResponse response;
+        details::build_stream_response(job.get(), &response);
+        completions->push(std::move(response));
+    };
+    if (dispatcher_) {
+        dispatcher_(std::move(task));
+    } else {
+        task();
+    }
+    return PROTOCOL_OK;
+}
+
+// ==================== NegotiatingHandler实现 ====================
+
+NegotiatingHandler::NegotiatingHandler()
+    : conn_(nullptr)
+    , tls_handler_(std::make_unique<TlsHandler>())
+    , selected_()
+    , compression_()
+    , http2_settings_()
+    , max_receive_window_(HTTP2_DEFAULT_MAX_RECEIVE_WINDOW)
+    , allow_h2c_(false)
+    , dispatcher_()
+    , handshake_dispatcher_()
+    , handshake_job_()
+{
+}
+
+NegotiatingHandler::~NegotiatingHandler() = default;
+
+int NegotiatingHandler::init(Connection* conn,
+                             const CertConfig& cert_config,
+                             const TlsConfig& tls_config) {
+    conn_ = conn;
+    selected_.reset();
+    handshake_job_.reset();
+    if (!tls_handler_) {
+        tls_handler_ = std::make_unique<TlsHandler>();
+    }
+
+    int ret = tls_handler_->init(conn, cert_config, tls_config);
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+
+    if (conn_) {
+        tls_handler_->set_read_buffer(&conn_->get_read_buffer());
+        tls_handler_->set_write_buffer(&conn_->get_write_buffer());
+    }
+    return PROTOCOL_OK;
+}
+
+int NegotiatingHandler::on_read() {
+    if (selected_) {
+        return selected_->on_read();
+    }
+    // 握手在途：新到的密文留在连接读缓冲区，任务收回时再处理
+    if (handshake_job_) {
+        return PROTOCOL_OK;
+    }
+    if (!tls_handler_) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    // 握手未完成时ALPN结果不可用，继续推进握手（配置了握手线程时交给握手线程）；
+    // 已读出0-RTT早期数据时不再等待握手完成
+    if (!tls_handler_->is_handshake_done() && !can_select_early()) {
+        if (handshake_dispatcher_ && conn_ && !tls_handler_->is_socket_io()) {
+            return start_handshake_job();
         }
-        if (written != HTTP2_FRAME_HEADER_SIZE) {
-            return PROTOCOL_ERROR_BUFFER;
+        int ret = tls_handler_->continue_handshake();
+        if (ret == PROTOCOL_ERROR_EAGAIN && !can_select_early()) {
+            return PROTOCOL_OK;
         }
-        if (len > 0 && payload != nullptr) {
-            ret = tls_handler_->write(payload, len, &written);
-            if (ret != PROTOCOL_OK) {
-                return ret;
-            }
-            if (written != len) {
-                return PROTOCOL_ERROR_BUFFER;
-            }
+        if (ret < 0 && ret != PROTOCOL_ERROR_EAGAIN) {
+            return ret;
         }
     }
 
-    return PROTOCOL_OK;
+    int ret = select_protocol();
+    if (ret == PROTOCOL_ERROR_EAGAIN) {
+        return PROTOCOL_OK;
+    }
+    if (ret < 0) {
+        return ret;
+    }
+
+    // 握手最后一批数据之后可能已带有应用数据，立即交给选定的处理器
+    return selected_->on_read();
 }
 
-Http2Stream* Http2Handler::get_or_create_stream(uint32_t stream_id) {
-    auto it = streams_.find(stream_id);
-    if (it != streams_.end()) {
-        return it->second.get();
+int NegotiatingHandler::start_handshake_job() {
+    utils::Buffer& read_buffer = conn_->get_read_buffer();
+    if (read_buffer.readable_bytes() == 0) {
+        return PROTOCOL_OK;
     }
 
-    auto stream = std::make_unique<Http2Stream>();
-    stream->init(stream_id);
-    Http2Stream* ptr = stream.get();
-    streams_[stream_id] = std::move(stream);
-    return ptr;
+    auto job = std::make_shared<details::TlsHandshakeJob>();
+    job->input.write(read_buffer.read_ptr(), read_buffer.readable_bytes());
+    read_buffer.clear();
+    job->tls_handler = std::move(tls_handler_);
+    job->tls_handler->set_read_buffer(&job->input);
+    job->tls_handler->set_write_buffer(&job->output);
+    handshake_job_ = job;
+
+    // 任务持有job的引用：连接在握手期间关闭时TLS处理器随任务结束释放
+    handshake_dispatcher_([job]() {
+        job->result = job->tls_handler->continue_handshake();
+        job->done.store(true, std::memory_order_release);
+    });
+    return PROTOCOL_OK;
 }
 
-int Http2Handler::handle_complete_request(Http2Stream* stream) {
-    // 空指针检查
-    if (conn_ == nullptr || stream == nullptr) {
-        return PROTOCOL_ERROR_INVALID;
+int NegotiatingHandler::finish_handshake_job() {
+    std::shared_ptr<details::TlsHandshakeJob> job = std::move(handshake_job_);
+    tls_handler_ = std::move(job->tls_handler);
+    tls_handler_->set_read_buffer(&conn_->get_read_buffer());
+    tls_handler_->set_write_buffer(&conn_->get_write_buffer());
+
+    utils::Buffer& write_buffer = conn_->get_write_buffer();
+    if (job->output.readable_bytes() > 0 &&
+        write_buffer.write(job->output.read_ptr(), job->output.readable_bytes()) != job->output.readable_bytes()) {
+        return PROTOCOL_ERROR_BUFFER;
     }
 
-    // 构建ClientContext并调用Callback模块
-    // 注意：将字符串复制到局部变量，确保指针在函数执行期间有效（修复悬空指针问题）
-    ClientContext ctx;
-    const ClientInfo& client_info = conn_->get_client_info();
+    // 握手未消费的数据（如随Finished到达的应用数据）放回连接读缓冲区，排在在途期间新到的数据之前
+    utils::Buffer& read_buffer = conn_->get_read_buffer();
+    if (job->input.readable_bytes() > 0) {
+        job->input.write(read_buffer.read_ptr(), read_buffer.readable_bytes());
+        read_buffer.clear();
+        read_buffer.write(job->input.read_ptr(), job->input.readable_bytes());
+    }
 
-    std::string local_client_ip = client_info.client_ip;
-    std::string local_debug_token;
-    bool found_token = false;
+    if (job->result == PROTOCOL_ERROR_EAGAIN && !can_select_early()) {
+        return start_handshake_job();
+    }
+    if (job->result < 0 && job->result != PROTOCOL_ERROR_EAGAIN) {
+        return job->result;
+    }
+    return on_read();
+}
 
-    ctx.connection_id = client_info.connection_id;
-    ctx.client_ip = local_client_ip.c_str();
-    ctx.client_port = client_info.client_port;
-    ctx.server_port = client_info.server_port;
+bool NegotiatingHandler::can_select_early() const {
+    // HTTP/2的早期数据要解码HPACK才能识别方法，留在TLS层等握手完成后再交付
+    return tls_handler_->is_early_data() && tls_handler_->has_early_data() &&
+           ProtocolFactory::instance().select_protocol_by_alpn(tls_handler_->get_selected_alpn()) ==
+               ProtocolType::HTTP_1_1;
+}
 
-    // 从header中获取debug token（大小写不敏感查找）
-    for (const auto& header : stream->request.headers) {
-        if (StrCaseCmp(header.first.c_str(), "Debug-Token") == 0) {
-            local_debug_token = header.second;
-            found_token = true;
-            break;
+int NegotiatingHandler::select_protocol() {
+    ProtocolType type = ProtocolType::HTTP_1_1;
+    if (tls_handler_->is_plaintext()) {
+        // h2c先验知识：明文连接以客户端前言开头即为HTTP/2，前言由Http2Handler校验并消费
+        if (allow_h2c_ && conn_) {
+            const utils::Buffer& buffer = conn_->get_read_buffer();
+            size_t n = std::min(buffer.readable_bytes(), HTTP2_CLIENT_PREFACE_LEN);
+            if (n == 0) {
+                return PROTOCOL_ERROR_EAGAIN;
+            }
+            if (std::memcmp(buffer.read_ptr(), HTTP2_CLIENT_PREFACE, n) == 0) {
+                if (n < HTTP2_CLIENT_PREFACE_LEN) {
+                    return PROTOCOL_ERROR_EAGAIN;
+                }
+                type = ProtocolType::HTTP_2;
+            }
         }
+    } else {
+        type = ProtocolFactory::instance().select_protocol_by_alpn(tls_handler_->get_selected_alpn());
     }
-    if (found_token) {
-        ctx.token = local_debug_token.c_str();
+
+    int ret = PROTOCOL_OK;
+    if (type == ProtocolType::HTTP_2) {
+        auto handler = std::make_unique<Http2Handler>();
+        handler->set_compression_config(compression_);
+        handler->set_local_settings(http2_settings_);
+        handler->set_max_receive_window(max_receive_window_);
+        handler->set_task_dispatcher(dispatcher_);
+        ret = handler->attach(conn_, std::move(tls_handler_));
+        selected_ = std::move(handler);
     } else {
-        ctx.token = nullptr;
+        auto handler = std::make_unique<Http1Handler>();
+        handler->set_compression_config(compression_);
+        ret = handler->attach(conn_, std::move(tls_handler_));
+        selected_ = std::move(handler);
     }
+    return ret;
+}
 
-    // 模拟Callback模块调用
-    std::map<std::string, std::string> response_headers;
-    response_headers[":status"] = "200";
-    response_headers["content-type"] = "text/plain";
+int NegotiatingHandler::on_write() {
+    if (selected_) {
+        return selected_->on_write();
+    }
+    return PROTOCOL_OK;
+}
 
-    send_headers_frame(stream->stream_id, response_headers, false);
+int NegotiatingHandler::send_response(const uint8_t* data, uint32_t len) {
+    if (!selected_) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+    return selected_->send_response(data, len);
+}
 
-    // 如果有请求体，回显请求体，否则返回"OK"
-    if (!stream->request.body.empty()) {
-        send_data_frame(stream->stream_id, stream->request.body.data(),
-                        stream->request.body.size(), true);
-    } else {
-        const char* reply = "OK";
-        send_data_frame(stream->stream_id, reinterpret_cast<const uint8_t*>(reply), 2, true);
+void NegotiatingHandler::close() {
+    // 在途握手的TLS处理器由任务持有，任务结束后释放
+    handshake_job_.reset();
+    if (selected_) {
+        selected_->close();
+    } else if (tls_handler_) {
+        tls_handler_->close();
     }
+}
+
+TlsHandler* NegotiatingHandler::get_tls_handler() {
+    if (selected_) {
+        return selected_->get_tls_handler();
+    }
+    return tls_handler_.get();
+}
+
+ProtocolType NegotiatingHandler::get_protocol_type() const {
+    if (selected_) {
+        return selected_->get_protocol_type();
+    }
+    return ProtocolType::UNKNOWN;
+}
 
+void NegotiatingHandler::reset() {
+    if (selected_) {
+        selected_->reset();
+    }
+}
+
+int NegotiatingHandler::on_callback_done() {
+    if (handshake_job_ && handshake_job_->done.load(std::memory_order_acquire)) {
+        return finish_handshake_job();
+    }
+    if (selected_) {
+        return selected_->on_callback_done();
+    }
     return PROTOCOL_OK;
 }
 
+void NegotiatingHandler::set_compression_config(const CompressionConfig& config) {
+    compression_ = config;
+}
+
+void NegotiatingHandler::set_local_settings(const Http2Settings& settings) {
+    http2_settings_ = settings;
+}
+
+void NegotiatingHandler::set_max_receive_window(uint32_t max_window) {
+    max_receive_window_ = max_window;
+}
+
+void NegotiatingHandler::set_allow_h2c(bool allow) {
+    allow_h2c_ = allow;
+}
+
+void NegotiatingHandler::set_task_dispatcher(TaskDispatcher dispatcher) {
+    dispatcher_ = std::move(dispatcher);
+}
+
+void NegotiatingHandler::set_handshake_dispatcher(TaskDispatcher dispatcher) {
+    handshake_dispatcher_ = std::move(dispatcher);
+}
+
+bool NegotiatingHandler::is_handshake_in_flight() const {
+    return handshake_job_ != nullptr;
+}
+
+ProtocolHandler* NegotiatingHandler::get_selected_handler() const {
+    return selected_.get();
+}
+
 // ==================== ProtocolFactory实现 ====================
 
 ProtocolFactory& ProtocolFactory::instance() {
@@ -8,21 +8,46 @@
 #include "protocol/protocol_handler_factory.hpp"
 #include "config/config.hpp"
 #include "protocol/protocol_handler.hpp"
+#include "protocol/config_converter.hpp"
 
 namespace https_server_sim {
 namespace protocol {
 
 std::unique_ptr<ProtocolHandler> ProtocolHandlerFactory::create(const config::Config& config) {
-    // TODO: 当前简化版本：无论HTTP/2是否启用都返回Http1Handler
-    // 后续版本完整实现HTTP/2后，需根据config.get_http2().enabled和ALPN协商结果
-    // 选择返回Http1Handler或Http2Handler
-    if (config.get_http2().enabled) {
-        // HTTP/2启用：暂返回Http1Handler（当前主要实现）
-        return std::make_unique<Http1Handler>();
-    } else {
-        // HTTP/2禁用：仅使用HTTP/1.1
-        return std::make_unique<Http1Handler>();
+    return create_handler(config, CompressionConfig());
+}
+
+std::unique_ptr<ProtocolHandler> ProtocolHandlerFactory::create(const config::Config& config,
+                                                                uint16_t port) {
+    CompressionConfig compression;
+    for (const auto& listen : config.get_listens()) {
+        if (listen.port == port) {
+            ConfigConverter::convert_compression_config(listen, compression);
+            break;
+        }
+    }
+    return create_handler(config, compression);
+}
+
+std::unique_ptr<ProtocolHandler> ProtocolHandlerFactory::create_handler(
+    const config::Config& config, const CompressionConfig& compression) {
+    const auto& http2_config = config.get_http2();
+    if (!http2_config.enabled) {
+        // HTTP/2禁用：ALPN只提供http/1.1，直接使用Http1Handler
+        auto handler = std::make_unique<Http1Handler>();
+        handler->set_compression_config(compression);
+        return handler;
     }
+
+    // HTTP/2启用：协议推迟到握手完成（ALPN）或收到首批明文数据（h2c）时选择
+    Http2Settings settings;
+    ConfigConverter::convert_http2_settings(http2_config, settings);
+    auto handler = std::make_unique<NegotiatingHandler>();
+    handler->set_compression_config(compression);
+    handler->set_local_settings(settings);
+    handler->set_max_receive_window(http2_config.max_window_size);
+    handler->set_allow_h2c(http2_config.allow_h2c);
+    return handler;
 }
 
 } // namespace protocol
@@ -0,0 +1,192 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: response_template.cpp
+//  描述: ResponseTemplate/ResponseTemplateRegistry类实现
+//  版权: Copyright (c) 2026
+// =============================================================================
+#include "protocol/response_template.hpp"
+#include "protocol/http_serializer.hpp"
+#include "protocol/protocol_utils.hpp"
+#include "utils/time.hpp"
+#include <charconv>
+#include <cstring>
+
+namespace https_server_sim {
+namespace protocol {
+
+namespace details {
+
+constexpr char TEMPLATE_DATE[] = "Date: ";
+constexpr size_t TEMPLATE_DATE_LEN = sizeof(TEMPLATE_DATE) - 1;
+constexpr char TEMPLATE_CONTENT_LENGTH[] = "\r\nContent-Length: ";
+constexpr size_t TEMPLATE_CONTENT_LENGTH_LEN = sizeof(TEMPLATE_CONTENT_LENGTH) - 1;
+constexpr size_t TEMPLATE_MAX_DECIMAL_LEN = 24;
+
+} // namespace details
+
+// ==================== ResponseTemplate实现 ====================
+
+ResponseTemplate::ResponseTemplate(int status_code,
+                                   const std::string& status_text,
+                                   const HttpHeaders& headers)
+    : status_code_(status_code)
+    , prefix_()
+{
+    size_t line_len = 0;
+    const char* line = HttpSerializer::find_status_line(status_code, status_text, &line_len);
+    if (line != nullptr) {
+        prefix_.assign(line, line_len);
+    } else {
+        prefix_ = "HTTP/1.1 " + std::to_string(status_code) + " " + status_text + "\r\n";
+    }
+
+    for (const auto& header : headers) {
+        // Date/Content-Length每次发送时生成
+        if (StrCaseCmp(header.first.c_str(), "Date") == 0 ||
+            StrCaseCmp(header.first.c_str(), "Content-Length") == 0) {
+            continue;
+        }
+        prefix_ += header.first;
+        prefix_ += ": ";
+        prefix_ += header.second;
+        prefix_ += "\r\n";
+    }
+}
+
+int ResponseTemplate::get_status_code() const {
+    return status_code_;
+}
+
+size_t ResponseTemplate::header_size(size_t body_len, size_t extra_len) const {
+    char digits[details::TEMPLATE_MAX_DECIMAL_LEN];
+    auto result = std::to_chars(digits, digits + sizeof(digits), body_len);
+    return prefix_.size() + extra_len + details::TEMPLATE_DATE_LEN + utils::HTTP_DATE_LEN +
+           details::TEMPLATE_CONTENT_LENGTH_LEN +
+           static_cast<size_t>(result.ptr - digits) + 4;
+}
+
+int ResponseTemplate::render(const uint8_t* body, size_t body_len,
+                             utils::Buffer* out, bool include_body,
+                             const char* extra_lines, size_t extra_len) const {
+    if (out == nullptr || (body == nullptr && body_len > 0) ||
+        (extra_lines == nullptr && extra_len > 0)) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    size_t head_len = header_size(body_len, extra_len);
+    size_t total = head_len + (include_body ? body_len : 0);
+    uint8_t* p = out->reserve(total);
+    if (p == nullptr) {
+        return PROTOCOL_ERROR_BUFFER;
+    }
+
+    uint8_t* start = p;
+    memcpy(p, prefix_.data(), prefix_.size());
+    p += prefix_.size();
+    if (extra_len > 0) {
+        memcpy(p, extra_lines, extra_len);
+        p += extra_len;
+    }
+    memcpy(p, details::TEMPLATE_DATE, details::TEMPLATE_DATE_LEN);
+    p += details::TEMPLATE_DATE_LEN;
+    utils::copy_cached_http_date(reinterpret_cast<char*>(p));
+    p += utils::HTTP_DATE_LEN;
+    memcpy(p, details::TEMPLATE_CONTENT_LENGTH, details::TEMPLATE_CONTENT_LENGTH_LEN);
+    p += details::TEMPLATE_CONTENT_LENGTH_LEN;
+    char* digits = reinterpret_cast<char*>(p);
+    p = reinterpret_cast<uint8_t*>(
+        std::to_chars(digits, digits + details::TEMPLATE_MAX_DECIMAL_LEN, body_len).ptr);
+    memcpy(p, "\r\n\r\n", 4);
+    p += 4;
+
+    if (include_body && body_len > 0) {
+        memcpy(p, body, body_len);
+        p += body_len;
+    }
+
+    out->commit(static_cast<size_t>(p - start));
+    return PROTOCOL_OK;
+}
+
+// ==================== ResponseTemplateRegistry实现 ====================
+
+ResponseTemplateRegistry& ResponseTemplateRegistry::instance() {
+    static ResponseTemplateRegistry registry;
+    return registry;
+}
+
+ResponseTemplateRegistry::ResponseTemplateRegistry()
+    : mutex_()
+    , templates_()
+    , version_(0)
+{
+}
+
+ResponseTemplateRegistry::~ResponseTemplateRegistry() = default;
+
+uint32_t ResponseTemplateRegistry::make_key(uint16_t port, int status_code) {
+    return (static_cast<uint32_t>(port) << 16) | static_cast<uint32_t>(status_code);
+}
+
+int ResponseTemplateRegistry::register_template(uint16_t port, int status_code,
+                                                const std::string& status_text,
+                                                const HttpHeaders& headers,
+                                                bool replace) {
+    if (status_code < 100 || status_code > 999) {
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    // 模板在锁外构造，临界区只做指针替换
+    auto tmpl = std::make_shared<const ResponseTemplate>(status_code, status_text, headers);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t key = make_key(port, status_code);
+    auto it = templates_.find(key);
+    if (it != templates_.end()) {
+        if (!replace) {
+            return PROTOCOL_OK;
+        }
+        it->second = std::move(tmpl);
+    } else {
+        templates_.emplace(key, std::move(tmpl));
+    }
+    version_.fetch_add(1, std::memory_order_release);
+    return PROTOCOL_OK;
+}
+
+int ResponseTemplateRegistry::register_defaults(uint16_t port) {
+    // 回调先行注册的同状态码模板优先
+    return register_template(port, 200, "OK", HttpHeaders{{"Content-Type", "text/plain"}}, false);
+}
+
+std::shared_ptr<const ResponseTemplate> ResponseTemplateRegistry::find(uint16_t port,
+                                                                        int status_code) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = templates_.find(make_key(port, status_code));
+    if (it == templates_.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+void ResponseTemplateRegistry::deregister_template(uint16_t port, int status_code) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (templates_.erase(make_key(port, status_code)) > 0) {
+        version_.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void ResponseTemplateRegistry::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    templates_.clear();
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t ResponseTemplateRegistry::get_version() const {
+    return version_.load(std::memory_order_acquire);
+}
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
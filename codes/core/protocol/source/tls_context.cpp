@@ -0,0 +1,1138 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: tls_context.cpp
+//  描述: TlsContext/TlsContextManager类实现
+//  版权: Copyright (c) 2026
+// =============================================================================
+#include "protocol/tls_context.hpp"
+#include "protocol/config_converter.hpp"
+#include "config/config.hpp"
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+
+#if HAVE_OPENSSL
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/x509.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#endif
+#endif
+
+namespace https_server_sim {
+namespace protocol {
+
+// ==================== RAII资源包装器 ====================
+namespace details {
+
+// FILE* 包装器
+struct FileCloser {
+    void operator()(FILE* fp) const {
+        if (fp) {
+            fclose(fp);
+        }
+    }
+};
+
+using UniqueFilePtr = std::unique_ptr<FILE, FileCloser>;
+
+// SNI主机名规范化：转小写并去掉末尾的根域点
+static std::string NormalizeServerName(const std::string& name) {
+    std::string host = name;
+    while (!host.empty() && host.back() == '.') {
+        host.pop_back();
+    }
+    for (auto& c : host) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return host;
+}
+
+#if HAVE_OPENSSL
+
+// 按协议版本拆分加密套件列表：TLS_前缀的为TLS 1.3套件，其余为TLS 1.2及以下的cipher list
+static void SplitCipherSuites(const std::string& suites, std::string& tls13, std::string& tls12) {
+    tls13.clear();
+    tls12.clear();
+    size_t pos = 0;
+    while (pos <= suites.size()) {
+        size_t end = suites.find(':', pos);
+        if (end == std::string::npos) {
+            end = suites.size();
+        }
+        std::string name = suites.substr(pos, end - pos);
+        if (!name.empty()) {
+            std::string& dst = (name.compare(0, 4, "TLS_") == 0) ? tls13 : tls12;
+            if (!dst.empty()) {
+                dst.push_back(':');
+            }
+            dst += name;
+        }
+        pos = end + 1;
+    }
+}
+
+// X509* 包装器
+struct X509Deleter {
+    void operator()(X509* x509) const {
+        if (x509) {
+            X509_free(x509);
+        }
+    }
+};
+
+using UniqueX509Ptr = std::unique_ptr<X509, X509Deleter>;
+
+// EVP_PKEY* 包装器
+struct EvpPkeyDeleter {
+    void operator()(EVP_PKEY* pkey) const {
+        if (pkey) {
+            EVP_PKEY_free(pkey);
+        }
+    }
+};
+
+using UniqueEvpPkeyPtr = std::unique_ptr<EVP_PKEY, EvpPkeyDeleter>;
+
+// 会话缓存与票据密钥使用的单调时间（秒）
+static uint64_t NowSeconds() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#endif // HAVE_OPENSSL
+
+} // namespace details
+
+#if HAVE_OPENSSL
+
+// ==================== ALPN选择回调 ====================
+static int AlpnSelectCallback(SSL* ssl, const unsigned char** out,
+                               unsigned char* outlen, const unsigned char* in,
+                               unsigned int inlen, void* arg) {
+    (void)ssl;
+
+    // 回调参数为共享的TlsContext（与连接无关）
+    TlsContext* context = static_cast<TlsContext*>(arg);
+    if (!context) {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+
+    // 解析服务器配置的ALPN协议列表（格式: "h2,http/1.1"）
+    const std::string& server_alpn = context->get_alpn_protocols();
+
+    // 我们优先按服务器配置的顺序选择
+    // 首先解析服务器支持的协议列表
+    std::vector<std::string> server_protocols;
+    size_t pos = 0;
+    while (pos < server_alpn.size()) {
+        size_t comma = server_alpn.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = server_alpn.size();
+        }
+        std::string proto = server_alpn.substr(pos, comma - pos);
+        // 去除首尾空格
+        size_t start = proto.find_first_not_of(" \t");
+        size_t end = proto.find_last_not_of(" \t");
+        if (start != std::string::npos && end != std::string::npos && start <= end) {
+            std::string trimmed = proto.substr(start, end - start + 1);
+            // 跳过空字符串
+            if (!trimmed.empty()) {
+                server_protocols.push_back(std::move(trimmed));
+            }
+        }
+        pos = comma + 1;
+    }
+
+    // 如果没有有效的协议，直接返回
+    if (server_protocols.empty()) {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+
+    // 遍历客户端支持的协议，按服务器配置的优先级选择
+    const unsigned char* client_end = in + inlen;
+
+    // 按服务器配置的优先级查找
+    for (const auto& server_proto : server_protocols) {
+        const unsigned char* client_ptr = in;
+        while (client_ptr < client_end) {
+            unsigned int len = *client_ptr++;
+            if (client_ptr + len > client_end) {
+                break;
+            }
+            if (len == server_proto.size() &&
+                memcmp(client_ptr, server_proto.data(), len) == 0) {
+                *out = client_ptr;
+                *outlen = len;
+                return SSL_TLSEXT_ERR_OK;
+            }
+            client_ptr += len;
+        }
+    }
+
+    // 没有匹配的协议
+    return SSL_TLSEXT_ERR_NOACK;
+}
+
+// ==================== 会话复用回调 ====================
+// SSL_CTX的app_data指向所属TlsContext，回调据此找到共享的会话缓存与票据密钥
+static TlsContext* ContextFromSsl(SSL* ssl) {
+    return static_cast<TlsContext*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+}
+
+// 新会话建立：序列化后存入分片缓存（返回0表示不持有SSL_SESSION引用）
+static int NewSessionCallback(SSL* ssl, SSL_SESSION* session) {
+    TlsContext* context = ContextFromSsl(ssl);
+    if (!context || !context->get_session_cache()) {
+        return 0;
+    }
+
+    unsigned int id_len = 0;
+    const unsigned char* id = SSL_SESSION_get_id(session, &id_len);
+    int der_len = i2d_SSL_SESSION(session, nullptr);
+    if (der_len <= 0) {
+        return 0;
+    }
+    std::vector<uint8_t> der(static_cast<size_t>(der_len));
+    unsigned char* out = der.data();
+    i2d_SSL_SESSION(session, &out);
+
+    context->get_session_cache()->put(id, id_len, std::move(der), details::NowSeconds());
+    return 0;
+}
+
+// 按会话ID查找：命中时反序列化，所有权交给OpenSSL（*copy = 0）
+static SSL_SESSION* GetSessionCallback(SSL* ssl, const unsigned char* id, int id_len, int* copy) {
+    *copy = 0;
+    TlsContext* context = ContextFromSsl(ssl);
+    if (!context || !context->get_session_cache() || id_len <= 0) {
+        return nullptr;
+    }
+
+    std::vector<uint8_t> der;
+    if (!context->get_session_cache()->get(id, static_cast<size_t>(id_len), details::NowSeconds(), &der)) {
+        return nullptr;
+    }
+    const unsigned char* in = der.data();
+    return d2i_SSL_SESSION(nullptr, &in, static_cast<long>(der.size()));
+}
+
+// 会话失效（超时或致命告警）：从缓存删除
+static void RemoveSessionCallback(SSL_CTX* ctx, SSL_SESSION* session) {
+    TlsContext* context = static_cast<TlsContext*>(SSL_CTX_get_app_data(ctx));
+    if (!context || !context->get_session_cache()) {
+        return;
+    }
+
+    unsigned int id_len = 0;
+    const unsigned char* id = SSL_SESSION_get_id(session, &id_len);
+    context->get_session_cache()->remove(id, id_len);
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+
+// 会话票据密钥回调（AES-256-CBC + HMAC-SHA256）：签发时使用当前密钥（到期先轮换），
+// 解密时按密钥名查找；旧密钥解出的票据返回2，要求OpenSSL用当前密钥重新签发
+static int TicketKeyCallback(SSL* ssl, unsigned char key_name[16], unsigned char* iv,
+                             EVP_CIPHER_CTX* cipher_ctx, EVP_MAC_CTX* mac_ctx, int enc) {
+    TlsContext* context = ContextFromSsl(ssl);
+    if (!context || !context->get_ticket_keys()) {
+        return -1;
+    }
+
+    TlsTicketKey key;
+    int ret = 1;
+    if (enc) {
+        if (!context->get_ticket_keys()->encrypt_key(details::NowSeconds(), &key)) {
+            return -1;
+        }
+        int iv_len = EVP_CIPHER_get_iv_length(EVP_aes_256_cbc());
+        if (RAND_bytes(iv, iv_len) != 1) {
+            OPENSSL_cleanse(&key, sizeof(key));
+            return -1;
+        }
+        memcpy(key_name, key.name, TLS_TICKET_KEY_NAME_SIZE);
+        if (EVP_EncryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), nullptr, key.aes_key, iv) != 1) {
+            ret = -1;
+        }
+    } else {
+        bool current = false;
+        if (!context->get_ticket_keys()->decrypt_key(key_name, &key, &current)) {
+            // 未知或已淘汰的密钥：按完整握手处理
+            return 0;
+        }
+        if (EVP_DecryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), nullptr, key.aes_key, iv) != 1) {
+            ret = -1;
+        } else if (!current) {
+            ret = 2;
+        }
+    }
+
+    if (ret != -1) {
+        char digest[] = "SHA256";
+        OSSL_PARAM params[] = {
+            OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmac_key, sizeof(key.hmac_key)),
+            OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+            OSSL_PARAM_construct_end()
+        };
+        if (EVP_MAC_CTX_set_params(mac_ctx, params) != 1) {
+            ret = -1;
+        }
+    }
+    OPENSSL_cleanse(&key, sizeof(key));
+    return ret;
+}
+
+#endif // OPENSSL_VERSION_NUMBER >= 0x30000000L
+
+// ==================== 0-RTT防重放回调 ====================
+// OpenSSL决定接受早期数据前调用：同一ClientHello随机数在窗口内第二次出现视为重放，
+// 只拒绝早期数据，握手本身照常完成（客户端在握手后重发请求）
+static int AllowEarlyDataCallback(SSL* ssl, void* arg) {
+    (void)arg;
+    TlsContext* context = ContextFromSsl(ssl);
+    if (!context || !context->get_anti_replay()) {
+        return 0;
+    }
+
+    unsigned char client_random[SSL3_RANDOM_SIZE];
+    size_t len = SSL_get_client_random(ssl, client_random, sizeof(client_random));
+    return context->get_anti_replay()->check(client_random, len, details::NowSeconds()) ? 1 : 0;
+}
+
+// ==================== SNI证书选择回调 ====================
+// ClientHello扩展全部解析完后调用，此时已能拿到客户端的签名算法列表：
+// 列表含ECDSA时优先切到ECDSA证书（签名开销远低于RSA），含sm2sig_sm3时使用SM2证书。
+// 子上下文的app_data指向端口上下文，会话缓存、票据与防重放不随切换改变
+static int ServerNameCallback(SSL* ssl, int* alert, void* arg) {
+    (void)alert;
+    TlsContext* context = static_cast<TlsContext*>(arg);
+    const char* name = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+    if (!context || !name) {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+
+    bool ecdsa = false;
+    bool sm2 = false;
+    int count = SSL_get_sigalgs(ssl, -1, nullptr, nullptr, nullptr, nullptr, nullptr);
+    for (int i = 0; i < count; ++i) {
+        int sign = 0;
+        unsigned char rsig = 0;
+        unsigned char rhash = 0;
+        SSL_get_sigalgs(ssl, i, &sign, nullptr, nullptr, &rsig, &rhash);
+        if (sign == EVP_PKEY_EC) {
+            ecdsa = true;
+        } else if (rhash == 0x07 && rsig == 0x08) {
+            sm2 = true;
+        }
+    }
+
+    TlsContext* selected = context->select_server_name(name, ecdsa, sm2);
+    if (selected && selected->native_handle()) {
+        SSL_set_SSL_CTX(ssl, static_cast<SSL_CTX*>(selected->native_handle()));
+    }
+    return SSL_TLSEXT_ERR_OK;
+}
+
+#endif // HAVE_OPENSSL
+
+// ==================== TlsContext实现 ====================
+
+TlsContext::TlsContext()
+    : ssl_ctx_(nullptr)
+    , cert_path_()
+    , key_path_()
+    , ca_path_()
+    , sm2_cert_path_()
+    , sm2_key_path_()
+    , sm2_sign_cert_path_()
+    , sm2_sign_key_path_()
+    , cert_type_(CertType::RSA)
+    , use_gmssl_(false)
+    , cert_compressed_(false)
+    , alpn_protocols_("h2,http/1.1")
+    , session_cache_()
+    , ticket_keys_()
+    , anti_replay_()
+    , server_names_()
+    , error_code_(0)
+    , error_msg_()
+{
+}
+
+TlsContext::~TlsContext() {
+#if HAVE_OPENSSL
+    if (ssl_ctx_) {
+        SSL_CTX_free(static_cast<SSL_CTX*>(ssl_ctx_));
+        ssl_ctx_ = nullptr;
+    }
+#endif
+}
+
+int TlsContext::init(const CertConfig& cert_config, const TlsConfig& tls_config) {
+    // 保存国密配置标志
+    use_gmssl_ = cert_config.use_gmssl;
+
+    if (!tls_config.alpn_protocols.empty()) {
+        alpn_protocols_ = tls_config.alpn_protocols;
+    }
+
+    cert_path_ = cert_config.cert_path;
+    key_path_ = cert_config.key_path;
+    ca_path_ = cert_config.ca_path;
+
+    // 保存国密双证书配置
+    sm2_cert_path_ = cert_config.sm2_cert_path;
+    sm2_key_path_ = cert_config.sm2_key_path;
+    sm2_sign_cert_path_ = cert_config.sm2_sign_cert_path;
+    sm2_sign_key_path_ = cert_config.sm2_sign_key_path;
+
+    // 1. 初始化SSL上下文
+    int ret = init_ssl_context();
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+
+    // 2. 识别证书类型
+    ret = load_certificates();
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+
+    // 3. 配置证书
+    ret = configure_certificates();
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+
+    // 4. 配置加密套件
+    ret = configure_cipher_suites(tls_config);
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+
+    // 5. 配置ALPN
+    ret = configure_alpn();
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+
+    // 6. 配置会话复用
+    ret = configure_session_resumption(tls_config);
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+
+    // 7. 配置0-RTT早期数据
+    ret = configure_early_data(tls_config);
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+
+    // 8. 配置证书压缩（证书已加载，预压缩一次供所有连接复用）
+    ret = configure_cert_compression(tls_config);
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+
+    // 9. 预建SNI虚拟主机证书
+    return configure_server_names(cert_config, tls_config);
+}
+
+void* TlsContext::native_handle() const {
+    return ssl_ctx_;
+}
+
+const std::string& TlsContext::get_alpn_protocols() const {
+    return alpn_protocols_;
+}
+
+CertType TlsContext::get_cert_type() const {
+    return cert_type_;
+}
+
+int TlsContext::get_error_code() const {
+    return error_code_;
+}
+
+const std::string& TlsContext::get_error_msg() const {
+    return error_msg_;
+}
+
+TlsSessionCache* TlsContext::get_session_cache() const {
+    return session_cache_.get();
+}
+
+TlsTicketKeys* TlsContext::get_ticket_keys() const {
+    return ticket_keys_.get();
+}
+
+TlsAntiReplay* TlsContext::get_anti_replay() const {
+    return anti_replay_.get();
+}
+
+bool TlsContext::is_cert_compressed() const {
+    return cert_compressed_;
+}
+
+TlsContext* TlsContext::select_server_name(const std::string& server_name, bool ecdsa, bool sm2) const {
+    if (server_names_.empty() || server_name.empty()) {
+        return nullptr;
+    }
+
+    // 精确匹配优先，其次用"*.父域"匹配一级通配
+    std::string host = details::NormalizeServerName(server_name);
+    auto it = server_names_.find(host);
+    if (it == server_names_.end()) {
+        size_t dot = host.find('.');
+        if (dot == std::string::npos) {
+            return nullptr;
+        }
+        it = server_names_.find("*" + host.substr(dot));
+        if (it == server_names_.end()) {
+            return nullptr;
+        }
+    }
+
+    const ServerNameContexts& contexts = it->second;
+    if (sm2 && contexts.sm2) {
+        return contexts.sm2.get();
+    }
+    if (ecdsa && contexts.ecdsa) {
+        return contexts.ecdsa.get();
+    }
+    if (contexts.rsa) {
+        return contexts.rsa.get();
+    }
+    // 客户端能力与已配置证书都不匹配时仍交给握手协商（可能以告警结束）
+    return contexts.ecdsa ? contexts.ecdsa.get() : contexts.sm2.get();
+}
+
+size_t TlsContext::get_server_name_count() const {
+    return server_names_.size();
+}
+
+void TlsContext::inherit_resumption_state(const TlsContext& previous) {
+    // 回调经app_data取这些对象，新上下文发布前替换即可，无需加锁
+    if (session_cache_ && previous.session_cache_) {
+        session_cache_ = previous.session_cache_;
+    }
+    if (ticket_keys_ && previous.ticket_keys_) {
+        ticket_keys_ = previous.ticket_keys_;
+    }
+    if (anti_replay_ && previous.anti_replay_) {
+        anti_replay_ = previous.anti_replay_;
+    }
+}
+
+int TlsContext::configure_server_names(const CertConfig& cert_config, const TlsConfig& tls_config) {
+    for (const auto& entry : cert_config.server_names) {
+        std::string host = details::NormalizeServerName(entry.server_name);
+        if (host.empty() || server_names_.count(host) != 0) {
+            set_error(PROTOCOL_ERROR_INVALID, "Invalid or duplicate server name: " + entry.server_name);
+            return PROTOCOL_ERROR_INVALID;
+        }
+
+        ServerNameContexts contexts;
+        int ret = PROTOCOL_OK;
+        if (!entry.cert_path.empty() && !entry.key_path.empty()) {
+            CertConfig rsa;
+            rsa.cert_path = entry.cert_path;
+            rsa.key_path = entry.key_path;
+            ret = build_server_name_context(rsa, tls_config, &contexts.rsa);
+        }
+        if (ret == PROTOCOL_OK && !entry.ecdsa_cert_path.empty() && !entry.ecdsa_key_path.empty()) {
+            CertConfig ecdsa;
+            ecdsa.cert_path = entry.ecdsa_cert_path;
+            ecdsa.key_path = entry.ecdsa_key_path;
+            ret = build_server_name_context(ecdsa, tls_config, &contexts.ecdsa);
+        }
+        if (ret == PROTOCOL_OK && !entry.sm2_cert_path.empty() && !entry.sm2_key_path.empty()) {
+            CertConfig sm2;
+            sm2.sm2_cert_path = entry.sm2_cert_path;
+            sm2.sm2_key_path = entry.sm2_key_path;
+            sm2.use_gmssl = true;
+            ret = build_server_name_context(sm2, tls_config, &contexts.sm2);
+        }
+        if (ret != PROTOCOL_OK) {
+            return ret;
+        }
+        if (!contexts.rsa && !contexts.ecdsa && !contexts.sm2) {
+            set_error(PROTOCOL_ERROR_INVALID, "No certificate for server name: " + entry.server_name);
+            return PROTOCOL_ERROR_INVALID;
+        }
+        server_names_[host] = std::move(contexts);
+    }
+
+#if HAVE_OPENSSL
+    if (!server_names_.empty()) {
+        SSL_CTX* ctx = static_cast<SSL_CTX*>(ssl_ctx_);
+        SSL_CTX_set_tlsext_servername_callback(ctx, ServerNameCallback);
+        SSL_CTX_set_tlsext_servername_arg(ctx, this);
+    }
+#endif
+    return PROTOCOL_OK;
+}
+
+int TlsContext::build_server_name_context(const CertConfig& cert_config, const TlsConfig& tls_config,
+                                          std::unique_ptr<TlsContext>* out) {
+    // 子上下文只承载证书、套件与ALPN：会话缓存、票据与0-RTT都在握手开始时
+    // 由端口上下文决定，切换SSL_CTX后OpenSSL仍使用最初的会话上下文
+    TlsConfig child_config = tls_config;
+    child_config.session_cache_size = 0;
+    child_config.early_data = false;
+
+    std::unique_ptr<TlsContext> context(new TlsContext());
+    int ret = context->init(cert_config, child_config);
+    if (ret != PROTOCOL_OK) {
+        set_error(ret, context->get_error_msg());
+        return ret;
+    }
+#if HAVE_OPENSSL
+    // 会话回调经由SSL_get_SSL_CTX找到上下文，指回端口上下文使切换前后状态一致
+    SSL_CTX_set_app_data(static_cast<SSL_CTX*>(context->native_handle()), this);
+#endif
+    *out = std::move(context);
+    return PROTOCOL_OK;
+}
+
+void TlsContext::set_error(int code, const std::string& msg) {
+    error_code_ = code;
+    error_msg_ = msg;
+}
+
+// ==================== 私有方法实现 ====================
+
+#if HAVE_OPENSSL
+
+int TlsContext::init_ssl_context() {
+    // 使用TLS_server_method()创建SSL上下文
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    ssl_ctx_ = SSL_CTX_new(TLS_server_method());
+#else
+    ssl_ctx_ = SSL_CTX_new(SSLv23_server_method());
+    SSL_CTX_set_options(static_cast<SSL_CTX*>(ssl_ctx_), SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3);
+#endif
+
+    if (!ssl_ctx_) {
+        set_error(PROTOCOL_ERROR_TLS, "SSL_CTX_new failed");
+        return PROTOCOL_ERROR_TLS;
+    }
+
+    // 设置推荐的SSL选项
+    SSL_CTX_set_options(static_cast<SSL_CTX*>(ssl_ctx_), SSL_OP_ALL | SSL_OP_NO_COMPRESSION);
+
+    return PROTOCOL_OK;
+}
+
+int TlsContext::load_certificates() {
+    // 注意：cert_path_、key_path_、ca_path_已在init()中设置，避免重复赋值
+
+    // 国密模式下，优先检查SM2证书
+    if (use_gmssl_) {
+        // 国密模式下，至少需要有一个SM2证书配置
+        // 优先使用签名证书识别证书类型
+        std::string cert_to_check;
+        if (!sm2_sign_cert_path_.empty()) {
+            cert_to_check = sm2_sign_cert_path_;
+        } else if (!sm2_cert_path_.empty()) {
+            cert_to_check = sm2_cert_path_;
+        } else if (!cert_path_.empty()) {
+            cert_to_check = cert_path_;
+        }
+
+        if (!cert_to_check.empty()) {
+            // 尝试读取证书以识别类型
+            details::UniqueFilePtr fp(fopen(cert_to_check.c_str(), "r"));
+            if (fp) {
+                details::UniqueX509Ptr x509(PEM_read_X509(fp.get(), nullptr, nullptr, nullptr));
+                if (x509) {
+                    details::UniqueEvpPkeyPtr pkey(X509_get_pubkey(x509.get()));
+                    if (pkey) {
+                        int key_type = EVP_PKEY_id(pkey.get());
+#ifdef EVP_PKEY_SM2
+                        if (key_type == EVP_PKEY_SM2) {
+                            cert_type_ = CertType::SM2;
+                        } else
+#endif
+                        if (key_type == EVP_PKEY_EC) {
+                            cert_type_ = CertType::ECDSA;
+                        } else {
+                            cert_type_ = CertType::RSA;
+                        }
+                    } else {
+                        // 无法识别公钥类型，默认按国密处理
+                        cert_type_ = CertType::SM2;
+                    }
+                } else {
+                    // 无法读取证书，默认按国密处理
+                    cert_type_ = CertType::SM2;
+                }
+            } else {
+                // 文件无法打开，默认按国密处理
+                cert_type_ = CertType::SM2;
+            }
+        } else {
+            // 没有证书路径，默认按国密处理
+            cert_type_ = CertType::SM2;
+        }
+        return PROTOCOL_OK;
+    }
+
+    // 非国密模式下，使用普通证书
+    if (cert_path_.empty() || key_path_.empty()) {
+        cert_type_ = CertType::RSA;
+        return PROTOCOL_OK;
+    }
+
+    // 尝试读取证书以识别类型（使用RAII管理所有资源）
+    details::UniqueFilePtr fp(fopen(cert_path_.c_str(), "r"));
+    if (fp) {
+        details::UniqueX509Ptr x509(PEM_read_X509(fp.get(), nullptr, nullptr, nullptr));
+        if (x509) {
+            details::UniqueEvpPkeyPtr pkey(X509_get_pubkey(x509.get()));
+            if (pkey) {
+                int key_type = EVP_PKEY_id(pkey.get());
+#ifdef EVP_PKEY_SM2
+                if (key_type == EVP_PKEY_SM2) {
+                    cert_type_ = CertType::SM2;
+                } else
+#endif
+                if (key_type == EVP_PKEY_EC) {
+                    cert_type_ = CertType::ECDSA;
+                } else {
+                    cert_type_ = CertType::RSA;
+                }
+            }
+        }
+    }
+
+    return PROTOCOL_OK;
+}
+
+int TlsContext::load_ca_certificate(const std::string& ca_path) {
+    ca_path_ = ca_path;
+
+    if (ca_path_.empty()) {
+        return PROTOCOL_OK;
+    }
+
+    if (!ssl_ctx_) {
+        set_error(PROTOCOL_ERROR_INVALID, "SSL_CTX not initialized");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    if (SSL_CTX_load_verify_locations(static_cast<SSL_CTX*>(ssl_ctx_), ca_path_.c_str(), nullptr) != 1) {
+        set_error(PROTOCOL_ERROR_TLS, "Failed to load CA certificate");
+        return PROTOCOL_ERROR_TLS;
+    }
+
+    return PROTOCOL_OK;
+}
+
+int TlsContext::configure_certificates() {
+    if (!ssl_ctx_) {
+        set_error(PROTOCOL_ERROR_INVALID, "SSL_CTX not initialized");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    // 国密模式下，配置国密双证书
+    if (use_gmssl_) {
+        // 国密模式优先加载签名证书（用于签名）
+        bool has_sign_cert = !sm2_sign_cert_path_.empty() && !sm2_sign_key_path_.empty();
+        bool has_enc_cert = !sm2_cert_path_.empty() && !sm2_key_path_.empty();
+
+        // 优先使用签名证书作为主证书
+        if (has_sign_cert) {
+            // 加载签名证书链
+            if (SSL_CTX_use_certificate_chain_file(static_cast<SSL_CTX*>(ssl_ctx_), sm2_sign_cert_path_.c_str()) != 1) {
+                set_error(PROTOCOL_ERROR_TLS, "Failed to load SM2 sign certificate chain");
+                return PROTOCOL_ERROR_TLS;
+            }
+
+            // 加载签名私钥
+            if (SSL_CTX_use_PrivateKey_file(static_cast<SSL_CTX*>(ssl_ctx_), sm2_sign_key_path_.c_str(), SSL_FILETYPE_PEM) != 1) {
+                set_error(PROTOCOL_ERROR_TLS, "Failed to load SM2 sign private key");
+                return PROTOCOL_ERROR_TLS;
+            }
+
+            // 验证签名私钥
+            if (SSL_CTX_check_private_key(static_cast<SSL_CTX*>(ssl_ctx_)) != 1) {
+                set_error(PROTOCOL_ERROR_TLS, "SM2 sign private key does not match certificate");
+                return PROTOCOL_ERROR_TLS;
+            }
+        } else if (has_enc_cert) {
+            // 只有加密证书时，使用加密证书作为主证书
+            if (SSL_CTX_use_certificate_chain_file(static_cast<SSL_CTX*>(ssl_ctx_), sm2_cert_path_.c_str()) != 1) {
+                set_error(PROTOCOL_ERROR_TLS, "Failed to load SM2 enc certificate chain");
+                return PROTOCOL_ERROR_TLS;
+            }
+
+            if (SSL_CTX_use_PrivateKey_file(static_cast<SSL_CTX*>(ssl_ctx_), sm2_key_path_.c_str(), SSL_FILETYPE_PEM) != 1) {
+                set_error(PROTOCOL_ERROR_TLS, "Failed to load SM2 enc private key");
+                return PROTOCOL_ERROR_TLS;
+            }
+
+            if (SSL_CTX_check_private_key(static_cast<SSL_CTX*>(ssl_ctx_)) != 1) {
+                set_error(PROTOCOL_ERROR_TLS, "SM2 enc private key does not match certificate");
+                return PROTOCOL_ERROR_TLS;
+            }
+        } else if (!cert_path_.empty() && !key_path_.empty()) {
+            // 如果没有配置SM2证书但启用了国密，尝试使用普通证书
+            if (SSL_CTX_use_certificate_chain_file(static_cast<SSL_CTX*>(ssl_ctx_), cert_path_.c_str()) != 1) {
+                set_error(PROTOCOL_ERROR_TLS, "Failed to load certificate chain");
+                return PROTOCOL_ERROR_TLS;
+            }
+
+            if (SSL_CTX_use_PrivateKey_file(static_cast<SSL_CTX*>(ssl_ctx_), key_path_.c_str(), SSL_FILETYPE_PEM) != 1) {
+                set_error(PROTOCOL_ERROR_TLS, "Failed to load private key");
+                return PROTOCOL_ERROR_TLS;
+            }
+
+            if (SSL_CTX_check_private_key(static_cast<SSL_CTX*>(ssl_ctx_)) != 1) {
+                set_error(PROTOCOL_ERROR_TLS, "Private key does not match certificate");
+                return PROTOCOL_ERROR_TLS;
+            }
+        }
+        // 国密模式下，即使没有证书也不报错（测试场景）
+        return PROTOCOL_OK;
+    }
+
+    // 非国密模式下，配置普通证书
+    if (cert_path_.empty() || key_path_.empty()) {
+        return PROTOCOL_OK;
+    }
+
+    // 加载证书链
+    if (SSL_CTX_use_certificate_chain_file(static_cast<SSL_CTX*>(ssl_ctx_), cert_path_.c_str()) != 1) {
+        set_error(PROTOCOL_ERROR_TLS, "Failed to load certificate chain");
+        return PROTOCOL_ERROR_TLS;
+    }
+
+    // 加载私钥
+    if (SSL_CTX_use_PrivateKey_file(static_cast<SSL_CTX*>(ssl_ctx_), key_path_.c_str(), SSL_FILETYPE_PEM) != 1) {
+        set_error(PROTOCOL_ERROR_TLS, "Failed to load private key");
+        return PROTOCOL_ERROR_TLS;
+    }
+
+    // 验证私钥
+    if (SSL_CTX_check_private_key(static_cast<SSL_CTX*>(ssl_ctx_)) != 1) {
+        set_error(PROTOCOL_ERROR_TLS, "Private key does not match certificate");
+        return PROTOCOL_ERROR_TLS;
+    }
+
+    return PROTOCOL_OK;
+}
+
+int TlsContext::configure_cipher_suites(const TlsConfig& config) {
+    if (!ssl_ctx_) {
+        set_error(PROTOCOL_ERROR_INVALID, "SSL_CTX not initialized");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    // 检查是否使用国密（优先使用配置标志，其次根据证书类型判断）
+    if (use_gmssl_ || cert_type_ == CertType::SM2) {
+        // 配置国密SM2/SM3/SM4套件
+        // 国密密码套件优先级按推荐顺序配置
+        const char* gm_ciphers = "SM2-WITH-SMS4-SM3:"
+                                 "ECDHE-SM2-WITH-SMS4-SM3:"
+                                 "SM2-WITH-SMS4-GCM-SM3:"
+                                 "ECDHE-SM2-WITH-SMS4-GCM-SM3";
+
+        // 尝试设置国密密码套件（可能不被所有OpenSSL版本支持）
+        if (SSL_CTX_set_cipher_list(static_cast<SSL_CTX*>(ssl_ctx_), gm_ciphers) != 1) {
+            // 如果失败，尝试单个套件
+            const char* single_gm_cipher = "SM2-WITH-SMS4-SM3";
+            if (SSL_CTX_set_cipher_list(static_cast<SSL_CTX*>(ssl_ctx_), single_gm_cipher) != 1) {
+                // 国密套件设置失败时，记录警告但继续（使用默认套件）
+                // 注意：这里不返回错误，因为可能是测试场景或OpenSSL不支持国密
+            }
+        }
+
+        // 国密主要使用TLS 1.2，禁用TLS 1.3（如果支持）
+#ifdef SSL_OP_NO_TLSv1_3
+        SSL_CTX_set_options(static_cast<SSL_CTX*>(ssl_ctx_), SSL_OP_NO_TLSv1_3);
+#endif
+    } else {
+        // 用户指定的套件中TLS 1.3套件（TLS_前缀）与TLS 1.2 cipher list分别设置，
+        // 二者在OpenSSL中是两套独立的配置接口
+        std::string tls13_suites;
+        std::string tls12_ciphers;
+        details::SplitCipherSuites(config.cipher_suites, tls13_suites, tls12_ciphers);
+
+        if (!tls13_suites.empty() &&
+            SSL_CTX_set_ciphersuites(static_cast<SSL_CTX*>(ssl_ctx_), tls13_suites.c_str()) != 1) {
+            set_error(PROTOCOL_ERROR_TLS, "Failed to set TLS 1.3 cipher suites");
+            return PROTOCOL_ERROR_TLS;
+        }
+
+        if (!tls12_ciphers.empty()) {
+            // 使用用户指定的TLS 1.2加密套件
+            if (SSL_CTX_set_cipher_list(static_cast<SSL_CTX*>(ssl_ctx_), tls12_ciphers.c_str()) != 1) {
+                set_error(PROTOCOL_ERROR_TLS, "Failed to set cipher list");
+                return PROTOCOL_ERROR_TLS;
+            }
+        } else {
+            // 使用默认TLS 1.2加密套件
+            const char* default_ciphers =
+                "ECDHE-ECDSA-AES128-GCM-SHA256:"
+                "ECDHE-RSA-AES128-GCM-SHA256:"
+                "ECDHE-ECDSA-AES256-GCM-SHA384:"
+                "ECDHE-RSA-AES256-GCM-SHA384";
+            if (SSL_CTX_set_cipher_list(static_cast<SSL_CTX*>(ssl_ctx_), default_ciphers) != 1) {
+                set_error(PROTOCOL_ERROR_TLS, "Failed to set default cipher list");
+                return PROTOCOL_ERROR_TLS;
+            }
+        }
+    }
+
+    // 配置TLS版本（非国密模式）
+    if (!use_gmssl_ && cert_type_ != CertType::SM2) {
+#ifdef SSL_OP_NO_TLSv1_2
+        if (!config.enable_tls_1_2) {
+            SSL_CTX_set_options(static_cast<SSL_CTX*>(ssl_ctx_), SSL_OP_NO_TLSv1_2);
+        }
+#endif
+#ifdef SSL_OP_NO_TLSv1_3
+        if (!config.enable_tls_1_3) {
+            SSL_CTX_set_options(static_cast<SSL_CTX*>(ssl_ctx_), SSL_OP_NO_TLSv1_3);
+        }
+#endif
+    }
+
+    return PROTOCOL_OK;
+}
+
+int TlsContext::configure_alpn() {
+    if (!ssl_ctx_) {
+        set_error(PROTOCOL_ERROR_INVALID, "SSL_CTX not initialized");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    // 设置ALPN选择回调（参数为上下文自身，所有连接共用）
+    SSL_CTX_set_alpn_select_cb(static_cast<SSL_CTX*>(ssl_ctx_), AlpnSelectCallback, this);
+
+    // 注意：在服务器端，我们不需要调用 SSL_CTX_set_alpn_protos
+    // 服务器端是通过回调函数 AlpnSelectCallback 来选择协议的
+    // 我们的回调函数已经支持从 alpn_protocols_ 中选择合适的协议
+
+    return PROTOCOL_OK;
+}
+
+int TlsContext::configure_session_resumption(const TlsConfig& config) {
+    if (!ssl_ctx_) {
+        set_error(PROTOCOL_ERROR_INVALID, "SSL_CTX not initialized");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    SSL_CTX* ctx = static_cast<SSL_CTX*>(ssl_ctx_);
+    SSL_CTX_set_app_data(ctx, this);
+
+    static const unsigned char SESSION_ID_CONTEXT[] = "https_server_sim";
+    SSL_CTX_set_session_id_context(ctx, SESSION_ID_CONTEXT, sizeof(SESSION_ID_CONTEXT) - 1);
+    SSL_CTX_set_timeout(ctx, static_cast<long>(config.session_timeout));
+
+    // 服务端会话缓存：关闭OpenSSL内部缓存（单锁），改用分片缓存
+    if (config.session_cache_size > 0) {
+        session_cache_.reset(new TlsSessionCache(config.session_cache_size, config.session_timeout));
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+        SSL_CTX_sess_set_new_cb(ctx, NewSessionCallback);
+        SSL_CTX_sess_set_get_cb(ctx, GetSessionCallback);
+        SSL_CTX_sess_set_remove_cb(ctx, RemoveSessionCallback);
+    } else {
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    }
+
+    if (!config.session_tickets) {
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+        return PROTOCOL_OK;
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    ticket_keys_.reset(new TlsTicketKeys(config.ticket_key_rotation));
+    if (SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, TicketKeyCallback) != 1) {
+        set_error(PROTOCOL_ERROR_TLS, "Failed to set session ticket key callback");
+        return PROTOCOL_ERROR_TLS;
+    }
+#endif
+    // 更早的OpenSSL使用其内置的票据密钥（进程生命周期内不轮换）
+
+    return PROTOCOL_OK;
+}
+
+int TlsContext::configure_early_data(const TlsConfig& config) {
+    // 早期数据只存在于TLS 1.3会话复用中
+    if (!config.early_data || !config.enable_tls_1_3 || config.max_early_data == 0) {
+        return PROTOCOL_OK;
+    }
+    if (!ssl_ctx_) {
+        set_error(PROTOCOL_ERROR_INVALID, "SSL_CTX not initialized");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    SSL_CTX* ctx = static_cast<SSL_CTX*>(ssl_ctx_);
+    anti_replay_.reset(new TlsAntiReplay(TLS_EARLY_DATA_REPLAY_WINDOW, TLS_EARLY_DATA_REPLAY_ENTRIES));
+    if (SSL_CTX_set_max_early_data(ctx, config.max_early_data) != 1 ||
+        SSL_CTX_set_recv_max_early_data(ctx, config.max_early_data) != 1) {
+        set_error(PROTOCOL_ERROR_TLS, "Failed to set max early data");
+        return PROTOCOL_ERROR_TLS;
+    }
+    // OpenSSL自带的防重放要求改发有状态的一次性票据（依赖会话缓存且连接异常关闭即失效），
+    // 这里关闭它，票据保持无状态，重放由按端口共享的ClientHello过滤器识别
+    SSL_CTX_set_options(ctx, SSL_OP_NO_ANTI_REPLAY);
+    SSL_CTX_set_allow_early_data_cb(ctx, AllowEarlyDataCallback, nullptr);
+    return PROTOCOL_OK;
+}
+
+int TlsContext::configure_cert_compression(const TlsConfig& config) {
+    if (!ssl_ctx_) {
+        set_error(PROTOCOL_ERROR_INVALID, "SSL_CTX not initialized");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L
+    SSL_CTX* ctx = static_cast<SSL_CTX*>(ssl_ctx_);
+    if (!config.cert_compression || !config.enable_tls_1_3) {
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TX_CERTIFICATE_COMPRESSION);
+        return PROTOCOL_OK;
+    }
+
+    // 按压缩率排序；OpenSSL未编入的算法会被忽略
+    int algs[] = { TLSEXT_comp_cert_brotli, TLSEXT_comp_cert_zstd, TLSEXT_comp_cert_zlib };
+    if (SSL_CTX_set1_cert_comp_preference(ctx, algs, sizeof(algs) / sizeof(algs[0])) != 1) {
+        return PROTOCOL_OK;
+    }
+    // 每种算法压缩一次并挂在证书上，握手时直接发送压缩结果；
+    // 没有证书或没有可用的压缩算法时返回失败，按未压缩发送即可
+    cert_compressed_ = SSL_CTX_compress_certs(ctx, TLSEXT_comp_cert_none) == 1;
+#else
+    // 证书压缩需要OpenSSL 3.2+，更早的版本按未压缩发送
+    (void)config;
+#endif
+    return PROTOCOL_OK;
+}
+
+#else // !HAVE_OPENSSL
+
+// 没有OpenSSL时的空实现
+int TlsContext::init_ssl_context() {
+    return PROTOCOL_OK;
+}
+
+int TlsContext::load_certificates() {
+    cert_type_ = CertType::RSA;
+    return PROTOCOL_OK;
+}
+
+int TlsContext::load_ca_certificate(const std::string& ca_path) {
+    (void)ca_path;
+    return PROTOCOL_OK;
+}
+
+int TlsContext::configure_certificates() {
+    return PROTOCOL_OK;
+}
+
+int TlsContext::configure_cipher_suites(const TlsConfig& config) {
+    (void)config;
+    return PROTOCOL_OK;
+}
+
+int TlsContext::configure_alpn() {
+    return PROTOCOL_OK;
+}
+
+int TlsContext::configure_session_resumption(const TlsConfig& config) {
+    // 无OpenSSL时仍创建缓存与密钥环，保持与真实环境一致的配置语义
+    if (config.session_cache_size > 0) {
+        session_cache_.reset(new TlsSessionCache(config.session_cache_size, config.session_timeout));
+    }
+    if (config.session_tickets) {
+        ticket_keys_.reset(new TlsTicketKeys(config.ticket_key_rotation));
+    }
+    return PROTOCOL_OK;
+}
+
+int TlsContext::configure_early_data(const TlsConfig& config) {
+    if (config.early_data && config.enable_tls_1_3 && config.max_early_data > 0) {
+        anti_replay_.reset(new TlsAntiReplay(TLS_EARLY_DATA_REPLAY_WINDOW, TLS_EARLY_DATA_REPLAY_ENTRIES));
+    }
+    return PROTOCOL_OK;
+}
+
+int TlsContext::configure_cert_compression(const TlsConfig& config) {
+    (void)config;
+    return PROTOCOL_OK;
+}
+
+#endif // HAVE_OPENSSL
+
+// ==================== TlsContextManager实现 ====================
+
+TlsContextManager& TlsContextManager::instance() {
+    static TlsContextManager manager;
+    return manager;
+}
+
+int TlsContextManager::build(const config::Config& config) {
+    CertConfig cert_config;
+    ConfigConverter::convert_cert_config(config.get_certificates(), cert_config);
+
+    std::lock_guard<std::mutex> lock(build_mutex_);
+    std::shared_ptr<const ContextMap> previous = std::atomic_load(&contexts_);
+
+    // 先全部构建成功再替换，失败时保留原有上下文
+    auto contexts = std::make_shared<ContextMap>();
+    for (const auto& listen : config.get_listens()) {
+        if (!listen.enabled || !listen.tls_enabled || contexts->count(listen.port) != 0) {
+            continue;
+        }
+        TlsConfig tls_config;
+        ConfigConverter::convert_tls_config(config, listen.port, tls_config);
+        auto context = std::make_shared<TlsContext>();
+        int ret = context->init(cert_config, tls_config);
+        if (ret != PROTOCOL_OK) {
+            return ret;
+        }
+        if (previous) {
+            auto it = previous->find(listen.port);
+            if (it != previous->end()) {
+                context->inherit_resumption_state(*it->second);
+            }
+        }
+        (*contexts)[listen.port] = std::move(context);
+    }
+
+    std::atomic_store(&contexts_, std::shared_ptr<const ContextMap>(std::move(contexts)));
+    generation_.fetch_add(1, std::memory_order_relaxed);
+    return PROTOCOL_OK;
+}
+
+std::shared_ptr<TlsContext> TlsContextManager::get(uint16_t port) const {
+    std::shared_ptr<const ContextMap> contexts = std::atomic_load(&contexts_);
+    if (!contexts) {
+        return nullptr;
+    }
+    auto it = contexts->find(port);
+    return it != contexts->end() ? it->second : nullptr;
+}
+
+void TlsContextManager::clear() {
+    std::lock_guard<std::mutex> lock(build_mutex_);
+    std::atomic_store(&contexts_, std::shared_ptr<const ContextMap>());
+}
+
+uint64_t TlsContextManager::get_generation() const {
+    return generation_.load(std::memory_order_relaxed);
+}
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
@@ -5,10 +5,19 @@
 //  版权: Copyright (c) 2026
 // =============================================================================
 #include "protocol/tls_handler.hpp"
+#include "protocol/tls_context.hpp"
+#include "connection/connection.hpp"
+#include "utils/statistics.hpp"
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <cstdio>
 #include <memory>
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 #if HAVE_OPENSSL
 #include <openssl/ssl.h>
 #include <openssl/err.h>
@@ -16,6 +25,13 @@
 #include <openssl/pem.h>
 #endif
 
+// kTLS需要Linux内核TLS ULP以及带ktls支持编译的OpenSSL 3.0+
+#if HAVE_OPENSSL && defined(__linux__) && !defined(OPENSSL_NO_KTLS) && defined(SSL_OP_ENABLE_KTLS)
+#define TLS_HANDLER_HAS_KTLS 1
+#else
+#define TLS_HANDLER_HAS_KTLS 0
+#endif
+
 namespace https_server_sim {
 namespace protocol {
 
@@ -33,136 +49,116 @@ struct FileCloser {
 
 using UniqueFilePtr = std::unique_ptr<FILE, FileCloser>;
 
-#if HAVE_OPENSSL
-
-// X509* 包装器
-struct X509Deleter {
-    void operator()(X509* x509) const {
-        if (x509) {
-            X509_free(x509);
-        }
-    }
-};
-
-using UniqueX509Ptr = std::unique_ptr<X509, X509Deleter>;
-
-// EVP_PKEY* 包装器
-struct EvpPkeyDeleter {
-    void operator()(EVP_PKEY* pkey) const {
-        if (pkey) {
-            EVP_PKEY_free(pkey);
-        }
-    }
-};
-
-using UniqueEvpPkeyPtr = std::unique_ptr<EVP_PKEY, EvpPkeyDeleter>;
-
-#endif // HAVE_OPENSSL
-
-} // namespace details
+// 单调时钟毫秒数（动态记录长度的空闲判断）
+static uint64_t NowMillis() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
 
 #if HAVE_OPENSSL
 
-// ==================== ALPN选择回调 ====================
-static int AlpnSelectCallback(SSL* ssl, const unsigned char** out,
-                               unsigned char* outlen, const unsigned char* in,
-                               unsigned int inlen, void* arg) {
-    (void)ssl;
-
-    // 获取TlsHandler实例
-    TlsHandler* handler = static_cast<TlsHandler*>(arg);
-    if (!handler) {
-        return SSL_TLSEXT_ERR_NOACK;
-    }
-
-    // 解析服务器配置的ALPN协议列表（格式: "h2,http/1.1"）
-    const std::string& server_alpn = handler->get_alpn_protocols();
-
-    // 我们优先按服务器配置的顺序选择
-    // 首先解析服务器支持的协议列表
-    std::vector<std::string> server_protocols;
-    size_t pos = 0;
-    while (pos < server_alpn.size()) {
-        size_t comma = server_alpn.find(',', pos);
-        if (comma == std::string::npos) {
-            comma = server_alpn.size();
-        }
-        std::string proto = server_alpn.substr(pos, comma - pos);
-        // 去除首尾空格
-        size_t start = proto.find_first_not_of(" \t");
-        size_t end = proto.find_last_not_of(" \t");
-        if (start != std::string::npos && end != std::string::npos && start <= end) {
-            std::string trimmed = proto.substr(start, end - start + 1);
-            // 跳过空字符串
-            if (!trimmed.empty()) {
-                server_protocols.push_back(std::move(trimmed));
+// ==================== Connection缓冲区BIO ====================
+// SSL的读直接消费Connection read_buffer_中的密文，写直接reserve/commit进
+// write_buffer_。BIO数据指针为所属TlsHandler，缓冲区在读写时才取，
+// 因此init之后再set_read_buffer/set_write_buffer同样生效。
+struct ConnectionBio {
+    static BIO_METHOD* method() {
+        static BIO_METHOD* const bio_method = []() {
+            BIO_METHOD* m = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK,
+                                         "https_server_sim connection");
+            if (m) {
+                BIO_meth_set_write(m, bio_write);
+                BIO_meth_set_read(m, bio_read);
+                BIO_meth_set_ctrl(m, bio_ctrl);
+                BIO_meth_set_create(m, bio_create);
             }
-        }
-        pos = comma + 1;
+            return m;
+        }();
+        return bio_method;
     }
 
-    // 如果没有有效的协议，直接返回
-    if (server_protocols.empty()) {
-        return SSL_TLSEXT_ERR_NOACK;
+    static int bio_create(BIO* bio) {
+        BIO_set_init(bio, 1);
+        return 1;
     }
 
-    // 遍历客户端支持的协议，按服务器配置的优先级选择
-    const unsigned char* client_end = in + inlen;
+    static int bio_read(BIO* bio, char* out, int len) {
+        BIO_clear_retry_flags(bio);
+        TlsHandler* handler = static_cast<TlsHandler*>(BIO_get_data(bio));
+        utils::Buffer* buffer = handler ? handler->read_buffer_ : nullptr;
+        if (!buffer || len <= 0) {
+            return 0;
+        }
+        if (buffer->readable_bytes() == 0) {
+            // 密文尚未到达：等待下一次读事件
+            BIO_set_retry_read(bio);
+            return -1;
+        }
+        return static_cast<int>(buffer->read(reinterpret_cast<uint8_t*>(out), static_cast<size_t>(len)));
+    }
 
-    // 按服务器配置的优先级查找
-    for (const auto& server_proto : server_protocols) {
-        const unsigned char* client_ptr = in;
-        while (client_ptr < client_end) {
-            unsigned int len = *client_ptr++;
-            if (client_ptr + len > client_end) {
-                break;
-            }
-            if (len == server_proto.size() &&
-                memcmp(client_ptr, server_proto.data(), len) == 0) {
-                *out = client_ptr;
-                *outlen = len;
-                return SSL_TLSEXT_ERR_OK;
-            }
-            client_ptr += len;
+    static int bio_write(BIO* bio, const char* data, int len) {
+        BIO_clear_retry_flags(bio);
+        TlsHandler* handler = static_cast<TlsHandler*>(BIO_get_data(bio));
+        utils::Buffer* buffer = handler ? handler->write_buffer_ : nullptr;
+        if (!buffer || len <= 0) {
+            return len == 0 ? 0 : -1;
         }
+        uint8_t* space = buffer->reserve(static_cast<size_t>(len));
+        if (!space) {
+            // 写缓冲区已到上限：等待连接层发送后重试
+            BIO_set_retry_write(bio);
+            return -1;
+        }
+        std::memcpy(space, data, static_cast<size_t>(len));
+        buffer->commit(static_cast<size_t>(len));
+        return len;
     }
 
-    // 没有匹配的协议
-    return SSL_TLSEXT_ERR_NOACK;
-}
+    static long bio_ctrl(BIO* bio, int cmd, long num, void* ptr) {
+        (void)bio;
+        (void)num;
+        (void)ptr;
+        // 写入即进入Connection写缓冲区，无需刷新；其余控制命令不支持
+        return (cmd == BIO_CTRL_FLUSH) ? 1 : 0;
+    }
+};
 
 #endif // HAVE_OPENSSL
 
+} // namespace details
+
 // ==================== TlsHandler实现 ====================
 
 TlsHandler::TlsHandler()
     : conn_(nullptr)
-    , ssl_ctx_(nullptr)
+    , context_()
     , ssl_(nullptr)
-    , ssl_read_bio_(nullptr)
-    , ssl_write_bio_(nullptr)
     , initialized_(false)
     , handshake_done_(false)
+    , socket_io_(false)
+    , plaintext_(false)
+    , ktls_tx_(false)
+    , ktls_rx_(false)
     , read_buffer_(nullptr)
     , write_buffer_(nullptr)
-    , cert_path_()
-    , key_path_()
-    , ca_path_()
-    , sm2_cert_path_()
-    , sm2_key_path_()
-    , sm2_sign_cert_path_()
-    , sm2_sign_key_path_()
-    , cert_type_(CertType::RSA)
-    , use_gmssl_(false)
+    , pending_write_()
+    , retry_len_(0)
+    , record_ramp_bytes_(DEFAULT_TLS_RECORD_RAMP_BYTES)
+    , record_idle_ms_(DEFAULT_TLS_RECORD_IDLE_MS)
+    , record_bytes_sent_(0)
+    , last_write_ms_(0)
+    , handshake_flight_bytes_(0)
+    , handshake_round_trips_(0)
+    , early_data_reading_(false)
+    , early_data_accepted_(false)
+    , early_data_methods_()
+    , early_data_()
     , error_code_(0)
     , error_msg_()
-    , alpn_protocols_("h2,http/1.1")
 {
     // 标记条件编译下可能未使用的字段
-    (void)ssl_ctx_;
     (void)ssl_;
-    (void)ssl_read_bio_;
-    (void)ssl_write_bio_;
 }
 
 TlsHandler::~TlsHandler() {
@@ -173,70 +169,56 @@ int TlsHandler::init(Connection* conn,
                      const CertConfig& cert_config,
                      const TlsConfig& tls_config) {
     conn_ = conn;
-
-    // 保存国密配置标志
-    use_gmssl_ = cert_config.use_gmssl;
-
-    if (!tls_config.alpn_protocols.empty()) {
-        alpn_protocols_ = tls_config.alpn_protocols;
-    }
-
-    cert_path_ = cert_config.cert_path;
-    key_path_ = cert_config.key_path;
-    ca_path_ = cert_config.ca_path;
-
-    // 保存国密双证书配置
-    sm2_cert_path_ = cert_config.sm2_cert_path;
-    sm2_key_path_ = cert_config.sm2_key_path;
-    sm2_sign_cert_path_ = cert_config.sm2_sign_cert_path;
-    sm2_sign_key_path_ = cert_config.sm2_sign_key_path;
-
-#if HAVE_OPENSSL
-    // 1. 初始化SSL上下文
-    int ret = init_ssl_context(cert_config);
-    if (ret != PROTOCOL_OK) {
-        return ret;
-    }
-
-    // 2. 加载证书
-    ret = load_certificates(cert_config);
-    if (ret != PROTOCOL_OK) {
-        return ret;
-    }
-
-    // 3. 配置证书
-    ret = configure_certificates(cert_config);
-    if (ret != PROTOCOL_OK) {
-        return ret;
-    }
-
-    // 4. 配置加密套件
-    ret = configure_cipher_suites(tls_config);
-    if (ret != PROTOCOL_OK) {
-        return ret;
+    record_ramp_bytes_ = tls_config.record_ramp_bytes;
+    record_idle_ms_ = tls_config.record_idle_ms;
+    early_data_methods_ = tls_config.early_data_methods;
+
+    // 明文端口不创建SSL对象，视为握手已完成
+    plaintext_ = tls_config.plaintext;
+    if (plaintext_) {
+        initialized_ = true;
+        handshake_done_ = true;
+        return PROTOCOL_OK;
     }
 
-    // 5. 配置ALPN
-    ret = configure_alpn();
-    if (ret != PROTOCOL_OK) {
-        return ret;
+    // 1. 优先使用监听端口共享的上下文；未提供时为本连接单独构建（独立使用与测试）
+    context_ = tls_config.context;
+    if (!context_) {
+        auto context = std::make_shared<TlsContext>();
+        int ret = context->init(cert_config, tls_config);
+        if (ret != PROTOCOL_OK) {
+            set_error(context->get_error_code(), context->get_error_msg());
+            return ret;
+        }
+        context_ = std::move(context);
     }
 
-    // 6. 创建SSL对象
-    ssl_ = SSL_new(static_cast<SSL_CTX*>(ssl_ctx_));
+#if HAVE_OPENSSL
+    // 2. 创建SSL对象（证书、套件与ALPN均继承自上下文）
+    ssl_ = SSL_new(static_cast<SSL_CTX*>(context_->native_handle()));
     if (!ssl_) {
         set_error(PROTOCOL_ERROR_TLS, "SSL_new failed");
         return PROTOCOL_ERROR_TLS;
     }
 
-    // 7. 设置内存BIO
-    ret = setup_bio();
-    if (ret != PROTOCOL_OK) {
-        return ret;
+    // 3. 设置BIO：请求kTLS且内核支持时直接绑定socket，否则使用Connection缓冲区BIO
+    if (!tls_config.enable_ktls || setup_ktls() != PROTOCOL_OK) {
+        int ret = setup_bio();
+        if (ret != PROTOCOL_OK) {
+            return ret;
+        }
     }
 
+    // 每条记录写出即返回（按记录切分与暂存剩余明文依赖此模式）；暂存缓冲区可能搬移，
+    // 重试时允许传入不同地址
+    SSL_set_mode(static_cast<SSL*>(ssl_),
+                 SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
     // 设置SSL为服务器模式
     SSL_set_accept_state(static_cast<SSL*>(ssl_));
+
+    // 上下文已配置0-RTT（带防重放过滤器）时，握手先从读取早期数据开始
+    early_data_reading_ = tls_config.early_data && context_->get_anti_replay() != nullptr;
 #endif // HAVE_OPENSSL
 
     initialized_ = true;
@@ -257,26 +239,27 @@ int TlsHandler::read(uint8_t* data, size_t len, size_t* out_len) {
 
     *out_len = 0;
 
+    // 明文模式：直接从Connection read_buffer_取数据
+    if (plaintext_) {
+        if (!read_buffer_ || read_buffer_->readable_bytes() == 0) {
+            return PROTOCOL_ERROR_EAGAIN;
+        }
+        *out_len = read_buffer_->read(data, len);
+        return PROTOCOL_OK;
+    }
+
 #if HAVE_OPENSSL
     if (!ssl_ || !handshake_done_) {
         set_error(PROTOCOL_ERROR_INVALID, "SSL not initialized or handshake not done");
         return PROTOCOL_ERROR_INVALID;
     }
 
-    // 步骤1: 从Connection read_buffer_读取密文 -> SSL read BIO
-    int ret = pump_read_bio();
-    if (ret < 0) {
-        return ret;
-    }
-
-    // 步骤2: 从SSL读取明文
-    ret = SSL_read(static_cast<SSL*>(ssl_), data, static_cast<int>(len));
+    // SSL经BIO直接消费read_buffer_中的密文
+    int ret = SSL_read(static_cast<SSL*>(ssl_), data, static_cast<int>(len));
     if (ret <= 0) {
         int err = SSL_get_error(static_cast<SSL*>(ssl_), ret);
         if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
             // 需要更多数据
-            // 步骤3: 将SSL write BIO中的数据 -> Connection write_buffer_
-            pump_write_bio();
             return PROTOCOL_ERROR_EAGAIN;
         } else {
             // 真实错误
@@ -286,10 +269,6 @@ int TlsHandler::read(uint8_t* data, size_t len, size_t* out_len) {
     }
 
     *out_len = static_cast<size_t>(ret);
-
-    // 步骤3: 将SSL write BIO中的数据 -> Connection write_buffer_
-    pump_write_bio();
-
     return PROTOCOL_OK;
 #else
     // 没有OpenSSL，返回EAGAIN（桩代码行为）
@@ -299,6 +278,93 @@ int TlsHandler::read(uint8_t* data, size_t len, size_t* out_len) {
 #endif
 }
 
+int TlsHandler::read_into(utils::Buffer* dst, size_t* out_len) {
+    // 检查初始化状态
+    if (!initialized_) {
+        set_error(PROTOCOL_ERROR_INVALID, "TlsHandler not initialized");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    if (dst == nullptr || out_len == nullptr) {
+        set_error(PROTOCOL_ERROR_INVALID, "Invalid read_into arguments");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    *out_len = 0;
+
+    // 明文模式：Connection read_buffer_整体搬入目标缓冲区
+    if (plaintext_) {
+        if (!read_buffer_ || read_buffer_->readable_bytes() == 0) {
+            return PROTOCOL_ERROR_EAGAIN;
+        }
+        size_t readable = read_buffer_->readable_bytes();
+        *out_len = dst->write(read_buffer_->read_ptr(), readable);
+        read_buffer_->skip(*out_len);
+        if (*out_len != readable) {
+            set_error(PROTOCOL_ERROR_BUFFER, "Plaintext buffer full");
+            return PROTOCOL_ERROR_BUFFER;
+        }
+        return PROTOCOL_OK;
+    }
+
+#if HAVE_OPENSSL
+    if (!ssl_ || (!handshake_done_ && !early_data_accepted_)) {
+        set_error(PROTOCOL_ERROR_INVALID, "SSL not initialized or handshake not done");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    // 0-RTT阶段：继续读取早期数据，客户端Finished到达后完成握手
+    if (!handshake_done_) {
+        int ret = continue_handshake();
+        if (ret < 0 && ret != PROTOCOL_ERROR_EAGAIN) {
+            return ret;
+        }
+    }
+
+    // 早期数据先于握手之后的明文交付
+    if (has_early_data()) {
+        size_t readable = early_data_->readable_bytes();
+        *out_len = dst->write(early_data_->read_ptr(), readable);
+        early_data_->skip(*out_len);
+        if (*out_len != readable) {
+            set_error(PROTOCOL_ERROR_BUFFER, "Plaintext buffer full");
+            return PROTOCOL_ERROR_BUFFER;
+        }
+    }
+    if (!handshake_done_) {
+        return *out_len > 0 ? PROTOCOL_OK : PROTOCOL_ERROR_EAGAIN;
+    }
+
+    // 每次在目标缓冲区预留一个TLS记录的空间，SSL_read直接解密到其中
+    while (true) {
+        uint8_t* space = dst->reserve(TLS_MAX_RECORD_SIZE);
+        if (!space) {
+            if (*out_len > 0) {
+                break;
+            }
+            set_error(PROTOCOL_ERROR_BUFFER, "Plaintext buffer full");
+            return PROTOCOL_ERROR_BUFFER;
+        }
+        int ret = SSL_read(static_cast<SSL*>(ssl_), space, static_cast<int>(TLS_MAX_RECORD_SIZE));
+        if (ret <= 0) {
+            int err = SSL_get_error(static_cast<SSL*>(ssl_), ret);
+            if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+                break;
+            }
+            set_error(PROTOCOL_ERROR_TLS, "SSL_read failed");
+            return PROTOCOL_ERROR_TLS;
+        }
+        dst->commit(static_cast<size_t>(ret));
+        *out_len += static_cast<size_t>(ret);
+    }
+
+    return *out_len > 0 ? PROTOCOL_OK : PROTOCOL_ERROR_EAGAIN;
+#else
+    // 没有OpenSSL，返回EAGAIN（桩代码行为）
+    return PROTOCOL_ERROR_EAGAIN;
+#endif
+}
+
 int TlsHandler::write(const uint8_t* data, size_t len, size_t* out_len) {
     // 检查初始化状态
     if (!initialized_) {
@@ -313,49 +379,301 @@ int TlsHandler::write(const uint8_t* data, size_t len, size_t* out_len) {
 
     *out_len = 0;
 
+    // 明文模式：直接写入Connection write_buffer_
+    if (plaintext_) {
+        if (!write_buffer_) {
+            set_error(PROTOCOL_ERROR_INVALID, "write buffer not set");
+            return PROTOCOL_ERROR_INVALID;
+        }
+        *out_len = write_buffer_->write(data, len);
+        return *out_len == len ? PROTOCOL_OK : PROTOCOL_ERROR_BUFFER;
+    }
+
 #if HAVE_OPENSSL
-    if (!ssl_ || !handshake_done_) {
+    if (!ssl_ || (!handshake_done_ && !early_data_accepted_)) {
         set_error(PROTOCOL_ERROR_INVALID, "SSL not initialized or handshake not done");
         return PROTOCOL_ERROR_INVALID;
     }
 
-    // 步骤1: 从Connection read_buffer_读取密文 -> SSL read BIO
-    // (SSL_write可能需要读取数据)
-    int ret = pump_read_bio();
-    if (ret < 0) {
-        return ret;
+    // 已有暂存明文时排在其后，保证写出顺序
+    if (get_pending_bytes() > 0) {
+        int ret = stash_pending(data, len);
+        if (ret != PROTOCOL_OK) {
+            return ret;
+        }
+        *out_len = len;
+        ret = flush_pending();
+        return ret == PROTOCOL_ERROR_EAGAIN ? PROTOCOL_OK : ret;
     }
 
-    // 步骤2: 写入明文到SSL
-    ret = SSL_write(static_cast<SSL*>(ssl_), data, static_cast<int>(len));
-    if (ret <= 0) {
-        int err = SSL_get_error(static_cast<SSL*>(ssl_), ret);
-        if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
-            // 需要更多数据或等待写入
-            // 步骤3: 将SSL write BIO中的数据 -> Connection write_buffer_
-            pump_write_bio();
-            return PROTOCOL_ERROR_EAGAIN;
-        } else {
-            // 真实错误
-            set_error(PROTOCOL_ERROR_TLS, "SSL_write failed");
-            return PROTOCOL_ERROR_TLS;
+    // 加密后的记录经BIO直接写入write_buffer_；写缓冲区已满时剩余明文暂存
+    int ret = write_records(data, len, out_len);
+    if (ret == PROTOCOL_ERROR_EAGAIN) {
+        ret = stash_pending(data + *out_len, len - *out_len);
+        if (ret == PROTOCOL_OK) {
+            *out_len = len;
         }
     }
+    return ret;
+#else
+    // 没有OpenSSL，直接返回成功（桩代码行为），记录长度仍按已发送量切换
+    (void)data;
+    account_record(len, details::NowMillis());
+    *out_len = len;
+    return PROTOCOL_OK;
+#endif
+}
 
-    *out_len = static_cast<size_t>(ret);
+int TlsHandler::writev(const IoSlice* slices, size_t count, size_t* out_len) {
+    // 检查初始化状态
+    if (!initialized_) {
+        set_error(PROTOCOL_ERROR_INVALID, "TlsHandler not initialized");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    if (out_len == nullptr || (slices == nullptr && count > 0)) {
+        set_error(PROTOCOL_ERROR_INVALID, "Invalid writev arguments");
+        return PROTOCOL_ERROR_INVALID;
+    }
 
-    // 步骤3: 将SSL write BIO中的数据 -> Connection write_buffer_
-    pump_write_bio();
+    *out_len = 0;
+
+    // 明文模式：各片段依次写入Connection write_buffer_
+    if (plaintext_) {
+        for (size_t i = 0; i < count; ++i) {
+            size_t written = 0;
+            int ret = write(slices[i].data, slices[i].len, &written);
+            *out_len += written;
+            if (ret != PROTOCOL_OK) {
+                return ret;
+            }
+        }
+        return PROTOCOL_OK;
+    }
+
+#if HAVE_OPENSSL
+    if (!ssl_ || (!handshake_done_ && !early_data_accepted_)) {
+        set_error(PROTOCOL_ERROR_INVALID, "SSL not initialized or handshake not done");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    // 各片段依次交给write按记录长度切分，明文只在加密时拷贝一次
+    for (size_t i = 0; i < count; ++i) {
+        size_t written = 0;
+        int ret = write(slices[i].data, slices[i].len, &written);
+        *out_len += written;
+        if (ret != PROTOCOL_OK) {
+            return ret;
+        }
+    }
 
     return PROTOCOL_OK;
 #else
     // 没有OpenSSL，直接返回成功（桩代码行为）
-    (void)data;
-    *out_len = len;
+    for (size_t i = 0; i < count; ++i) {
+        *out_len += slices[i].len;
+    }
+    account_record(*out_len, details::NowMillis());
     return PROTOCOL_OK;
 #endif
 }
 
+int TlsHandler::send_file(int file_fd, int64_t offset, size_t len, size_t* out_len) {
+    // 检查初始化状态
+    if (!initialized_) {
+        set_error(PROTOCOL_ERROR_INVALID, "TlsHandler not initialized");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    if (out_len == nullptr || file_fd < 0 || offset < 0) {
+        set_error(PROTOCOL_ERROR_INVALID, "Invalid send_file arguments");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    *out_len = 0;
+
+    // 暂存的明文（如未写完的响应头部）须先于文件内容写出
+    int ret = flush_pending();
+    if (ret != PROTOCOL_OK) {
+        return ret;
+    }
+
+#if TLS_HANDLER_HAS_KTLS
+    // kTLS发送：文件页直接由内核加密发出，不经过用户态
+    if (ktls_tx_) {
+        while (*out_len < len) {
+            ossl_ssize_t sent = SSL_sendfile(static_cast<SSL*>(ssl_), file_fd,
+                                             static_cast<off_t>(offset + *out_len),
+                                             len - *out_len, 0);
+            if (sent <= 0) {
+                int err = SSL_get_error(static_cast<SSL*>(ssl_), static_cast<int>(sent));
+                if (err == SSL_ERROR_WANT_WRITE) {
+                    return PROTOCOL_ERROR_EAGAIN;
+                }
+                set_error(PROTOCOL_ERROR_TLS, "SSL_sendfile failed");
+                return PROTOCOL_ERROR_TLS;
+            }
+            *out_len += static_cast<size_t>(sent);
+        }
+        return PROTOCOL_OK;
+    }
+#endif
+
+#ifndef _WIN32
+    // 回退路径：按TLS记录大小分块读取后加密发送
+    uint8_t chunk[TLS_MAX_RECORD_SIZE];
+    while (*out_len < len) {
+        size_t to_read = std::min(sizeof(chunk), len - *out_len);
+        ssize_t n = pread(file_fd, chunk, to_read, static_cast<off_t>(offset + *out_len));
+        if (n <= 0) {
+            set_error(PROTOCOL_ERROR_INVALID, "pread failed or file truncated");
+            return PROTOCOL_ERROR_INVALID;
+        }
+        size_t written = 0;
+        ret = write(chunk, static_cast<size_t>(n), &written);
+        *out_len += written;
+        if (ret != PROTOCOL_OK) {
+            return ret;
+        }
+        // 写缓冲区已满时停在此处等待可写，避免把整个文件读入暂存区
+        if (get_pending_bytes() > 0 && *out_len < len) {
+            return PROTOCOL_ERROR_EAGAIN;
+        }
+    }
+    return PROTOCOL_OK;
+#else
+    set_error(PROTOCOL_ERROR_INVALID, "send_file not supported on this platform");
+    return PROTOCOL_ERROR_INVALID;
+#endif
+}
+
+int TlsHandler::flush_pending() {
+    if (get_pending_bytes() == 0) {
+        return PROTOCOL_OK;
+    }
+
+#if HAVE_OPENSSL
+    if (!ssl_ || (!handshake_done_ && !early_data_accepted_)) {
+        set_error(PROTOCOL_ERROR_INVALID, "SSL not initialized or handshake not done");
+        return PROTOCOL_ERROR_INVALID;
+    }
+
+    size_t written = 0;
+    int ret = write_records(pending_write_->read_ptr(), pending_write_->readable_bytes(), &written);
+    pending_write_->skip(written);
+    return ret;
+#else
+    pending_write_->clear();
+    return PROTOCOL_OK;
+#endif
+}
+
+size_t TlsHandler::get_pending_bytes() const {
+    return pending_write_ ? pending_write_->readable_bytes() : 0;
+}
+
+size_t TlsHandler::get_record_size() const {
+    return record_size_at(details::NowMillis());
+}
+
+size_t TlsHandler::record_size_at(uint64_t now_ms) const {
+    if (record_ramp_bytes_ == 0) {
+        return TLS_MAX_RECORD_SIZE;
+    }
+    // 空闲后拥塞窗口可能已回落，重新从小记录开始
+    if (last_write_ms_ != 0 && record_idle_ms_ > 0 && now_ms - last_write_ms_ >= record_idle_ms_) {
+        return TLS_SMALL_RECORD_SIZE;
+    }
+    return record_bytes_sent_ < record_ramp_bytes_ ? TLS_SMALL_RECORD_SIZE : TLS_MAX_RECORD_SIZE;
+}
+
+void TlsHandler::account_record(size_t len, uint64_t now_ms) {
+    if (last_write_ms_ != 0 && record_idle_ms_ > 0 && now_ms - last_write_ms_ >= record_idle_ms_) {
+        record_bytes_sent_ = 0;
+    }
+    record_bytes_sent_ += len;
+    last_write_ms_ = now_ms;
+}
+
+uint32_t TlsHandler::get_handshake_round_trips() const {
+    return handshake_round_trips_;
+}
+
+void TlsHandler::account_handshake_flight(size_t bytes, bool flight_done) {
+    handshake_flight_bytes_ += bytes;
+    if (flight_done && handshake_flight_bytes_ > 0) {
+        // 超出初始拥塞窗口的部分要等ACK才能继续发送，每个窗口多一个往返
+        handshake_round_trips_ += static_cast<uint32_t>(
+            (handshake_flight_bytes_ + TLS_INITIAL_CWND_BYTES - 1) / TLS_INITIAL_CWND_BYTES);
+        handshake_flight_bytes_ = 0;
+    }
+}
+
+int TlsHandler::stash_pending(const uint8_t* data, size_t len) {
+    if (len == 0) {
+        return PROTOCOL_OK;
+    }
+    if (!pending_write_) {
+        pending_write_.reset(new utils::Buffer(utils::Buffer::MIN_CAPACITY));
+    }
+    if (pending_write_->write(data, len) != len) {
+        set_error(PROTOCOL_ERROR_BUFFER, "Pending write buffer full");
+        return PROTOCOL_ERROR_BUFFER;
+    }
+    return PROTOCOL_OK;
+}
+
+bool TlsHandler::is_ktls_tx_enabled() const {
+    return ktls_tx_;
+}
+
+bool TlsHandler::is_ktls_rx_enabled() const {
+    return ktls_rx_;
+}
+
+bool TlsHandler::is_socket_io() const {
+    return socket_io_;
+}
+
+bool TlsHandler::is_plaintext() const {
+    return plaintext_;
+}
+
+bool TlsHandler::is_ktls_available() {
+#if TLS_HANDLER_HAS_KTLS
+    // 已注册的TCP ULP列表中包含"tls"即表示内核模块已加载
+    static const bool available = []() {
+        details::UniqueFilePtr fp(fopen("/proc/sys/net/ipv4/tcp_available_ulp", "r"));
+        if (!fp) {
+            return false;
+        }
+        char line[256] = {0};
+        if (fgets(line, sizeof(line), fp.get()) == nullptr) {
+            return false;
+        }
+        for (char* token = strtok(line, " \t\n"); token != nullptr;
+             token = strtok(nullptr, " \t\n")) {
+            if (strcmp(token, "tls") == 0) {
+                return true;
+            }
+        }
+        return false;
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+void TlsHandler::update_ktls_state() {
+#if TLS_HANDLER_HAS_KTLS
+    if (socket_io_ && ssl_) {
+        ktls_tx_ = BIO_get_ktls_send(SSL_get_wbio(static_cast<SSL*>(ssl_))) > 0;
+        ktls_rx_ = BIO_get_ktls_recv(SSL_get_rbio(static_cast<SSL*>(ssl_))) > 0;
+    }
+#endif
+}
+
 int TlsHandler::continue_handshake() {
     // 检查初始化状态
     if (!initialized_) {
@@ -363,26 +681,38 @@ int TlsHandler::continue_handshake() {
         return PROTOCOL_ERROR_INVALID;
     }
 
+    if (plaintext_) {
+        return PROTOCOL_OK;
+    }
+
 #if HAVE_OPENSSL
     if (!ssl_) {
         set_error(PROTOCOL_ERROR_INVALID, "SSL not initialized");
         return PROTOCOL_ERROR_INVALID;
     }
 
-    // 步骤1: 从Connection read_buffer_读取密文 -> SSL read BIO
-    int ret = pump_read_bio();
-    if (ret < 0) {
-        return ret;
+    SSL* ssl = static_cast<SSL*>(ssl_);
+    uint64_t written = BIO_number_written(SSL_get_wbio(ssl));
+
+    // 0-RTT：处理ClientHello后先读出早期数据，读完（或被拒绝）再完成握手
+    if (early_data_reading_) {
+        int ret = read_early_data();
+        if (ret != PROTOCOL_OK) {
+            if (ret == PROTOCOL_ERROR_EAGAIN) {
+                account_handshake_flight(static_cast<size_t>(BIO_number_written(SSL_get_wbio(ssl)) - written), true);
+            }
+            return ret;
+        }
     }
 
-    // 步骤2: 执行握手
-    ret = SSL_do_handshake(static_cast<SSL*>(ssl_));
+    // 执行握手：ClientHello等直接从read_buffer_读取，回应直接写入write_buffer_
+    int ret = SSL_do_handshake(ssl);
     if (ret != 1) {
-        int err = SSL_get_error(static_cast<SSL*>(ssl_), ret);
+        int err = SSL_get_error(ssl, ret);
         if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
-            // 握手进行中，需要更多数据
-            // 步骤3: 将SSL write BIO中的数据 -> Connection write_buffer_
-            pump_write_bio();
+            // 握手进行中，需要更多数据；等待读说明这批数据已发完
+            account_handshake_flight(static_cast<size_t>(BIO_number_written(SSL_get_wbio(ssl)) - written),
+                                     err == SSL_ERROR_WANT_READ);
             return PROTOCOL_ERROR_EAGAIN;
         } else {
             // 真实错误
@@ -391,11 +721,26 @@ int TlsHandler::continue_handshake() {
         }
     }
 
-    // 握手成功
+    // 握手成功，首次完成时按是否复用会话计入命中/未命中，并记录握手开销。
+    // TLS 1.2由服务端Finished结束握手，客户端收到后才能发请求，这批数据计一个往返；
+    // TLS 1.3此时只剩会话票据，不影响客户端发送
+    if (!handshake_done_) {
+        account_handshake_flight(static_cast<size_t>(BIO_number_written(SSL_get_wbio(ssl)) - written),
+                                 SSL_version(ssl) < TLS1_3_VERSION);
+        utils::StatisticsManager::instance().record_tls_handshake(SSL_session_reused(ssl) == 1);
+        utils::StatisticsManager::instance().record_tls_handshake_traffic(
+            BIO_number_written(SSL_get_wbio(ssl)), BIO_number_read(SSL_get_rbio(ssl)), handshake_round_trips_);
+    }
     handshake_done_ = true;
+    update_ktls_state();
 
-    // 步骤3: 将SSL write BIO中的数据 -> Connection write_buffer_
-    pump_write_bio();
+    // 0-RTT阶段未能写出的响应在握手完成后写出
+    if (early_data_accepted_) {
+        ret = flush_pending();
+        if (ret < 0 && ret != PROTOCOL_ERROR_EAGAIN) {
+            return ret;
+        }
+    }
 #else
     // 没有OpenSSL，直接设置握手完成（桩代码行为）
     handshake_done_ = true;
@@ -408,7 +753,39 @@ bool TlsHandler::is_handshake_done() const {
     return handshake_done_;
 }
 
+bool TlsHandler::is_early_data() const {
+    return early_data_accepted_ && !handshake_done_;
+}
+
+bool TlsHandler::has_early_data() const {
+    return early_data_ && early_data_->readable_bytes() > 0;
+}
+
+bool TlsHandler::is_early_data_method(const std::string& method) const {
+    // 逗号分隔的方法列表，忽略两侧空白
+    size_t pos = 0;
+    while (pos <= early_data_methods_.size()) {
+        size_t comma = early_data_methods_.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = early_data_methods_.size();
+        }
+        std::string token = early_data_methods_.substr(pos, comma - pos);
+        size_t start = token.find_first_not_of(" \t");
+        size_t end = token.find_last_not_of(" \t");
+        if (start != std::string::npos && token.compare(start, end - start + 1, method) == 0) {
+            return true;
+        }
+        pos = comma + 1;
+    }
+    return false;
+}
+
 std::string TlsHandler::get_selected_alpn() const {
+    // 明文连接没有ALPN协商
+    if (plaintext_) {
+        return "";
+    }
+
 #if HAVE_OPENSSL
     if (!ssl_) {
         return "";
@@ -448,24 +825,19 @@ int TlsHandler::shutdown() {
             break;
         }
         if (ret == 0) {
-            // 需要继续处理：发送数据并再次尝试
-            pump_write_bio();
+            // close_notify已写入write_buffer_，再次尝试等待对端回应
             retry_count++;
             continue;
         }
         // ret < 0: 检查错误类型
         int err = SSL_get_error(static_cast<SSL*>(ssl_), ret);
         if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
-            pump_write_bio();
             retry_count++;
             continue;
         }
         // 其他错误：记录但继续，因为我们正在关闭
         break;
     }
-
-    // 最后确保发送所有待处理数据
-    pump_write_bio();
 #endif
 
     return PROTOCOL_OK;
@@ -475,18 +847,27 @@ int TlsHandler::close() {
 #if HAVE_OPENSSL
     if (ssl_) {
         SSL_free(static_cast<SSL*>(ssl_));
-        ssl_ = nullptr;
+        ssl_ = nullptr;  // BIO由SSL_free释放
     }
-    if (ssl_ctx_) {
-        SSL_CTX_free(static_cast<SSL_CTX*>(ssl_ctx_));
-        ssl_ctx_ = nullptr;
-    }
-    ssl_read_bio_ = nullptr;  // BIO由SSL_free释放
-    ssl_write_bio_ = nullptr;
 #endif
+    // 共享上下文由最后一个引用者释放
+    context_.reset();
+
+    pending_write_.reset();
+    early_data_.reset();
+    early_data_reading_ = false;
+    early_data_accepted_ = false;
+    retry_len_ = 0;
+    record_bytes_sent_ = 0;
+    last_write_ms_ = 0;
+    handshake_flight_bytes_ = 0;
+    handshake_round_trips_ = 0;
 
     initialized_ = false;
     handshake_done_ = false;
+    socket_io_ = false;
+    ktls_tx_ = false;
+    ktls_rx_ = false;
     error_code_ = 0;
     error_msg_.clear();
     return PROTOCOL_OK;
@@ -506,7 +887,7 @@ const std::string& TlsHandler::get_error_msg() const {
 }
 
 void TlsHandler::reset() {
-    handshake_done_ = false;
+    handshake_done_ = plaintext_;
     error_code_ = 0;
     error_msg_.clear();
 }
@@ -523,471 +904,141 @@ void TlsHandler::set_write_buffer(utils::Buffer* buffer) {
 
 #if HAVE_OPENSSL
 
-int TlsHandler::init_ssl_context(const CertConfig& config) {
-    (void)config;
-
-    // 使用TLS_server_method()创建SSL上下文
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-    ssl_ctx_ = SSL_CTX_new(TLS_server_method());
-#else
-    ssl_ctx_ = SSL_CTX_new(SSLv23_server_method());
-    SSL_CTX_set_options(static_cast<SSL_CTX*>(ssl_ctx_), SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3);
-#endif
+int TlsHandler::setup_bio() {
+    if (!ssl_) {
+        set_error(PROTOCOL_ERROR_INVALID, "SSL not initialized");
+        return PROTOCOL_ERROR_INVALID;
+    }
 
-    if (!ssl_ctx_) {
-        set_error(PROTOCOL_ERROR_TLS, "SSL_CTX_new failed");
+    BIO_METHOD* method = details::ConnectionBio::method();
+    BIO* bio = method ? BIO_new(method) : nullptr;
+    if (!bio) {
+        set_error(PROTOCOL_ERROR_TLS, "BIO_new failed");
         return PROTOCOL_ERROR_TLS;
     }
+    BIO_set_data(bio, this);
 
-    // 设置推荐的SSL选项
-    SSL_CTX_set_options(static_cast<SSL_CTX*>(ssl_ctx_), SSL_OP_ALL | SSL_OP_NO_COMPRESSION);
+    // 读写共用同一个BIO，所有权交给SSL
+    SSL_set_bio(static_cast<SSL*>(ssl_), bio, bio);
 
     return PROTOCOL_OK;
 }
 
-int TlsHandler::load_certificates(const CertConfig& config) {
-    // 注意：cert_path_、key_path_、ca_path_已在init()中设置，避免重复赋值
-
-    // 国密模式下，优先检查SM2证书
-    if (use_gmssl_) {
-        // 国密模式下，至少需要有一个SM2证书配置
-        // 优先使用签名证书识别证书类型
-        std::string cert_to_check;
-        if (!sm2_sign_cert_path_.empty()) {
-            cert_to_check = sm2_sign_cert_path_;
-        } else if (!sm2_cert_path_.empty()) {
-            cert_to_check = sm2_cert_path_;
-        } else if (!cert_path_.empty()) {
-            cert_to_check = cert_path_;
-        }
-
-        if (!cert_to_check.empty()) {
-            // 尝试读取证书以识别类型
-            details::UniqueFilePtr fp(fopen(cert_to_check.c_str(), "r"));
-            if (fp) {
-                details::UniqueX509Ptr x509(PEM_read_X509(fp.get(), nullptr, nullptr, nullptr));
-                if (x509) {
-                    details::UniqueEvpPkeyPtr pkey(X509_get_pubkey(x509.get()));
-                    if (pkey) {
-                        int key_type = EVP_PKEY_id(pkey.get());
-#ifdef EVP_PKEY_SM2
-                        if (key_type == EVP_PKEY_SM2) {
-                            cert_type_ = CertType::SM2;
-                        } else
-#endif
-                        if (key_type == EVP_PKEY_EC) {
-                            cert_type_ = CertType::ECDSA;
-                        } else {
-                            cert_type_ = CertType::RSA;
-                        }
-                    } else {
-                        // 无法识别公钥类型，默认按国密处理
-                        cert_type_ = CertType::SM2;
-                    }
-                } else {
-                    // 无法读取证书，默认按国密处理
-                    cert_type_ = CertType::SM2;
-                }
-            } else {
-                // 文件无法打开，默认按国密处理
-                cert_type_ = CertType::SM2;
+int TlsHandler::write_records(const uint8_t* data, size_t len, size_t* out_len) {
+    *out_len = 0;
+    SSL* ssl = static_cast<SSL*>(ssl_);
+    uint64_t now_ms = details::NowMillis();
+
+    // 部分写模式下每次SSL_write只生成一条记录；WANT_WRITE后重试长度不得小于上次
+    while (*out_len < len) {
+        size_t chunk = std::min(len - *out_len, std::max(record_size_at(now_ms), retry_len_));
+        int ret = 0;
+        if (early_data_reading_) {
+            // 仍在读取早期数据时以0.5-RTT数据发出，无需等待客户端Finished
+            size_t written = 0;
+            if (SSL_write_early_data(ssl, data + *out_len, chunk, &written) == 1) {
+                ret = static_cast<int>(written);
             }
         } else {
-            // 没有证书路径，默认按国密处理
-            cert_type_ = CertType::SM2;
+            ret = SSL_write(ssl, data + *out_len, static_cast<int>(chunk));
         }
-        return PROTOCOL_OK;
-    }
-
-    // 非国密模式下，使用普通证书
-    if (cert_path_.empty() || key_path_.empty()) {
-        cert_type_ = CertType::RSA;
-        return PROTOCOL_OK;
-    }
-
-    // 尝试读取证书以识别类型（使用RAII管理所有资源）
-    details::UniqueFilePtr fp(fopen(cert_path_.c_str(), "r"));
-    if (fp) {
-        details::UniqueX509Ptr x509(PEM_read_X509(fp.get(), nullptr, nullptr, nullptr));
-        if (x509) {
-            details::UniqueEvpPkeyPtr pkey(X509_get_pubkey(x509.get()));
-            if (pkey) {
-                int key_type = EVP_PKEY_id(pkey.get());
-#ifdef EVP_PKEY_SM2
-                if (key_type == EVP_PKEY_SM2) {
-                    cert_type_ = CertType::SM2;
-                } else
-#endif
-                if (key_type == EVP_PKEY_EC) {
-                    cert_type_ = CertType::ECDSA;
-                } else {
-                    cert_type_ = CertType::RSA;
-                }
+        if (ret <= 0) {
+            int err = SSL_get_error(ssl, ret);
+            if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+                // 等待写缓冲区腾出空间
+                retry_len_ = chunk;
+                return PROTOCOL_ERROR_EAGAIN;
             }
+            set_error(PROTOCOL_ERROR_TLS, "SSL_write failed");
+            return PROTOCOL_ERROR_TLS;
         }
+        retry_len_ = 0;
+        *out_len += static_cast<size_t>(ret);
+        account_record(static_cast<size_t>(ret), now_ms);
     }
-
     return PROTOCOL_OK;
 }
 
-int TlsHandler::load_ca_certificate(const std::string& ca_path) {
-    ca_path_ = ca_path;
-
-    if (ca_path_.empty()) {
-        return PROTOCOL_OK;
-    }
-
-    if (!ssl_ctx_) {
-        set_error(PROTOCOL_ERROR_INVALID, "SSL_CTX not initialized");
-        return PROTOCOL_ERROR_INVALID;
-    }
-
-    if (SSL_CTX_load_verify_locations(static_cast<SSL_CTX*>(ssl_ctx_), ca_path_.c_str(), nullptr) != 1) {
-        set_error(PROTOCOL_ERROR_TLS, "Failed to load CA certificate");
-        return PROTOCOL_ERROR_TLS;
-    }
-
-    return PROTOCOL_OK;
-}
-
-int TlsHandler::configure_certificates(const CertConfig& config) {
-    (void)config;
-
-    if (!ssl_ctx_) {
-        set_error(PROTOCOL_ERROR_INVALID, "SSL_CTX not initialized");
-        return PROTOCOL_ERROR_INVALID;
+int TlsHandler::read_early_data() {
+    SSL* ssl = static_cast<SSL*>(ssl_);
+    if (!early_data_) {
+        early_data_.reset(new utils::Buffer(utils::Buffer::MIN_CAPACITY));
     }
 
-    // 国密模式下，配置国密双证书
-    if (use_gmssl_) {
-        // 国密模式优先加载签名证书（用于签名）
-        bool has_sign_cert = !sm2_sign_cert_path_.empty() && !sm2_sign_key_path_.empty();
-        bool has_enc_cert = !sm2_cert_path_.empty() && !sm2_key_path_.empty();
-
-        // 优先使用签名证书作为主证书
-        if (has_sign_cert) {
-            // 加载签名证书链
-            if (SSL_CTX_use_certificate_chain_file(static_cast<SSL_CTX*>(ssl_ctx_), sm2_sign_cert_path_.c_str()) != 1) {
-                set_error(PROTOCOL_ERROR_TLS, "Failed to load SM2 sign certificate chain");
-                return PROTOCOL_ERROR_TLS;
-            }
-
-            // 加载签名私钥
-            if (SSL_CTX_use_PrivateKey_file(static_cast<SSL_CTX*>(ssl_ctx_), sm2_sign_key_path_.c_str(), SSL_FILETYPE_PEM) != 1) {
-                set_error(PROTOCOL_ERROR_TLS, "Failed to load SM2 sign private key");
-                return PROTOCOL_ERROR_TLS;
-            }
-
-            // 验证签名私钥
-            if (SSL_CTX_check_private_key(static_cast<SSL_CTX*>(ssl_ctx_)) != 1) {
-                set_error(PROTOCOL_ERROR_TLS, "SM2 sign private key does not match certificate");
-                return PROTOCOL_ERROR_TLS;
-            }
-        } else if (has_enc_cert) {
-            // 只有加密证书时，使用加密证书作为主证书
-            if (SSL_CTX_use_certificate_chain_file(static_cast<SSL_CTX*>(ssl_ctx_), sm2_cert_path_.c_str()) != 1) {
-                set_error(PROTOCOL_ERROR_TLS, "Failed to load SM2 enc certificate chain");
-                return PROTOCOL_ERROR_TLS;
-            }
-
-            if (SSL_CTX_use_PrivateKey_file(static_cast<SSL_CTX*>(ssl_ctx_), sm2_key_path_.c_str(), SSL_FILETYPE_PEM) != 1) {
-                set_error(PROTOCOL_ERROR_TLS, "Failed to load SM2 enc private key");
-                return PROTOCOL_ERROR_TLS;
-            }
-
-            if (SSL_CTX_check_private_key(static_cast<SSL_CTX*>(ssl_ctx_)) != 1) {
-                set_error(PROTOCOL_ERROR_TLS, "SM2 enc private key does not match certificate");
-                return PROTOCOL_ERROR_TLS;
-            }
-        } else if (!cert_path_.empty() && !key_path_.empty()) {
-            // 如果没有配置SM2证书但启用了国密，尝试使用普通证书
-            if (SSL_CTX_use_certificate_chain_file(static_cast<SSL_CTX*>(ssl_ctx_), cert_path_.c_str()) != 1) {
-                set_error(PROTOCOL_ERROR_TLS, "Failed to load certificate chain");
-                return PROTOCOL_ERROR_TLS;
-            }
-
-            if (SSL_CTX_use_PrivateKey_file(static_cast<SSL_CTX*>(ssl_ctx_), key_path_.c_str(), SSL_FILETYPE_PEM) != 1) {
-                set_error(PROTOCOL_ERROR_TLS, "Failed to load private key");
-                return PROTOCOL_ERROR_TLS;
-            }
-
-            if (SSL_CTX_check_private_key(static_cast<SSL_CTX*>(ssl_ctx_)) != 1) {
-                set_error(PROTOCOL_ERROR_TLS, "Private key does not match certificate");
-                return PROTOCOL_ERROR_TLS;
-            }
+    while (true) {
+        uint8_t* space = early_data_->reserve(TLS_MAX_RECORD_SIZE);
+        if (!space) {
+            set_error(PROTOCOL_ERROR_BUFFER, "Early data buffer full");
+            return PROTOCOL_ERROR_BUFFER;
         }
-        // 国密模式下，即使没有证书也不报错（测试场景）
-        return PROTOCOL_OK;
-    }
-
-    // 非国密模式下，配置普通证书
-    if (cert_path_.empty() || key_path_.empty()) {
-        return PROTOCOL_OK;
-    }
-
-    // 加载证书链
-    if (SSL_CTX_use_certificate_chain_file(static_cast<SSL_CTX*>(ssl_ctx_), cert_path_.c_str()) != 1) {
-        set_error(PROTOCOL_ERROR_TLS, "Failed to load certificate chain");
-        return PROTOCOL_ERROR_TLS;
-    }
-
-    // 加载私钥
-    if (SSL_CTX_use_PrivateKey_file(static_cast<SSL_CTX*>(ssl_ctx_), key_path_.c_str(), SSL_FILETYPE_PEM) != 1) {
-        set_error(PROTOCOL_ERROR_TLS, "Failed to load private key");
-        return PROTOCOL_ERROR_TLS;
-    }
-
-    // 验证私钥
-    if (SSL_CTX_check_private_key(static_cast<SSL_CTX*>(ssl_ctx_)) != 1) {
-        set_error(PROTOCOL_ERROR_TLS, "Private key does not match certificate");
-        return PROTOCOL_ERROR_TLS;
-    }
-
-    return PROTOCOL_OK;
-}
-
-int TlsHandler::configure_cipher_suites(const TlsConfig& config) {
-    if (!ssl_ctx_) {
-        set_error(PROTOCOL_ERROR_INVALID, "SSL_CTX not initialized");
-        return PROTOCOL_ERROR_INVALID;
-    }
-
-    // 检查是否使用国密（优先使用配置标志，其次根据证书类型判断）
-    if (use_gmssl_ || cert_type_ == CertType::SM2) {
-        // 配置国密SM2/SM3/SM4套件
-        // 国密密码套件优先级按推荐顺序配置
-        const char* gm_ciphers = "SM2-WITH-SMS4-SM3:"
-                                 "ECDHE-SM2-WITH-SMS4-SM3:"
-                                 "SM2-WITH-SMS4-GCM-SM3:"
-                                 "ECDHE-SM2-WITH-SMS4-GCM-SM3";
-
-        // 尝试设置国密密码套件（可能不被所有OpenSSL版本支持）
-        if (SSL_CTX_set_cipher_list(static_cast<SSL_CTX*>(ssl_ctx_), gm_ciphers) != 1) {
-            // 如果失败，尝试单个套件
-            const char* single_gm_cipher = "SM2-WITH-SMS4-SM3";
-            if (SSL_CTX_set_cipher_list(static_cast<SSL_CTX*>(ssl_ctx_), single_gm_cipher) != 1) {
-                // 国密套件设置失败时，记录警告但继续（使用默认套件）
-                // 注意：这里不返回错误，因为可能是测试场景或OpenSSL不支持国密
+        size_t read_len = 0;
+        int ret = SSL_read_early_data(ssl, space, TLS_MAX_RECORD_SIZE, &read_len);
+        if (ret == SSL_READ_EARLY_DATA_ERROR) {
+            int err = SSL_get_error(ssl, 0);
+            if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+                early_data_accepted_ = SSL_get_early_data_status(ssl) == SSL_EARLY_DATA_ACCEPTED;
+                return PROTOCOL_ERROR_EAGAIN;
             }
-        }
-
-        // 国密主要使用TLS 1.2，禁用TLS 1.3（如果支持）
-#ifdef SSL_OP_NO_TLSv1_3
-        SSL_CTX_set_options(static_cast<SSL_CTX*>(ssl_ctx_), SSL_OP_NO_TLSv1_3);
-#endif
-    } else if (!config.cipher_suites.empty()) {
-        // 使用用户指定的加密套件
-        if (SSL_CTX_set_cipher_list(static_cast<SSL_CTX*>(ssl_ctx_), config.cipher_suites.c_str()) != 1) {
-            set_error(PROTOCOL_ERROR_TLS, "Failed to set cipher list");
+            set_error(PROTOCOL_ERROR_TLS, "SSL_read_early_data failed");
             return PROTOCOL_ERROR_TLS;
         }
-    } else {
-        // 使用默认加密套件
-        const char* default_ciphers =
-            "ECDHE-ECDSA-AES128-GCM-SHA256:"
-            "ECDHE-RSA-AES128-GCM-SHA256:"
-            "ECDHE-ECDSA-AES256-GCM-SHA384:"
-            "ECDHE-RSA-AES256-GCM-SHA384";
-        if (SSL_CTX_set_cipher_list(static_cast<SSL_CTX*>(ssl_ctx_), default_ciphers) != 1) {
-            set_error(PROTOCOL_ERROR_TLS, "Failed to set default cipher list");
-            return PROTOCOL_ERROR_TLS;
-        }
-    }
-
-    // 配置TLS版本（非国密模式）
-    if (!use_gmssl_ && cert_type_ != CertType::SM2) {
-#ifdef SSL_OP_NO_TLSv1_2
-        if (!config.enable_tls_1_2) {
-            SSL_CTX_set_options(static_cast<SSL_CTX*>(ssl_ctx_), SSL_OP_NO_TLSv1_2);
+        early_data_->commit(read_len);
+        early_data_accepted_ = SSL_get_early_data_status(ssl) == SSL_EARLY_DATA_ACCEPTED;
+        if (ret == SSL_READ_EARLY_DATA_FINISH) {
+            // 早期数据结束（或被拒绝），之后按普通握手继续
+            early_data_reading_ = false;
+            return PROTOCOL_OK;
         }
-#endif
-#ifdef SSL_OP_NO_TLSv1_3
-        if (!config.enable_tls_1_3) {
-            SSL_CTX_set_options(static_cast<SSL_CTX*>(ssl_ctx_), SSL_OP_NO_TLSv1_3);
-        }
-#endif
     }
-
-    return PROTOCOL_OK;
-}
-
-int TlsHandler::configure_alpn() {
-    if (!ssl_ctx_) {
-        set_error(PROTOCOL_ERROR_INVALID, "SSL_CTX not initialized");
-        return PROTOCOL_ERROR_INVALID;
-    }
-
-    // 设置ALPN选择回调
-    SSL_CTX_set_alpn_select_cb(static_cast<SSL_CTX*>(ssl_ctx_), AlpnSelectCallback, this);
-
-    // 注意：在服务器端，我们不需要调用 SSL_CTX_set_alpn_protos
-    // 服务器端是通过回调函数 AlpnSelectCallback 来选择协议的
-    // 我们的回调函数已经支持从 alpn_protocols_ 中选择合适的协议
-
-    return PROTOCOL_OK;
 }
 
-int TlsHandler::setup_bio() {
-    if (!ssl_) {
-        set_error(PROTOCOL_ERROR_INVALID, "SSL not initialized");
+int TlsHandler::setup_ktls() {
+#if TLS_HANDLER_HAS_KTLS
+    if (!ssl_ || !conn_ || !conn_->is_fd_valid() || !is_ktls_available()) {
         return PROTOCOL_ERROR_INVALID;
     }
 
-    // 创建内存BIO对
-    BIO* bio1 = nullptr;
-    BIO* bio2 = nullptr;
-
-    if (BIO_new_bio_pair(&bio1, &bio2, 0) != 1) {
-        set_error(PROTOCOL_ERROR_TLS, "BIO_new_bio_pair failed");
+    // 密钥就绪后OpenSSL自动向socket设置TLS_TX/TLS_RX；内核拒绝时仍以普通socket BIO工作
+    SSL* ssl = static_cast<SSL*>(ssl_);
+    SSL_set_options(ssl, SSL_OP_ENABLE_KTLS);
+    if (SSL_set_fd(ssl, conn_->get_fd()) != 1) {
+        SSL_clear_options(ssl, SSL_OP_ENABLE_KTLS);
         return PROTOCOL_ERROR_TLS;
     }
 
-    ssl_read_bio_ = bio1;
-    ssl_write_bio_ = bio2;
-
-    // 设置BIO到SSL
-    SSL_set_bio(static_cast<SSL*>(ssl_), static_cast<BIO*>(ssl_read_bio_), static_cast<BIO*>(ssl_write_bio_));
-
+    socket_io_ = true;
     return PROTOCOL_OK;
-}
-
-int TlsHandler::pump_read_bio() {
-    // 从Connection read_buffer_读取数据，写入SSL read BIO
-    // 处理部分写入的情况
-    if (!read_buffer_ || !ssl_read_bio_) {
-        return PROTOCOL_ERROR_INVALID;
-    }
-
-    size_t readable = read_buffer_->readable_bytes();
-    if (readable == 0) {
-        return 0;  // 没有数据需要读取
-    }
-
-    const uint8_t* data = read_buffer_->read_ptr();
-    size_t total_written = 0;
-
-    while (total_written < readable) {
-        // 尝试写入剩余数据
-        int written = BIO_write(static_cast<BIO*>(ssl_read_bio_),
-                               data + total_written,
-                               static_cast<int>(readable - total_written));
-        if (written <= 0) {
-            // BIO_WRITE返回0或负数表示错误或重试
-            if (!BIO_should_retry(static_cast<BIO*>(ssl_read_bio_))) {
-                // 真实错误
-                set_error(PROTOCOL_ERROR_TLS, "BIO_write failed");
-                return PROTOCOL_ERROR_TLS;
-            }
-            // 应该重试，退出循环，等待下次调用
-            break;
-        }
-        total_written += static_cast<size_t>(written);
-    }
-
-    if (total_written > 0) {
-        // 消耗已写入BIO的数据
-        read_buffer_->skip(total_written);
-    }
-
-    return static_cast<int>(total_written);
-}
-
-int TlsHandler::pump_write_bio() {
-    // 从SSL write BIO读取数据，写入Connection write_buffer_
-    // 使用BIO_ctrl_pending检查待读取数据量
-    if (!write_buffer_ || !ssl_write_bio_) {
-        return PROTOCOL_ERROR_INVALID;
-    }
-
-    size_t total_read = 0;
-    uint8_t buf[TEMP_BUFFER_SIZE];  // 临时缓冲区
-
-    while (true) {
-        // 检查SSL write BIO中有多少待读取的数据
-        size_t pending = BIO_ctrl_pending(static_cast<BIO*>(ssl_write_bio_));
-        if (pending == 0) {
-            break;  // 没有更多数据
-        }
-
-        // 读取数据（每次最多读取sizeof(buf)）
-        int to_read = (sizeof(buf) < pending) ? static_cast<int>(sizeof(buf)) : static_cast<int>(pending);
-        int read = BIO_read(static_cast<BIO*>(ssl_write_bio_), buf, to_read);
-        if (read <= 0) {
-            // BIO_read返回0或负数表示错误或重试
-            if (!BIO_should_retry(static_cast<BIO*>(ssl_write_bio_))) {
-                // 真实错误
-                set_error(PROTOCOL_ERROR_TLS, "BIO_read failed");
-                return PROTOCOL_ERROR_TLS;
-            }
-            // 需要重试，退出循环
-            break;
-        }
-
-        // 将读取的数据写入Connection的write_buffer_
-        if (write_buffer_->write(buf, static_cast<size_t>(read)) != static_cast<size_t>(read)) {
-            set_error(PROTOCOL_ERROR_BUFFER, "Write buffer full");
-            return PROTOCOL_ERROR_BUFFER;
-        }
-
-        total_read += static_cast<size_t>(read);
-    }
-
-    return static_cast<int>(total_read);
+#else
+    return PROTOCOL_ERROR_INVALID;
+#endif
 }
 
 #else // !HAVE_OPENSSL
 
 // 没有OpenSSL时的空实现
-int TlsHandler::init_ssl_context(const CertConfig& config) {
-    (void)config;
-    return PROTOCOL_OK;
-}
-
-int TlsHandler::load_certificates(const CertConfig& config) {
-    (void)config;
-    cert_type_ = CertType::RSA;
-    return PROTOCOL_OK;
-}
-
-int TlsHandler::load_ca_certificate(const std::string& ca_path) {
-    (void)ca_path;
-    return PROTOCOL_OK;
-}
-
-int TlsHandler::configure_certificates(const CertConfig& config) {
-    (void)config;
-    return PROTOCOL_OK;
-}
-
-int TlsHandler::configure_cipher_suites(const TlsConfig& config) {
-    (void)config;
+int TlsHandler::setup_bio() {
     return PROTOCOL_OK;
 }
 
-int TlsHandler::configure_alpn() {
+int TlsHandler::write_records(const uint8_t* data, size_t len, size_t* out_len) {
+    (void)data;
+    *out_len = len;
     return PROTOCOL_OK;
 }
 
-int TlsHandler::setup_bio() {
+int TlsHandler::read_early_data() {
+    early_data_reading_ = false;
     return PROTOCOL_OK;
 }
 
-int TlsHandler::pump_read_bio() {
-    return 0;
-}
-
-int TlsHandler::pump_write_bio() {
-    return 0;
+int TlsHandler::setup_ktls() {
+    return PROTOCOL_ERROR_INVALID;
 }
 
 #endif // HAVE_OPENSSL
 
 bool TlsHandler::is_sm2_cert() const {
-    return cert_type_ == CertType::SM2;
-}
-
-const std::string& TlsHandler::get_alpn_protocols() const {
-    return alpn_protocols_;
+    return context_ && context_->get_cert_type() == CertType::SM2;
 }
 
 } // namespace protocol
@@ -0,0 +1,253 @@
+// =============================================================================
+//  HTTPS Server Simulator - Protocol Module
+//  文件: tls_session_cache.cpp
+//  描述: TlsSessionCache/TlsTicketKeys/TlsAntiReplay类实现
+//  版权: Copyright (c) 2026
+// =============================================================================
+#include "protocol/tls_session_cache.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#if HAVE_OPENSSL
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#else
+#include <random>
+#endif
+
+namespace https_server_sim {
+namespace protocol {
+
+namespace details {
+
+// 生成密钥材料：有OpenSSL时使用其CSPRNG
+static bool FillRandom(uint8_t* out, size_t len) {
+#if HAVE_OPENSSL
+    return RAND_bytes(out, static_cast<int>(len)) == 1;
+#else
+    static std::random_device device;
+    for (size_t i = 0; i < len; ++i) {
+        out[i] = static_cast<uint8_t>(device());
+    }
+    return true;
+#endif
+}
+
+// 清零密钥材料
+static void Cleanse(void* ptr, size_t len) {
+#if HAVE_OPENSSL
+    OPENSSL_cleanse(ptr, len);
+#else
+    volatile uint8_t* p = static_cast<volatile uint8_t*>(ptr);
+    while (len-- > 0) {
+        *p++ = 0;
+    }
+#endif
+}
+
+} // namespace details
+
+// ==================== TlsSessionCache实现 ====================
+
+TlsSessionCache::TlsSessionCache(size_t capacity, uint32_t timeout_sec)
+    : shards_()
+    , shard_capacity_((capacity + TLS_SESSION_CACHE_SHARDS - 1) / TLS_SESSION_CACHE_SHARDS)
+    , timeout_sec_(timeout_sec)
+{
+}
+
+TlsSessionCache::~TlsSessionCache() = default;
+
+TlsSessionCache::Shard& TlsSessionCache::shard_for(const std::string& key) {
+    return shards_[std::hash<std::string>()(key) % TLS_SESSION_CACHE_SHARDS];
+}
+
+void TlsSessionCache::put(const uint8_t* id, size_t id_len, std::vector<uint8_t> session, uint64_t now) {
+    if (shard_capacity_ == 0 || id == nullptr || id_len == 0) {
+        return;
+    }
+
+    std::string key(reinterpret_cast<const char*>(id), id_len);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end()) {
+        it->second.session = std::move(session);
+        it->second.expires_at = now + timeout_sec_;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+        return;
+    }
+
+    // 分片已满时淘汰最久未用的会话
+    if (shard.entries.size() >= shard_capacity_) {
+        shard.entries.erase(shard.lru.back());
+        shard.lru.pop_back();
+    }
+    shard.lru.push_front(key);
+    shard.entries.emplace(std::move(key), Entry{std::move(session), now + timeout_sec_, shard.lru.begin()});
+}
+
+bool TlsSessionCache::get(const uint8_t* id, size_t id_len, uint64_t now, std::vector<uint8_t>* session) {
+    if (shard_capacity_ == 0 || id == nullptr || id_len == 0 || session == nullptr) {
+        return false;
+    }
+
+    std::string key(reinterpret_cast<const char*>(id), id_len);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    if (it->second.expires_at <= now) {
+        shard.lru.erase(it->second.lru);
+        shard.entries.erase(it);
+        return false;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+    *session = it->second.session;
+    return true;
+}
+
+void TlsSessionCache::remove(const uint8_t* id, size_t id_len) {
+    if (id == nullptr || id_len == 0) {
+        return;
+    }
+
+    std::string key(reinterpret_cast<const char*>(id), id_len);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end()) {
+        shard.lru.erase(it->second.lru);
+        shard.entries.erase(it);
+    }
+}
+
+size_t TlsSessionCache::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.entries.size();
+    }
+    return total;
+}
+
+// ==================== TlsTicketKeys实现 ====================
+
+TlsTicketKeys::TlsTicketKeys(uint32_t rotation_sec)
+    : mutex_()
+    , keys_()
+    , rotation_sec_(rotation_sec)
+{
+}
+
+TlsTicketKeys::~TlsTicketKeys() {
+    if (!keys_.empty()) {
+        details::Cleanse(keys_.data(), keys_.size() * sizeof(TlsTicketKey));
+    }
+}
+
+bool TlsTicketKeys::encrypt_key(uint64_t now, TlsTicketKey* key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (keys_.empty() || now >= keys_.front().created_at + rotation_sec_) {
+        if (!rotate(now)) {
+            return false;
+        }
+    }
+    *key = keys_.front();
+    return true;
+}
+
+bool TlsTicketKeys::decrypt_key(const uint8_t* name, TlsTicketKey* key, bool* current) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        if (std::memcmp(keys_[i].name, name, TLS_TICKET_KEY_NAME_SIZE) == 0) {
+            *key = keys_[i];
+            *current = (i == 0);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t TlsTicketKeys::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return keys_.size();
+}
+
+bool TlsTicketKeys::rotate(uint64_t now) {
+    TlsTicketKey key;
+    if (!details::FillRandom(key.name, sizeof(key.name)) ||
+        !details::FillRandom(key.aes_key, sizeof(key.aes_key)) ||
+        !details::FillRandom(key.hmac_key, sizeof(key.hmac_key))) {
+        return false;
+    }
+    key.created_at = now;
+    keys_.insert(keys_.begin(), key);
+    details::Cleanse(&key, sizeof(key));
+
+    // 超出保留代数的旧密钥清零后丢弃
+    while (keys_.size() > TLS_TICKET_RETIRED_KEYS + 1) {
+        details::Cleanse(&keys_.back(), sizeof(TlsTicketKey));
+        keys_.pop_back();
+    }
+    return true;
+}
+
+// ==================== TlsAntiReplay实现 ====================
+
+TlsAntiReplay::TlsAntiReplay(uint32_t window_sec, size_t max_entries)
+    : mutex_()
+    , current_()
+    , previous_()
+    , bucket_start_(0)
+    , window_sec_(window_sec)
+    , max_entries_(max_entries)
+{
+}
+
+TlsAntiReplay::~TlsAntiReplay() = default;
+
+bool TlsAntiReplay::check(const uint8_t* key, size_t len, uint64_t now) {
+    if (key == nullptr || len == 0) {
+        return false;
+    }
+
+    std::string entry(reinterpret_cast<const char*>(key), len);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 当前桶到期后降为上一桶；超过两个窗口未轮换时两桶都已过期
+    if (now >= bucket_start_ + window_sec_) {
+        if (now >= bucket_start_ + 2 * static_cast<uint64_t>(window_sec_)) {
+            previous_.clear();
+        } else {
+            previous_.swap(current_);
+        }
+        current_.clear();
+        bucket_start_ = now;
+    }
+
+    if (current_.count(entry) != 0 || previous_.count(entry) != 0) {
+        return false;
+    }
+    if (current_.size() + previous_.size() >= max_entries_) {
+        return false;
+    }
+    current_.insert(std::move(entry));
+    return true;
+}
+
+size_t TlsAntiReplay::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_.size() + previous_.size();
+}
+
+} // namespace protocol
+} // namespace https_server_sim
+
+// 文件结束
@@ -7,11 +7,29 @@
 #include "protocol/protocol.hpp"
 #include "protocol/config_converter.hpp"
 #include "protocol/protocol_handler_factory.hpp"
+#include "connection/connection.hpp"
+#include "msg_center/worker_pool.hpp"
 #include "utils/buffer.hpp"
+#include "utils/time.hpp"
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <functional>
+#include <thread>
 #include <vector>
 
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#if HAVE_OPENSSL
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#endif
+
 namespace https_server_sim {
 namespace protocol {
 namespace test {
@@ -171,6 +189,23 @@ TEST_F(Http2StreamTest, Init) {
     EXPECT_EQ(stream.state, Http2StreamState::IDLE);
 }
 
+TEST_F(Http2StreamTest, ParsePriorityField) {
+    uint8_t urgency = HTTP2_DEFAULT_URGENCY;
+    bool incremental = false;
+    parse_priority_field("u=0, i", &urgency, &incremental);
+    EXPECT_EQ(urgency, 0);
+    EXPECT_TRUE(incremental);
+
+    parse_priority_field("i=?0,u=7", &urgency, &incremental);
+    EXPECT_EQ(urgency, 7);
+    EXPECT_FALSE(incremental);
+
+    // 越界与未知参数被忽略
+    parse_priority_field("u=9, foo=bar, , i;x=1", &urgency, &incremental);
+    EXPECT_EQ(urgency, 7);
+    EXPECT_TRUE(incremental);
+}
+
 TEST_F(Http2StreamTest, Reset) {
     Http2Stream stream;
     stream.init(3);
@@ -335,6 +370,173 @@ TEST_F(HttpParserTest, BuildResponse) {
     EXPECT_NE(result.find("Hello"), std::string::npos);
 }
 
+TEST_F(HttpParserTest, BuildResponseBufferTooSmall) {
+    HttpResponse resp;
+    resp.set_status(200, "OK");
+    const char* body = "Hello";
+    resp.set_body(reinterpret_cast<const uint8_t*>(body), 5);
+
+    uint8_t buf[16];
+    size_t out_len = 0;
+    EXPECT_EQ(parser_.build_response(resp, buf, sizeof(buf), &out_len), PROTOCOL_ERROR_BUFFER);
+}
+
+// ==================== HttpSerializer测试 ====================
+
+class HttpSerializerTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    std::string serialize(const HttpResponse& resp, bool include_body) {
+        utils::Buffer buffer;
+        EXPECT_EQ(HttpSerializer::serialize(resp, &buffer, include_body), PROTOCOL_OK);
+        return std::string(reinterpret_cast<const char*>(buffer.read_ptr()),
+                           buffer.readable_bytes());
+    }
+};
+
+TEST_F(HttpSerializerTest, StatusLineTableHit) {
+    size_t len = 0;
+    const char* line = HttpSerializer::find_status_line(404, "Not Found", &len);
+    ASSERT_NE(line, nullptr);
+    EXPECT_EQ(std::string(line, len), "HTTP/1.1 404 Not Found\r\n");
+}
+
+TEST_F(HttpSerializerTest, StatusLineCustomReasonFallback) {
+    EXPECT_EQ(HttpSerializer::find_status_line(200, "Fine", nullptr), nullptr);
+    EXPECT_EQ(HttpSerializer::find_status_line(299, "", nullptr), nullptr);
+
+    HttpResponse resp;
+    resp.set_status(299, "Custom");
+    EXPECT_EQ(serialize(resp, true), "HTTP/1.1 299 Custom\r\n\r\n");
+}
+
+TEST_F(HttpSerializerTest, SerializeWithBody) {
+    HttpResponse resp;
+    resp.set_status(200, "OK");
+    resp.add_header("Content-Type", "text/plain");
+    const char* body = "Hello";
+    resp.set_body(reinterpret_cast<const uint8_t*>(body), 5);
+
+    EXPECT_EQ(serialize(resp, true),
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: text/plain\r\n"
+              "Content-Length: 5\r\n"
+              "\r\n"
+              "Hello");
+}
+
+TEST_F(HttpSerializerTest, SerializeHeaderOnlyForScatterWrite) {
+    HttpResponse resp;
+    resp.set_status(200, "OK");
+    std::vector<uint8_t> body(RESPONSE_SCATTER_THRESHOLD, 'x');
+    resp.set_body(body.data(), body.size());
+
+    std::string head = serialize(resp, false);
+    EXPECT_EQ(head, "HTTP/1.1 200 OK\r\nContent-Length: 16384\r\n\r\n");
+    EXPECT_EQ(head.size(), HttpSerializer::header_size(resp, body.size()));
+}
+
+TEST_F(HttpSerializerTest, ExistingContentLengthNotDuplicated) {
+    HttpResponse resp;
+    resp.set_status(200, "OK");
+    resp.add_header("content-length", "2");
+    resp.set_body(reinterpret_cast<const uint8_t*>("OK"), 2);
+
+    std::string result = serialize(resp, true);
+    EXPECT_EQ(result, "HTTP/1.1 200 OK\r\ncontent-length: 2\r\n\r\nOK");
+}
+
+TEST_F(HttpSerializerTest, SerializeAppendsToBuffer) {
+    HttpResponse resp;
+    resp.set_status(204, "No Content");
+
+    utils::Buffer buffer;
+    buffer.write("X", 1);
+    EXPECT_EQ(HttpSerializer::serialize(resp, &buffer, true), PROTOCOL_OK);
+    EXPECT_EQ(buffer.readable_bytes(), 1 + HttpSerializer::header_size(resp, 0));
+    EXPECT_EQ(HttpSerializer::serialize(resp, nullptr, true), PROTOCOL_ERROR_INVALID);
+}
+
+// ==================== ResponseTemplate测试 ====================
+
+class ResponseTemplateTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ResponseTemplateRegistry::instance().clear();
+    }
+    void TearDown() override {
+        ResponseTemplateRegistry::instance().clear();
+    }
+
+    static std::string to_string(const utils::Buffer& buffer) {
+        return std::string(reinterpret_cast<const char*>(buffer.read_ptr()),
+                           buffer.readable_bytes());
+    }
+};
+
+TEST_F(ResponseTemplateTest, RenderPatchesDateAndContentLength) {
+    ResponseTemplate tmpl(200, "OK", HttpHeaders{{"Content-Type", "text/plain"}});
+    const char* body = "Hello";
+
+    utils::Buffer buffer;
+    EXPECT_EQ(tmpl.render(reinterpret_cast<const uint8_t*>(body), 5, &buffer, true), PROTOCOL_OK);
+    std::string result = to_string(buffer);
+
+    const std::string head = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nDate: ";
+    ASSERT_EQ(result.compare(0, head.size(), head), 0);
+    EXPECT_EQ(result.substr(head.size() + utils::HTTP_DATE_LEN),
+              "\r\nContent-Length: 5\r\n\r\nHello");
+    EXPECT_EQ(result.size(), tmpl.header_size(5) + 5);
+}
+
+TEST_F(ResponseTemplateTest, VariableHeadersNotFrozen) {
+    ResponseTemplate tmpl(404, "Not Found",
+                          HttpHeaders{{"content-length", "3"}, {"date", "x"}, {"Server", "sim"}});
+    utils::Buffer buffer;
+    EXPECT_EQ(tmpl.render(nullptr, 0, &buffer, false), PROTOCOL_OK);
+    std::string result = to_string(buffer);
+
+    EXPECT_EQ(result.find("content-length"), std::string::npos);
+    EXPECT_EQ(result.find("date: x"), std::string::npos);
+    EXPECT_NE(result.find("Server: sim\r\n"), std::string::npos);
+    EXPECT_NE(result.find("Content-Length: 0\r\n\r\n"), std::string::npos);
+    EXPECT_EQ(tmpl.render(nullptr, 1, &buffer, true), PROTOCOL_ERROR_INVALID);
+}
+
+TEST_F(ResponseTemplateTest, RegistryPerPort) {
+    ResponseTemplateRegistry& registry = ResponseTemplateRegistry::instance();
+    uint64_t version = registry.get_version();
+
+    EXPECT_EQ(registry.register_template(8443, 200, "OK", HttpHeaders{{"X-Port", "8443"}}), PROTOCOL_OK);
+    EXPECT_GT(registry.get_version(), version);
+    EXPECT_NE(registry.find(8443, 200), nullptr);
+    EXPECT_EQ(registry.find(8444, 200), nullptr);
+    EXPECT_EQ(registry.find(8443, 404), nullptr);
+    EXPECT_EQ(registry.register_template(8443, 42, "Bad", HttpHeaders{}), PROTOCOL_ERROR_INVALID);
+
+    registry.deregister_template(8443, 200);
+    EXPECT_EQ(registry.find(8443, 200), nullptr);
+}
+
+TEST_F(ResponseTemplateTest, RegistryKeepsExistingWhenNotReplacing) {
+    ResponseTemplateRegistry& registry = ResponseTemplateRegistry::instance();
+    registry.register_template(9000, 200, "OK", HttpHeaders{{"X-Owner", "callback"}});
+    auto first = registry.find(9000, 200);
+
+    uint64_t version = registry.get_version();
+    registry.register_template(9000, 200, "OK", HttpHeaders{{"X-Owner", "handler"}}, false);
+    EXPECT_EQ(registry.find(9000, 200), first);
+    EXPECT_EQ(registry.get_version(), version);
+    // 启动时登记的默认模板同样不覆盖回调注册的模板
+    EXPECT_EQ(registry.register_defaults(9000), PROTOCOL_OK);
+    EXPECT_EQ(registry.find(9000, 200), first);
+
+    registry.register_template(9000, 200, "OK", HttpHeaders{{"X-Owner", "handler"}});
+    EXPECT_NE(registry.find(9000, 200), first);
+}
+
 // ==================== Hpack测试 ====================
 
 class HpackTest : public ::testing::Test {
@@ -410,6 +612,527 @@ TEST_F(HpackTest, DecoderSetMaxSize) {
     EXPECT_EQ(decoder.get_max_dynamic_table_size(), 8192u);
 }
 
+TEST_F(HpackTest, DynamicTableEviction) {
+    HpackDynamicTable table;
+    table.set_max_size(100);
+    EXPECT_TRUE(table.add("a", "1"));   // 34字节
+    EXPECT_TRUE(table.add("b", "2"));
+    EXPECT_TRUE(table.add("c", "3"));   // 超出100，淘汰最旧的a
+    EXPECT_EQ(table.get_count(), 2u);
+    EXPECT_EQ(table.get_size(), 68u);
+    ASSERT_NE(table.get(1), nullptr);
+    EXPECT_EQ(table.get(1)->name, "c");
+    EXPECT_EQ(table.get(2)->name, "b");
+    EXPECT_EQ(table.get(3), nullptr);
+
+    // 条目大于表容量时清空动态表
+    EXPECT_FALSE(table.add("name", std::string(100, 'x')));
+    EXPECT_EQ(table.get_count(), 0u);
+    EXPECT_EQ(table.get_size(), 0u);
+}
+
+TEST_F(HpackTest, DynamicTableRingGrowth) {
+    HpackDynamicTable table;
+    for (int i = 0; i < 40; ++i) {
+        table.add("h" + std::to_string(i), "v");
+    }
+    table.set_max_size(HpackDynamicTable::ENTRY_OVERHEAD * 30);
+    for (int i = 40; i < 100; ++i) {
+        table.add("h" + std::to_string(i), "v");
+    }
+    ASSERT_GT(table.get_count(), 0u);
+    for (uint32_t i = 1; i <= table.get_count(); ++i) {
+        ASSERT_NE(table.get(i), nullptr);
+        EXPECT_EQ(table.get(i)->name, "h" + std::to_string(100 - i));
+    }
+
+    bool full_match = false;
+    EXPECT_EQ(table.find("h99", "v", &full_match), 1u);
+    EXPECT_TRUE(full_match);
+    EXPECT_EQ(table.find("h98", "other", &full_match), 2u);
+    EXPECT_FALSE(full_match);
+    EXPECT_EQ(table.find("h0", "v", &full_match), 0u);
+}
+
+TEST_F(HpackTest, EncoderStaticTableLookup) {
+    struct Case {
+        const char* name;
+        const char* value;
+        uint8_t first_byte;
+        size_t size;
+    };
+    const Case cases[] = {
+        {":authority", "", 0x81, 1},
+        {":status", "200", 0x88, 1},
+        {":status", "500", 0x8e, 1},
+        {"accept-encoding", "gzip, deflate", 0x90, 1},
+        {"www-authenticate", "", 0xbd, 1},
+        {":status", "201", 0x48, 4},   // 同名不同值：名称索引8，增量索引
+        {"vary", "x", 0x7b, 3},        // 名称索引59，增量索引
+        {"x-custom", "1", 0x40, 0},    // 静态表无此名称：新名称
+    };
+    for (const auto& c : cases) {
+        HpackEncoder encoder;
+        std::map<std::string, std::string> headers{{c.name, c.value}};
+        std::vector<uint8_t> encoded;
+        ASSERT_EQ(encoder.encode(headers, &encoded), PROTOCOL_OK);
+        ASSERT_FALSE(encoded.empty());
+        EXPECT_EQ(encoded[0], c.first_byte) << c.name << ": " << c.value;
+        if (c.size != 0) {
+            EXPECT_EQ(encoded.size(), c.size) << c.name << ": " << c.value;
+        }
+
+        HpackDecoder decoder;
+        std::map<std::string, std::string> decoded;
+        ASSERT_EQ(decoder.decode(encoded.data(), encoded.size(), &decoded), PROTOCOL_OK);
+        EXPECT_EQ(decoded, headers);
+    }
+}
+
+TEST_F(HpackTest, DynamicTableFindMatchesLinearScan) {
+    HpackDynamicTable table;
+    table.set_max_size(1024);
+    for (int i = 0; i < 500; ++i) {
+        std::string name = "x-h" + std::to_string(i % 17);
+        std::string value = "v" + std::to_string(i % 23);
+        table.add(name, value);
+        if (i == 250) {
+            table.set_max_size(300);
+        }
+
+        for (int probe = 0; probe < 17; probe += 4) {
+            std::string probe_name = "x-h" + std::to_string(probe);
+            bool full = false;
+            uint32_t idx = table.find(probe_name, value, &full);
+
+            uint32_t expected_full = 0;
+            uint32_t expected_name = 0;
+            for (uint32_t j = 1; j <= table.get_count(); ++j) {
+                const HpackHeaderField* field = table.get(j);
+                if (field->name != probe_name) {
+                    continue;
+                }
+                if (expected_name == 0) {
+                    expected_name = j;
+                }
+                if (field->value == value && expected_full == 0) {
+                    expected_full = j;
+                }
+            }
+            if (expected_full != 0) {
+                EXPECT_TRUE(full);
+                EXPECT_EQ(idx, expected_full);
+            } else {
+                EXPECT_FALSE(full);
+                EXPECT_EQ(idx, expected_name);
+            }
+        }
+    }
+}
+
+TEST_F(HpackTest, DecodeRfc7541RequestsWithDynamicTable) {
+    // RFC 7541 附录C.3（无Huffman编码的请求序列）
+    HpackDecoder decoder;
+    std::map<std::string, std::string> headers;
+
+    const uint8_t first[] = {0x82, 0x86, 0x84, 0x41, 0x0f, 'w', 'w', 'w', '.', 'e', 'x', 'a',
+                             'm', 'p', 'l', 'e', '.', 'c', 'o', 'm'};
+    ASSERT_EQ(decoder.decode(first, sizeof(first), &headers), PROTOCOL_OK);
+    EXPECT_EQ(headers[":authority"], "www.example.com");
+    EXPECT_EQ(decoder.get_dynamic_table().get_size(), 57u);
+
+    const uint8_t second[] = {0x82, 0x86, 0x84, 0xbe, 0x58, 0x08, 'n', 'o', '-', 'c', 'a',
+                              'c', 'h', 'e'};
+    ASSERT_EQ(decoder.decode(second, sizeof(second), &headers), PROTOCOL_OK);
+    EXPECT_EQ(headers[":authority"], "www.example.com");
+    EXPECT_EQ(headers["cache-control"], "no-cache");
+    EXPECT_EQ(decoder.get_dynamic_table().get_size(), 110u);
+}
+
+TEST_F(HpackTest, DecodeInvalidDynamicIndex) {
+    HpackDecoder decoder;
+    std::map<std::string, std::string> headers;
+    const uint8_t data[] = {0xbe};  // 索引62，动态表为空
+    EXPECT_NE(decoder.decode(data, sizeof(data), &headers), PROTOCOL_OK);
+}
+
+TEST_F(HpackTest, EncoderReusesDynamicEntries) {
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    std::map<std::string, std::string> headers;
+    headers[":status"] = "200";
+    headers["content-type"] = "application/json";
+    headers["server"] = "https-server-sim";
+    headers["content-length"] = "42";
+
+    std::vector<uint8_t> first;
+    ASSERT_EQ(encoder.encode(headers, &first), PROTOCOL_OK);
+    std::vector<uint8_t> second;
+    ASSERT_EQ(encoder.encode(headers, &second), PROTOCOL_OK);
+    // 第二次仅content-length为文字表示，其余均为单字节索引
+    EXPECT_LT(second.size(), first.size() / 2);
+    EXPECT_EQ(encoder.get_dynamic_table().get_count(), 2u);
+
+    std::map<std::string, std::string> decoded;
+    ASSERT_EQ(decoder.decode(first.data(), first.size(), &decoded), PROTOCOL_OK);
+    ASSERT_EQ(decoder.decode(second.data(), second.size(), &decoded), PROTOCOL_OK);
+    EXPECT_EQ(decoded, headers);
+}
+
+TEST_F(HpackTest, EncoderSignalsTableSizeUpdate) {
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    std::map<std::string, std::string> headers;
+    headers["server"] = "sim";
+
+    encoder.set_max_dynamic_table_size(0);
+    encoder.set_max_dynamic_table_size(256);
+    std::vector<uint8_t> encoded;
+    ASSERT_EQ(encoder.encode(headers, &encoded), PROTOCOL_OK);
+    // 先通告最小值0，再通告最终值256
+    ASSERT_GE(encoded.size(), 3u);
+    EXPECT_EQ(encoded[0], 0x20);
+    EXPECT_EQ(encoded[1], 0x3f);
+
+    std::map<std::string, std::string> decoded;
+    ASSERT_EQ(decoder.decode(encoded.data(), encoded.size(), &decoded), PROTOCOL_OK);
+    EXPECT_EQ(decoder.get_dynamic_table().get_max_size(), 256u);
+    EXPECT_EQ(decoded["server"], "sim");
+
+    // 超过本端通告值的表大小更新视为错误
+    decoder.set_max_dynamic_table_size(128);
+    EXPECT_NE(decoder.decode(encoded.data(), encoded.size(), &decoded), PROTOCOL_OK);
+}
+
+TEST_F(HpackTest, DecodeRejectsOverflowingInteger) {
+    HpackDecoder decoder;
+    decoder.set_max_dynamic_table_size(UINT32_MAX);
+    std::map<std::string, std::string> headers;
+
+    // 表大小更新（5位前缀）恰好编码UINT32_MAX时合法
+    const uint8_t largest[] = {0x3f, 0xe0, 0xff, 0xff, 0xff, 0x0f};
+    EXPECT_EQ(decoder.decode(largest, sizeof(largest), &headers), PROTOCOL_OK);
+    EXPECT_EQ(decoder.get_dynamic_table().get_max_size(), UINT32_MAX);
+
+    // 第5个续字节超出4位
+    const uint8_t too_wide[] = {0x3f, 0xff, 0xff, 0xff, 0xff, 0x7f};
+    EXPECT_EQ(decoder.decode(too_wide, sizeof(too_wide), &headers), PROTOCOL_ERROR_INVALID);
+    // 各字节均在范围内但累加超过UINT32_MAX
+    const uint8_t wraps[] = {0x3f, 0xff, 0xff, 0xff, 0xff, 0x0f};
+    EXPECT_EQ(decoder.decode(wraps, sizeof(wraps), &headers), PROTOCOL_ERROR_INVALID);
+    // 超过5个续字节
+    const uint8_t too_long[] = {0x3f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00};
+    EXPECT_EQ(decoder.decode(too_long, sizeof(too_long), &headers), PROTOCOL_ERROR_INVALID);
+}
+
+TEST_F(HpackTest, DecodeRejectsTableSizeUpdateAfterField) {
+    HpackDecoder decoder;
+    std::map<std::string, std::string> headers;
+    // 块首的连续表大小更新合法
+    const uint8_t leading[] = {0x20, 0x3f, 0xe1, 0x1f, 0x82};  // 大小0、4096，:method GET
+    EXPECT_EQ(decoder.decode(leading, sizeof(leading), &headers), PROTOCOL_OK);
+    EXPECT_EQ(headers[":method"], "GET");
+
+    // 字段表示之后的表大小更新为COMPRESSION_ERROR
+    const uint8_t trailing[] = {0x82, 0x20};
+    EXPECT_EQ(decoder.decode(trailing, sizeof(trailing), &headers), PROTOCOL_ERROR_INVALID);
+}
+
+// ==================== HpackHuffman测试 ====================
+
+class HpackHuffmanTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    static std::vector<uint8_t> encode(const std::string& str) {
+        std::vector<uint8_t> out;
+        huffman_encode(reinterpret_cast<const uint8_t*>(str.data()), str.size(), &out);
+        return out;
+    }
+};
+
+// 逐位遍历Huffman树的朴素解码器，用于对比测试与基准
+class BitwiseHuffmanDecoder {
+public:
+    BitwiseHuffmanDecoder() : nodes_(1) {
+        for (uint16_t sym = 0; sym <= HUFFMAN_EOS; ++sym) {
+            const HuffmanCode& hc = huffman_code(sym);
+            size_t node = 0;
+            for (int i = hc.bits - 1; i >= 0; --i) {
+                int bit = (hc.code >> i) & 1;
+                if (nodes_[node].child[bit] == 0) {
+                    nodes_[node].child[bit] = nodes_.size();
+                    nodes_.emplace_back();
+                }
+                node = nodes_[node].child[bit];
+            }
+            nodes_[node].symbol = sym;
+        }
+    }
+
+    bool decode(const uint8_t* data, size_t len, std::string* out) const {
+        out->clear();
+        size_t node = 0;
+        for (size_t i = 0; i < len; ++i) {
+            for (int b = 7; b >= 0; --b) {
+                node = nodes_[node].child[(data[i] >> b) & 1];
+                if (nodes_[node].symbol >= 0) {
+                    if (nodes_[node].symbol == HUFFMAN_EOS) {
+                        return false;
+                    }
+                    out->push_back(static_cast<char>(nodes_[node].symbol));
+                    node = 0;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    struct Node {
+        size_t child[2] = {0, 0};
+        int symbol = -1;
+    };
+    std::vector<Node> nodes_;
+};
+
+TEST_F(HpackHuffmanTest, EncodeRfc7541Vectors) {
+    const std::vector<uint8_t> expected1 = {0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a,
+                                            0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff};
+    EXPECT_EQ(encode("www.example.com"), expected1);
+    const std::vector<uint8_t> expected2 = {0xa8, 0xeb, 0x10, 0x64, 0x9c, 0xbf};
+    EXPECT_EQ(encode("no-cache"), expected2);
+    EXPECT_EQ(huffman_encoded_length(reinterpret_cast<const uint8_t*>("no-cache"), 8), 6u);
+}
+
+TEST_F(HpackHuffmanTest, RoundTripAllBytes) {
+    std::string input;
+    for (int i = 0; i < 256; ++i) {
+        input.push_back(static_cast<char>(i));
+    }
+    std::vector<uint8_t> encoded = encode(input);
+    std::string decoded;
+    ASSERT_EQ(huffman_decode(encoded.data(), encoded.size(), &decoded), PROTOCOL_OK);
+    EXPECT_EQ(decoded, input);
+}
+
+TEST_F(HpackHuffmanTest, DecodeRejectsInvalidPadding) {
+    std::string decoded;
+    // 'a'=00011，填充必须为1
+    const uint8_t valid[] = {0x1f};
+    EXPECT_EQ(huffman_decode(valid, sizeof(valid), &decoded), PROTOCOL_OK);
+    EXPECT_EQ(decoded, "a");
+    const uint8_t zero_padding[] = {0x18};
+    EXPECT_NE(huffman_decode(zero_padding, sizeof(zero_padding), &decoded), PROTOCOL_OK);
+
+    // 填充超过7位
+    std::vector<uint8_t> long_padding = encode("www.example.com");
+    long_padding.push_back(0xff);
+    EXPECT_NE(huffman_decode(long_padding.data(), long_padding.size(), &decoded), PROTOCOL_OK);
+
+    // 显式编码EOS
+    const uint8_t eos[] = {0xff, 0xff, 0xff, 0xff};
+    EXPECT_NE(huffman_decode(eos, sizeof(eos), &decoded), PROTOCOL_OK);
+}
+
+TEST_F(HpackHuffmanTest, DecodeRfc7541HuffmanRequest) {
+    // RFC 7541 附录C.4.1
+    const uint8_t data[] = {0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5,
+                            0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff};
+    HpackDecoder decoder;
+    std::map<std::string, std::string> headers;
+    ASSERT_EQ(decoder.decode(data, sizeof(data), &headers), PROTOCOL_OK);
+    EXPECT_EQ(headers[":authority"], "www.example.com");
+    EXPECT_EQ(headers[":method"], "GET");
+}
+
+TEST_F(HpackHuffmanTest, EncoderUsesShorterRepresentation) {
+    HpackEncoder encoder;
+    std::map<std::string, std::string> headers;
+    headers["content-length"] = "42";   // Huffman后不更短，使用原文
+    headers["server"] = "https-server-sim";
+
+    std::vector<uint8_t> encoded;
+    ASSERT_EQ(encoder.encode(headers, &encoded), PROTOCOL_OK);
+    // content-length: 无索引(0x0f 0x0d) + 原文长度2
+    ASSERT_GE(encoded.size(), 5u);
+    EXPECT_EQ(encoded[0], 0x0f);
+    EXPECT_EQ(encoded[2], 0x02);
+    // server: 值使用Huffman
+    EXPECT_EQ(encoded[6] & 0x80, 0x80);
+
+    HpackDecoder decoder;
+    std::map<std::string, std::string> decoded;
+    ASSERT_EQ(decoder.decode(encoded.data(), encoded.size(), &decoded), PROTOCOL_OK);
+    EXPECT_EQ(decoded, headers);
+}
+
+// 吞吐量微基准：状态机解码与逐位解码对比（仅输出结果，不作为通过条件）
+// 默认不运行，需要时以--gtest_also_run_disabled_tests --gtest_filter=*Benchmark执行
+TEST_F(HpackHuffmanTest, DISABLED_DecodeThroughputBenchmark) {
+    const char* samples[] = {
+        "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0",
+        "/api/v1/resources/0123456789abcdef?page=2&limit=50&sort=desc",
+        "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8",
+        "session=4f3c2b1a0e9d8c7b6a5f4e3d2c1b0a99; theme=dark; lang=zh-CN",
+        "Mon, 21 Oct 2013 20:13:21 GMT",
+        "https://www.example.com/path/to/page.html"
+    };
+    std::vector<std::vector<uint8_t>> corpus;
+    size_t total_bytes = 0;
+    for (int i = 0; i < 64; ++i) {
+        for (const char* sample : samples) {
+            corpus.push_back(encode(sample));
+            total_bytes += corpus.back().size();
+        }
+    }
+
+    BitwiseHuffmanDecoder bitwise;
+    std::string table_out;
+    std::string bitwise_out;
+    for (const auto& encoded : corpus) {
+        ASSERT_EQ(huffman_decode(encoded.data(), encoded.size(), &table_out), PROTOCOL_OK);
+        ASSERT_TRUE(bitwise.decode(encoded.data(), encoded.size(), &bitwise_out));
+        ASSERT_EQ(table_out, bitwise_out);
+    }
+
+    const int rounds = 50;
+    auto measure = [&](auto&& decode_fn) {
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            for (const auto& encoded : corpus) {
+                decode_fn(encoded);
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(total_bytes) * rounds / elapsed.count() / (1024.0 * 1024.0);
+    };
+    double table_mbps = measure([&](const std::vector<uint8_t>& e) {
+        huffman_decode(e.data(), e.size(), &table_out);
+    });
+    double bitwise_mbps = measure([&](const std::vector<uint8_t>& e) {
+        bitwise.decode(e.data(), e.size(), &bitwise_out);
+    });
+    std::printf("[ BENCH    ] huffman decode: nibble table %.1f MB/s, bitwise %.1f MB/s\n",
+                table_mbps, bitwise_mbps);
+    RecordProperty("nibble_table_mbps", static_cast<int>(table_mbps));
+    RecordProperty("bitwise_mbps", static_cast<int>(bitwise_mbps));
+}
+
+// ==================== Compression测试 ====================
+
+class CompressionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        CompressionCache::instance().clear();
+    }
+    void TearDown() override {
+        CompressionCache::instance().set_capacity(CompressionCache::DEFAULT_CAPACITY_BYTES);
+        CompressionCache::instance().clear();
+    }
+};
+
+TEST_F(CompressionTest, EncodingHeaderLines) {
+    size_t len = 0;
+    const char* lines = content_encoding_header_lines(ContentEncoding::GZIP, &len);
+    EXPECT_EQ(std::string(lines, len), "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n");
+    content_encoding_header_lines(ContentEncoding::IDENTITY, &len);
+    EXPECT_EQ(len, 0u);
+    EXPECT_STREQ(content_encoding_name(ContentEncoding::DEFLATE), "deflate");
+}
+
+TEST_F(CompressionTest, TemplateRenderWithExtraLines) {
+    ResponseTemplate tmpl(200, "OK", HttpHeaders());
+    size_t extra_len = 0;
+    const char* extra = content_encoding_header_lines(ContentEncoding::GZIP, &extra_len);
+    utils::Buffer out;
+    const uint8_t body[] = {'z'};
+    ASSERT_EQ(tmpl.render(body, 1, &out, true, extra, extra_len), PROTOCOL_OK);
+    EXPECT_EQ(out.readable_bytes(), tmpl.header_size(1, extra_len) + 1);
+
+    std::string text(reinterpret_cast<const char*>(out.read_ptr()), out.readable_bytes());
+    EXPECT_EQ(text.find("HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nVary: Accept-Encoding\r\nDate: "), 0u);
+    EXPECT_NE(text.find("\r\nContent-Length: 1\r\n\r\nz"), std::string::npos);
+}
+
+#if HAVE_ZLIB
+TEST_F(CompressionTest, NegotiateContentEncoding) {
+    EXPECT_EQ(negotiate_content_encoding(""), ContentEncoding::IDENTITY);
+    EXPECT_EQ(negotiate_content_encoding("gzip, deflate, br"), ContentEncoding::GZIP);
+    EXPECT_EQ(negotiate_content_encoding("deflate"), ContentEncoding::DEFLATE);
+    EXPECT_EQ(negotiate_content_encoding("gzip;q=0.5, deflate;q=0.8"), ContentEncoding::DEFLATE);
+    EXPECT_EQ(negotiate_content_encoding("GZIP;Q=1"), ContentEncoding::GZIP);
+    EXPECT_EQ(negotiate_content_encoding("gzip;q=0, deflate;q=0"), ContentEncoding::IDENTITY);
+    EXPECT_EQ(negotiate_content_encoding("*"), ContentEncoding::GZIP);
+    EXPECT_EQ(negotiate_content_encoding("br, identity"), ContentEncoding::IDENTITY);
+}
+
+TEST_F(CompressionTest, GzipRoundTrip) {
+    std::string text;
+    for (int i = 0; i < 200; ++i) {
+        text += "hello compression ";
+    }
+    std::vector<uint8_t> compressed;
+    ASSERT_EQ(compress_body(reinterpret_cast<const uint8_t*>(text.data()), text.size(),
+                            ContentEncoding::GZIP, 6, &compressed), PROTOCOL_OK);
+    ASSERT_LT(compressed.size(), text.size());
+    EXPECT_EQ(compressed[0], 0x1f);
+    EXPECT_EQ(compressed[1], 0x8b);
+
+    // gzip格式解压校验
+    std::vector<uint8_t> inflated(text.size());
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    ASSERT_EQ(inflateInit2(&zs, MAX_WBITS + 16), Z_OK);
+    zs.next_in = compressed.data();
+    zs.avail_in = static_cast<uInt>(compressed.size());
+    zs.next_out = inflated.data();
+    zs.avail_out = static_cast<uInt>(inflated.size());
+    EXPECT_EQ(inflate(&zs, Z_FINISH), Z_STREAM_END);
+    EXPECT_EQ(zs.total_out, text.size());
+    inflateEnd(&zs);
+    EXPECT_EQ(memcmp(inflated.data(), text.data(), text.size()), 0);
+}
+
+TEST_F(CompressionTest, CacheHitsAndEviction) {
+    CompressionCache& cache = CompressionCache::instance();
+    std::string a(4096, 'a');
+    std::string b(4096, 'b');
+    const uint8_t* pa = reinterpret_cast<const uint8_t*>(a.data());
+    const uint8_t* pb = reinterpret_cast<const uint8_t*>(b.data());
+
+    auto first = cache.get_or_compress(pa, a.size(), ContentEncoding::GZIP, 6);
+    auto second = cache.get_or_compress(pa, a.size(), ContentEncoding::GZIP, 6);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(cache.hits(), 1u);
+    EXPECT_EQ(cache.misses(), 1u);
+
+    // 编码不同视为不同条目
+    auto deflated = cache.get_or_compress(pa, a.size(), ContentEncoding::DEFLATE, 6);
+    ASSERT_NE(deflated, nullptr);
+    EXPECT_NE(deflated.get(), first.get());
+    EXPECT_EQ(cache.entry_count(), 2u);
+
+    // 条目按原始数据+压缩结果计容量；只够两个gzip条目时淘汰最久未使用的deflate条目
+    size_t gzip_entry = a.size() + first->size();
+    cache.set_capacity(gzip_entry * 2);
+    cache.get_or_compress(pa, a.size(), ContentEncoding::GZIP, 6);
+    auto other = cache.get_or_compress(pb, b.size(), ContentEncoding::GZIP, 6);
+    ASSERT_NE(other, nullptr);
+    EXPECT_LE(cache.size_bytes(), gzip_entry * 2);
+    EXPECT_EQ(cache.entry_count(), 2u);
+    uint64_t misses = cache.misses();
+    cache.get_or_compress(pa, a.size(), ContentEncoding::DEFLATE, 6);
+    EXPECT_EQ(cache.misses(), misses + 1);
+}
+#else
+TEST_F(CompressionTest, NegotiateWithoutZlib) {
+    EXPECT_EQ(negotiate_content_encoding("gzip"), ContentEncoding::IDENTITY);
+}
+#endif
+
 // ==================== ProtocolFactory测试 ====================
 
 class ProtocolFactoryTest : public ::testing::Test {
@@ -476,6 +1199,248 @@ TEST_F(Http1HandlerTest, Reset) {
     SUCCEED();
 }
 
+// 统计输出中出现的响应状态行数
+static size_t CountHttp1Responses(const utils::Buffer& out) {
+    const std::string text(reinterpret_cast<const char*>(out.read_ptr()), out.readable_bytes());
+    size_t count = 0;
+    for (size_t pos = text.find("HTTP/1.1 "); pos != std::string::npos; pos = text.find("HTTP/1.1 ", pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+TEST_F(Http1HandlerTest, PipelinedRequestsProcessedInOnePass) {
+    // 默认模板由服务器按监听端口登记
+    ASSERT_EQ(ResponseTemplateRegistry::instance().register_defaults(18443), PROTOCOL_OK);
+    Connection conn(1, -1, 18443);
+    Http1Handler handler;
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    const std::string pipelined =
+        "GET /a HTTP/1.1\r\n\r\n"
+        "POST /b HTTP/1.1\r\nContent-Length: 2\r\n\r\nhi"
+        "GET /c HTTP/1.1\r\n\r\n"
+        "GET /d HTT";
+    conn.get_read_buffer().write(pipelined);
+
+    // 三个完整请求的响应在本次读事件结束时一起写出
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(conn.get_read_buffer().readable_bytes(), 0u);
+    EXPECT_EQ(CountHttp1Responses(conn.get_write_buffer()), 3u);
+    conn.get_write_buffer().clear();
+
+    // 不完整的第四个请求保留在处理器中，补齐后继续处理
+    conn.get_read_buffer().write(std::string("P/1.1\r\n\r\n"));
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(CountHttp1Responses(conn.get_write_buffer()), 1u);
+
+    ResponseTemplateRegistry::instance().deregister_template(18443, 200);
+}
+
+TEST_F(Http1HandlerTest, SendFileResponseNotInitialized) {
+    Http1Handler handler;
+    EXPECT_NE(handler.send_file_response(0, 0, 1), PROTOCOL_OK);
+}
+
+TEST_F(Http1HandlerTest, SendFileResponseWritesHeaderAndBody) {
+    FILE* fp = tmpfile();
+    ASSERT_NE(fp, nullptr);
+    fputs("hello world", fp);
+    fflush(fp);
+
+    Connection conn(1, -1, 18445);
+    Http1Handler handler;
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    EXPECT_EQ(handler.send_file_response(fileno(fp), 6, 5), PROTOCOL_OK);
+    const utils::Buffer& out = conn.get_write_buffer();
+    const std::string text(reinterpret_cast<const char*>(out.read_ptr()), out.readable_bytes());
+    EXPECT_EQ(text.compare(0, 15, "HTTP/1.1 200 OK"), 0);
+    EXPECT_NE(text.find("Content-Length: 5\r\n"), std::string::npos);
+    EXPECT_EQ(text.substr(text.size() - 9), "\r\n\r\nworld");
+    // 文件已发完，写事件无剩余内容
+    EXPECT_EQ(handler.on_write(), PROTOCOL_OK);
+    EXPECT_EQ(out.readable_bytes(), text.size());
+    fclose(fp);
+}
+
+TEST_F(Http1HandlerTest, CompressesEchoedBody) {
+    CompressionCache::instance().clear();
+    ASSERT_EQ(ResponseTemplateRegistry::instance().register_defaults(18444), PROTOCOL_OK);
+    Connection conn(1, -1, 18444);
+    Http1Handler handler;
+    CompressionConfig compression;
+    compression.enabled = true;
+    compression.min_size = 64;
+    handler.set_compression_config(compression);
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    const std::string body(256, 'a');
+    const std::string request =
+        "POST /x HTTP/1.1\r\nAccept-Encoding: gzip\r\nContent-Length: 256\r\n\r\n" + body;
+    conn.get_read_buffer().write(request + request);
+
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(CountHttp1Responses(conn.get_write_buffer()), 2u);
+#if HAVE_ZLIB
+    // 两次相同响应体只压缩一次
+    EXPECT_EQ(CompressionCache::instance().misses(), 1u);
+    EXPECT_EQ(CompressionCache::instance().hits(), 1u);
+    const utils::Buffer& out = conn.get_write_buffer();
+    const std::string text(reinterpret_cast<const char*>(out.read_ptr()), out.readable_bytes());
+    EXPECT_NE(text.find("Content-Encoding: gzip\r\n"), std::string::npos);
+#else
+    EXPECT_EQ(CompressionCache::instance().entry_count(), 0u);
+#endif
+
+    ResponseTemplateRegistry::instance().deregister_template(18444, 200);
+    CompressionCache::instance().clear();
+}
+
+// ==================== Http2StreamTable测试 ====================
+
+class Http2StreamTableTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_F(Http2StreamTableTest, InsertFindErase) {
+    Http2StreamTable table;
+    table.init(4);  // 8个槽位
+    EXPECT_EQ(table.capacity(), 4u);
+
+    // 1与17、3与19起始槽位相同，删除后探测链需保持完整
+    ASSERT_NE(table.insert(1), nullptr);
+    ASSERT_NE(table.insert(17), nullptr);
+    ASSERT_NE(table.insert(3), nullptr);
+    ASSERT_NE(table.insert(19), nullptr);
+    EXPECT_EQ(table.insert(5), nullptr);   // 已满
+    EXPECT_EQ(table.size(), 4u);
+
+    table.erase(1);
+    EXPECT_EQ(table.find(1), nullptr);
+    ASSERT_NE(table.find(17), nullptr);
+    EXPECT_EQ(table.find(17)->stream_id, 17u);
+    EXPECT_EQ(table.find(19)->stream_id, 19u);
+    EXPECT_EQ(table.find(3)->stream_id, 3u);
+    EXPECT_EQ(table.insert(3), nullptr);   // 重复
+
+    size_t visited = 0;
+    table.for_each([&visited](Http2Stream*) { visited++; });
+    EXPECT_EQ(visited, 3u);
+}
+
+TEST_F(Http2StreamTableTest, ReusesPooledStreams) {
+    Http2StreamTable table;
+    table.init(2);
+    Http2Stream* stream = table.insert(1);
+    ASSERT_NE(stream, nullptr);
+    stream->state = Http2StreamState::OPEN;
+    stream->pending_data.assign(16, 'p');
+    stream->pending_shared = std::make_shared<std::vector<uint8_t>>(16, 'c');
+    table.erase(1);
+
+    // 删除的对象reset后被下一个流复用
+    Http2Stream* reused = table.insert(3);
+    EXPECT_EQ(reused, stream);
+    EXPECT_EQ(reused->stream_id, 3u);
+    EXPECT_EQ(reused->state, Http2StreamState::IDLE);
+    EXPECT_TRUE(reused->pending_data.empty());
+    EXPECT_EQ(reused->pending_shared, nullptr);
+    EXPECT_EQ(table.allocated(), 1u);
+
+    table.clear();
+    EXPECT_EQ(table.size(), 0u);
+    EXPECT_EQ(table.allocated(), 1u);
+}
+
+TEST_F(Http2StreamTableTest, MatchesReferenceMap) {
+    Http2StreamTable table;
+    table.init(64);
+    std::map<uint32_t, Http2Stream*> reference;
+    uint32_t seed = 12345;
+    for (int i = 0; i < 20000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        uint32_t id = ((seed >> 8) % 512) * 2 + 1;
+        if ((seed & 3) != 0 && reference.size() < table.capacity()) {
+            Http2Stream* stream = table.insert(id);
+            EXPECT_EQ(stream != nullptr, reference.count(id) == 0);
+            if (stream != nullptr) {
+                reference[id] = stream;
+            }
+        } else {
+            table.erase(id);
+            reference.erase(id);
+        }
+        ASSERT_EQ(table.size(), reference.size());
+    }
+    for (uint32_t id = 1; id < 1024; id += 2) {
+        auto it = reference.find(id);
+        EXPECT_EQ(table.find(id), it == reference.end() ? nullptr : it->second);
+    }
+    EXPECT_LE(table.allocated(), table.capacity());
+}
+
+// ==================== Http2BdpEstimator测试 ====================
+
+class Http2BdpEstimatorTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_F(Http2BdpEstimatorTest, GrowsWindowWhenSaturated) {
+    Http2BdpEstimator bdp;
+    bdp.init(65535, 1 << 20);
+    auto now = Http2BdpEstimator::Clock::now();
+
+    // 第一个DATA触发探测，探测期间的到达量计入样本
+    EXPECT_TRUE(bdp.add_bytes(16384));
+    bdp.ping_sent(now);
+    EXPECT_TRUE(bdp.ping_pending());
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_FALSE(bdp.add_bytes(16384));
+    }
+    now += std::chrono::milliseconds(100);
+    EXPECT_EQ(bdp.ping_acked(now), 131072u);
+    EXPECT_EQ(bdp.window(), 131072u);
+    EXPECT_NEAR(bdp.rtt(), 0.1, 1e-6);
+    EXPECT_FALSE(bdp.ping_pending());
+
+    // 到达量远小于窗口时不调整
+    EXPECT_TRUE(bdp.add_bytes(1000));
+    bdp.ping_sent(now);
+    now += std::chrono::milliseconds(100);
+    EXPECT_EQ(bdp.ping_acked(now), 0u);
+    EXPECT_EQ(bdp.window(), 131072u);
+
+    // 没有在途探测时ACK被忽略
+    EXPECT_EQ(bdp.ping_acked(now), 0u);
+}
+
+TEST_F(Http2BdpEstimatorTest, StopsAtMaxWindow) {
+    Http2BdpEstimator bdp;
+    bdp.init(65535, 100000);
+    auto now = Http2BdpEstimator::Clock::now();
+    EXPECT_TRUE(bdp.add_bytes(65535));
+    bdp.ping_sent(now);
+    EXPECT_EQ(bdp.ping_acked(now + std::chrono::milliseconds(50)), 100000u);
+
+    // 窗口到达上限后不再探测
+    EXPECT_FALSE(bdp.add_bytes(65535));
+
+    Http2BdpEstimator disabled;
+    disabled.init(65535, 65535);
+    EXPECT_FALSE(disabled.add_bytes(1));
+}
+
 // ==================== Http2Handler测试 ====================
 
 class Http2HandlerTest : public ::testing::Test {
@@ -500,6 +1465,1206 @@ TEST_F(Http2HandlerTest, Reset) {
     SUCCEED();
 }
 
+// 构造HTTP/2帧并追加到out
+static void AppendHttp2Frame(std::vector<uint8_t>* out, Http2FrameType type, uint8_t flags,
+                             uint32_t stream_id, const uint8_t* payload, size_t len) {
+    out->push_back(static_cast<uint8_t>((len >> 16) & 0xFF));
+    out->push_back(static_cast<uint8_t>((len >> 8) & 0xFF));
+    out->push_back(static_cast<uint8_t>(len & 0xFF));
+    out->push_back(static_cast<uint8_t>(type));
+    out->push_back(flags);
+    out->push_back(static_cast<uint8_t>((stream_id >> 24) & 0x7F));
+    out->push_back(static_cast<uint8_t>((stream_id >> 16) & 0xFF));
+    out->push_back(static_cast<uint8_t>((stream_id >> 8) & 0xFF));
+    out->push_back(static_cast<uint8_t>(stream_id & 0xFF));
+    if (len > 0) {
+        out->insert(out->end(), payload, payload + len);
+    }
+}
+
+static void AppendHttp2Headers(std::vector<uint8_t>* out, HpackEncoder* encoder,
+                               uint32_t stream_id, bool end_stream,
+                               const char* priority = nullptr) {
+    std::map<std::string, std::string> headers = {
+        {":method", "POST"}, {":path", "/echo"}, {":scheme", "https"}};
+    if (priority != nullptr) {
+        headers["priority"] = priority;
+    }
+    std::vector<uint8_t> block;
+    ASSERT_EQ(encoder->encode(headers, &block), PROTOCOL_OK);
+    uint8_t flags = HTTP2_FLAG_END_HEADERS | (end_stream ? HTTP2_FLAG_END_STREAM : 0);
+    AppendHttp2Frame(out, Http2FrameType::HEADERS, flags, stream_id, block.data(), block.size());
+}
+
+// 解析输出缓冲区中的全部完整帧，返回(帧类型, 标志, 流ID, 负载)
+struct WrittenFrame {
+    uint8_t type;
+    uint8_t flags;
+    uint32_t stream_id;
+    std::vector<uint8_t> payload;
+};
+
+static std::vector<WrittenFrame> ConsumeHttp2Frames(utils::Buffer* out) {
+    std::vector<WrittenFrame> frames;
+    while (out->readable_bytes() >= HTTP2_FRAME_HEADER_SIZE) {
+        const uint8_t* p = out->read_ptr();
+        size_t len = (static_cast<size_t>(p[0]) << 16) | (static_cast<size_t>(p[1]) << 8) | p[2];
+        if (out->readable_bytes() < HTTP2_FRAME_HEADER_SIZE + len) {
+            break;
+        }
+        WrittenFrame frame;
+        frame.type = p[3];
+        frame.flags = p[4];
+        frame.stream_id = ((static_cast<uint32_t>(p[5]) & 0x7F) << 24) |
+                          (static_cast<uint32_t>(p[6]) << 16) |
+                          (static_cast<uint32_t>(p[7]) << 8) | p[8];
+        frame.payload.assign(p + HTTP2_FRAME_HEADER_SIZE, p + HTTP2_FRAME_HEADER_SIZE + len);
+        frames.push_back(std::move(frame));
+        out->skip(HTTP2_FRAME_HEADER_SIZE + len);
+    }
+    return frames;
+}
+
+// 统计指定流的DATA负载字节数，ended返回是否带END_STREAM
+static size_t Http2DataBytes(const std::vector<WrittenFrame>& frames, uint32_t stream_id, bool* ended) {
+    size_t bytes = 0;
+    *ended = false;
+    for (const auto& frame : frames) {
+        if (frame.type == static_cast<uint8_t>(Http2FrameType::DATA) && frame.stream_id == stream_id) {
+            bytes += frame.payload.size();
+            *ended = *ended || (frame.flags & HTTP2_FLAG_END_STREAM) != 0;
+        }
+    }
+    return bytes;
+}
+
+// 查找指定类型与流ID的第一个帧，没有时返回nullptr
+static const WrittenFrame* FindHttp2Frame(const std::vector<WrittenFrame>& frames,
+                                          Http2FrameType type, uint32_t stream_id) {
+    for (const auto& frame : frames) {
+        if (frame.type == static_cast<uint8_t>(type) && frame.stream_id == stream_id) {
+            return &frame;
+        }
+    }
+    return nullptr;
+}
+
+// 读取4字节负载（WINDOW_UPDATE增量、RST_STREAM错误码）
+static uint32_t Http2PayloadUint32(const WrittenFrame& frame) {
+    const std::vector<uint8_t>& p = frame.payload;
+    return ((static_cast<uint32_t>(p[0]) & 0x7F) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+TEST_F(Http2HandlerTest, QueuesDataUntilWindowOpens) {
+    Connection conn(1, -1, 18445);
+    Http2Handler handler;
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    // 对端初始窗口为100，回显300字节的请求体
+    std::vector<uint8_t> frames(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE + HTTP2_CLIENT_PREFACE_LEN);
+    const uint8_t small_window[6] = {0x00, 0x04, 0x00, 0x00, 0x00, 100};
+    AppendHttp2Frame(&frames, Http2FrameType::SETTINGS, 0, 0, small_window, sizeof(small_window));
+    HpackEncoder encoder;
+    AppendHttp2Headers(&frames, &encoder, 1, false);
+    const std::vector<uint8_t> body(300, 'x');
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, HTTP2_FLAG_END_STREAM, 1, body.data(), body.size());
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+
+    bool ended = false;
+    EXPECT_EQ(Http2DataBytes(ConsumeHttp2Frames(&conn.get_write_buffer()), 1, &ended), 100u);
+    EXPECT_FALSE(ended);
+
+    // 流级WINDOW_UPDATE只放出150字节
+    frames.clear();
+    const uint8_t increment[4] = {0x00, 0x00, 0x00, 150};
+    AppendHttp2Frame(&frames, Http2FrameType::WINDOW_UPDATE, 0, 1, increment, sizeof(increment));
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(Http2DataBytes(ConsumeHttp2Frames(&conn.get_write_buffer()), 1, &ended), 150u);
+    EXPECT_FALSE(ended);
+
+    // 增大SETTINGS_INITIAL_WINDOW_SIZE，差值(+30)作用于已打开流
+    frames.clear();
+    const uint8_t larger_window[6] = {0x00, 0x04, 0x00, 0x00, 0x00, 130};
+    AppendHttp2Frame(&frames, Http2FrameType::SETTINGS, 0, 0, larger_window, sizeof(larger_window));
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(Http2DataBytes(ConsumeHttp2Frames(&conn.get_write_buffer()), 1, &ended), 30u);
+    EXPECT_FALSE(ended);
+
+    // 剩余数据随END_STREAM发出，流关闭后其WINDOW_UPDATE被忽略
+    frames.clear();
+    const uint8_t rest[4] = {0x00, 0x00, 0x00, 20};
+    AppendHttp2Frame(&frames, Http2FrameType::WINDOW_UPDATE, 0, 1, rest, sizeof(rest));
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(Http2DataBytes(ConsumeHttp2Frames(&conn.get_write_buffer()), 1, &ended), 20u);
+    EXPECT_TRUE(ended);
+
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_TRUE(ConsumeHttp2Frames(&conn.get_write_buffer()).empty());
+}
+
+TEST_F(Http2HandlerTest, ReplenishesReceiveWindow) {
+    Connection conn(1, -1, 18446);
+    Http2Handler handler;
+    Http2Settings local;
+    local.initial_window_size = 1000;
+    handler.set_local_settings(local);
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    std::vector<uint8_t> frames(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE + HTTP2_CLIENT_PREFACE_LEN);
+    HpackEncoder encoder;
+    AppendHttp2Headers(&frames, &encoder, 1, false);
+    const std::vector<uint8_t> chunk(400, 'a');
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, 0, 1, chunk.data(), chunk.size());
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+
+    // 默认连接窗口不需要放大；400字节不足半个流窗口，不归还
+    std::vector<WrittenFrame> written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    EXPECT_EQ(FindHttp2Frame(written, Http2FrameType::WINDOW_UPDATE, 0), nullptr);
+    EXPECT_EQ(FindHttp2Frame(written, Http2FrameType::WINDOW_UPDATE, 1), nullptr);
+
+    // 累计消费超过半个窗口，一次性归还；连接级消费未到阈值
+    frames.clear();
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, 0, 1, chunk.data(), 200);
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    const WrittenFrame* update = FindHttp2Frame(written, Http2FrameType::WINDOW_UPDATE, 1);
+    ASSERT_NE(update, nullptr);
+    EXPECT_EQ(Http2PayloadUint32(*update), 600u);
+    EXPECT_EQ(FindHttp2Frame(written, Http2FrameType::WINDOW_UPDATE, 0), nullptr);
+
+    // 超出流级窗口的DATA只重置该流
+    frames.clear();
+    const std::vector<uint8_t> overrun(1200, 'b');
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, 0, 1, overrun.data(), overrun.size());
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    const WrittenFrame* reset = FindHttp2Frame(written, Http2FrameType::RST_STREAM, 1);
+    ASSERT_NE(reset, nullptr);
+    EXPECT_EQ(Http2PayloadUint32(*reset), HTTP2_ERROR_FLOW_CONTROL);
+
+    // 本端窗口大于默认值时连接级窗口经WINDOW_UPDATE同步放大
+    Connection large_conn(2, -1, 18446);
+    Http2Handler large;
+    local.initial_window_size = 1 << 20;
+    large.set_local_settings(local);
+    ASSERT_EQ(large.init(&large_conn, CertConfig(), tls_config), PROTOCOL_OK);
+    large_conn.get_read_buffer().write(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE_LEN);
+    ASSERT_EQ(large.on_read(), PROTOCOL_OK);
+    written = ConsumeHttp2Frames(&large_conn.get_write_buffer());
+    update = FindHttp2Frame(written, Http2FrameType::WINDOW_UPDATE, 0);
+    ASSERT_NE(update, nullptr);
+    EXPECT_EQ(Http2PayloadUint32(*update), (1u << 20) - 65535u);
+}
+
+TEST_F(Http2HandlerTest, RefusesStreamsBeyondLimit) {
+    Connection conn(1, -1, 18447);
+    Http2Handler handler;
+    Http2Settings local;
+    local.max_concurrent_streams = 1;
+    handler.set_local_settings(local);
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    // 流3超出并发限制被拒绝，其在途DATA被丢弃
+    std::vector<uint8_t> frames(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE + HTTP2_CLIENT_PREFACE_LEN);
+    HpackEncoder encoder;
+    AppendHttp2Headers(&frames, &encoder, 1, false);
+    AppendHttp2Headers(&frames, &encoder, 3, false);
+    const uint8_t data[2] = {'h', 'i'};
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, HTTP2_FLAG_END_STREAM, 3, data, sizeof(data));
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    std::vector<WrittenFrame> written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    const WrittenFrame* refused = FindHttp2Frame(written, Http2FrameType::RST_STREAM, 3);
+    ASSERT_NE(refused, nullptr);
+    EXPECT_EQ(Http2PayloadUint32(*refused), HTTP2_ERROR_REFUSED_STREAM);
+    EXPECT_EQ(FindHttp2Frame(written, Http2FrameType::RST_STREAM, 1), nullptr);
+    EXPECT_EQ(FindHttp2Frame(written, Http2FrameType::DATA, 3), nullptr);
+
+    // 流1完成后收到回显
+    frames.clear();
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, HTTP2_FLAG_END_STREAM, 1, data, sizeof(data));
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    bool ended = false;
+    EXPECT_EQ(Http2DataBytes(ConsumeHttp2Frames(&conn.get_write_buffer()), 1, &ended), sizeof(data));
+    EXPECT_TRUE(ended);
+
+    // 流1关闭后新流可被接受（被拒绝流的头部块也已解码，HPACK状态保持同步）
+    frames.clear();
+    AppendHttp2Headers(&frames, &encoder, 5, false);
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, HTTP2_FLAG_END_STREAM, 5, data, sizeof(data));
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    EXPECT_EQ(FindHttp2Frame(written, Http2FrameType::RST_STREAM, 5), nullptr);
+    EXPECT_NE(FindHttp2Frame(written, Http2FrameType::HEADERS, 5), nullptr);
+    EXPECT_EQ(Http2DataBytes(written, 5, &ended), sizeof(data));
+    EXPECT_TRUE(ended);
+
+    // 客户端不能使用偶数流ID
+    frames.clear();
+    AppendHttp2Headers(&frames, &encoder, 6, true);
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    EXPECT_NE(handler.on_read(), PROTOCOL_OK);
+}
+
+TEST_F(Http2HandlerTest, SchedulesDataByUrgency) {
+    Connection conn(1, -1, 18448);
+    Http2Handler handler;
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    // 流1（默认紧急度3）先完成，流3（u=0）后完成；连接窗口只够65535字节
+    std::vector<uint8_t> frames(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE + HTTP2_CLIENT_PREFACE_LEN);
+    HpackEncoder encoder;
+    const std::vector<uint8_t> body(40000, 'z');
+    AppendHttp2Headers(&frames, &encoder, 1, false);
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, HTTP2_FLAG_END_STREAM, 1, body.data(), body.size());
+    AppendHttp2Headers(&frames, &encoder, 3, false, "u=0");
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, HTTP2_FLAG_END_STREAM, 3, body.data(), body.size());
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+
+    // 高紧急度的流3先发完，流1只拿到剩余窗口
+    std::vector<WrittenFrame> written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    std::vector<uint32_t> order;
+    for (const auto& frame : written) {
+        if (frame.type == static_cast<uint8_t>(Http2FrameType::DATA) &&
+            (order.empty() || order.back() != frame.stream_id)) {
+            order.push_back(frame.stream_id);
+        }
+    }
+    EXPECT_EQ(order, std::vector<uint32_t>({3, 1}));
+    bool ended = false;
+    EXPECT_EQ(Http2DataBytes(written, 3, &ended), 40000u);
+    EXPECT_TRUE(ended);
+    EXPECT_EQ(Http2DataBytes(written, 1, &ended), 65535u - 40000u);
+    EXPECT_FALSE(ended);
+
+    // 流5（u=2）在窗口耗尽时排队；PRIORITY_UPDATE把流1提到u=1，窗口打开后流1先发
+    frames.clear();
+    AppendHttp2Headers(&frames, &encoder, 5, false, "u=2");
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, HTTP2_FLAG_END_STREAM, 5, body.data(), 1000);
+    const char field[] = "u=1, i";
+    std::vector<uint8_t> update = {0x00, 0x00, 0x00, 0x01};
+    update.insert(update.end(), field, field + sizeof(field) - 1);
+    AppendHttp2Frame(&frames, Http2FrameType::PRIORITY_UPDATE, 0, 0, update.data(), update.size());
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(FindHttp2Frame(ConsumeHttp2Frames(&conn.get_write_buffer()), Http2FrameType::DATA, 5), nullptr);
+
+    frames.clear();
+    const uint8_t increment[4] = {0x00, 0x01, 0x00, 0x00};
+    AppendHttp2Frame(&frames, Http2FrameType::WINDOW_UPDATE, 0, 0, increment, sizeof(increment));
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    order.clear();
+    for (const auto& frame : written) {
+        if (frame.type == static_cast<uint8_t>(Http2FrameType::DATA) &&
+            (order.empty() || order.back() != frame.stream_id)) {
+            order.push_back(frame.stream_id);
+        }
+    }
+    EXPECT_EQ(order, std::vector<uint32_t>({1, 5}));
+    EXPECT_EQ(Http2DataBytes(written, 1, &ended), 40000u - (65535u - 40000u));
+    EXPECT_TRUE(ended);
+    EXPECT_EQ(Http2DataBytes(written, 5, &ended), 1000u);
+    EXPECT_TRUE(ended);
+}
+
+TEST_F(Http2HandlerTest, InterleavesIncrementalStreams) {
+    Connection conn(1, -1, 18449);
+    Http2Handler handler;
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    std::vector<uint8_t> frames(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE + HTTP2_CLIENT_PREFACE_LEN);
+    HpackEncoder encoder;
+    const std::vector<uint8_t> body(50000, 'r');
+    AppendHttp2Headers(&frames, &encoder, 1, false, "i");
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, HTTP2_FLAG_END_STREAM, 1, body.data(), body.size());
+    AppendHttp2Headers(&frames, &encoder, 3, false, "u=3, i");
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, HTTP2_FLAG_END_STREAM, 3, body.data(), body.size());
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+
+    // 增量流按帧轮转：1, 3, 1, 3(窗口剩余16383)，而非流1独占窗口
+    std::vector<std::pair<uint32_t, size_t>> data_frames;
+    for (const auto& frame : ConsumeHttp2Frames(&conn.get_write_buffer())) {
+        if (frame.type == static_cast<uint8_t>(Http2FrameType::DATA)) {
+            data_frames.emplace_back(frame.stream_id, frame.payload.size());
+        }
+    }
+    const size_t max_frame = HTTP2_DEFAULT_MAX_FRAME_SIZE;
+    EXPECT_EQ(data_frames, (std::vector<std::pair<uint32_t, size_t>>{
+        {1, max_frame}, {3, max_frame}, {1, max_frame}, {3, 65535u - 3u * max_frame}}));
+
+    // 窗口打开后两个流都发完
+    frames.clear();
+    const uint8_t increment[4] = {0x00, 0x01, 0x00, 0x00};
+    AppendHttp2Frame(&frames, Http2FrameType::WINDOW_UPDATE, 0, 0, increment, sizeof(increment));
+    AppendHttp2Frame(&frames, Http2FrameType::WINDOW_UPDATE, 0, 1, increment, sizeof(increment));
+    AppendHttp2Frame(&frames, Http2FrameType::WINDOW_UPDATE, 0, 3, increment, sizeof(increment));
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    std::vector<WrittenFrame> written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    bool ended = false;
+    EXPECT_EQ(Http2DataBytes(written, 1, &ended), 50000u - 2u * max_frame);
+    EXPECT_TRUE(ended);
+    EXPECT_EQ(Http2DataBytes(written, 3, &ended), 50000u - (65535u - 2u * max_frame));
+    EXPECT_TRUE(ended);
+}
+
+TEST_F(Http2HandlerTest, ReclaimsClosedStreams) {
+    Connection conn(1, -1, 18450);
+    Http2Handler handler;
+    Http2Settings local;
+    local.max_concurrent_streams = 4;
+    handler.set_local_settings(local);
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+    conn.get_read_buffer().write(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE_LEN);
+
+    // 长连接上依次完成1000个流：每批4个流占满并发限制，已关闭的流未回收时下一批会被拒绝
+    HpackEncoder encoder;
+    std::vector<uint8_t> frames;
+    size_t responses = 0;
+    for (uint32_t id = 1; id < 2000; id += 8) {
+        frames.clear();
+        for (uint32_t i = 0; i < 8 && id + i < 2000; i += 2) {
+            AppendHttp2Headers(&frames, &encoder, id + i, true);
+        }
+        conn.get_read_buffer().write(frames.data(), frames.size());
+        ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+        for (const auto& frame : ConsumeHttp2Frames(&conn.get_write_buffer())) {
+            ASSERT_NE(frame.type, static_cast<uint8_t>(Http2FrameType::RST_STREAM));
+            if (frame.type == static_cast<uint8_t>(Http2FrameType::HEADERS)) {
+                responses++;
+            }
+        }
+    }
+    EXPECT_EQ(responses, 1000u);
+}
+
+
+TEST_F(Http2HandlerTest, ResetsRepeatedHeadersOnHalfClosedStream) {
+    Connection conn(1, -1, 18451);
+    Http2Handler handler;
+    std::vector<std::function<void()>> tasks;
+    handler.set_task_dispatcher([&tasks](std::function<void()> task) {
+        tasks.push_back(std::move(task));
+    });
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    // 对端初始窗口为0：响应头部发出后DATA挂起，流停留在半关闭（远端）状态
+    HpackEncoder encoder;
+    std::vector<uint8_t> frames(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE + HTTP2_CLIENT_PREFACE_LEN);
+    const uint8_t zero_window[] = {0x00, 0x04, 0x00, 0x00, 0x00, 0x00};
+    AppendHttp2Frame(&frames, Http2FrameType::SETTINGS, 0, 0, zero_window, sizeof(zero_window));
+    AppendHttp2Headers(&frames, &encoder, 1, true);
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    ASSERT_EQ(tasks.size(), 1u);
+    tasks[0]();
+    ASSERT_EQ(handler.on_callback_done(), PROTOCOL_OK);
+
+    // 同一流再次收到带END_STREAM的头部块：复位该流，不再分发
+    frames.clear();
+    AppendHttp2Headers(&frames, &encoder, 1, true);
+    // 请求尚在工作线程处理时重复的头部块同样复位
+    AppendHttp2Headers(&frames, &encoder, 3, true);
+    AppendHttp2Headers(&frames, &encoder, 3, true);
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(tasks.size(), 2u);
+
+    size_t responses = 0;
+    std::vector<WrittenFrame> written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    for (const auto& frame : written) {
+        if (frame.type == static_cast<uint8_t>(Http2FrameType::HEADERS)) {
+            responses++;
+        }
+    }
+    EXPECT_EQ(responses, 1u);
+    for (uint32_t stream_id : {1u, 3u}) {
+        const WrittenFrame* rst = FindHttp2Frame(written, Http2FrameType::RST_STREAM, stream_id);
+        ASSERT_NE(rst, nullptr);
+        EXPECT_EQ(Http2PayloadUint32(*rst), HTTP2_ERROR_STREAM_CLOSED);
+    }
+
+    // 被复位流的任务完成后不再产生响应
+    tasks[1]();
+    EXPECT_EQ(handler.on_callback_done(), PROTOCOL_OK);
+    EXPECT_EQ(FindHttp2Frame(ConsumeHttp2Frames(&conn.get_write_buffer()),
+                             Http2FrameType::HEADERS, 3), nullptr);
+}
+
+TEST_F(Http2HandlerTest, ClampsHeaderTableSizes) {
+    Connection conn(1, -1, 18452);
+    Http2Handler handler;
+    Http2Settings local;
+    local.header_table_size = 256;
+    handler.set_local_settings(local);
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    // 对端通告极大的表容量，编码器仍只用默认4096字节（表大小更新3f e1 1f）
+    HpackEncoder encoder;
+    std::vector<uint8_t> frames(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE + HTTP2_CLIENT_PREFACE_LEN);
+    const uint8_t huge_table[] = {0x00, 0x01, 0xff, 0xff, 0xff, 0xff};
+    AppendHttp2Frame(&frames, Http2FrameType::SETTINGS, 0, 0, huge_table, sizeof(huge_table));
+    AppendHttp2Headers(&frames, &encoder, 1, true);
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    std::vector<WrittenFrame> written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    const WrittenFrame* headers = FindHttp2Frame(written, Http2FrameType::HEADERS, 1);
+    ASSERT_NE(headers, nullptr);
+    ASSERT_GE(headers->payload.size(), 3u);
+    EXPECT_EQ(headers->payload[0], 0x3f);
+    EXPECT_EQ(headers->payload[1], 0xe1);
+    EXPECT_EQ(headers->payload[2], 0x1f);
+
+    // 解码器按本端通告的256字节校验对端的表大小更新
+    const uint8_t oversized_update[] = {0x3f, 0xe1, 0x1f, 0x82};
+    frames.clear();
+    AppendHttp2Frame(&frames, Http2FrameType::HEADERS, HTTP2_FLAG_END_HEADERS | HTTP2_FLAG_END_STREAM,
+                     3, oversized_update, sizeof(oversized_update));
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    EXPECT_NE(handler.on_read(), PROTOCOL_OK);
+}
+
+#if HAVE_ZLIB
+TEST_F(Http2HandlerTest, FramesSharedCompressedBody) {
+    CompressionCache::instance().clear();
+    Connection conn(1, -1, 18453);
+    Http2Handler handler;
+    CompressionConfig compression;
+    compression.enabled = true;
+    compression.min_size = 64;
+    handler.set_compression_config(compression);
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    // 对端初始窗口只有16字节：共享压缩体跨多次写事件分帧发送
+    HpackEncoder encoder;
+    std::vector<uint8_t> frames(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE + HTTP2_CLIENT_PREFACE_LEN);
+    const uint8_t small_window[] = {0x00, 0x04, 0x00, 0x00, 0x00, 0x10};
+    AppendHttp2Frame(&frames, Http2FrameType::SETTINGS, 0, 0, small_window, sizeof(small_window));
+    std::map<std::string, std::string> headers = {
+        {":method", "POST"}, {":path", "/echo"}, {":scheme", "https"}, {"accept-encoding", "gzip"}};
+    std::vector<uint8_t> block;
+    ASSERT_EQ(encoder.encode(headers, &block), PROTOCOL_OK);
+    AppendHttp2Frame(&frames, Http2FrameType::HEADERS, HTTP2_FLAG_END_HEADERS, 1, block.data(), block.size());
+    const std::string body(1024, 'z');
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, HTTP2_FLAG_END_STREAM, 1,
+                     reinterpret_cast<const uint8_t*>(body.data()), body.size());
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+
+    CompressionCache::Body compressed = CompressionCache::instance().get_or_compress(
+        reinterpret_cast<const uint8_t*>(body.data()), body.size(), ContentEncoding::GZIP,
+        compression.level);
+    ASSERT_NE(compressed, nullptr);
+    ASSERT_GT(compressed->size(), 16u);
+
+    std::vector<WrittenFrame> written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    bool ended = false;
+    EXPECT_EQ(Http2DataBytes(written, 1, &ended), 16u);
+    EXPECT_FALSE(ended);
+
+    // 放开窗口后发出剩余部分，拼接结果与缓存中的压缩体一致
+    std::vector<uint8_t> received;
+    for (const auto& frame : written) {
+        if (frame.type == static_cast<uint8_t>(Http2FrameType::DATA)) {
+            received.insert(received.end(), frame.payload.begin(), frame.payload.end());
+        }
+    }
+    const uint8_t increment[] = {0x00, 0x01, 0x00, 0x00};
+    frames.clear();
+    AppendHttp2Frame(&frames, Http2FrameType::WINDOW_UPDATE, 0, 0, increment, sizeof(increment));
+    AppendHttp2Frame(&frames, Http2FrameType::WINDOW_UPDATE, 0, 1, increment, sizeof(increment));
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    for (const auto& frame : written) {
+        if (frame.type == static_cast<uint8_t>(Http2FrameType::DATA)) {
+            received.insert(received.end(), frame.payload.begin(), frame.payload.end());
+        }
+    }
+    Http2DataBytes(written, 1, &ended);
+    EXPECT_TRUE(ended);
+    EXPECT_EQ(received, *compressed);
+
+    CompressionCache::instance().clear();
+}
+#endif
+
+// 解析并取出输出缓冲区中的完整帧，按流收集DATA负载，返回本次结束的流数
+static size_t ConsumeHttp2Responses(utils::Buffer* out, std::map<uint32_t, std::string>* bodies) {
+    size_t ended = 0;
+    while (out->readable_bytes() >= HTTP2_FRAME_HEADER_SIZE) {
+        const uint8_t* p = out->read_ptr();
+        size_t len = (static_cast<size_t>(p[0]) << 16) | (static_cast<size_t>(p[1]) << 8) | p[2];
+        if (out->readable_bytes() < HTTP2_FRAME_HEADER_SIZE + len) {
+            break;
+        }
+        uint32_t stream_id = ((static_cast<uint32_t>(p[5]) & 0x7F) << 24) |
+                             (static_cast<uint32_t>(p[6]) << 16) |
+                             (static_cast<uint32_t>(p[7]) << 8) | p[8];
+        if (p[3] == static_cast<uint8_t>(Http2FrameType::DATA)) {
+            (*bodies)[stream_id].append(reinterpret_cast<const char*>(p + HTTP2_FRAME_HEADER_SIZE), len);
+            if (p[4] & HTTP2_FLAG_END_STREAM) {
+                ended++;
+            }
+        }
+        out->skip(HTTP2_FRAME_HEADER_SIZE + len);
+    }
+    return ended;
+}
+
+// 构造一个h2c连接的请求批次：前言、SETTINGS与count个带请求体的流
+static std::vector<uint8_t> BuildHttp2Requests(HpackEncoder* encoder, uint32_t count) {
+    std::vector<uint8_t> frames(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE + HTTP2_CLIENT_PREFACE_LEN);
+    AppendHttp2Frame(&frames, Http2FrameType::SETTINGS, 0, 0, nullptr, 0);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t stream_id = 2 * i + 1;
+        AppendHttp2Headers(&frames, encoder, stream_id, false);
+        const std::string body = "stream-" + std::to_string(stream_id);
+        AppendHttp2Frame(&frames, Http2FrameType::DATA, HTTP2_FLAG_END_STREAM, stream_id,
+                         reinterpret_cast<const uint8_t*>(body.data()), body.size());
+    }
+    return frames;
+}
+
+TEST_F(Http2HandlerTest, RoutesOutOfOrderCompletions) {
+    Connection conn(1, -1, 18449);
+    Http2Handler handler;
+    std::vector<std::function<void()>> tasks;
+    handler.set_task_dispatcher([&tasks](std::function<void()> task) {
+        tasks.push_back(std::move(task));
+    });
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    HpackEncoder encoder;
+    std::vector<uint8_t> frames = BuildHttp2Requests(&encoder, 3);
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+
+    // 三个流各自分发，读事件结束时尚无响应
+    ASSERT_EQ(tasks.size(), 3u);
+    std::map<uint32_t, std::string> bodies;
+    EXPECT_EQ(ConsumeHttp2Responses(&conn.get_write_buffer(), &bodies), 0u);
+
+    // 倒序完成，响应仍回到各自的流
+    tasks[2]();
+    EXPECT_EQ(handler.on_callback_done(), PROTOCOL_OK);
+    EXPECT_EQ(ConsumeHttp2Responses(&conn.get_write_buffer(), &bodies), 1u);
+    EXPECT_EQ(bodies[5], "stream-5");
+    tasks[1]();
+    tasks[0]();
+    EXPECT_EQ(handler.on_callback_done(), PROTOCOL_OK);
+    EXPECT_EQ(ConsumeHttp2Responses(&conn.get_write_buffer(), &bodies), 2u);
+    EXPECT_EQ(bodies[1], "stream-1");
+    EXPECT_EQ(bodies[3], "stream-3");
+    EXPECT_EQ(handler.send_response(1, reinterpret_cast<const uint8_t*>("x"), 1), PROTOCOL_ERROR_INVALID);
+}
+
+// 并发流吞吐微基准（仅输出结果），默认不运行，运行方式同DecodeThroughputBenchmark
+TEST_F(Http2HandlerTest, DISABLED_ConcurrentStreamsBenchmark) {
+    const uint32_t kStreams = 100;
+    const int kConnections = 50;
+
+    // 每个连接一次送达100个并发流，等待全部流结束
+    auto run = [&](WorkerPool* pool) {
+        auto start = std::chrono::steady_clock::now();
+        for (int c = 0; c < kConnections; ++c) {
+            Connection conn(1, -1, 18450);
+            Http2Handler handler;
+            if (pool != nullptr) {
+                handler.set_task_dispatcher([pool](std::function<void()> task) {
+                    pool->post_task(std::move(task));
+                });
+            }
+            TlsConfig tls_config;
+            tls_config.plaintext = true;
+            EXPECT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+            HpackEncoder client_encoder;
+            std::vector<uint8_t> frames = BuildHttp2Requests(&client_encoder, kStreams);
+            conn.get_read_buffer().write(frames.data(), frames.size());
+            EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+
+            std::map<uint32_t, std::string> bodies;
+            size_t ended = ConsumeHttp2Responses(&conn.get_write_buffer(), &bodies);
+            while (ended < kStreams) {
+                std::this_thread::yield();
+                EXPECT_EQ(handler.on_callback_done(), PROTOCOL_OK);
+                ended += ConsumeHttp2Responses(&conn.get_write_buffer(), &bodies);
+            }
+            EXPECT_EQ(bodies[2 * kStreams - 1], "stream-" + std::to_string(2 * kStreams - 1));
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return kStreams * kConnections / elapsed.count();
+    };
+    double inline_rps = run(nullptr);
+    WorkerPool pool(4);
+    pool.start();
+    double pool_rps = run(&pool);
+    pool.stop();
+    std::printf("[ BENCH    ] h2 %u streams/conn: inline %.0f req/s, worker pool %.0f req/s\n",
+                kStreams, inline_rps, pool_rps);
+    RecordProperty("inline_rps", static_cast<int>(inline_rps));
+    RecordProperty("worker_pool_rps", static_cast<int>(pool_rps));
+}
+
+TEST_F(Http2HandlerTest, DecodesHeaderBlockAcrossContinuation) {
+    Connection conn(1, -1, 18445);
+    Http2Handler handler;
+    std::vector<std::function<void()>> tasks;
+    handler.set_task_dispatcher([&tasks](std::function<void()> task) {
+        tasks.push_back(std::move(task));
+    });
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    HpackEncoder encoder;
+    std::vector<uint8_t> block;
+    ASSERT_EQ(encoder.encode({{":method", "GET"}, {":path", "/"}, {"priority", "u=0, i"},
+                              {"x-long", std::string(300, 'v')}}, &block), PROTOCOL_OK);
+
+    // HEADERS带填充与优先级字段，头部块在字段中间切成三段
+    std::vector<uint8_t> first = {2};                  // 填充长度
+    first.insert(first.end(), {0, 0, 0, 0, 16});       // 流依赖与权重
+    first.insert(first.end(), block.begin(), block.begin() + 7);
+    first.insert(first.end(), {0, 0});                 // 填充
+    std::vector<uint8_t> frames(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE + HTTP2_CLIENT_PREFACE_LEN);
+    AppendHttp2Frame(&frames, Http2FrameType::HEADERS,
+                     HTTP2_FLAG_END_STREAM | HTTP2_FLAG_PADDED | HTTP2_FLAG_PRIORITY,
+                     1, first.data(), first.size());
+    AppendHttp2Frame(&frames, Http2FrameType::CONTINUATION, 0, 1, block.data() + 7, 100);
+    AppendHttp2Frame(&frames, Http2FrameType::CONTINUATION, HTTP2_FLAG_END_HEADERS, 1,
+                     block.data() + 107, block.size() - 107);
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+
+    // 头部块结束时一次解码，请求已分发，完成后响应回到流1
+    ASSERT_EQ(tasks.size(), 1u);
+    tasks[0]();
+    EXPECT_EQ(handler.on_callback_done(), PROTOCOL_OK);
+    std::vector<WrittenFrame> written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    EXPECT_NE(FindHttp2Frame(written, Http2FrameType::HEADERS, 1), nullptr);
+    bool ended = false;
+    Http2DataBytes(written, 1, &ended);
+    EXPECT_TRUE(ended);
+
+    // 头部块状态已清空，后续独立的HEADERS帧正常处理
+    frames.clear();
+    AppendHttp2Headers(&frames, &encoder, 3, true);
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(tasks.size(), 2u);
+}
+
+TEST_F(Http2HandlerTest, RejectsFrameInsideHeaderBlock) {
+    Connection conn(1, -1, 18445);
+    Http2Handler handler;
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    HpackEncoder encoder;
+    std::vector<uint8_t> block;
+    ASSERT_EQ(encoder.encode({{":method", "GET"}, {":path", "/"}}, &block), PROTOCOL_OK);
+    std::vector<uint8_t> frames(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE + HTTP2_CLIENT_PREFACE_LEN);
+    AppendHttp2Frame(&frames, Http2FrameType::HEADERS, 0, 1, block.data(), block.size());
+    AppendHttp2Frame(&frames, Http2FrameType::DATA, HTTP2_FLAG_END_STREAM, 1, block.data(), 1);
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    EXPECT_EQ(handler.on_read(), PROTOCOL_ERROR_INVALID);
+}
+
+TEST_F(Http2HandlerTest, RejectsInvalidClientPreface) {
+    Connection conn(1, -1, 18445);
+    Http2Handler handler;
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    conn.get_read_buffer().write(std::string("GET / HTTP/1.1\r\nHost: example\r\n\r\n"));
+    EXPECT_EQ(handler.on_read(), PROTOCOL_ERROR_INVALID);
+}
+
+TEST_F(Http2HandlerTest, CoalescesFramesPerReadCycle) {
+    Connection conn(1, -1, 18445);
+    Http2Handler handler;
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+    // 初始SETTINGS排队到首次读事件再写出
+    EXPECT_EQ(conn.get_write_buffer().readable_bytes(), 0u);
+
+    HpackEncoder encoder;
+    std::vector<uint8_t> frames = BuildHttp2Requests(&encoder, 2);
+    const uint8_t ping[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    AppendHttp2Frame(&frames, Http2FrameType::PING, 0, 0, ping, sizeof(ping));
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+
+    // 控制帧与响应帧在同一输出缓冲内按产生顺序排列，读事件结束时全部写出
+    std::vector<std::pair<uint8_t, uint8_t>> written;
+    utils::Buffer& out = conn.get_write_buffer();
+    while (out.readable_bytes() >= HTTP2_FRAME_HEADER_SIZE) {
+        const uint8_t* p = out.read_ptr();
+        size_t len = (static_cast<size_t>(p[0]) << 16) | (static_cast<size_t>(p[1]) << 8) | p[2];
+        ASSERT_GE(out.readable_bytes(), HTTP2_FRAME_HEADER_SIZE + len);
+        written.emplace_back(p[3], p[4]);
+        out.skip(HTTP2_FRAME_HEADER_SIZE + len);
+    }
+    EXPECT_EQ(out.readable_bytes(), 0u);
+    ASSERT_GE(written.size(), 7u);
+    EXPECT_EQ(written[0], std::make_pair(static_cast<uint8_t>(Http2FrameType::SETTINGS),
+                                         static_cast<uint8_t>(0)));
+    EXPECT_EQ(written[1], std::make_pair(static_cast<uint8_t>(Http2FrameType::SETTINGS),
+                                         HTTP2_FLAG_ACK));
+    size_t headers = 0;
+    size_t ended = 0;
+    bool ping_ack = false;
+    for (const auto& frame : written) {
+        if (frame.first == static_cast<uint8_t>(Http2FrameType::HEADERS)) {
+            headers++;
+        } else if (frame.first == static_cast<uint8_t>(Http2FrameType::DATA) &&
+                   (frame.second & HTTP2_FLAG_END_STREAM)) {
+            ended++;
+        } else if (frame.first == static_cast<uint8_t>(Http2FrameType::PING)) {
+            ping_ack = (frame.second & HTTP2_FLAG_ACK) != 0;
+        }
+    }
+    EXPECT_EQ(headers, 2u);
+    EXPECT_EQ(ended, 2u);
+    EXPECT_TRUE(ping_ack);
+}
+
+TEST_F(Http2HandlerTest, GrowsReceiveWindowFromBdpProbe) {
+    Connection conn(1, -1, 18445);
+    Http2Handler handler;
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+    conn.get_write_buffer().clear();
+
+    // 一个RTT内送满64KB窗口
+    HpackEncoder encoder;
+    std::vector<uint8_t> frames(HTTP2_CLIENT_PREFACE, HTTP2_CLIENT_PREFACE + HTTP2_CLIENT_PREFACE_LEN);
+    AppendHttp2Frame(&frames, Http2FrameType::SETTINGS, 0, 0, nullptr, 0);
+    AppendHttp2Headers(&frames, &encoder, 1, false);
+    const std::vector<uint8_t> chunk(16000, 'a');
+    for (int i = 0; i < 4; ++i) {
+        AppendHttp2Frame(&frames, Http2FrameType::DATA, 0, 1, chunk.data(), chunk.size());
+    }
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+
+    size_t probes = 0;
+    for (const auto& frame : ConsumeHttp2Frames(&conn.get_write_buffer())) {
+        if (frame.type == static_cast<uint8_t>(Http2FrameType::PING)) {
+            EXPECT_EQ(frame.flags, 0);
+            EXPECT_EQ(std::memcmp(frame.payload.data(), HTTP2_BDP_PING_DATA, 8), 0);
+            probes++;
+        }
+    }
+    ASSERT_EQ(probes, 1u);
+
+    // 对端自己的PING ACK不参与估计，探测ACK使窗口放大到到达量的2倍
+    const uint8_t other[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    frames.clear();
+    AppendHttp2Frame(&frames, Http2FrameType::PING, HTTP2_FLAG_ACK, 0, other, sizeof(other));
+    AppendHttp2Frame(&frames, Http2FrameType::PING, HTTP2_FLAG_ACK, 0, HTTP2_BDP_PING_DATA, 8);
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    ASSERT_EQ(handler.on_read(), PROTOCOL_OK);
+
+    // 新的初始窗口(128000)经SETTINGS通告，连接级窗口按差值经WINDOW_UPDATE放大
+    const uint32_t grown = 128000;
+    std::vector<WrittenFrame> written = ConsumeHttp2Frames(&conn.get_write_buffer());
+    ASSERT_EQ(written.size(), 2u);
+    EXPECT_EQ(written[0].type, static_cast<uint8_t>(Http2FrameType::SETTINGS));
+    EXPECT_EQ(written[0].payload, std::vector<uint8_t>({0, 4, 0, 0x01, 0xF4, 0x00}));
+    EXPECT_EQ(written[1].type, static_cast<uint8_t>(Http2FrameType::WINDOW_UPDATE));
+    EXPECT_EQ(written[1].stream_id, 0u);
+    EXPECT_EQ(Http2PayloadUint32(written[1]), grown - 65535u);
+
+    // 长度错误的PING是连接错误
+    frames.clear();
+    AppendHttp2Frame(&frames, Http2FrameType::PING, 0, 0, other, 4);
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    EXPECT_EQ(handler.on_read(), PROTOCOL_ERROR_INVALID);
+}
+
+// ==================== NegotiatingHandler测试 ====================
+
+class NegotiatingHandlerTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+#if HAVE_OPENSSL
+
+// 生成自签名测试证书与私钥（RSA 2048或P-256），写入PEM文件
+static bool WriteTestCertificate(const std::string& cert_path, const std::string& key_path, bool ec) {
+    EVP_PKEY_CTX* key_ctx = EVP_PKEY_CTX_new_id(ec ? EVP_PKEY_EC : EVP_PKEY_RSA, nullptr);
+    EVP_PKEY* pkey = nullptr;
+    bool ok = key_ctx != nullptr && EVP_PKEY_keygen_init(key_ctx) == 1 &&
+              (ec ? EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_ctx, NID_X9_62_prime256v1)
+                  : EVP_PKEY_CTX_set_rsa_keygen_bits(key_ctx, 2048)) == 1 &&
+              EVP_PKEY_keygen(key_ctx, &pkey) == 1;
+    EVP_PKEY_CTX_free(key_ctx);
+
+    X509* x509 = ok ? X509_new() : nullptr;
+    if (x509 != nullptr) {
+        X509_set_version(x509, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+        X509_gmtime_adj(X509_getm_notBefore(x509), 0);
+        X509_gmtime_adj(X509_getm_notAfter(x509), 86400);
+        X509_set_pubkey(x509, pkey);
+        X509_NAME* name = X509_get_subject_name(x509);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(x509, name);
+        ok = X509_sign(x509, pkey, EVP_sha256()) > 0;
+    }
+
+    FILE* cert_file = ok ? fopen(cert_path.c_str(), "w") : nullptr;
+    ok = cert_file != nullptr && PEM_write_X509(cert_file, x509) == 1;
+    if (cert_file != nullptr) {
+        fclose(cert_file);
+    }
+    FILE* key_file = ok ? fopen(key_path.c_str(), "w") : nullptr;
+    ok = key_file != nullptr && PEM_write_PrivateKey(key_file, pkey, nullptr, nullptr, 0, nullptr, nullptr) == 1;
+    if (key_file != nullptr) {
+        fclose(key_file);
+    }
+    X509_free(x509);
+    EVP_PKEY_free(pkey);
+    return ok;
+}
+
+// 测试用TLS客户端：经内存BIO与服务端的连接缓冲区交换密文
+class TestTlsClient {
+public:
+    explicit TestTlsClient(const std::string& alpn)
+        : ctx_(SSL_CTX_new(TLS_client_method()))
+        , ssl_(nullptr)
+        , in_(BIO_new(BIO_s_mem()))
+        , out_(BIO_new(BIO_s_mem()))
+    {
+        std::string protos(1, static_cast<char>(alpn.size()));
+        protos += alpn;
+        SSL_CTX_set_alpn_protos(ctx_, reinterpret_cast<const unsigned char*>(protos.data()),
+                                static_cast<unsigned int>(protos.size()));
+        ssl_ = SSL_new(ctx_);
+        SSL_set_bio(ssl_, in_, out_);
+        SSL_set_connect_state(ssl_);
+    }
+
+    ~TestTlsClient() {
+        SSL_free(ssl_);
+        SSL_CTX_free(ctx_);
+    }
+
+    TestTlsClient(const TestTlsClient&) = delete;
+    TestTlsClient& operator=(const TestTlsClient&) = delete;
+
+    // 推进握手，返回待发给服务端的密文
+    std::string flight() {
+        SSL_do_handshake(ssl_);
+        return drain();
+    }
+
+    // 加密应用数据，返回待发给服务端的密文（握手未完成时连同握手消息）
+    std::string write(const std::string& data) {
+        SSL_write(ssl_, data.data(), static_cast<int>(data.size()));
+        return drain();
+    }
+
+    // 取走服务端写出的全部密文
+    void receive(utils::Buffer* from_server) {
+        BIO_write(in_, from_server->read_ptr(), static_cast<int>(from_server->readable_bytes()));
+        from_server->clear();
+    }
+
+    // 解密已收到的应用数据
+    std::string read() {
+        std::string plain;
+        char buf[4096];
+        int n = 0;
+        while ((n = SSL_read(ssl_, buf, sizeof(buf))) > 0) {
+            plain.append(buf, static_cast<size_t>(n));
+        }
+        return plain;
+    }
+
+private:
+    std::string drain() {
+        std::string cipher;
+        char buf[4096];
+        int n = 0;
+        while ((n = BIO_read(out_, buf, sizeof(buf))) > 0) {
+            cipher.append(buf, static_cast<size_t>(n));
+        }
+        return cipher;
+    }
+
+    SSL_CTX* ctx_;
+    SSL* ssl_;
+    BIO* in_;   // 服务端到客户端，由ssl_持有
+    BIO* out_;  // 客户端到服务端，由ssl_持有
+};
+
+// 真实握手使用的服务端证书（进程内只生成一次）
+static CertConfig TestServerCertConfig() {
+    static const bool generated = WriteTestCertificate("/tmp/test_protocol_server.pem",
+                                                       "/tmp/test_protocol_server.key", false);
+    CertConfig cert_config;
+    if (generated) {
+        cert_config.cert_path = "/tmp/test_protocol_server.pem";
+        cert_config.key_path = "/tmp/test_protocol_server.key";
+    }
+    return cert_config;
+}
+
+TEST_F(NegotiatingHandlerTest, SelectsProtocolAfterHandshake) {
+    Connection conn(1, -1, 18446);
+    NegotiatingHandler handler;
+    CertConfig cert_config = TestServerCertConfig();
+    ASSERT_FALSE(cert_config.cert_path.empty());
+    TlsConfig tls_config;
+    tls_config.alpn_protocols = ALPN_HTTP2_HTTP11;
+    ASSERT_EQ(handler.init(&conn, cert_config, tls_config), PROTOCOL_OK);
+    TlsHandler* tls = handler.get_tls_handler();
+    ASSERT_NE(tls, nullptr);
+    EXPECT_EQ(handler.get_protocol_type(), ProtocolType::UNKNOWN);
+    EXPECT_EQ(handler.get_selected_handler(), nullptr);
+    EXPECT_EQ(handler.send_response(reinterpret_cast<const uint8_t*>("x"), 1), PROTOCOL_ERROR_INVALID);
+
+    // 客户端Finished到达前握手未完成，不选择协议
+    TestTlsClient client("h2");
+    conn.get_read_buffer().write(client.flight());
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_FALSE(tls->is_handshake_done());
+    EXPECT_EQ(handler.get_protocol_type(), ProtocolType::UNKNOWN);
+
+    // 握手完成后按ALPN选择处理器，TLS处理器原样移交
+    client.receive(&conn.get_write_buffer());
+    conn.get_read_buffer().write(client.flight());
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_TRUE(tls->is_handshake_done());
+    EXPECT_EQ(handler.get_protocol_type(), ProtocolType::HTTP_2);
+    ASSERT_NE(handler.get_selected_handler(), nullptr);
+    EXPECT_EQ(handler.get_tls_handler(), tls);
+
+    // 选定的HTTP/2处理器在握手完成后写出初始SETTINGS
+    client.receive(&conn.get_write_buffer());
+    const std::string plain = client.read();
+    ASSERT_GE(plain.size(), HTTP2_FRAME_HEADER_SIZE);
+    EXPECT_EQ(static_cast<uint8_t>(plain[3]), static_cast<uint8_t>(Http2FrameType::SETTINGS));
+}
+
+TEST_F(NegotiatingHandlerTest, OffloadsHandshakeToDispatcher) {
+    Connection conn(1, -1, 18448);
+    NegotiatingHandler handler;
+    std::vector<std::function<void()>> tasks;
+    handler.set_handshake_dispatcher([&tasks](std::function<void()> task) {
+        tasks.push_back(std::move(task));
+    });
+    CertConfig cert_config = TestServerCertConfig();
+    ASSERT_FALSE(cert_config.cert_path.empty());
+    ASSERT_EQ(handler.init(&conn, cert_config, TlsConfig()), PROTOCOL_OK);
+    TlsHandler* tls = handler.get_tls_handler();
+    ASSERT_NE(tls, nullptr);
+
+    // 没有密文时不分发
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_TRUE(tasks.empty());
+
+    // 密文随TLS处理器移入任务，在途期间IO线程不持有TLS处理器
+    TestTlsClient client("http/1.1");
+    const std::string client_hello = client.flight();
+    conn.get_read_buffer().write(client_hello.substr(0, 5));
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    ASSERT_EQ(tasks.size(), 1u);
+    EXPECT_TRUE(handler.is_handshake_in_flight());
+    EXPECT_EQ(conn.get_read_buffer().readable_bytes(), 0u);
+    EXPECT_EQ(handler.get_tls_handler(), nullptr);
+
+    // 在途期间新到的数据留在连接缓冲区；任务未完成时回调完成事件不收回任务
+    conn.get_read_buffer().write(client_hello.substr(5));
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(handler.on_callback_done(), PROTOCOL_OK);
+    EXPECT_EQ(tasks.size(), 1u);
+    EXPECT_TRUE(handler.is_handshake_in_flight());
+
+    // 任务收回后，在途期间新到的数据接着分发给握手线程
+    tasks[0]();
+    EXPECT_EQ(handler.on_callback_done(), PROTOCOL_OK);
+    ASSERT_EQ(tasks.size(), 2u);
+    tasks[1]();
+    EXPECT_EQ(handler.on_callback_done(), PROTOCOL_OK);
+    EXPECT_FALSE(handler.is_handshake_in_flight());
+    EXPECT_EQ(handler.get_tls_handler(), tls);
+    EXPECT_FALSE(tls->is_handshake_done());
+
+    // 客户端Finished与请求一起到达：握手未消费的请求在握手完成后由选定的处理器处理
+    client.receive(&conn.get_write_buffer());
+    conn.get_read_buffer().write(client.write("GET / HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    ASSERT_EQ(tasks.size(), 3u);
+    tasks[2]();
+    EXPECT_EQ(handler.on_callback_done(), PROTOCOL_OK);
+    EXPECT_TRUE(tls->is_handshake_done());
+    EXPECT_EQ(handler.get_protocol_type(), ProtocolType::HTTP_1_1);
+    EXPECT_EQ(handler.get_tls_handler(), tls);
+
+    client.receive(&conn.get_write_buffer());
+    EXPECT_EQ(client.read().compare(0, 9, "HTTP/1.1 "), 0);
+}
+
+#else
+
+TEST_F(NegotiatingHandlerTest, SelectsProtocolAfterHandshake) {
+    Connection conn(1, -1, 18446);
+    NegotiatingHandler handler;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), TlsConfig()), PROTOCOL_OK);
+    TlsHandler* tls = handler.get_tls_handler();
+    ASSERT_NE(tls, nullptr);
+    EXPECT_EQ(handler.get_protocol_type(), ProtocolType::UNKNOWN);
+    EXPECT_EQ(handler.get_selected_handler(), nullptr);
+    EXPECT_EQ(handler.send_response(reinterpret_cast<const uint8_t*>("x"), 1), PROTOCOL_ERROR_INVALID);
+
+    // 握手完成后按ALPN（桩实现为http/1.1）选择处理器，TLS处理器原样移交
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_TRUE(tls->is_handshake_done());
+    EXPECT_EQ(handler.get_protocol_type(), ProtocolType::HTTP_1_1);
+    ASSERT_NE(handler.get_selected_handler(), nullptr);
+    EXPECT_EQ(handler.get_tls_handler(), tls);
+}
+
+TEST_F(NegotiatingHandlerTest, OffloadsHandshakeToDispatcher) {
+    Connection conn(1, -1, 18448);
+    NegotiatingHandler handler;
+    std::vector<std::function<void()>> tasks;
+    handler.set_handshake_dispatcher([&tasks](std::function<void()> task) {
+        tasks.push_back(std::move(task));
+    });
+    ASSERT_EQ(handler.init(&conn, CertConfig(), TlsConfig()), PROTOCOL_OK);
+    TlsHandler* tls = handler.get_tls_handler();
+    ASSERT_NE(tls, nullptr);
+
+    // 没有密文时不分发
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_TRUE(tasks.empty());
+
+    // 密文随TLS处理器移入任务，在途期间IO线程不持有TLS处理器
+    conn.get_read_buffer().write(std::string("hello"));
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    ASSERT_EQ(tasks.size(), 1u);
+    EXPECT_TRUE(handler.is_handshake_in_flight());
+    EXPECT_EQ(conn.get_read_buffer().readable_bytes(), 0u);
+    EXPECT_EQ(handler.get_tls_handler(), nullptr);
+
+    // 在途期间新到的数据留在连接缓冲区；任务未完成时回调完成事件不收回任务
+    conn.get_read_buffer().write(std::string(" world"));
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(handler.on_callback_done(), PROTOCOL_OK);
+    EXPECT_EQ(tasks.size(), 1u);
+    EXPECT_TRUE(handler.is_handshake_in_flight());
+
+    // 握手线程完成后收回TLS处理器并选择协议
+    tasks[0]();
+    EXPECT_EQ(handler.on_callback_done(), PROTOCOL_OK);
+    EXPECT_FALSE(handler.is_handshake_in_flight());
+    EXPECT_TRUE(tls->is_handshake_done());
+    EXPECT_EQ(handler.get_protocol_type(), ProtocolType::HTTP_1_1);
+    EXPECT_EQ(handler.get_tls_handler(), tls);
+
+    // 握手未消费的数据排在在途期间新到的数据之前
+    const utils::Buffer& read_buffer = conn.get_read_buffer();
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(read_buffer.read_ptr()), read_buffer.readable_bytes()),
+              "hello world");
+}
+
+#endif // HAVE_OPENSSL
+
+TEST_F(NegotiatingHandlerTest, SelectsH2cByPriorKnowledge) {
+    Connection conn(1, -1, 18447);
+    NegotiatingHandler handler;
+    handler.set_allow_h2c(true);
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    // 前言不完整时继续等待
+    conn.get_read_buffer().write(HTTP2_CLIENT_PREFACE, 10);
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(handler.get_protocol_type(), ProtocolType::UNKNOWN);
+
+    std::vector<uint8_t> frames;
+    AppendHttp2Frame(&frames, Http2FrameType::SETTINGS, 0, 0, nullptr, 0);
+    conn.get_read_buffer().write(HTTP2_CLIENT_PREFACE + 10, HTTP2_CLIENT_PREFACE_LEN - 10);
+    conn.get_read_buffer().write(frames.data(), frames.size());
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(handler.get_protocol_type(), ProtocolType::HTTP_2);
+    EXPECT_EQ(conn.get_read_buffer().readable_bytes(), 0u);
+
+    // 明文输出：服务端SETTINGS之后是对客户端SETTINGS的ACK
+    const utils::Buffer& out = conn.get_write_buffer();
+    ASSERT_GE(out.readable_bytes(), HTTP2_FRAME_HEADER_SIZE * 2);
+    EXPECT_EQ(out.read_ptr()[3], static_cast<uint8_t>(Http2FrameType::SETTINGS));
+    const uint8_t* ack = out.read_ptr() + out.readable_bytes() - HTTP2_FRAME_HEADER_SIZE;
+    EXPECT_EQ(ack[3], static_cast<uint8_t>(Http2FrameType::SETTINGS));
+    EXPECT_EQ(ack[4], HTTP2_FLAG_ACK);
+}
+
+TEST_F(NegotiatingHandlerTest, PlaintextFallsBackToHttp1) {
+    Connection conn(1, -1, 18448);
+    NegotiatingHandler handler;
+    handler.set_allow_h2c(true);
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(&conn, CertConfig(), tls_config), PROTOCOL_OK);
+
+    conn.get_read_buffer().write(std::string("GET / HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(handler.on_read(), PROTOCOL_OK);
+    EXPECT_EQ(handler.get_protocol_type(), ProtocolType::HTTP_1_1);
+
+    const utils::Buffer& out = conn.get_write_buffer();
+    ASSERT_GT(out.readable_bytes(), 9u);
+    EXPECT_EQ(std::memcmp(out.read_ptr(), "HTTP/1.1 ", 9), 0);
+}
+
 // ==================== TlsHandler测试 ====================
 
 class TlsHandlerTest : public ::testing::Test {
@@ -521,6 +2686,110 @@ TEST_F(TlsHandlerTest, SetGetError) {
     EXPECT_EQ(handler.get_error_msg(), "Test error");
 }
 
+TEST_F(TlsHandlerTest, WritevNotInitialized) {
+    TlsHandler handler;
+    uint8_t data[4] = {0};
+    IoSlice slices[1] = {{data, sizeof(data)}};
+    size_t written = 0;
+    EXPECT_EQ(handler.writev(slices, 1, &written), PROTOCOL_ERROR_INVALID);
+}
+
+TEST_F(TlsHandlerTest, KtlsDisabledByDefault) {
+    TlsHandler handler;
+    EXPECT_FALSE(handler.is_ktls_tx_enabled());
+    EXPECT_FALSE(handler.is_ktls_rx_enabled());
+    EXPECT_FALSE(handler.is_socket_io());
+}
+
+TEST_F(TlsHandlerTest, SendFileNotInitialized) {
+    TlsHandler handler;
+    size_t written = 0;
+    EXPECT_EQ(handler.send_file(0, 0, 1, &written), PROTOCOL_ERROR_INVALID);
+}
+
+#if !HAVE_OPENSSL
+TEST_F(TlsHandlerTest, SendFileFallbackReadsRange) {
+    FILE* fp = tmpfile();
+    ASSERT_NE(fp, nullptr);
+    fputs("hello world", fp);
+    fflush(fp);
+
+    TlsHandler handler;
+    TlsConfig tls_config;
+    tls_config.enable_ktls = true;  // 无OpenSSL时请求kTLS也应回退
+    ASSERT_EQ(handler.init(nullptr, CertConfig(), tls_config), PROTOCOL_OK);
+    EXPECT_FALSE(handler.is_socket_io());
+
+    size_t written = 0;
+    EXPECT_EQ(handler.send_file(fileno(fp), 6, 5, &written), PROTOCOL_OK);
+    EXPECT_EQ(written, 5u);
+    EXPECT_EQ(handler.send_file(fileno(fp), 6, 64, &written), PROTOCOL_ERROR_INVALID);
+    fclose(fp);
+}
+#endif
+
+TEST_F(TlsHandlerTest, RecordSizeRampDisabled) {
+    TlsHandler handler;
+    EXPECT_EQ(handler.get_record_size(), TLS_SMALL_RECORD_SIZE);
+
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    tls_config.record_ramp_bytes = 0;
+    ASSERT_EQ(handler.init(nullptr, CertConfig(), tls_config), PROTOCOL_OK);
+    EXPECT_EQ(handler.get_record_size(), TLS_MAX_RECORD_SIZE);
+    EXPECT_EQ(handler.get_pending_bytes(), 0u);
+    EXPECT_EQ(handler.flush_pending(), PROTOCOL_OK);
+}
+
+#if !HAVE_OPENSSL
+TEST_F(TlsHandlerTest, RecordSizeRampsUpAndResetsAfterIdle) {
+    TlsHandler handler;
+    TlsConfig tls_config;
+    tls_config.record_ramp_bytes = 4096;
+    tls_config.record_idle_ms = 20;
+    ASSERT_EQ(handler.init(nullptr, CertConfig(), tls_config), PROTOCOL_OK);
+    EXPECT_EQ(handler.get_record_size(), TLS_SMALL_RECORD_SIZE);
+
+    // 累计发送达到阈值后切换为最大记录
+    std::vector<uint8_t> data(4096, 'a');
+    size_t written = 0;
+    ASSERT_EQ(handler.write(data.data(), 4000, &written), PROTOCOL_OK);
+    EXPECT_EQ(handler.get_record_size(), TLS_SMALL_RECORD_SIZE);
+    IoSlice slices[1] = {{data.data(), 96}};
+    ASSERT_EQ(handler.writev(slices, 1, &written), PROTOCOL_OK);
+    EXPECT_EQ(handler.get_record_size(), TLS_MAX_RECORD_SIZE);
+
+    // 空闲后回到小记录，重新累计
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    EXPECT_EQ(handler.get_record_size(), TLS_SMALL_RECORD_SIZE);
+    ASSERT_EQ(handler.write(data.data(), 1, &written), PROTOCOL_OK);
+    EXPECT_EQ(handler.get_record_size(), TLS_SMALL_RECORD_SIZE);
+}
+#endif
+
+TEST_F(TlsHandlerTest, ReadIntoAppendsToDestination) {
+    utils::Buffer read_buffer;
+    utils::Buffer plaintext;
+    TlsHandler handler;
+    TlsConfig tls_config;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(nullptr, CertConfig(), tls_config), PROTOCOL_OK);
+    handler.set_read_buffer(&read_buffer);
+
+    size_t read_len = 0;
+    EXPECT_EQ(handler.read_into(&plaintext, &read_len), PROTOCOL_ERROR_EAGAIN);
+    EXPECT_EQ(handler.read_into(nullptr, &read_len), PROTOCOL_ERROR_INVALID);
+
+    // 已有数据之后追加，连接读缓冲区被整体消费
+    plaintext.write(std::string("GET "));
+    read_buffer.write(std::string("/ HTTP/1.1\r\n"));
+    ASSERT_EQ(handler.read_into(&plaintext, &read_len), PROTOCOL_OK);
+    EXPECT_EQ(read_len, 12u);
+    EXPECT_EQ(read_buffer.readable_bytes(), 0u);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(plaintext.read_ptr()), plaintext.readable_bytes()),
+              "GET / HTTP/1.1\r\n");
+}
+
 TEST_F(TlsHandlerTest, Reset) {
     TlsHandler handler;
     handler.set_error(-10, "Test error");
@@ -528,6 +2797,305 @@ TEST_F(TlsHandlerTest, Reset) {
     EXPECT_EQ(handler.get_error_code(), 0);
 }
 
+TEST_F(TlsHandlerTest, SharesListenerContext) {
+    config::Config config;
+    config::ListenConfig tls_listen;
+    tls_listen.port = 8443;
+    config::ListenConfig plain_listen;
+    plain_listen.port = 8080;
+    plain_listen.tls_enabled = false;
+    config.set_listens({tls_listen, plain_listen});
+
+    // 每个TLS监听端口一个上下文，明文端口不构建
+    ASSERT_EQ(TlsContextManager::instance().build(config), PROTOCOL_OK);
+    std::shared_ptr<TlsContext> context = TlsContextManager::instance().get(8443);
+    ASSERT_NE(context, nullptr);
+    EXPECT_EQ(TlsContextManager::instance().get(8080), nullptr);
+    EXPECT_EQ(context->get_alpn_protocols(), ALPN_HTTP2_HTTP11);
+
+    TlsConfig tls_config;
+    ConfigConverter::convert_tls_config(config, 8443, tls_config);
+    EXPECT_EQ(tls_config.context, context);
+    {
+        TlsHandler first;
+        TlsHandler second;
+        ASSERT_EQ(first.init(nullptr, CertConfig(), tls_config), PROTOCOL_OK);
+        ASSERT_EQ(second.init(nullptr, CertConfig(), tls_config), PROTOCOL_OK);
+        // 管理器、本地变量、tls_config与两个连接各持有一个引用
+        EXPECT_EQ(context.use_count(), 5);
+    }
+
+    // 连接关闭只释放各自的引用，上下文由管理器继续持有
+    EXPECT_EQ(context.use_count(), 3);
+    TlsContextManager::instance().clear();
+    EXPECT_EQ(context.use_count(), 2);
+}
+
+TEST_F(TlsHandlerTest, ReloadSwapsContextAndKeepsSessions) {
+    config::Config config;
+    config::ListenConfig tls_listen;
+    tls_listen.port = 8443;
+    config.set_listens({tls_listen});
+
+    ASSERT_EQ(TlsContextManager::instance().build(config), PROTOCOL_OK);
+    uint64_t generation = TlsContextManager::instance().get_generation();
+    std::shared_ptr<TlsContext> old_context = TlsContextManager::instance().get(8443);
+    ASSERT_NE(old_context, nullptr);
+
+    // 热加载：新连接取到新上下文，旧连接持有的上下文不受影响，会话状态被继承
+    ASSERT_EQ(TlsContextManager::instance().build(config), PROTOCOL_OK);
+    std::shared_ptr<TlsContext> new_context = TlsContextManager::instance().get(8443);
+    ASSERT_NE(new_context, nullptr);
+    EXPECT_NE(new_context, old_context);
+    EXPECT_EQ(old_context.use_count(), 1);
+    EXPECT_EQ(TlsContextManager::instance().get_generation(), generation + 1);
+    EXPECT_EQ(new_context->get_session_cache(), old_context->get_session_cache());
+    EXPECT_EQ(new_context->get_ticket_keys(), old_context->get_ticket_keys());
+
+    // 新证书构建失败时继续使用原有上下文
+    config::CertificatesConfig certs;
+    config::ServerNameConfig name;
+    name.server_name = "a.example.com";
+    name.cert_path = "/path/to/a.pem";
+    name.key_path = "/path/to/a.key";
+    certs.server_names = {name, name};
+    config.set_certificates(certs);
+    EXPECT_NE(TlsContextManager::instance().build(config), PROTOCOL_OK);
+    EXPECT_EQ(TlsContextManager::instance().get(8443), new_context);
+    EXPECT_EQ(TlsContextManager::instance().get_generation(), generation + 1);
+
+    TlsContextManager::instance().clear();
+    EXPECT_EQ(TlsContextManager::instance().get(8443), nullptr);
+}
+
+// ==================== TLS会话复用测试 ====================
+
+class TlsSessionCacheTest : public ::testing::Test {
+protected:
+    // 找出与first落在同一分片的另一个会话ID
+    static std::string SameShardId(const std::string& first, int seed) {
+        size_t shard = std::hash<std::string>()(first) % TLS_SESSION_CACHE_SHARDS;
+        for (int i = seed;; ++i) {
+            std::string id = "session-" + std::to_string(i);
+            if (id != first && std::hash<std::string>()(id) % TLS_SESSION_CACHE_SHARDS == shard) {
+                return id;
+            }
+        }
+    }
+
+    static const uint8_t* Bytes(const std::string& id) {
+        return reinterpret_cast<const uint8_t*>(id.data());
+    }
+};
+
+TEST_F(TlsSessionCacheTest, StoresAndExpiresSessions) {
+    TlsSessionCache cache(1024, 300);
+    std::string id = "session-id";
+    cache.put(Bytes(id), id.size(), {1, 2, 3}, 1000);
+
+    std::vector<uint8_t> session;
+    ASSERT_TRUE(cache.get(Bytes(id), id.size(), 1299, &session));
+    EXPECT_EQ(session, std::vector<uint8_t>({1, 2, 3}));
+
+    // 到期后查找即删除
+    EXPECT_FALSE(cache.get(Bytes(id), id.size(), 1300, &session));
+    EXPECT_EQ(cache.size(), 0u);
+
+    cache.put(Bytes(id), id.size(), {4}, 2000);
+    cache.remove(Bytes(id), id.size());
+    EXPECT_FALSE(cache.get(Bytes(id), id.size(), 2000, &session));
+
+    // 容量为0时不缓存
+    TlsSessionCache disabled(0, 300);
+    disabled.put(Bytes(id), id.size(), {1}, 0);
+    EXPECT_FALSE(disabled.get(Bytes(id), id.size(), 0, &session));
+}
+
+TEST_F(TlsSessionCacheTest, EvictsLeastRecentlyUsedPerShard) {
+    // 每片容量2
+    TlsSessionCache cache(TLS_SESSION_CACHE_SHARDS * 2, 300);
+    std::string a = "session-a";
+    std::string b = SameShardId(a, 0);
+    std::string c = SameShardId(a, std::stoi(b.substr(8)) + 1);
+
+    std::vector<uint8_t> session;
+    cache.put(Bytes(a), a.size(), {'a'}, 0);
+    cache.put(Bytes(b), b.size(), {'b'}, 0);
+    ASSERT_TRUE(cache.get(Bytes(a), a.size(), 0, &session));
+    cache.put(Bytes(c), c.size(), {'c'}, 0);
+
+    // b最久未用被淘汰，a因刚被访问而保留
+    EXPECT_FALSE(cache.get(Bytes(b), b.size(), 0, &session));
+    EXPECT_TRUE(cache.get(Bytes(a), a.size(), 0, &session));
+    EXPECT_TRUE(cache.get(Bytes(c), c.size(), 0, &session));
+
+    // 其他分片不受影响，总量受容量约束
+    for (int i = 0; i < 1000; ++i) {
+        std::string id = "bulk-" + std::to_string(i);
+        cache.put(Bytes(id), id.size(), {0}, 0);
+    }
+    EXPECT_LE(cache.size(), TLS_SESSION_CACHE_SHARDS * 2);
+}
+
+TEST_F(TlsSessionCacheTest, RotatesTicketKeys) {
+    TlsTicketKeys keys(3600);
+    TlsTicketKey first;
+    ASSERT_TRUE(keys.encrypt_key(0, &first));
+
+    // 轮换周期内复用同一密钥
+    TlsTicketKey key;
+    ASSERT_TRUE(keys.encrypt_key(3599, &key));
+    EXPECT_EQ(memcmp(key.name, first.name, TLS_TICKET_KEY_NAME_SIZE), 0);
+
+    // 到期生成新密钥，旧密钥只用于解密
+    ASSERT_TRUE(keys.encrypt_key(3600, &key));
+    EXPECT_NE(memcmp(key.name, first.name, TLS_TICKET_KEY_NAME_SIZE), 0);
+    bool current = true;
+    ASSERT_TRUE(keys.decrypt_key(first.name, &key, &current));
+    EXPECT_FALSE(current);
+    EXPECT_EQ(memcmp(key.aes_key, first.aes_key, TLS_TICKET_AES_KEY_SIZE), 0);
+
+    // 超过保留代数后旧密钥被丢弃
+    for (uint64_t i = 2; i <= TLS_TICKET_RETIRED_KEYS + 1; ++i) {
+        ASSERT_TRUE(keys.encrypt_key(3600 * i, &key));
+    }
+    EXPECT_EQ(keys.size(), TLS_TICKET_RETIRED_KEYS + 1);
+    EXPECT_FALSE(keys.decrypt_key(first.name, &key, &current));
+    ASSERT_TRUE(keys.encrypt_key(3600 * (TLS_TICKET_RETIRED_KEYS + 1), &first));
+    ASSERT_TRUE(keys.decrypt_key(first.name, &key, &current));
+    EXPECT_TRUE(current);
+}
+
+TEST_F(TlsSessionCacheTest, ContextOwnsResumptionState) {
+    TlsConfig tls_config;
+    TlsContext context;
+    ASSERT_EQ(context.init(CertConfig(), tls_config), PROTOCOL_OK);
+    EXPECT_NE(context.get_session_cache(), nullptr);
+
+    tls_config.session_cache_size = 0;
+    tls_config.session_tickets = false;
+    TlsContext disabled;
+    ASSERT_EQ(disabled.init(CertConfig(), tls_config), PROTOCOL_OK);
+    EXPECT_EQ(disabled.get_session_cache(), nullptr);
+    EXPECT_EQ(disabled.get_ticket_keys(), nullptr);
+    EXPECT_EQ(context.get_anti_replay(), nullptr);
+}
+
+TEST_F(TlsSessionCacheTest, RejectsReplayedClientHello) {
+    TlsAntiReplay filter(10, 3);
+    std::string a(32, 'a');
+    std::string b(32, 'b');
+    EXPECT_TRUE(filter.check(Bytes(a), a.size(), 100));
+    EXPECT_FALSE(filter.check(Bytes(a), a.size(), 105));
+
+    // 轮换为上一桶后仍能识别，两个窗口后整体过期
+    EXPECT_TRUE(filter.check(Bytes(b), b.size(), 112));
+    EXPECT_FALSE(filter.check(Bytes(a), a.size(), 112));
+    EXPECT_FALSE(filter.check(Bytes(b), b.size(), 121));
+    EXPECT_TRUE(filter.check(Bytes(a), a.size(), 140));
+    EXPECT_EQ(filter.size(), 1u);
+
+    // 记录数达到上限时拒绝新的早期数据
+    std::string c(32, 'c');
+    std::string d(32, 'd');
+    EXPECT_TRUE(filter.check(Bytes(b), b.size(), 141));
+    EXPECT_TRUE(filter.check(Bytes(c), c.size(), 141));
+    EXPECT_FALSE(filter.check(Bytes(d), d.size(), 141));
+    EXPECT_FALSE(filter.check(nullptr, 0, 141));
+}
+
+TEST_F(TlsSessionCacheTest, EarlyDataMethodsAndContext) {
+    TlsConfig tls_config;
+    tls_config.early_data = true;
+    TlsContext context;
+    ASSERT_EQ(context.init(CertConfig(), tls_config), PROTOCOL_OK);
+    EXPECT_NE(context.get_anti_replay(), nullptr);
+
+    // 明文端口不会进入0-RTT阶段，方法列表仍按配置解析
+    TlsHandler handler;
+    tls_config.plaintext = true;
+    tls_config.early_data_methods = " GET , HEAD";
+    ASSERT_EQ(handler.init(nullptr, CertConfig(), tls_config), PROTOCOL_OK);
+    EXPECT_FALSE(handler.is_early_data());
+    EXPECT_FALSE(handler.has_early_data());
+    EXPECT_TRUE(handler.is_early_data_method("GET"));
+    EXPECT_TRUE(handler.is_early_data_method("HEAD"));
+    EXPECT_FALSE(handler.is_early_data_method("POST"));
+    EXPECT_FALSE(handler.is_early_data_method("GE"));
+    EXPECT_FALSE(handler.is_early_data_method(""));
+}
+
+TEST_F(TlsSessionCacheTest, CertCompressionNeedsCertificate) {
+    // 没有证书链时无内容可压缩，握手按未压缩处理
+    TlsConfig tls_config;
+    TlsContext context;
+    ASSERT_EQ(context.init(CertConfig(), tls_config), PROTOCOL_OK);
+    EXPECT_FALSE(context.is_cert_compressed());
+
+    // 明文端口不做握手，往返计数保持为0
+    TlsHandler handler;
+    tls_config.plaintext = true;
+    ASSERT_EQ(handler.init(nullptr, CertConfig(), tls_config), PROTOCOL_OK);
+    EXPECT_EQ(handler.continue_handshake(), PROTOCOL_OK);
+    EXPECT_EQ(handler.get_handshake_round_trips(), 0u);
+}
+
+TEST_F(TlsSessionCacheTest, SelectsServerNameCertificate) {
+#if HAVE_OPENSSL
+    // 真实构建需要可加载的证书：生成RSA与ECDSA证书各一张，SM2位置复用ECDSA证书
+    const std::string rsa_cert = "/tmp/test_protocol_sni_rsa.pem";
+    const std::string rsa_key = "/tmp/test_protocol_sni_rsa.key";
+    const std::string ec_cert = "/tmp/test_protocol_sni_ec.pem";
+    const std::string ec_key = "/tmp/test_protocol_sni_ec.key";
+    ASSERT_TRUE(WriteTestCertificate(rsa_cert, rsa_key, false));
+    ASSERT_TRUE(WriteTestCertificate(ec_cert, ec_key, true));
+#else
+    const std::string rsa_cert = "/path/to/rsa.pem";
+    const std::string rsa_key = "/path/to/rsa.key";
+    const std::string ec_cert = "/path/to/ec.pem";
+    const std::string ec_key = "/path/to/ec.key";
+#endif
+    CertConfig cert_config;
+    ServerNameCert dual;
+    dual.server_name = "Api.Example.com.";
+    dual.cert_path = rsa_cert;
+    dual.key_path = rsa_key;
+    dual.ecdsa_cert_path = ec_cert;
+    dual.ecdsa_key_path = ec_key;
+    ServerNameCert wildcard;
+    wildcard.server_name = "*.example.org";
+    wildcard.cert_path = rsa_cert;
+    wildcard.key_path = rsa_key;
+    wildcard.sm2_cert_path = ec_cert;
+    wildcard.sm2_key_path = ec_key;
+    cert_config.server_names = {dual, wildcard};
+
+    TlsContext context;
+    ASSERT_EQ(context.init(cert_config, TlsConfig()), PROTOCOL_OK);
+    EXPECT_EQ(context.get_server_name_count(), 2u);
+
+    // 客户端支持ECDSA时优先ECDSA证书，否则回落到RSA；主机名不区分大小写
+    TlsContext* ec = context.select_server_name("api.example.com", true, false);
+    TlsContext* rsa = context.select_server_name("API.EXAMPLE.COM", false, false);
+    ASSERT_NE(ec, nullptr);
+    ASSERT_NE(rsa, nullptr);
+    EXPECT_NE(ec, rsa);
+    EXPECT_EQ(context.select_server_name("api.example.com", true, true), ec);
+
+    // 通配只匹配一级子域名；未配置ECDSA时ECDSA客户端拿到RSA证书
+    TlsContext* org = context.select_server_name("www.example.org", true, false);
+    ASSERT_NE(org, nullptr);
+    EXPECT_NE(context.select_server_name("www.example.org", false, true), org);
+    EXPECT_EQ(context.select_server_name("a.www.example.org", true, false), nullptr);
+    EXPECT_EQ(context.select_server_name("example.org", true, false), nullptr);
+    EXPECT_EQ(context.select_server_name("", true, false), nullptr);
+
+    // 重复的主机名在构建时拒绝
+    cert_config.server_names.push_back(dual);
+    TlsContext duplicated;
+    EXPECT_EQ(duplicated.init(cert_config, TlsConfig()), PROTOCOL_ERROR_INVALID);
+}
+
 // ==================== 国密证书测试 ====================
 
 class GmsslCertTest : public ::testing::Test {
@@ -598,6 +3166,25 @@ TEST_F(ConfigConverterTest, ConvertCertConfigBasic) {
     EXPECT_FALSE(dst.use_gmssl);
 }
 
+TEST_F(ConfigConverterTest, ConvertCertConfigServerNames) {
+    config::CertificatesConfig src;
+    config::ServerNameConfig name;
+    name.server_name = "a.example.com";
+    name.ecdsa_cert_path = "/path/to/ec.pem";
+    name.ecdsa_key_path = "/path/to/ec.key";
+    src.server_names.push_back(name);
+
+    CertConfig dst;
+    ConfigConverter::convert_cert_config(src, dst);
+
+    ASSERT_EQ(dst.server_names.size(), 1u);
+    EXPECT_EQ(dst.server_names[0].server_name, "a.example.com");
+    EXPECT_EQ(dst.server_names[0].ecdsa_cert_path, "/path/to/ec.pem");
+    EXPECT_EQ(dst.server_names[0].ecdsa_key_path, "/path/to/ec.key");
+    EXPECT_TRUE(dst.server_names[0].cert_path.empty());
+    EXPECT_FALSE(dst.use_gmssl);
+}
+
 TEST_F(ConfigConverterTest, ConvertCertConfigWithGmssl) {
     config::CertificatesConfig src;
     src.sm2_cert_path = "/path/to/sm2_cert.pem";
@@ -724,6 +3311,136 @@ TEST_F(ConfigConverterTest, ConvertTlsConfigCipherSuites) {
     EXPECT_EQ(dst.cipher_suites, "ECDHE-ECDSA-AES256-GCM-SHA384");
 }
 
+TEST_F(ConfigConverterTest, DefaultCipherSuitesBuildContext) {
+    // 默认配置为TLS 1.3套件名，混合列表中的TLS 1.2套件单独设置
+    config::Config config;
+    CertConfig cert_config;
+    TlsConfig tls_config;
+    ConfigConverter::convert_cert_config(config.get_certificates(), cert_config);
+    ConfigConverter::convert_tls_config(config, tls_config);
+    ASSERT_FALSE(tls_config.cipher_suites.empty());
+
+    TlsContext context;
+    EXPECT_EQ(context.init(cert_config, tls_config), PROTOCOL_OK);
+
+    tls_config.cipher_suites = "TLS_AES_128_GCM_SHA256:ECDHE-RSA-AES128-GCM-SHA256";
+    TlsContext mixed;
+    EXPECT_EQ(mixed.init(cert_config, tls_config), PROTOCOL_OK);
+}
+
+TEST_F(ConfigConverterTest, ConvertTlsConfigKtls) {
+    config::Config config;
+    TlsConfig dst;
+    ConfigConverter::convert_tls_config(config, dst);
+    EXPECT_FALSE(dst.enable_ktls);
+
+    config::CertificatesConfig cert_config;
+    cert_config.enable_ktls = true;
+    config.set_certificates(cert_config);
+    ConfigConverter::convert_tls_config(config, dst);
+    EXPECT_TRUE(dst.enable_ktls);
+}
+
+TEST_F(ConfigConverterTest, ConvertTlsConfigPlaintextPort) {
+    config::Config config;
+    config::ListenConfig tls_listen;
+    tls_listen.port = 8443;
+    config::ListenConfig plain_listen;
+    plain_listen.port = 8080;
+    plain_listen.tls_enabled = false;
+    config.set_listens({tls_listen, plain_listen});
+
+    TlsConfig dst;
+    ConfigConverter::convert_tls_config(config, 8080, dst);
+    EXPECT_TRUE(dst.plaintext);
+    EXPECT_EQ(dst.alpn_protocols, ALPN_HTTP2_HTTP11);
+    ConfigConverter::convert_tls_config(config, 8443, dst);
+    EXPECT_FALSE(dst.plaintext);
+}
+
+TEST_F(ConfigConverterTest, ConvertTlsConfigEarlyDataPerPort) {
+    config::Config config;
+    config::ListenConfig early_listen;
+    early_listen.port = 8443;
+    early_listen.early_data = true;
+    early_listen.early_data_methods = "GET";
+    config::ListenConfig other_listen;
+    other_listen.port = 8444;
+    config.set_listens({early_listen, other_listen});
+
+    TlsConfig dst;
+    ConfigConverter::convert_tls_config(config, 8443, dst);
+    EXPECT_TRUE(dst.early_data);
+    EXPECT_EQ(dst.early_data_methods, "GET");
+    EXPECT_EQ(dst.max_early_data, DEFAULT_TLS_MAX_EARLY_DATA);
+    ConfigConverter::convert_tls_config(config, 8444, dst);
+    EXPECT_FALSE(dst.early_data);
+    EXPECT_EQ(dst.early_data_methods, DEFAULT_EARLY_DATA_METHODS);
+}
+
+TEST_F(ConfigConverterTest, ConvertTlsConfigSessionResumption) {
+    config::Config config;
+    TlsConfig dst;
+    ConfigConverter::convert_tls_config(config, dst);
+    EXPECT_EQ(dst.session_cache_size, DEFAULT_TLS_SESSION_CACHE_SIZE);
+    EXPECT_EQ(dst.session_timeout, DEFAULT_TLS_SESSION_TIMEOUT);
+    EXPECT_TRUE(dst.session_tickets);
+    EXPECT_EQ(dst.ticket_key_rotation, DEFAULT_TLS_TICKET_KEY_ROTATION);
+    EXPECT_EQ(dst.record_ramp_bytes, DEFAULT_TLS_RECORD_RAMP_BYTES);
+    EXPECT_EQ(dst.record_idle_ms, DEFAULT_TLS_RECORD_IDLE_MS);
+    EXPECT_TRUE(dst.cert_compression);
+
+    config::CertificatesConfig cert_config;
+    cert_config.session_cache_size = 0;
+    cert_config.session_timeout = 60;
+    cert_config.session_tickets = false;
+    cert_config.ticket_key_rotation = 600;
+    cert_config.record_ramp_bytes = 0;
+    cert_config.record_idle_ms = 250;
+    cert_config.cert_compression = false;
+    config.set_certificates(cert_config);
+    ConfigConverter::convert_tls_config(config, dst);
+    EXPECT_EQ(dst.session_cache_size, 0u);
+    EXPECT_EQ(dst.session_timeout, 60u);
+    EXPECT_FALSE(dst.session_tickets);
+    EXPECT_EQ(dst.ticket_key_rotation, 600u);
+    EXPECT_EQ(dst.record_ramp_bytes, 0u);
+    EXPECT_EQ(dst.record_idle_ms, 250u);
+    EXPECT_FALSE(dst.cert_compression);
+}
+
+TEST_F(ConfigConverterTest, ConvertCompressionConfig) {
+    config::ListenConfig listen;
+    CompressionConfig dst;
+    ConfigConverter::convert_compression_config(listen, dst);
+    EXPECT_FALSE(dst.enabled);
+    EXPECT_EQ(dst.level, DEFAULT_COMPRESSION_LEVEL);
+    EXPECT_EQ(dst.min_size, DEFAULT_COMPRESSION_MIN_SIZE);
+
+    listen.compression_enabled = true;
+    listen.compression_level = 1;
+    listen.compression_min_size = 128;
+    ConfigConverter::convert_compression_config(listen, dst);
+    EXPECT_TRUE(dst.enabled);
+    EXPECT_EQ(dst.level, 1);
+    EXPECT_EQ(dst.min_size, 128u);
+}
+
+TEST_F(ConfigConverterTest, ConvertHttp2Settings) {
+    config::Http2Config http2_config;
+    Http2Settings dst;
+    ConfigConverter::convert_http2_settings(http2_config, dst);
+    EXPECT_EQ(dst.initial_window_size, HTTP2_DEFAULT_INITIAL_WINDOW_SIZE);
+    EXPECT_EQ(dst.max_concurrent_streams, HTTP2_DEFAULT_MAX_CONCURRENT_STREAMS);
+
+    http2_config.initial_window_size = 1 << 20;
+    http2_config.max_concurrent_streams = 16;
+    ConfigConverter::convert_http2_settings(http2_config, dst);
+    EXPECT_EQ(dst.initial_window_size, 1u << 20);
+    EXPECT_EQ(dst.max_concurrent_streams, 16u);
+    EXPECT_EQ(dst.max_frame_size, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+}
+
 // ==================== ProtocolHandlerFactory测试 ====================
 
 class ProtocolHandlerFactoryTest : public ::testing::Test {
@@ -743,8 +3460,7 @@ TEST_F(ProtocolHandlerFactoryTest, CreateWithHttp2Disabled) {
     EXPECT_EQ(handler->get_protocol_type(), ProtocolType::HTTP_1_1);
 }
 
-// TODO: 当HTTP/2完整实现后，此测试用例需要更新为期望返回HTTP_2类型
-TEST_F(ProtocolHandlerFactoryTest, CreateWithHttp2Enabled_ReturnsHttp1HandlerForNow) {
+TEST_F(ProtocolHandlerFactoryTest, CreateWithHttp2Enabled_DefersToNegotiation) {
     config::Config config;
     config::Http2Config http2_config;
     http2_config.enabled = true;
@@ -752,16 +3468,19 @@ TEST_F(ProtocolHandlerFactoryTest, CreateWithHttp2Enabled_ReturnsHttp1HandlerFor
 
     auto handler = ProtocolHandlerFactory::create(config);
     ASSERT_NE(handler, nullptr);
-    // 当前版本简化实现：即使HTTP/2启用也返回Http1Handler
-    EXPECT_EQ(handler->get_protocol_type(), ProtocolType::HTTP_1_1);
+    // 协议在握手完成后按ALPN确定
+    EXPECT_NE(dynamic_cast<NegotiatingHandler*>(handler.get()), nullptr);
+    EXPECT_EQ(handler->get_protocol_type(), ProtocolType::UNKNOWN);
 }
 
 TEST_F(ProtocolHandlerFactoryTest, CreateWithDefaultConfig) {
     config::Config config;
 
-    auto handler = ProtocolHandlerFactory::create(config);
+    // 默认启用HTTP/2
+    auto handler = ProtocolHandlerFactory::create(config, 8443);
     ASSERT_NE(handler, nullptr);
-    EXPECT_EQ(handler->get_protocol_type(), ProtocolType::HTTP_1_1);
+    EXPECT_NE(dynamic_cast<NegotiatingHandler*>(handler.get()), nullptr);
+    EXPECT_EQ(handler->get_protocol_type(), ProtocolType::UNKNOWN);
 }
 
 } // namespace test
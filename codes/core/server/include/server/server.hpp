@@ -32,7 +32,8 @@ enum class ServerError : int {
     SOCKET_LISTEN = -6,
     MSG_CENTER_START = -7,
     INVALID_ARGUMENT = -8,
-    INTERNAL = -9
+    INTERNAL = -9,
+    TLS_CONTEXT = -10
 };
 
 // 保持兼容的常量定义
@@ -46,6 +47,7 @@ constexpr int ERR_SOCKET_LISTEN = -6;
 constexpr int ERR_MSG_CENTER_START = -7;
 constexpr int ERR_INVALID_ARGUMENT = -8;
 constexpr int ERR_INTERNAL = -9;
+constexpr int ERR_TLS_CONTEXT = -10;
 
 // Server状态枚举
 typedef enum {
@@ -122,6 +124,17 @@ public:
      */
     void get_statistics(utils::Statistics* stats) const;
 
+    // ==================== 运行时管理 ====================
+
+    /**
+     * @brief 证书热加载：重新读取配置文件的证书部分，构建新的SSL上下文后原子替换
+     * @return 0 成功，非0 失败（失败时继续使用原有证书）
+     * @note 证书加载在调用线程上完成，应由管理线程（如收到SIGHUP后的处理线程）调用；
+     *       已建立的连接保持旧上下文直到关闭，会话缓存与票据密钥不因热加载失效。
+     *       监听地址等其余配置仍需重启生效
+     */
+    int reload_certificates();
+
 private:
     // ==================== 私有方法 ====================
 
@@ -175,6 +188,7 @@ private:
     // ==================== 成员变量 ====================
 
     std::unique_ptr<config::Config> config_;
+    std::string config_file_;
     std::unique_ptr<ConnectionManager> conn_manager_;
     std::unique_ptr<MsgCenter> msg_center_;
 
@@ -5,6 +5,8 @@
 //  版权: Copyright (c) 2026
 // =============================================================================
 #include "server/server.hpp"
+#include "protocol/response_template.hpp"
+#include "protocol/tls_context.hpp"
 #include "utils/logger.hpp"
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -46,6 +48,7 @@ int Server::init(const std::string& config_file)
     try {
         // 步骤2: 创建并加载配置（不加锁）
         config_ = std::make_unique<config::Config>();
+        config_file_ = config_file;
         int ret = config_->load_from_file(config_file);
         if (ret != ERR_SUCCESS) {
             handle_init_error();
@@ -59,18 +62,26 @@ int Server::init(const std::string& config_file)
             return ERR_CONFIG_VALIDATE;
         }
 
-        // 步骤4: 初始化监听socket（不加锁）
+        // 步骤4: 为每个TLS监听端口构建共享SSL上下文（证书只加载一次，连接只创建SSL对象）
+        ret = protocol::TlsContextManager::instance().build(*config_);
+        if (ret != protocol::PROTOCOL_OK) {
+            LOG_ERROR("Server", "Failed to build TLS context");
+            handle_init_error();
+            return ERR_TLS_CONTEXT;
+        }
+
+        // 步骤5: 初始化监听socket（不加锁）
         int socket_ret = init_listen_sockets();
         if (socket_ret != ERR_SUCCESS) {
             handle_init_error();
             return socket_ret;
         }
 
-        // 步骤5: 创建子模块（不加锁）
+        // 步骤6: 创建子模块（不加锁）
         conn_manager_ = std::make_unique<ConnectionManager>();
         msg_center_ = std::make_unique<MsgCenter>();
 
-        // 步骤6: 设置状态（仅在修改status_时加锁）
+        // 步骤7: 设置状态（仅在修改status_时加锁）
         set_status(SERVER_STATUS_STOPPED);
         return ERR_SUCCESS;
     } catch (...) {
@@ -178,8 +189,9 @@ void Server::cleanup()
     msg_center_.reset();
     conn_manager_.reset();
 
-    // 步骤4: 清理配置（不加锁）
+    // 步骤4: 清理配置与共享TLS上下文（不加锁）
     config_.reset();
+    protocol::TlsContextManager::instance().clear();
 
     // 步骤5: 恢复状态为STOPPED（仅在修改status_时加锁）
     {
@@ -243,6 +255,48 @@ void Server::get_statistics(utils::Statistics* stats) const
     utils::StatisticsManager::instance().get_statistics(stats);
 }
 
+int Server::reload_certificates()
+{
+    // 步骤1: 复制当前配置（加锁），未init时拒绝
+    std::unique_ptr<config::Config> next;
+    std::string config_file;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!config_ || (status_ != SERVER_STATUS_RUNNING && status_ != SERVER_STATUS_STOPPED)) {
+            return ERR_INVALID_STATE;
+        }
+        next = std::make_unique<config::Config>(*config_);
+        config_file = config_file_;
+    }
+
+    // 步骤2: 重新加载并校验配置文件（不加锁），只取证书部分
+    config::Config loaded;
+    if (loaded.load_from_file(config_file) != ERR_SUCCESS) {
+        return ERR_CONFIG_LOAD;
+    }
+    next->set_certificates(loaded.get_certificates());
+    if (next->validate() != ERR_SUCCESS) {
+        return ERR_CONFIG_VALIDATE;
+    }
+
+    // 步骤3: 构建新上下文并原子替换（不加锁，失败时保留原有上下文）
+    if (protocol::TlsContextManager::instance().build(*next) != protocol::PROTOCOL_OK) {
+        LOG_ERROR("Server", "Failed to reload TLS certificates");
+        return ERR_TLS_CONTEXT;
+    }
+
+    // 步骤4: 记录生效的证书配置（加锁）
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (config_) {
+            config_->set_certificates(next->get_certificates());
+        }
+    }
+
+    LOG_INFO("Server", "TLS certificates reloaded");
+    return ERR_SUCCESS;
+}
+
 int Server::init_listen_sockets()
 {
     const auto& listens = config_->get_listens();
@@ -326,6 +380,9 @@ int Server::init_listen_sockets()
         listen_ports_.push_back(listen_cfg.port);
         listen_ips_.push_back(listen_cfg.ip);
 
+        // 每个端口登记一次默认回复模板，连接建立时直接复用
+        protocol::ResponseTemplateRegistry::instance().register_defaults(listen_cfg.port);
+
         LOG_INFO("Server", "Listening on %s:%d", listen_cfg.ip.c_str(), listen_cfg.port);
     }
 
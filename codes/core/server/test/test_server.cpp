@@ -394,6 +394,34 @@ TEST(ServerTest, UseCase013_Cleanup) {
     server.cleanup();
 }
 
+// Server_UseCase018: 证书热加载
+TEST(ServerTest, UseCase018_ReloadCertificates) {
+    Server server;
+    EXPECT_EQ(server.reload_certificates(), ERR_INVALID_STATE);
+
+    TempFile config_file(get_valid_config_json());
+    ASSERT_EQ(server.init(config_file.path()), 0);
+    EXPECT_EQ(server.reload_certificates(), 0);
+
+    // 新证书配置非法时拒绝热加载，原有上下文继续生效
+    {
+        std::ofstream file(config_file.path());
+        file << R"({
+            "listens": [{"ip": "127.0.0.1", "port": 18443, "enabled": true}],
+            "certificates": {"server_names": [{"server_name": "a.example.com"}]}
+        })";
+    }
+    EXPECT_EQ(server.reload_certificates(), ERR_CONFIG_VALIDATE);
+
+    {
+        std::ofstream file(config_file.path());
+        file << "{ invalid json";
+    }
+    EXPECT_EQ(server.reload_certificates(), ERR_CONFIG_LOAD);
+
+    server.cleanup();
+}
+
 // Server_UseCase014: 正常创建socket（内部测试）
 // 此用例通过UseCase001间接测试
 
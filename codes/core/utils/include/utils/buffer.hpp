@@ -8,6 +8,8 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <algorithm>
+#include <string>
 #include <vector>
 
 namespace https_server_sim {
@@ -19,6 +19,11 @@ struct Statistics {
     uint32_t p99_response_latency_ms = 0;
     uint64_t total_bytes_received = 0;
     uint64_t total_bytes_sent = 0;
+    uint64_t tls_resumption_hits = 0;     // 会话复用的握手数（会话缓存或票据）
+    uint64_t tls_resumption_misses = 0;   // 完整握手数
+    uint64_t tls_handshake_bytes_sent = 0;      // 握手期间发出的密文字节
+    uint64_t tls_handshake_bytes_received = 0;  // 握手期间收到的密文字节
+    uint64_t tls_handshake_round_trips = 0;     // 握手往返次数（按初始拥塞窗口估算）
 };
 
 class StatisticsManager {
@@ -52,6 +57,12 @@ public:
     // 记录发送字节
     void record_bytes_sent(uint64_t bytes);
 
+    // 记录一次TLS握手完成（resumed为true表示会话复用）
+    void record_tls_handshake(bool resumed);
+
+    // 记录一次TLS握手的开销（收发字节与往返次数）
+    void record_tls_handshake_traffic(uint64_t bytes_sent, uint64_t bytes_received, uint32_t round_trips);
+
     // ========== 获取统计 ==========
 
     // 获取统计信息
@@ -66,6 +77,12 @@ public:
     // 获取总请求数
     uint64_t total_requests() const;
 
+    // 获取TLS会话复用命中数
+    uint64_t tls_resumption_hits() const;
+
+    // 获取TLS会话复用未命中数（完整握手）
+    uint64_t tls_resumption_misses() const;
+
     // ========== 更新与重置 ==========
 
     // 定期更新（每秒调用）
@@ -83,6 +100,11 @@ private:
     std::atomic<uint64_t> total_requests_;
     std::atomic<uint64_t> total_bytes_received_;
     std::atomic<uint64_t> total_bytes_sent_;
+    std::atomic<uint64_t> tls_resumption_hits_;
+    std::atomic<uint64_t> tls_resumption_misses_;
+    std::atomic<uint64_t> tls_handshake_bytes_sent_;
+    std::atomic<uint64_t> tls_handshake_bytes_received_;
+    std::atomic<uint64_t> tls_handshake_round_trips_;
 
     // RPS计算
     std::atomic<uint64_t> requests_last_second_;
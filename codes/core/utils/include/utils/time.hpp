@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
 #include <string>
 #include <chrono>
 
@@ -41,6 +42,21 @@ std::string format_current_time(const char* format = "%Y-%m-%d %H:%M:%S");
 // return: 格式化后的时间字符串
 std::string format_time(uint64_t timestamp_ms, const char* format = "%Y-%m-%d %H:%M:%S");
 
+// ========== HTTP日期 ==========
+
+// IMF-fixdate格式长度，如 "Sun, 06 Nov 1994 08:49:37 GMT"
+constexpr size_t HTTP_DATE_LEN = 29;
+
+// 格式化Unix秒为HTTP日期（IMF-fixdate，与locale无关）
+// unix_sec: 自Unix纪元以来的秒数
+// out: 输出缓冲区，至少HTTP_DATE_LEN字节（不写入'\0'）
+void format_http_date(int64_t unix_sec, char* out);
+
+// 拷贝当前时刻的HTTP日期
+// 所有线程共享同一份缓存，每秒最多格式化一次
+// out: 输出缓冲区，至少HTTP_DATE_LEN字节（不写入'\0'）
+void copy_cached_http_date(char* out);
+
 // ========== 时间工具类 ==========
 
 // 计时器类，用于测量耗时
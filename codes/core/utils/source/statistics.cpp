@@ -16,6 +16,11 @@ StatisticsManager::StatisticsManager()
     , total_requests_(0)
     , total_bytes_received_(0)
     , total_bytes_sent_(0)
+    , tls_resumption_hits_(0)
+    , tls_resumption_misses_(0)
+    , tls_handshake_bytes_sent_(0)
+    , tls_handshake_bytes_received_(0)
+    , tls_handshake_round_trips_(0)
     , requests_last_second_(0)
     , requests_current_second_(0)
     , requests_per_second_(0)
@@ -67,6 +72,21 @@ void StatisticsManager::record_bytes_sent(uint64_t bytes) {
     total_bytes_sent_.fetch_add(bytes, std::memory_order_relaxed);
 }
 
+void StatisticsManager::record_tls_handshake(bool resumed) {
+    if (resumed) {
+        tls_resumption_hits_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        tls_resumption_misses_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void StatisticsManager::record_tls_handshake_traffic(uint64_t bytes_sent, uint64_t bytes_received,
+                                                     uint32_t round_trips) {
+    tls_handshake_bytes_sent_.fetch_add(bytes_sent, std::memory_order_relaxed);
+    tls_handshake_bytes_received_.fetch_add(bytes_received, std::memory_order_relaxed);
+    tls_handshake_round_trips_.fetch_add(round_trips, std::memory_order_relaxed);
+}
+
 void StatisticsManager::get_statistics(Statistics* stats) {
     if (stats == nullptr) {
         return;
@@ -77,6 +97,11 @@ void StatisticsManager::get_statistics(Statistics* stats) {
     stats->requests_per_second = requests_per_second_.load(std::memory_order_relaxed);
     stats->total_bytes_received = total_bytes_received_.load(std::memory_order_relaxed);
     stats->total_bytes_sent = total_bytes_sent_.load(std::memory_order_relaxed);
+    stats->tls_resumption_hits = tls_resumption_hits_.load(std::memory_order_relaxed);
+    stats->tls_resumption_misses = tls_resumption_misses_.load(std::memory_order_relaxed);
+    stats->tls_handshake_bytes_sent = tls_handshake_bytes_sent_.load(std::memory_order_relaxed);
+    stats->tls_handshake_bytes_received = tls_handshake_bytes_received_.load(std::memory_order_relaxed);
+    stats->tls_handshake_round_trips = tls_handshake_round_trips_.load(std::memory_order_relaxed);
 
     // 复制延迟统计
     {
@@ -100,6 +125,14 @@ uint64_t StatisticsManager::total_requests() const {
     return total_requests_.load(std::memory_order_relaxed);
 }
 
+uint64_t StatisticsManager::tls_resumption_hits() const {
+    return tls_resumption_hits_.load(std::memory_order_relaxed);
+}
+
+uint64_t StatisticsManager::tls_resumption_misses() const {
+    return tls_resumption_misses_.load(std::memory_order_relaxed);
+}
+
 void StatisticsManager::update() {
     // 更新RPS
     uint64_t current = requests_current_second_.exchange(0, std::memory_order_relaxed);
@@ -116,6 +149,11 @@ void StatisticsManager::reset() {
     total_requests_.store(0, std::memory_order_relaxed);
     total_bytes_received_.store(0, std::memory_order_relaxed);
     total_bytes_sent_.store(0, std::memory_order_relaxed);
+    tls_resumption_hits_.store(0, std::memory_order_relaxed);
+    tls_resumption_misses_.store(0, std::memory_order_relaxed);
+    tls_handshake_bytes_sent_.store(0, std::memory_order_relaxed);
+    tls_handshake_bytes_received_.store(0, std::memory_order_relaxed);
+    tls_handshake_round_trips_.store(0, std::memory_order_relaxed);
     requests_last_second_.store(0, std::memory_order_relaxed);
     requests_current_second_.store(0, std::memory_order_relaxed);
     requests_per_second_.store(0, std::memory_order_relaxed);
@@ -1,6 +1,9 @@
 #include "utils/time.hpp"
+#include <atomic>
+#include <cstring>
 #include <ctime>
 #include <iomanip>
+#include <mutex>
 #include <sstream>
 
 namespace https_server_sim {
@@ -63,6 +66,101 @@ std::string format_time(uint64_t timestamp_ms, const char* format) {
     return oss.str();
 }
 
+// HTTP date implementation
+namespace {
+
+const char* const kWeekdays[7] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+const char* const kMonths[12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                 "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+inline char* put_2digits(char* p, int value) {
+    *p++ = static_cast<char>('0' + value / 10);
+    *p++ = static_cast<char>('0' + value % 10);
+    return p;
+}
+
+// 进程级HTTP日期缓存（seqlock：写者更新时序号为奇数，读者校验前后序号一致）
+// 文本按8字节字存放在原子变量中，读者与写者并发访问时不构成数据竞争
+constexpr size_t kHttpDateWords = (HTTP_DATE_LEN + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+struct HttpDateCache {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<int64_t> second{-1};
+    std::atomic<uint64_t> words[kHttpDateWords] = {};
+    std::mutex refresh_mutex;
+};
+
+HttpDateCache g_http_date_cache;
+
+} // namespace
+
+void format_http_date(int64_t unix_sec, char* out) {
+    std::time_t time = static_cast<std::time_t>(unix_sec);
+    std::tm tm;
+#ifdef _WIN32
+    gmtime_s(&tm, &time);
+#else
+    gmtime_r(&time, &tm);
+#endif
+    char* p = out;
+    std::memcpy(p, kWeekdays[tm.tm_wday], 3);
+    p += 3;
+    *p++ = ',';
+    *p++ = ' ';
+    p = put_2digits(p, tm.tm_mday);
+    *p++ = ' ';
+    std::memcpy(p, kMonths[tm.tm_mon], 3);
+    p += 3;
+    *p++ = ' ';
+    int year = tm.tm_year + 1900;
+    p = put_2digits(p, year / 100);
+    p = put_2digits(p, year % 100);
+    *p++ = ' ';
+    p = put_2digits(p, tm.tm_hour);
+    *p++ = ':';
+    p = put_2digits(p, tm.tm_min);
+    *p++ = ':';
+    p = put_2digits(p, tm.tm_sec);
+    std::memcpy(p, " GMT", 4);
+}
+
+void copy_cached_http_date(char* out) {
+    HttpDateCache& cache = g_http_date_cache;
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+
+    // 秒数变化时由一个线程重新格式化，其余线程等待或直接读取
+    if (cache.second.load(std::memory_order_acquire) != now) {
+        std::lock_guard<std::mutex> lock(cache.refresh_mutex);
+        if (cache.second.load(std::memory_order_relaxed) != now) {
+            uint64_t words[kHttpDateWords] = {};
+            format_http_date(now, reinterpret_cast<char*>(words));
+            cache.seq.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < kHttpDateWords; ++i) {
+                cache.words[i].store(words[i], std::memory_order_relaxed);
+            }
+            cache.seq.fetch_add(1, std::memory_order_release);
+            cache.second.store(now, std::memory_order_release);
+        }
+    }
+
+    uint64_t words[kHttpDateWords];
+    while (true) {
+        uint64_t before = cache.seq.load(std::memory_order_acquire);
+        if ((before & 1) != 0) {
+            continue;
+        }
+        for (size_t i = 0; i < kHttpDateWords; ++i) {
+            words[i] = cache.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (cache.seq.load(std::memory_order_relaxed) == before) {
+            break;
+        }
+    }
+    std::memcpy(out, words, HTTP_DATE_LEN);
+}
+
 // StopWatch implementation
 StopWatch::StopWatch() {
     reset();
@@ -161,6 +161,25 @@ TEST(TimeTest, FormatTime) {
     EXPECT_FALSE(time_str.empty());
 }
 
+TEST(TimeTest, FormatHttpDate) {
+    char date[HTTP_DATE_LEN];
+    format_http_date(784111777, date);
+    EXPECT_EQ(std::string(date, HTTP_DATE_LEN), "Sun, 06 Nov 1994 08:49:37 GMT");
+}
+
+TEST(TimeTest, CachedHttpDateSharedAcrossThreads) {
+    char main_date[HTTP_DATE_LEN];
+    char thread_date[HTTP_DATE_LEN];
+    copy_cached_http_date(main_date);
+    std::thread t([&thread_date]() { copy_cached_http_date(thread_date); });
+    t.join();
+
+    for (const char* date : {main_date, thread_date}) {
+        EXPECT_EQ(std::string(date + 3, 2), ", ");
+        EXPECT_EQ(std::string(date + HTTP_DATE_LEN - 4, 4), " GMT");
+    }
+}
+
 // =============================================================================
 // Buffer模块测试用例
 // =============================================================================
@@ -509,6 +528,38 @@ TEST(StatisticsTest, RecordRequest) {
     EXPECT_EQ(mgr.total_requests(), 100u);
 }
 
+TEST(StatisticsTest, RecordTlsHandshake) {
+    StatisticsManager& mgr = StatisticsManager::instance();
+    mgr.reset();
+    mgr.record_tls_handshake(false);
+    mgr.record_tls_handshake(true);
+    mgr.record_tls_handshake(true);
+    EXPECT_EQ(mgr.tls_resumption_hits(), 2u);
+    EXPECT_EQ(mgr.tls_resumption_misses(), 1u);
+
+    Statistics stats;
+    mgr.get_statistics(&stats);
+    EXPECT_EQ(stats.tls_resumption_hits, 2u);
+    EXPECT_EQ(stats.tls_resumption_misses, 1u);
+}
+
+TEST(StatisticsTest, RecordTlsHandshakeTraffic) {
+    StatisticsManager& mgr = StatisticsManager::instance();
+    mgr.reset();
+    mgr.record_tls_handshake_traffic(4200, 600, 1);
+    mgr.record_tls_handshake_traffic(18000, 700, 2);
+
+    Statistics stats;
+    mgr.get_statistics(&stats);
+    EXPECT_EQ(stats.tls_handshake_bytes_sent, 22200u);
+    EXPECT_EQ(stats.tls_handshake_bytes_received, 1300u);
+    EXPECT_EQ(stats.tls_handshake_round_trips, 3u);
+
+    mgr.reset();
+    mgr.get_statistics(&stats);
+    EXPECT_EQ(stats.tls_handshake_round_trips, 0u);
+}
+
 TEST(StatisticsTest, RecordLatency) {
     StatisticsManager& mgr = StatisticsManager::instance();
     mgr.reset();